@@ -9,4 +9,36 @@ struct PixelInputType
 float4 PS(PixelInputType input) : SV_TARGET
 {
     return input.Color;
+}
+
+
+// Permutation entry point, see VSPermutation
+#ifdef USE_FOG
+cbuffer FogBuffer : register(b2)
+{
+    float4 FogColor;
+    float FogStart;
+    float FogEnd;
+};
+#endif
+
+struct PermutationPixelInputType
+{
+    float4 Pos : SV_POSITION;
+    float4 Color : COLOR;
+#ifdef USE_FOG
+    float FogDepth : FOG;
+#endif
+};
+
+float4 PSPermutation(PermutationPixelInputType input) : SV_TARGET
+{
+    float4 color = input.Color;
+
+#ifdef USE_FOG
+    float fog = saturate((input.FogDepth - FogStart) / (FogEnd - FogStart));
+    color.rgb = lerp(color.rgb, FogColor.rgb, fog);
+#endif
+
+    return color;
 }
\ No newline at end of file
@@ -1,16 +1,27 @@
-cbuffer MatrrixBuffer
+cbuffer MatrrixBuffer : register(b0)
 {
-    float4x4 World;
     float4x4 View;
     float4x4 Projection;
 };
 
+cbuffer ObjectBuffer : register(b1)
+{
+    float4x4 World;
+};
+
 struct VertexInputType
 {
     float4 position : POSITION;
     float4 color : COLOR;
 };
 
+struct InstancedVertexInputType
+{
+    float4 position : POSITION;
+    float4 color : COLOR;
+    float4x4 world : WORLD; // Per-instance stream, slot 1
+};
+
 struct PixelInputType
 {
     float4 Pos : SV_POSITION;
@@ -18,20 +29,161 @@ struct PixelInputType
 };
 
 
+// Object to clip space for every entry point. The depth prepass lays down depth that the color pass tests with
+// LESS_EQUAL, so both must compute bit-identical positions: one function, and precise so the compiler cannot
+// fuse or reorder it differently in each shader. The position outputs below are precise for the same reason.
+float4 TransformToView(float3 position, float4x4 world)
+{
+    precise float4 worldPosition = mul(float4(position, 1.0f), world);
+    precise float4 viewPosition = mul(worldPosition, View);
+    return viewPosition;
+}
+
+float4 ViewToClip(float4 viewPosition)
+{
+    precise float4 clipPosition = mul(viewPosition, Projection);
+    return clipPosition;
+}
+
+float4 TransformPosition(float3 position, float4x4 world)
+{
+    return ViewToClip(TransformToView(position, world));
+}
+
+// The instance stream carries the same transposed matrices as ObjectBuffer, so its rows are World's columns.
+// Transposing only renames registers and keeps the instanced math identical to the ObjectBuffer path.
+float4x4 InstanceWorld(float4x4 streamWorld)
+{
+    return transpose(streamWorld);
+}
+
+
+void VS(VertexInputType input, out precise float4 position : SV_POSITION, out float4 color : COLOR)
+{
+    position = TransformPosition(input.position.xyz, World);
+    color = input.color;
+}
+
+
+void VSInstanced(InstancedVertexInputType input, out precise float4 position : SV_POSITION, out float4 color : COLOR)
+{
+    position = TransformPosition(input.position.xyz, InstanceWorld(input.world));
+    color = input.color;
+}
+
+
+// Depth-only passes: the layout only declares the position stream (slot 0), no attribute is fetched
+struct DepthVertexInputType
+{
+    float4 position : POSITION;
+};
+
+struct InstancedDepthVertexInputType
+{
+    float4 position : POSITION;
+    float4x4 world : WORLD; // Per-instance stream, slot 1
+};
+
+void VSDepth(DepthVertexInputType input, out precise float4 position : SV_POSITION)
+{
+    position = TransformPosition(input.position.xyz, World);
+}
+
+void VSDepthInstanced(InstancedDepthVertexInputType input, out precise float4 position : SV_POSITION)
+{
+    position = TransformPosition(input.position.xyz, InstanceWorld(input.world));
+}
 
-PixelInputType VS(VertexInputType input)
+
+// Compressed vertices (VertexPositionColorPacked): UNORM16 position inside the mesh bounds, RGBA8 color.
+// The input assembler already expands both to float4, only the bounds need to be applied.
+cbuffer PackingBuffer : register(b2)
 {
-    // Change the position vector to be 4 units for proper matrix calculations.
-    input.position.w = 1.0f; // Ensure w is set to 1 for proper transformation ?
-    
+    float4 PositionOffset; // PositionQuantization::offset, bounds minimum
+    float4 PositionScale; // PositionQuantization::scale, bounds extent
+};
+
+PixelInputType VSPacked(VertexInputType input)
+{
+    float3 position = PositionOffset.xyz + input.position.xyz * PositionScale.xyz;
+
     PixelInputType output;
 
-    output.Pos = mul(input.position, World);
-    output.Pos = mul(output.Pos, View);
-    output.Pos = mul(output.Pos, Projection);
-    
+    output.Pos = TransformPosition(position, World);
+
     output.Color = input.color;
 
+    return output;
+}
+
+
+// Permutation entry point, features come from ShaderFeature bits as USE_* defines:
+//   USE_VERTEX_COLOR  per-vertex color, white otherwise
+//   USE_INSTANCING    world matrix from the instance stream (slot 1) instead of ObjectBuffer
+//   USE_SKINNING      four bone influences from SkinBuffer
+//   USE_FOG           view depth for the pixel shader fog
+#ifdef USE_SKINNING
+cbuffer SkinBuffer : register(b3)
+{
+    float4x4 Bones[64]; // Transposed like World
+};
+#endif
+
+struct PermutationVertexInputType
+{
+    float4 position : POSITION;
+#ifdef USE_VERTEX_COLOR
+    float4 color : COLOR;
+#endif
+#ifdef USE_SKINNING
+    uint4 boneIndices : BLENDINDICES;
+    float4 boneWeights : BLENDWEIGHT;
+#endif
+#ifdef USE_INSTANCING
+    float4x4 world : WORLD;
+#endif
+};
+
+struct PermutationPixelInputType
+{
+    float4 Pos : SV_POSITION;
+    float4 Color : COLOR;
+#ifdef USE_FOG
+    float FogDepth : FOG;
+#endif
+};
+
+PermutationPixelInputType VSPermutation(PermutationVertexInputType input)
+{
+    float4 position = float4(input.position.xyz, 1.0f);
+
+#ifdef USE_SKINNING
+    float4 skinned = 0.0f;
+    [unroll]
+    for (uint i = 0; i < 4; ++i)
+        skinned += mul(position, Bones[input.boneIndices[i]]) * input.boneWeights[i]; // Row vector, like World
+    position = float4(skinned.xyz, 1.0f);
+#endif
+
+    PermutationPixelInputType output;
+
+#ifdef USE_INSTANCING
+    float4 viewPosition = TransformToView(position.xyz, InstanceWorld(input.world));
+#else
+    float4 viewPosition = TransformToView(position.xyz, World);
+#endif
+
+#ifdef USE_FOG
+    output.FogDepth = viewPosition.z;
+#endif
+
+    output.Pos = ViewToClip(viewPosition);
+
+#ifdef USE_VERTEX_COLOR
+    output.Color = input.color;
+#else
+    output.Color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
 
     return output;
 }
\ No newline at end of file
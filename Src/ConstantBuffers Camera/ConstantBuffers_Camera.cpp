@@ -190,7 +190,7 @@ public:
         renderDevice.deviceContext->RSSetViewports(1, &view);
 
         renderDevice.deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer.buffer, &vertexBuffer.stride, &vertexBuffer.offset);
-        renderDevice.deviceContext->IASetIndexBuffer(indexBuffer.buffer, DXGI_FORMAT_R32_UINT, indexBuffer.offset);
+        renderDevice.deviceContext->IASetIndexBuffer(indexBuffer.buffer, DXGI_FORMAT_R16_UINT, indexBuffer.offset);
 
         renderDevice.deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         renderDevice.deviceContext->IASetInputLayout(pipeline.inputLayout);
@@ -246,7 +246,7 @@ public:
         };
 
         D3D11_BUFFER_DESC vertexBufferDesc = {};
-        vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
         vertexBufferDesc.ByteWidth = sizeof(vertices);
         vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
@@ -265,7 +265,7 @@ public:
 
 
 
-        uint32_t indices[] =
+        uint16_t indices[] =
         {
             // front face
             0, 1, 2, // first triangle
@@ -295,7 +295,7 @@ public:
         indexBuffer.count = _countof(indices);
 
         D3D11_BUFFER_DESC indexBufferDesc = {};
-        indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
         indexBufferDesc.ByteWidth = sizeof(indices);
         indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+
+namespace Core
+{
+	struct FrameStageStats
+	{
+		double lastMilliseconds = 0.0;
+		double maxMilliseconds = 0.0;
+		double totalMilliseconds = 0.0;
+		uint64_t samples = 0;
+
+		double GetAverage() const { return samples ? totalMilliseconds / samples : 0.0; }
+
+		void Record(double milliseconds)
+		{
+			lastMilliseconds = milliseconds;
+			maxMilliseconds = (milliseconds > maxMilliseconds) ? milliseconds : maxMilliseconds; // Included after <windows.h>, no std::max
+			totalMilliseconds += milliseconds;
+			samples++;
+		}
+	};
+
+	struct FramePipelineStats
+	{
+		uint64_t framesUpdated = 0;
+		uint64_t framesRendered = 0;
+		FrameStageStats update;
+		FrameStageStats render;
+		FrameStageStats updateStall; // Update waiting for a free slot: render bound
+		FrameStageStats renderStall; // Render waiting for a finished frame: update bound
+		FrameStageStats latency; // Update start to render end of the same frame
+		FrameStageStats addedLatency; // latency minus both stages, the time the frame sat queued
+	};
+
+	// Runs the update (simulation) stage of frame N+1 on its own thread while the calling thread renders frame N.
+	// Each frame in flight owns one TFrame slot (transforms, camera, draw packets...), handed from update to render
+	// and back, so neither stage ever sees the other's frame half written.
+	//
+	// framesInFlight 1 runs the stages back to back, 2 lets update run one frame ahead (double buffering),
+	// 3 two frames ahead. More frames smooth out spikes in either stage at the cost of latency.
+	//
+	// A slot comes back to the update stage with the data of framesInFlight frames ago: state that carries from frame
+	// to frame (rotation angles, physics) belongs to the update stage, the slot only carries what render needs.
+	template <typename TFrame>
+	class FramePipeline
+	{
+	public:
+		using UpdateStage = std::function<void(TFrame& frame, uint64_t frameIndex)>;
+		using RenderStage = std::function<void(const TFrame& frame, uint64_t frameIndex)>;
+
+		FramePipeline() = default;
+		~FramePipeline() { Stop(); }
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+
+		bool Start(uint32_t framesInFlight, UpdateStage update)
+		{
+			if (m_Thread.joinable() || framesInFlight == 0 || !update)
+				return false;
+
+			m_Slots.clear();
+			m_Slots.resize(framesInFlight);
+			m_Update = std::move(update);
+			m_NextUpdate = 0;
+			m_NextRender = 0;
+			m_Stop = false;
+			m_Stats = {};
+
+			m_Thread = std::thread(&FramePipeline::UpdateLoop, this);
+			return true;
+		}
+
+		// Frames updated but not rendered yet are dropped
+		void Stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Stop = true;
+			}
+			m_Changed.notify_all();
+
+			if (m_Thread.joinable())
+				m_Thread.join();
+		}
+
+		// Waits for the oldest finished frame, renders it on this thread and hands the slot back to update.
+		// Returns false once the pipeline is stopped.
+		bool RenderFrame(const RenderStage& render)
+		{
+			Clock::time_point waitStart = Clock::now();
+
+			Slot* slot = nullptr;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Changed.wait(lock, [this]() { return m_Stop || GetSlot(m_NextRender).state == SlotState::Ready; });
+				if (m_Stop)
+					return false;
+
+				slot = &GetSlot(m_NextRender);
+			}
+
+			Clock::time_point renderStart = Clock::now();
+			render(slot->frame, slot->frameIndex);
+			Clock::time_point renderEnd = Clock::now();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+
+				double renderMilliseconds = Milliseconds(renderStart, renderEnd);
+				double latency = Milliseconds(slot->updateStart, renderEnd);
+
+				m_Stats.renderStall.Record(Milliseconds(waitStart, renderStart));
+				m_Stats.render.Record(renderMilliseconds);
+				m_Stats.latency.Record(latency);
+				double queued = latency - slot->updateMilliseconds - renderMilliseconds;
+				m_Stats.addedLatency.Record(queued > 0.0 ? queued : 0.0);
+				m_Stats.framesRendered++;
+
+				slot->state = SlotState::Free;
+				m_NextRender++;
+			}
+			m_Changed.notify_all();
+
+			return true;
+		}
+
+		FramePipelineStats GetStats() const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Stats;
+		}
+
+		uint32_t GetFramesInFlight() const { return static_cast<uint32_t>(m_Slots.size()); }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		enum class SlotState
+		{
+			Free, // Owned by update
+			Ready // Owned by render
+		};
+
+		struct Slot
+		{
+			TFrame frame {};
+			SlotState state = SlotState::Free;
+			uint64_t frameIndex = 0;
+			Clock::time_point updateStart;
+			double updateMilliseconds = 0.0;
+		};
+
+		static double Milliseconds(Clock::time_point begin, Clock::time_point end)
+		{
+			return std::chrono::duration<double, std::milli>(end - begin).count();
+		}
+
+		Slot& GetSlot(uint64_t frameIndex) { return m_Slots[frameIndex % m_Slots.size()]; }
+
+		void UpdateLoop()
+		{
+			Profiler::SetThreadName("Update");
+
+			while (true)
+			{
+				Clock::time_point waitStart = Clock::now();
+
+				Slot* slot = nullptr;
+				uint64_t frameIndex = 0;
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					m_Changed.wait(lock, [this]() { return m_Stop || GetSlot(m_NextUpdate).state == SlotState::Free; });
+					if (m_Stop)
+						return;
+
+					frameIndex = m_NextUpdate;
+					slot = &GetSlot(frameIndex);
+				}
+
+				// The slot belongs to this thread until it is marked Ready, no lock needed to fill it
+				Clock::time_point updateStart = Clock::now();
+				m_Update(slot->frame, frameIndex);
+				Clock::time_point updateEnd = Clock::now();
+
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+
+					slot->frameIndex = frameIndex;
+					slot->updateStart = updateStart;
+					slot->updateMilliseconds = Milliseconds(updateStart, updateEnd);
+					slot->state = SlotState::Ready;
+
+					m_Stats.updateStall.Record(Milliseconds(waitStart, updateStart));
+					m_Stats.update.Record(slot->updateMilliseconds);
+					m_Stats.framesUpdated++;
+					m_NextUpdate++;
+				}
+				m_Changed.notify_all();
+			}
+		}
+
+		std::vector<Slot> m_Slots;
+		UpdateStage m_Update;
+		std::thread m_Thread;
+
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_Changed;
+		uint64_t m_NextUpdate = 0;
+		uint64_t m_NextRender = 0;
+		bool m_Stop = false;
+		FramePipelineStats m_Stats;
+	};
+}
@@ -0,0 +1,329 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Core
+{
+	namespace
+	{
+		// Which pool, and which worker of it, the current thread belongs to
+		thread_local JobSystem* t_JobSystem = nullptr;
+		thread_local int32_t t_WorkerIndex = -1;
+
+		uint32_t NextRandom(uint32_t& state)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		constexpr uint32_t SpinsBeforeSleep = 64;
+	}
+
+	bool JobSystem::Initialize(uint32_t workerCount, uint32_t queueCapacity)
+	{
+		if (IsInitialized())
+			return true;
+
+		if (workerCount == 0)
+			workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+		m_Stop = false;
+		m_Queued = 0;
+		m_Sleeping = 0;
+
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back(new Worker(queueCapacity));
+			m_Workers.back()->random = 0x9E3779B9u * (i + 1);
+		}
+
+		t_JobSystem = this;
+		t_WorkerIndex = 0;
+
+		// Worker 0 is the calling thread
+		for (uint32_t i = 1; i < workerCount; ++i)
+			m_Workers[i]->thread = std::thread(&JobSystem::WorkerLoop, this, i);
+
+		return true;
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if (!IsInitialized())
+			return;
+
+		// Workers only leave once they find no work, so whatever was queued still runs
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+			m_Stop = true;
+		}
+		m_WakeUp.notify_all();
+
+		for (std::unique_ptr<Worker>& worker : m_Workers)
+		{
+			if (worker->thread.joinable())
+				worker->thread.join();
+		}
+
+		// Single worker pools have nobody left to drain the caller's deque
+		while (Job* job = FindJob(GetCurrentWorker()))
+			Execute(job, GetCurrentWorker());
+
+		if (t_JobSystem == this)
+		{
+			t_JobSystem = nullptr;
+			t_WorkerIndex = -1;
+		}
+
+		m_Workers.clear();
+	}
+
+	JobSystem::~JobSystem()
+	{
+		Shutdown();
+	}
+
+	int32_t JobSystem::GetCurrentWorker() const
+	{
+		return (t_JobSystem == this) ? t_WorkerIndex : -1;
+	}
+
+	void JobSystem::Run(JobFunction function, JobCounter* counter, const char* name)
+	{
+		if (counter)
+			counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		Job* job = new Job { std::move(function), counter, name };
+
+		int32_t worker = GetCurrentWorker();
+		if (!IsInitialized())
+		{
+			Execute(job, worker);
+			return;
+		}
+
+		if (worker >= 0)
+		{
+			if (!m_Workers[worker]->queue.Push(job))
+			{
+				m_Workers[worker]->ranInline.fetch_add(1, std::memory_order_relaxed);
+				Execute(job, worker);
+				return;
+			}
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(m_InjectedMutex);
+			m_Injected.push_back(job);
+			m_InjectedCount.fetch_add(1, std::memory_order_release);
+			m_InjectedTotal.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		m_Queued.fetch_add(1);
+		WakeOne();
+	}
+
+	void JobSystem::WakeOne()
+	{
+		// Pairs with the m_Sleeping increment in WorkerLoop: either the sleeper sees m_Queued or we see it sleeping
+		if (m_Sleeping.load() == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_WakeUp.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		int32_t worker = GetCurrentWorker();
+
+		// Help instead of blocking, the jobs we wait on may well be sitting in our own deque
+		while (!counter.IsDone())
+		{
+			if (Job* job = FindJob(worker))
+				Execute(job, worker);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t minChunk, const RangeFunction& function, const char* name)
+	{
+		if (count == 0)
+			return;
+
+		// A few chunks per worker leaves room to rebalance, never below what the caller finds worth a job
+		uint32_t workers = std::max(1u, GetWorkerCount());
+		uint32_t grain = std::max(std::max(minChunk, 1u), count / (workers * 4));
+
+		if (count <= grain || workers == 1)
+		{
+			function(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		Split(0, count, grain, function, counter, name);
+		Wait(counter);
+	}
+
+	void JobSystem::Split(uint32_t begin, uint32_t end, uint32_t grain, const RangeFunction& function, JobCounter& counter, const char* name)
+	{
+		// Queue the upper half and keep splitting the lower one: thieves take from the top, so they get the big halves
+		while (end - begin > grain)
+		{
+			uint32_t middle = begin + (end - begin) / 2;
+			Run([this, middle, end, grain, &function, &counter, name]() { Split(middle, end, grain, function, counter, name); }, &counter, name);
+			end = middle;
+		}
+
+		function(begin, end);
+	}
+
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		t_JobSystem = this;
+		t_WorkerIndex = static_cast<int32_t>(index);
+		Profiler::SetThreadName(("Job worker " + std::to_string(index)).c_str());
+
+		Worker& self = *m_Workers[index];
+		uint32_t spins = 0;
+
+		while (true)
+		{
+			if (Job* job = FindJob(static_cast<int32_t>(index)))
+			{
+				Execute(job, static_cast<int32_t>(index));
+				spins = 0;
+				continue;
+			}
+
+			if (m_Stop.load(std::memory_order_acquire))
+				break;
+
+			if (++spins < SpinsBeforeSleep)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_Sleeping.fetch_add(1);
+			if (m_Queued.load() <= 0 && !m_Stop.load())
+			{
+				self.sleeps.fetch_add(1, std::memory_order_relaxed);
+				m_WakeUp.wait(lock, [this]() { return m_Queued.load() > 0 || m_Stop.load(); });
+			}
+			m_Sleeping.fetch_sub(1);
+			spins = 0;
+		}
+
+		t_JobSystem = nullptr;
+		t_WorkerIndex = -1;
+	}
+
+	JobSystem::Job* JobSystem::FindJob(int32_t worker)
+	{
+		Job* job = nullptr;
+
+		if (worker >= 0)
+			job = m_Workers[worker]->queue.Pop();
+
+		if (!job && m_InjectedCount.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_InjectedMutex);
+			if (!m_Injected.empty())
+			{
+				job = m_Injected.front();
+				m_Injected.pop_front();
+				m_InjectedCount.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		if (!job)
+			job = Steal(worker);
+
+		if (job)
+			m_Queued.fetch_sub(1);
+
+		return job;
+	}
+
+	JobSystem::Job* JobSystem::Steal(int32_t worker)
+	{
+		const uint32_t count = GetWorkerCount();
+		if (count < 2 && worker >= 0)
+			return nullptr;
+
+		uint32_t random = (worker >= 0) ? NextRandom(m_Workers[worker]->random) : m_ExternalRandom.fetch_add(0x9E3779B9u, std::memory_order_relaxed);
+
+		// One pass over every other worker, starting at a random victim so thieves spread out
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t victim = (random + i) % count;
+			if (static_cast<int32_t>(victim) == worker)
+				continue;
+
+			if (Job* job = m_Workers[victim]->queue.Steal())
+			{
+				if (worker >= 0)
+					m_Workers[worker]->stolen.fetch_add(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::Execute(Job* job, int32_t worker)
+	{
+		if (m_Profiler.onBegin)
+			m_Profiler.onBegin(job->name, worker, m_Profiler.userData);
+
+		job->function();
+
+		if (m_Profiler.onEnd)
+			m_Profiler.onEnd(job->name, worker, m_Profiler.userData);
+
+		if (worker >= 0 && worker < static_cast<int32_t>(m_Workers.size()))
+			m_Workers[worker]->executed.fetch_add(1, std::memory_order_relaxed);
+
+		// Last touch of the job: a waiter may return and destroy the counter right after this
+		JobCounter* counter = job->counter;
+		delete job;
+
+		if (counter)
+			counter->m_Pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	JobSystemStats JobSystem::GetStats() const
+	{
+		JobSystemStats stats = {};
+		for (const std::unique_ptr<Worker>& worker : m_Workers)
+		{
+			stats.executed += worker->executed.load(std::memory_order_relaxed);
+			stats.stolen += worker->stolen.load(std::memory_order_relaxed);
+			stats.ranInline += worker->ranInline.load(std::memory_order_relaxed);
+			stats.sleeps += worker->sleeps.load(std::memory_order_relaxed);
+		}
+
+		stats.injected = m_InjectedTotal.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void JobSystem::ResetStats()
+	{
+		for (std::unique_ptr<Worker>& worker : m_Workers)
+		{
+			worker->executed = 0;
+			worker->stolen = 0;
+			worker->ranInline = 0;
+			worker->sleeps = 0;
+		}
+
+		m_InjectedTotal = 0;
+	}
+}
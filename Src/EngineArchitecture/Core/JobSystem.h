@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "WorkStealingQueue.h"
+
+namespace Core
+{
+	class JobSystem;
+
+	// Pending jobs of a group. Run() counts a job in before it is queued and the job counts itself out when it
+	// returns, so a counter reaching zero means every job given to it has finished.
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+		uint32_t GetPending() const { return m_Pending.load(std::memory_order_relaxed); }
+
+	private:
+		friend class JobSystem;
+		std::atomic<uint32_t> m_Pending { 0 };
+	};
+
+	// Called on the thread that runs the job, right before and after it. worker is -1 for threads outside the pool.
+	using JobHook = void (*)(const char* name, int32_t worker, void* userData);
+
+	struct JobProfiler
+	{
+		JobHook onBegin = nullptr;
+		JobHook onEnd = nullptr;
+		void* userData = nullptr;
+	};
+
+	struct JobSystemStats
+	{
+		uint64_t executed = 0;
+		uint64_t stolen = 0; // Taken from another worker's deque
+		uint64_t injected = 0; // Queued by threads outside the pool
+		uint64_t ranInline = 0; // Deque full, Run() executed the job on the spot
+		uint64_t sleeps = 0; // Times a worker ran out of work and blocked
+	};
+
+	// Per-core workers, each with a Chase-Lev deque. Workers pop their own jobs LIFO and steal FIFO from a
+	// random victim when empty, then block until more work is queued.
+	//
+	// The thread that calls Initialize() is worker 0: it owns a deque but never blocks in the pool, it only
+	// runs jobs while it waits. Threads outside the pool may call Run() and Wait() as well, their jobs go
+	// through a locked injection queue.
+	class JobSystem
+	{
+	public:
+		using JobFunction = std::function<void()>;
+		using RangeFunction = std::function<void(uint32_t begin, uint32_t end)>;
+
+		JobSystem() = default;
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		bool Initialize(uint32_t workerCount = 0, uint32_t queueCapacity = 4096); // 0 uses every hardware thread, the caller included
+		void Shutdown(); // Finishes the queued jobs, then joins the workers
+
+		void Run(JobFunction job, JobCounter* counter = nullptr, const char* name = "Job"); // name must outlive the job (string literal)
+		void Wait(JobCounter& counter); // Runs queued jobs until the counter drops to zero
+
+		// Calls function over [0, count) in chunks of at least minChunk. Ranges are split in halves on demand,
+		// idle workers steal the biggest halves first, so uneven work balances itself. Blocks until done.
+		void ParallelFor(uint32_t count, uint32_t minChunk, const RangeFunction& function, const char* name = "ParallelFor");
+
+		void SetProfiler(const JobProfiler& profiler) { m_Profiler = profiler; } // Before the first Run()
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+		int32_t GetCurrentWorker() const; // -1 outside the pool
+		bool IsInitialized() const { return !m_Workers.empty(); }
+
+		JobSystemStats GetStats() const;
+		void ResetStats();
+
+	private:
+		struct Job
+		{
+			JobFunction function;
+			JobCounter* counter = nullptr;
+			const char* name = nullptr;
+		};
+
+		struct Worker
+		{
+			explicit Worker(uint32_t queueCapacity) : queue(queueCapacity) {}
+
+			WorkStealingQueue<Job> queue;
+			std::thread thread;
+			uint32_t random = 0; // xorshift state for victim selection, touched by the owner only
+
+			std::atomic<uint64_t> executed { 0 };
+			std::atomic<uint64_t> stolen { 0 };
+			std::atomic<uint64_t> ranInline { 0 };
+			std::atomic<uint64_t> sleeps { 0 };
+		};
+
+		void WorkerLoop(uint32_t index);
+		Job* FindJob(int32_t worker);
+		Job* Steal(int32_t worker);
+		void Execute(Job* job, int32_t worker);
+		void Split(uint32_t begin, uint32_t end, uint32_t grain, const RangeFunction& function, JobCounter& counter, const char* name);
+		void WakeOne();
+
+		std::vector<std::unique_ptr<Worker>> m_Workers;
+		JobProfiler m_Profiler;
+
+		std::mutex m_InjectedMutex;
+		std::deque<Job*> m_Injected;
+		std::atomic<uint32_t> m_InjectedCount { 0 };
+		std::atomic<uint64_t> m_InjectedTotal { 0 };
+		std::atomic<uint32_t> m_ExternalRandom { 1 };
+
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeUp;
+		std::atomic<int32_t> m_Queued { 0 }; // Jobs in any queue, workers only block at zero
+		std::atomic<uint32_t> m_Sleeping { 0 };
+		std::atomic<bool> m_Stop { false };
+	};
+}
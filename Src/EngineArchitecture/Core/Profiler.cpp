@@ -0,0 +1,287 @@
+#include "Profiler.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace Core
+{
+	namespace
+	{
+		constexpr uint32_t MaxJobDepth = 16; // Jobs run jobs while they wait, deeper nesting is not timed
+
+		thread_local uint64_t t_JobStarts[MaxJobDepth];
+		thread_local uint32_t t_JobDepth = 0;
+
+		void OnJobBegin(const char* name, int32_t worker, void* userData)
+		{
+			if (t_JobDepth < MaxJobDepth)
+				t_JobStarts[t_JobDepth] = Profiler::IsEnabled() ? Profiler::Now() : 0;
+			t_JobDepth++;
+		}
+
+		void OnJobEnd(const char* name, int32_t worker, void* userData)
+		{
+			t_JobDepth--;
+			if (t_JobDepth < MaxJobDepth && t_JobStarts[t_JobDepth])
+				Profiler::Record(name, t_JobStarts[t_JobDepth], Profiler::Now());
+		}
+
+		void AppendEscaped(std::string& line, const char* text)
+		{
+			for (; *text; ++text)
+			{
+				char c = *text;
+				if (c == '"' || c == '\\')
+					line += '\\';
+				line += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+			}
+		}
+	}
+
+	std::atomic<bool> Profiler::s_Enabled { false };
+	thread_local Profiler::ThreadState Profiler::t_Thread;
+
+	Profiler::ThreadState::~ThreadState()
+	{
+		if (buffer)
+			buffer->state.store(Released, std::memory_order_release);
+	}
+
+	Profiler& Profiler::Get()
+	{
+		static Profiler profiler;
+		return profiler;
+	}
+
+	Profiler::~Profiler()
+	{
+		Stop();
+	}
+
+	uint64_t Profiler::Now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	bool Profiler::Start(const std::string& path, uint32_t eventsPerThread, uint32_t flushMilliseconds)
+	{
+		if (m_Running)
+		{
+			std::cerr << "[Profiler] Already running.\n";
+			return false;
+		}
+
+		m_File.open(path, std::ios::binary | std::ios::trunc);
+		if (!m_File)
+		{
+			std::cerr << "[Profiler] Failed to open " << path << ".\n";
+			return false;
+		}
+
+		m_File << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		m_FirstEvent = true;
+		m_Written.store(0, std::memory_order_relaxed);
+		m_Flushes.store(0, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock(m_BuffersMutex);
+			m_Capacity = eventsPerThread ? eventsPerThread : 1; // Threads that already have a ring keep its size
+		}
+
+		m_Origin = Now();
+		m_FlushMilliseconds = flushMilliseconds ? flushMilliseconds : 1;
+		m_StopCollector = false;
+		m_Running = true;
+		m_Collector = std::thread(&Profiler::CollectorLoop, this);
+
+		s_Enabled.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void Profiler::Stop()
+	{
+		if (!m_Running)
+			return;
+
+		s_Enabled.store(false, std::memory_order_release);
+
+		{
+			std::lock_guard<std::mutex> lock(m_CollectorMutex);
+			m_StopCollector = true;
+		}
+		m_CollectorWake.notify_one();
+		m_Collector.join();
+
+		Drain(); // Whatever arrived after the collector's last pass
+
+		// Track names as metadata events, Chrome and Perfetto accept them anywhere in the array
+		{
+			std::lock_guard<std::mutex> lock(m_BuffersMutex);
+			for (const ThreadName& thread : m_ThreadNames)
+			{
+				m_Line = m_FirstEvent ? "\n" : ",\n";
+				m_Line += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+				m_Line += std::to_string(thread.threadId);
+				m_Line += ",\"args\":{\"name\":\"";
+				AppendEscaped(m_Line, thread.name.c_str());
+				m_Line += "\"}}";
+				m_File << m_Line;
+				m_FirstEvent = false;
+			}
+		}
+
+		m_File << "\n]}\n";
+		m_File.close();
+		m_Running = false;
+	}
+
+	Profiler::ThreadBuffer* Profiler::AcquireBuffer()
+	{
+		std::lock_guard<std::mutex> lock(m_BuffersMutex);
+
+		// Threads come and go (shader compile batches), a ring whose thread exited is reused once the collector emptied it
+		ThreadBuffer* buffer = nullptr;
+		for (const std::unique_ptr<ThreadBuffer>& candidate : m_Buffers)
+		{
+			if (candidate->state.load(std::memory_order_acquire) == Free)
+			{
+				buffer = candidate.get();
+				buffer->state.store(InUse, std::memory_order_relaxed);
+				break;
+			}
+		}
+
+		if (!buffer)
+		{
+			m_Buffers.emplace_back(new ThreadBuffer(m_Capacity));
+			buffer = m_Buffers.back().get();
+		}
+
+		buffer->threadId = m_NextThreadId++;
+
+		ThreadName name;
+		name.threadId = buffer->threadId;
+		name.name = t_Thread.name.empty() ? "Thread " + std::to_string(buffer->threadId) : t_Thread.name;
+		m_ThreadNames.push_back(name);
+
+		t_Thread.buffer = buffer;
+		return buffer;
+	}
+
+	void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+	{
+		if (!IsEnabled())
+			return;
+
+		ThreadBuffer* buffer = t_Thread.buffer;
+		if (!buffer)
+			buffer = Get().AcquireBuffer();
+
+		ProfilerEvent event;
+		event.name = name;
+		event.start = start;
+		event.end = end;
+
+		if (!buffer->events.TryPush(event))
+			buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	void Profiler::SetThreadName(const char* name)
+	{
+		t_Thread.name = name ? name : "";
+
+		if (!t_Thread.buffer)
+			return; // Picked up with the first event
+
+		Profiler& profiler = Get();
+		std::lock_guard<std::mutex> lock(profiler.m_BuffersMutex);
+		for (ThreadName& thread : profiler.m_ThreadNames)
+		{
+			if (thread.threadId == t_Thread.buffer->threadId)
+				thread.name = t_Thread.name;
+		}
+	}
+
+	JobProfiler Profiler::GetJobProfiler()
+	{
+		JobProfiler hooks;
+		hooks.onBegin = &OnJobBegin;
+		hooks.onEnd = &OnJobEnd;
+		return hooks;
+	}
+
+	ProfilerStats Profiler::GetStats() const
+	{
+		ProfilerStats stats;
+		stats.written = m_Written.load(std::memory_order_relaxed);
+		stats.flushes = m_Flushes.load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(m_BuffersMutex);
+		for (const std::unique_ptr<ThreadBuffer>& buffer : m_Buffers)
+			stats.dropped += buffer->dropped.load(std::memory_order_relaxed);
+		stats.threads = m_NextThreadId - 1;
+		stats.buffers = static_cast<uint32_t>(m_Buffers.size());
+		return stats;
+	}
+
+	void Profiler::CollectorLoop()
+	{
+		SetThreadName("Profiler");
+
+		std::unique_lock<std::mutex> lock(m_CollectorMutex);
+		while (!m_StopCollector)
+		{
+			m_CollectorWake.wait_for(lock, std::chrono::milliseconds(m_FlushMilliseconds));
+
+			lock.unlock();
+			Drain();
+			lock.lock();
+		}
+	}
+
+	void Profiler::Drain()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_BuffersMutex);
+			m_DrainList.clear();
+			for (const std::unique_ptr<ThreadBuffer>& buffer : m_Buffers)
+				m_DrainList.push_back(buffer.get());
+		}
+
+		ProfilerEvent event;
+		for (ThreadBuffer* buffer : m_DrainList)
+		{
+			uint8_t state = buffer->state.load(std::memory_order_acquire); // Released: the owner pushes nothing more
+			if (state == Free)
+				continue;
+
+			while (buffer->events.TryPop(event))
+			{
+				// Recorded before this session started: left behind by the previous Stop()
+				if (event.start >= m_Origin)
+					WriteEvent(event, buffer->threadId);
+			}
+
+			if (state == Released)
+				buffer->state.store(Free, std::memory_order_release); // Done with threadId, AcquireBuffer() may take it
+		}
+
+		m_Flushes.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Profiler::WriteEvent(const ProfilerEvent& event, uint32_t threadId)
+	{
+		char numbers[128];
+		snprintf(numbers, sizeof(numbers), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+			(event.start - m_Origin) / 1000.0, (event.end - event.start) / 1000.0, threadId);
+
+		m_Line = m_FirstEvent ? "\n{\"name\":\"" : ",\n{\"name\":\"";
+		AppendEscaped(m_Line, event.name);
+		m_Line += numbers;
+		m_File << m_Line;
+
+		m_FirstEvent = false;
+		m_Written.fetch_add(1, std::memory_order_relaxed);
+	}
+}
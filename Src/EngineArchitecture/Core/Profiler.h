@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+
+namespace Core
+{
+	struct JobProfiler;
+
+	struct ProfilerEvent
+	{
+		const char* name = nullptr; // Must outlive the session: string literals and __FUNCTION__
+		uint64_t start = 0; // Profiler::Now() nanoseconds
+		uint64_t end = 0;
+	};
+
+	struct ProfilerStats
+	{
+		uint64_t written = 0; // Events in the file
+		uint64_t dropped = 0; // Ring full, the collector fell behind
+		uint64_t flushes = 0;
+		uint32_t threads = 0; // Threads that recorded at least one event, ever
+		uint32_t buffers = 0; // Rings allocated, a thread that exited hands its ring to the next new one
+	};
+
+	// Scoped CPU zones written to a Chrome trace (chrome://tracing, ui.perfetto.dev). Every thread records into its own
+	// SpscQueue ring, no locks after its first event. A collector thread drains the rings every few milliseconds and
+	// appends complete ("X") events to the JSON file, so a long session does not grow in memory.
+	//
+	// Disabled, a zone costs one relaxed atomic load. Defining CORE_PROFILER_DISABLED compiles the macros out entirely.
+	class Profiler
+	{
+	public:
+		static Profiler& Get();
+
+		// Start() and Stop() from one thread. Events still in flight when Stop() disables recording are dropped.
+		bool Start(const std::string& path, uint32_t eventsPerThread = 65536, uint32_t flushMilliseconds = 5); // Enables recording
+		void Stop(); // Disables recording, writes what is left and closes the file. Also runs at exit.
+		bool IsRunning() const { return m_Running; }
+
+		static bool IsEnabled() { return s_Enabled.load(std::memory_order_relaxed); }
+		static uint64_t Now(); // Nanoseconds on the steady clock
+
+		static void Record(const char* name, uint64_t start, uint64_t end); // Any thread, dropped when disabled or the ring is full
+		static void SetThreadName(const char* name); // Shown as the track name, copied
+		static JobProfiler GetJobProfiler(); // JobSystem hooks, one zone per job under the job's name
+
+		ProfilerStats GetStats() const;
+
+	private:
+		// Owning thread exited, then the collector drained what it left: the buffer goes to the next new thread
+		enum BufferState : uint8_t
+		{
+			InUse,
+			Released,
+			Free
+		};
+
+		struct ThreadBuffer
+		{
+			explicit ThreadBuffer(uint32_t capacity) : events(capacity) {}
+
+			SpscQueue<ProfilerEvent> events; // Owning thread pushes, the collector pops
+			std::atomic<uint64_t> dropped { 0 }; // Written by the owning thread only
+			std::atomic<uint8_t> state { InUse }; // InUse -> Released by the owner, Released -> Free by the collector
+			uint32_t threadId = 0; // Set before the owner's first push, the collector reads it while the buffer is not Free
+		};
+
+		// Per thread, the only state Record() touches besides the ring
+		struct ThreadState
+		{
+			ThreadBuffer* buffer = nullptr;
+			std::string name; // From SetThreadName(), used when the buffer is acquired
+			~ThreadState(); // Thread exit, releases the buffer
+		};
+
+		struct ThreadName
+		{
+			uint32_t threadId = 0;
+			std::string name;
+		};
+
+		Profiler() = default;
+		~Profiler();
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		ThreadBuffer* AcquireBuffer(); // First event of a thread
+		void CollectorLoop();
+		void Drain(); // Collector thread, or Stop() once the collector is gone
+		void WriteEvent(const ProfilerEvent& event, uint32_t threadId);
+
+		static std::atomic<bool> s_Enabled;
+		static thread_local ThreadState t_Thread;
+
+		mutable std::mutex m_BuffersMutex; // Guards the lists below, never taken while recording
+		std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+		std::vector<ThreadName> m_ThreadNames;
+		std::vector<ThreadBuffer*> m_DrainList; // Collector's copy of m_Buffers
+		uint32_t m_Capacity = 65536;
+		uint32_t m_NextThreadId = 1;
+
+		std::ofstream m_File;
+		std::string m_Line; // Reused for every event
+		bool m_FirstEvent = true;
+		uint64_t m_Origin = 0; // Now() at Start(), the trace starts at zero
+		bool m_Running = false;
+		std::atomic<uint64_t> m_Written { 0 }; // Collector thread writes, GetStats() reads
+		std::atomic<uint64_t> m_Flushes { 0 };
+
+		std::thread m_Collector;
+		std::mutex m_CollectorMutex;
+		std::condition_variable m_CollectorWake;
+		bool m_StopCollector = false;
+		uint32_t m_FlushMilliseconds = 5;
+	};
+
+	// Records the time between construction and destruction. The name is only read when the zone ends.
+	class ProfileZone
+	{
+	public:
+		explicit ProfileZone(const char* name) : m_Name(Profiler::IsEnabled() ? name : nullptr), m_Start(m_Name ? Profiler::Now() : 0) {}
+		~ProfileZone()
+		{
+			if (m_Name)
+				Profiler::Record(m_Name, m_Start, Profiler::Now());
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+}
+
+#define CORE_PROFILE_CONCAT_INNER(a, b) a##b
+#define CORE_PROFILE_CONCAT(a, b) CORE_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(CORE_PROFILER_DISABLED)
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_ZONE(name) Core::ProfileZone CORE_PROFILE_CONCAT(profileZone, __LINE__)(name) // Until the end of the enclosing scope
+#endif
+
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
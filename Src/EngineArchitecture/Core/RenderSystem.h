@@ -15,8 +15,17 @@
 #include "../Graphics/Buffer.h"
 #include "../Graphics/Texture.h"
 #include "../Graphics/Pipeline.h"
+#include "../Graphics/ConstantBufferRing.h"
+#include "../Graphics/UploadHeap.h"
+#include "../Graphics/BufferPool.h"
+#include "../Graphics/GeometryArena.h"
+#include "../Graphics/RenderQueue.h"
+#include "../Graphics/ParallelSubmit.h"
 #include "../Graphics/EngineData.h"
+#include "../Graphics/RenderBackend.h"
 #include "../Core/Windows.h"
+#include "../Core/JobSystem.h"
+#include "../Core/RenderThread.h"
 
 
 namespace Core
@@ -26,26 +35,34 @@ namespace Core
     {
     public:
         MeshPart() = default;
-        bool Create(Graphics::Device& device,const std::vector<TVertex>& vertices, const std::vector<uint32_t>& indices)
+        bool Create(Graphics::GeometryArena& arena, Graphics::Device& device, const std::vector<T>& vertices, const std::vector<uint32_t>& indices)
         {
-            if (!m_VertexBuffer.Initialize(device, Graphics::BufferType::VertexBuffer, vertices.data(), sizeof(vertices), sizeof(T)))
+            // Geometry is packed into the shared arena of this vertex layout, the part only keeps its range
+            m_Handle = arena.Allocate(device.GetContext(), vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+            if (m_Handle == Graphics::InvalidGeometry)
                 return false;
 
-            if (!m_IndexBuffer.Initialize(device, Graphics::BufferType::IndexBuffer, indices.data(), sizeof(indices), sizeof(uint32_t)))
-                return false;
-
-            m_IndexCount = static_cast<uint32_t>(indices.size());
+            m_Arena = &arena;
 
             return true;
         }
-        void Bind(Graphics::CommandList& commandList, Graphics::Device& device)
+        void Bind(Graphics::CommandList& commandList, Graphics::Device& device, Graphics::VertexStream streams = Graphics::VertexStream::All)
+        {
+            m_Arena->Bind(commandList, streams); // Position only for depth passes when the arena is split
+        }
+        void Release()
         {
-            m_VertexBuffer.Bind(device.GetContext());
-			m_IndexBuffer.Bind(device.GetContext());
+            if (m_Arena)
+                m_Arena->Free(m_Handle);
+
+            m_Arena = nullptr;
+            m_Handle = Graphics::InvalidGeometry;
         }
-        Graphics::Buffer m_VertexBuffer;
-        Graphics::Buffer m_IndexBuffer;
-        uint32_t m_IndexCount { 0 };
+        const Graphics::GeometryRange& GetRange() const { return m_Arena->GetRange(m_Handle); } // (firstIndex, baseVertex, indexCount), moves on Compact
+        bool IsSplit() const { return m_Arena && m_Arena->IsSplit(); } // Positions and attributes in separate streams
+
+        Graphics::GeometryArena* m_Arena { nullptr };
+        Graphics::GeometryHandle m_Handle { Graphics::InvalidGeometry };
 
     };
 
@@ -55,12 +72,14 @@ namespace Core
     {
     public:
         virtual ~IMesh() = default;
-        virtual void Draw(Graphics::CommandList& cmdList, Graphics::Device& device) = 0;
-		virtual void Initialize(Graphics::Device& device) = 0;
+        virtual void Draw(Graphics::CommandList& cmdList, Graphics::Device& device, Graphics::ConstantBufferRing& constantRing) = 0;
+        virtual void Enqueue(Graphics::RenderQueue& queue, Graphics::Device& device, Graphics::ConstantBufferRing& constantRing, const DirectX::XMMATRIX& world, const Graphics::Pipeline& pipeline, uint32_t pipelineId, const Graphics::Pipeline* instancedPipeline = nullptr) = 0; // world from the frame packet, not the live mesh
+		virtual void Initialize(Graphics::Device& device, Graphics::GeometryArena& arena) = 0;
         bool m_IsLoop { false };
 		virtual void SetPosition(const DirectX::XMFLOAT3& position) = 0;
 		virtual void SetRotation(const DirectX::XMFLOAT3& rotation) = 0;
         virtual void SetScale(const DirectX::XMFLOAT3& scale) = 0;
+        virtual DirectX::XMMATRIX GetWorldMatrix() const = 0;
         virtual Graphics::VertexInputElement GetVertexInputElement() const;
 
     };
@@ -77,22 +96,60 @@ namespace Core
         {
             //m_Vertices.assign(vertices, vertices + sizeof(vertices) / sizeof(TVertex));
             //m_Indices.assign(indices, indices + sizeof(indices) / sizeof(uint32_t));
-            Initialize(device);
 		}
 
-        void Initialize(Graphics::Device& device) override
+        void Initialize(Graphics::Device& device, Graphics::GeometryArena& arena) override
         {
-			m_MeshPart.Create(device, m_Vertices, m_Indices);   
-			m_ConstantBuffer.Initialize(device, Graphics::BufferType::ConstantBuffer, &m_WorldMatrix, sizeof(DirectX::XMMATRIX));
+			m_MeshPart.Create(arena, device, m_Vertices, m_Indices);   
 		}
 
-        void Draw(Graphics::CommandList& cmdList, Graphics::Device& device) override
+        void Draw(Graphics::CommandList& cmdList, Graphics::Device& device, Graphics::ConstantBufferRing& constantRing) override
         {
-			m_ConstantBuffer.Bind(device.GetContext(), 1); // Bind constant buffer to slot 1 for vertex shader
-            m_MeshPart.Bind(cmdList, device);
+            // Per-mesh data {camera, ligth, etc..} is sub-allocated from the shared ring every frame
+            Graphics::ConstantAllocation allocation {};
+            if (!constantRing.Allocate(device.GetContext(), &m_WorldMatrix, sizeof(DirectX::XMMATRIX), allocation))
+                return;
+
+			cmdList.SetConstantBuffer(allocation, 1); // Bind constant buffer to slot 1 for vertex shader
+            m_MeshPart.Bind(cmdList, device); // Same arena buffers for every mesh of this layout
+
+            const Graphics::GeometryRange& range = m_MeshPart.GetRange();
 
             cmdList.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			cmdList.DrawIndexed(m_MeshPart.m_IndexCount, 0, 0); // Draw the mesh using indexed drawing
+			cmdList.DrawIndexed(range.indexCount, range.firstIndex, range.baseVertex); // Draw the mesh using indexed drawing
+        }
+
+        void Enqueue(Graphics::RenderQueue& queue, Graphics::Device& device, Graphics::ConstantBufferRing& constantRing, const DirectX::XMMATRIX& world, const Graphics::Pipeline& pipeline, uint32_t pipelineId, const Graphics::Pipeline* instancedPipeline = nullptr) override
+        {
+            Graphics::DrawPacket packet {};
+
+            // Instanced meshes carry the world matrix in the instance stream, no ring space needed
+            if (!instancedPipeline && !constantRing.Allocate(device.GetContext(), &world, sizeof(DirectX::XMMATRIX), packet.constants))
+                return;
+
+            const Graphics::GeometryRange& range = m_MeshPart.GetRange();
+
+            // Depth from the mesh translation, normalized to the far plane
+            float viewDepth = DirectX::XMVectorGetZ(world.r[3]) / 1000.0f;
+
+            // The geometry handle as material keeps copies of a mesh adjacent, so they batch into one instanced draw
+            packet.sortKey = Graphics::RenderQueue::MakeSortKey(Graphics::RenderPassType::Opaque, pipelineId, m_MeshPart.m_Handle, viewDepth);
+            packet.pipeline = &pipeline;
+            packet.instancedPipeline = instancedPipeline;
+            packet.vertexBuffer = m_MeshPart.m_Arena->GetVertexBuffer();
+            packet.indexBuffer = m_MeshPart.m_Arena->GetIndexBuffer();
+            packet.vertexStride = m_MeshPart.m_Arena->GetVertexStride();
+            packet.attributeBuffer = m_MeshPart.m_Arena->GetAttributeBuffer();
+            packet.attributeStride = m_MeshPart.m_Arena->GetAttributeStride();
+            packet.indexFormat = m_MeshPart.m_Arena->GetIndexFormat();
+            packet.indexCount = range.indexCount;
+            packet.startIndex = range.firstIndex;
+            packet.baseVertex = range.baseVertex;
+
+            if (instancedPipeline)
+                queue.Push(packet, &world);
+            else
+                queue.Push(packet);
         }
 
 
@@ -108,47 +165,74 @@ namespace Core
         {
             m_WorldMatrix = DirectX::XMMatrixScaling(scale.x, scale.y, scale.z);
 		}
+        DirectX::XMMATRIX GetWorldMatrix() const override { return m_WorldMatrix; }
 
-        Graphics::VertexType GetVertexInputElement() const override
+        Graphics::VertexInputElement GetVertexInputElement() const override
         {
-            Graphics::VertexInputElement layout {};
+            // Resolved at compile time, unknown vertex types do not build
+            if (m_MeshPart.IsSplit())
+                return Graphics::VertexInputElement::CreateStreams<TVertex>();
 
-            if(std::is_same<TVertex, Graphics::VertexPosition>::value)
-            {
-                layout.Add(Graphics::VertexType::Position);
-                return layout;
-			}
-
-            if (typedef(TVertex) == Graphics::VertexPositionColor)
-            {
-                layout.Add(Graphics::VertexType::Position);
-                layout.Add(Graphics::VertexType::Color);
-                return layout;
-            }
-
-            return layout;
-		}
+            return Graphics::VertexInputElement::Create<TVertex>();
+        }
 
         Core::MeshPart<TVertex> m_MeshPart;
         DirectX::XMMATRIX m_WorldMatrix { DirectX::XMMatrixIdentity() };
-		Graphics::Buffer m_ConstantBuffer; // Constant buffer for per-mesh data {camera, ligth, etc..} 
 		bool m_IsLoop { false };
     };
 
+    // One frame as recorded by the game thread. The render thread runs the resource commands first, so a mesh
+    // created this frame is drawn in the same frame, and the draws only read what was copied in here.
+    struct FramePacket
+    {
+        struct DrawItem
+        {
+            IMesh* mesh { nullptr };
+            DirectX::XMMATRIX world;
+        };
+
+        std::vector<std::function<void(Graphics::Device& device)>> resourceCommands; // Create/destroy, render thread only
+        std::vector<DrawItem> draws;
+
+        void Clear() // Keeps the capacity, the packet is reused every other frame
+        {
+            resourceCommands.clear();
+            draws.clear();
+        }
+    };
+
 	class RenderSystem
 	{
 	public:
 		RenderSystem() = default;
-        void Initialize(uint32_t width, uint32_t height)
+        // backend: headless, no adapter or D3D11 device (NullBackend for CPU benchmarks), must outlive the render system
+        void Initialize(uint32_t width, uint32_t height, Graphics::RenderBackend* backend = nullptr)
         {
             m_Width = width;
             m_Height = height;
 
 
-            m_Adapter.Initialize(0); // Initialize the first GPU adapter (0)
-            m_Device.Initialize(m_Adapter); // Initialize the Direct3D device using the adapter
-            m_SwapChain.Initialize(m_Device, nullptr, m_Width, m_Height); // Initialize the swap chain with the device and window handle
-            m_CommandList.Initialize(m_Device.GetContext()); // Initialize the command list with the device context
+            if (backend)
+            {
+                m_Device.Initialize(*backend);
+                m_SwapChain.Initialize(m_Device, nullptr, m_Width, m_Height); // Offscreen targets, presented to the backend
+                m_CommandList.Initialize(*backend);
+            }
+            else
+            {
+                m_Adapter.Initialize(0); // Initialize the first GPU adapter (0)
+                m_Device.Initialize(m_Adapter); // Initialize the Direct3D device using the adapter
+                m_SwapChain.Initialize(m_Device, nullptr, m_Width, m_Height); // Initialize the swap chain with the device and window handle
+                m_CommandList.Initialize(m_Device.GetContext()); // Initialize the command list with the device context
+            }
+            m_ConstantRing.Initialize(m_Device); // Shared per-frame constant data for all meshes
+            m_UploadHeap.Initialize(m_Device); // Streaming geometry (UI, debug lines, particles)
+            m_BufferPool.Initialize(m_Device); // Recycles buffers of meshes created and destroyed at runtime
+            m_GeometryArena.InitializeSplit(m_Device, sizeof(Graphics::VertexPositionColor), Graphics::GetPositionStreamStride<Graphics::VertexPositionColor>()); // Static meshes with the VertexPositionColor layout, position stream apart for depth passes
+            m_JobSystem.Initialize(); // One worker per hardware thread, this thread is worker 0
+            if (!backend) // Left uninitialized it submits everything on m_CommandList
+                m_ParallelSubmitter.Initialize(m_Device, 4); // Deferred contexts, only used once the queue is big enough to split
+            m_ParallelSubmitter.SetJobSystem(&m_JobSystem);
 
             // Clear mesh list
             m_Meshes.clear();
@@ -175,31 +259,61 @@ namespace Core
             Mesh<Graphics::VertexPositionColor> model { m_Device, "../model.gltf"};
 			m_Meshes.push_back(model);
 
-
+            // From here on only the render thread touches the context and the command list
+            m_RenderThread.Start([this](FramePacket& packet) { ExecuteFrame(packet); }, 2);
 
 
         }
+        // Game thread: records the frame into a packet and hands it over, stalls only when a whole frame ahead
         void RenderLoop(const std::function<void()>& on_thread_begin)
         {
             on_thread_begin();
 
+            FramePacket& packet = m_RenderThread.BeginFrame();
+            packet.Clear();
+
             for (auto& mesh : m_Meshes)
             {
                 if (!mesh.m_IsLoop)
                 {
-                    mesh.Initialize(m_Device);
+                    IMesh* created = &mesh;
+                    packet.resourceCommands.push_back([this, created](Graphics::Device& device) { created->Initialize(device, m_GeometryArena); });
                     mesh.m_IsLoop = true; // Set the mesh to loop
                 }
-                else
-                {
-                    m_CommandList.SetPipelineState(m_Pipeline);
-                    mesh.Draw(m_CommandList, m_Device);
-
-                    m_CommandList.DrawIndexed(12, 12, 12);
-                }
 
+                packet.draws.push_back({ &mesh, mesh.GetWorldMatrix() });
             }
 
+            m_RenderThread.Submit();
+        }
+        // Render thread: owns the device context, the command list and every per-frame ring
+        void ExecuteFrame(FramePacket& packet)
+        {
+            for (const auto& command : packet.resourceCommands)
+                command(m_Device);
+
+            m_CommandList.ResetStats();
+
+            m_ConstantRing.BeginFrame(m_Device.GetContext());
+            m_RenderQueue.Clear();
+            m_UploadHeap.BeginFrame();
+            m_BufferPool.BeginFrame(m_Device.GetContext());
+
+            for (const FramePacket::DrawItem& draw : packet.draws)
+                draw.mesh->Enqueue(m_RenderQueue, m_Device, m_ConstantRing, draw.world, m_Pipeline, 0, &m_InstancedPipeline);
+
+            // Sorted by pass/pipeline/material/depth so consecutive draws share as much state as possible
+            m_RenderQueue.Sort();
+            m_RenderQueue.PrepareInstances(m_Device.GetContext(), m_UploadHeap, m_ConstantRing);
+            m_ParallelSubmitter.Submit(m_Device, m_CommandList, m_RenderQueue, [this](Graphics::CommandList& commandList)
+            {
+                commandList.SetRenderPass(m_SwapChain.GetRenderPass());
+                commandList.SetViewport(static_cast<float>(m_Width), static_cast<float>(m_Height));
+            });
+
+            m_ConstantRing.EndFrame(m_Device.GetContext());
+            m_BufferPool.EndFrame(m_Device.GetContext());
+
     //        for (auto& mesh : m_Meshes)
     //        {
     //            m_CommandList.SetPipelineState(m_Pipeline);
@@ -209,6 +323,8 @@ namespace Core
     //        }
         }
 		void Cleanup();
+        void FlushRenderThread() { m_RenderThread.Flush(); } // Before touching GPU resources from the game thread (resize, shutdown)
+        Core::RenderThreadStats GetRenderThreadStats() const { return m_RenderThread.GetStats(); }
 		void RenderOneFrame();
 
 
@@ -217,6 +333,16 @@ namespace Core
         Graphics::SwapChain m_SwapChain;
         Graphics::CommandList m_CommandList;
         Graphics::Pipeline m_Pipeline;
+        Graphics::Pipeline m_InstancedPipeline; // VSInstanced, world matrix in slot 1
+        Graphics::Pipeline m_DepthPipeline; // VSDepth, depth only, position stream only
+        Graphics::ConstantBufferRing m_ConstantRing;
+        Graphics::TransientUploadHeap m_UploadHeap;
+        Graphics::BufferPool m_BufferPool;
+        Graphics::GeometryArena m_GeometryArena;
+        Graphics::RenderQueue m_RenderQueue;
+        Graphics::ParallelSubmitter m_ParallelSubmitter;
+        Core::JobSystem m_JobSystem; // Culling, animation, asset decode and command recording fan out here
+        Core::RenderThread<FramePacket> m_RenderThread; // Double buffered, two packets
 
         std::vector<Core::IMesh> m_Meshes;
 
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "SpscQueue.h"
+#include "FramePipeline.h"
+#include "Profiler.h"
+
+namespace Core
+{
+	struct RenderThreadStats
+	{
+		uint64_t framesSubmitted = 0;
+		uint64_t framesExecuted = 0;
+		uint32_t maxQueueDepth = 0; // Packets submitted but not picked up yet, at most packetCount
+		FrameStageStats gameStall; // Game thread waiting for a free packet: render bound
+		FrameStageStats renderIdle; // Render thread waiting for a packet: game bound
+		FrameStageStats execute;
+		FrameStageStats latency; // Submit() to the end of execution
+	};
+
+	// Blocks one thread until a condition holds. The waiter flags itself before re-checking, the signaller checks
+	// the flag after publishing, and a full fence on both sides guarantees one of them sees the other.
+	class ThreadDoorbell
+	{
+	public:
+		template <typename TReady>
+		void Wait(const TReady& ready)
+		{
+			// Frames arrive every few milliseconds, a short spin catches the common case without a syscall
+			for (uint32_t spin = 0; spin < 64; ++spin)
+			{
+				if (ready())
+					return;
+				std::this_thread::yield();
+			}
+
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Waiting.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			m_Ready.wait(lock, ready);
+			m_Waiting.store(false, std::memory_order_relaxed);
+		}
+
+		void Ring()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!m_Waiting.load(std::memory_order_relaxed))
+				return;
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Ready.notify_one();
+		}
+
+	private:
+		std::mutex m_Mutex;
+		std::condition_variable m_Ready;
+		std::atomic<bool> m_Waiting { false };
+	};
+
+	// A thread that owns the device context and executes frame packets (draw lists, constant data, resource
+	// create/destroy commands) recorded on the game thread. Packets travel through two SPSC queues, game to
+	// render and back, so nothing on the data path takes a lock.
+	//
+	// packetCount 2 is double buffering: the game thread records frame N+1 while frame N executes, and stalls in
+	// BeginFrame() when it gets a whole frame ahead. A packet comes back with the contents of packetCount frames
+	// ago, the game thread clears or overwrites it.
+	template <typename TPacket>
+	class RenderThread
+	{
+	public:
+		using Executor = std::function<void(TPacket& packet)>;
+
+		RenderThread() = default;
+		~RenderThread() { Stop(); }
+		RenderThread(const RenderThread&) = delete;
+		RenderThread& operator=(const RenderThread&) = delete;
+
+		bool Start(Executor executor, uint32_t packetCount = 2)
+		{
+			if (m_Thread.joinable() || !executor || packetCount == 0)
+				return false;
+
+			m_Executor = std::move(executor);
+			m_Entries.clear();
+			m_Pending.reset(new SpscQueue<Entry*>(packetCount));
+			m_Free.reset(new SpscQueue<Entry*>(packetCount));
+
+			for (uint32_t i = 0; i < packetCount; ++i)
+			{
+				m_Entries.emplace_back(new Entry());
+				m_Free->TryPush(m_Entries.back().get());
+			}
+
+			m_Current = nullptr;
+			m_Submitted = 0;
+			m_Executed = 0;
+			m_Stop = false;
+			m_Stats = {};
+
+			m_Thread = std::thread(&RenderThread::ThreadLoop, this);
+			return true;
+		}
+
+		// Executes every packet already submitted, then joins
+		void Stop()
+		{
+			if (!m_Thread.joinable())
+				return;
+
+			m_Stop.store(true);
+			m_RenderBell.Ring();
+			m_Thread.join();
+		}
+
+		// Game thread. The packet belongs to the caller until Submit().
+		TPacket& BeginFrame()
+		{
+			Clock::time_point waitStart = Clock::now();
+
+			Entry* entry = nullptr;
+			m_GameBell.Wait([this, &entry]() { return m_Free->TryPop(entry); });
+
+			{
+				std::lock_guard<std::mutex> lock(m_StatsMutex);
+				m_Stats.gameStall.Record(Milliseconds(waitStart, Clock::now()));
+			}
+
+			m_Current = entry;
+			return entry->packet;
+		}
+
+		// Game thread, hands the packet from BeginFrame() to the render thread
+		void Submit()
+		{
+			if (!m_Current)
+				return;
+
+			m_Current->submitted = Clock::now();
+			m_Pending->TryPush(m_Current); // Cannot fail, the ring holds every packet
+			m_Current = nullptr;
+			m_Submitted.fetch_add(1, std::memory_order_relaxed);
+			m_RenderBell.Ring();
+
+			uint32_t depth = m_Pending->GetSize();
+			std::lock_guard<std::mutex> lock(m_StatsMutex);
+			m_Stats.framesSubmitted++;
+			if (depth > m_Stats.maxQueueDepth)
+				m_Stats.maxQueueDepth = depth;
+		}
+
+		// Game thread, returns once everything submitted so far has executed (resize, shutdown, readbacks)
+		void Flush()
+		{
+			const uint64_t submitted = m_Submitted.load(std::memory_order_relaxed);
+			m_GameBell.Wait([this, submitted]() { return m_Executed.load(std::memory_order_acquire) >= submitted; });
+		}
+
+		bool IsRenderThread() const { return std::this_thread::get_id() == m_Thread.get_id(); }
+		uint32_t GetPacketCount() const { return static_cast<uint32_t>(m_Entries.size()); }
+
+		RenderThreadStats GetStats() const
+		{
+			std::lock_guard<std::mutex> lock(m_StatsMutex);
+			return m_Stats;
+		}
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Entry
+		{
+			TPacket packet {};
+			Clock::time_point submitted;
+		};
+
+		static double Milliseconds(Clock::time_point begin, Clock::time_point end)
+		{
+			return std::chrono::duration<double, std::milli>(end - begin).count();
+		}
+
+		void ThreadLoop()
+		{
+			Profiler::SetThreadName("Render");
+
+			while (true)
+			{
+				Clock::time_point waitStart = Clock::now();
+
+				Entry* entry = nullptr;
+				m_RenderBell.Wait([this, &entry]() { return m_Pending->TryPop(entry) || m_Stop.load(); });
+
+				// Stop only wins once the queue is drained
+				if (!entry && !m_Pending->TryPop(entry))
+					break;
+
+				Clock::time_point executeStart = Clock::now();
+				m_Executor(entry->packet);
+				Clock::time_point executeEnd = Clock::now();
+
+				{
+					std::lock_guard<std::mutex> lock(m_StatsMutex);
+					m_Stats.renderIdle.Record(Milliseconds(waitStart, executeStart));
+					m_Stats.execute.Record(Milliseconds(executeStart, executeEnd));
+					m_Stats.latency.Record(Milliseconds(entry->submitted, executeEnd));
+					m_Stats.framesExecuted++;
+				}
+
+				m_Free->TryPush(entry);
+				m_Executed.fetch_add(1, std::memory_order_release);
+				m_GameBell.Ring();
+			}
+		}
+
+		Executor m_Executor;
+		std::vector<std::unique_ptr<Entry>> m_Entries;
+		std::unique_ptr<SpscQueue<Entry*>> m_Pending; // Game -> render
+		std::unique_ptr<SpscQueue<Entry*>> m_Free; // Render -> game
+		Entry* m_Current = nullptr; // Being recorded, game thread only
+
+		ThreadDoorbell m_RenderBell;
+		ThreadDoorbell m_GameBell;
+		std::atomic<uint64_t> m_Submitted { 0 };
+		std::atomic<uint64_t> m_Executed { 0 };
+		std::atomic<bool> m_Stop { false };
+		std::thread m_Thread;
+
+		mutable std::mutex m_StatsMutex; // Metrics only, once per frame on each side
+		RenderThreadStats m_Stats;
+	};
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Core
+{
+	// Bounded single-producer single-consumer ring. Lock-free and wait-free: one thread only calls TryPush(),
+	// one other thread only calls TryPop(). Each side caches the other's index and only reloads it when the
+	// ring looks full (or empty), so the shared cache lines are touched about once per wrap instead of per item.
+	template <typename T>
+	class SpscQueue
+	{
+	public:
+		explicit SpscQueue(uint32_t capacity = 64) // Rounded up to a power of two
+		{
+			uint32_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+
+			m_Mask = size - 1;
+			m_Items.reset(new T[size]);
+		}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		// Producer thread only, false when full
+		bool TryPush(T item)
+		{
+			const uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+			if (tail - m_CachedHead > m_Mask)
+			{
+				m_CachedHead = m_Head.load(std::memory_order_acquire);
+				if (tail - m_CachedHead > m_Mask)
+					return false;
+			}
+
+			m_Items[tail & m_Mask] = std::move(item);
+			m_Tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer thread only, false when empty
+		bool TryPop(T& item)
+		{
+			const uint64_t head = m_Head.load(std::memory_order_relaxed);
+			if (head == m_CachedTail)
+			{
+				m_CachedTail = m_Tail.load(std::memory_order_acquire);
+				if (head == m_CachedTail)
+					return false;
+			}
+
+			item = std::move(m_Items[head & m_Mask]);
+			m_Head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		uint32_t GetSize() const { return static_cast<uint32_t>(m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire)); } // A hint from any thread
+		uint32_t GetCapacity() const { return m_Mask + 1; }
+
+	private:
+		// Producer and consumer lines apart. Padding instead of alignas, C++14 new ignores over-alignment.
+		std::atomic<uint64_t> m_Tail { 0 }; // Written by the producer
+		uint64_t m_CachedHead = 0; // Producer's copy of m_Head
+		char m_TailPadding[64 - sizeof(std::atomic<uint64_t>) - sizeof(uint64_t)];
+
+		std::atomic<uint64_t> m_Head { 0 }; // Written by the consumer
+		uint64_t m_CachedTail = 0; // Consumer's copy of m_Tail
+		char m_HeadPadding[64 - sizeof(std::atomic<uint64_t>) - sizeof(uint64_t)];
+
+		std::unique_ptr<T[]> m_Items;
+		uint32_t m_Mask = 0;
+	};
+}
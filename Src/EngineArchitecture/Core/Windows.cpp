@@ -4,6 +4,7 @@
 #include <iostream>
 #include <functional>
 #include "Windows.h"
+#include "Profiler.h"
 
 
 namespace Core
@@ -57,6 +58,8 @@ namespace Core
 
 		while (!done)
 		{
+			PROFILE_ZONE("Windows::RenderLoop"); // One zone per iteration, the loop itself lasts the whole run
+
 			// Handle the windows messages.
 			if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 			{
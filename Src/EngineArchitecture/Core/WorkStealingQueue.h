@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Core
+{
+	// Chase-Lev deque with the memory orderings of Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models".
+	// The owner thread pushes and pops at the bottom (LIFO, cache warm), any thread steals from the top (FIFO, the
+	// oldest and usually biggest work). Fixed capacity: Push() returns false when full and the caller runs the item itself.
+	template <typename T>
+	class WorkStealingQueue
+	{
+	public:
+		explicit WorkStealingQueue(uint32_t capacity = 4096) // Rounded up to a power of two
+		{
+			uint32_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+
+			m_Mask = size - 1;
+			m_Items.reset(new std::atomic<T*>[size]);
+		}
+
+		WorkStealingQueue(const WorkStealingQueue&) = delete;
+		WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+
+		// Owner thread only
+		bool Push(T* item)
+		{
+			int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			if (bottom - top > static_cast<int64_t>(m_Mask))
+				return false;
+
+			m_Items[bottom & m_Mask].store(item, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_Bottom.store(bottom + 1, std::memory_order_release); // Free on x86, and lets thread sanitizers see the publication
+
+			return true;
+		}
+
+		// Owner thread only, nullptr when empty
+		T* Pop()
+		{
+			int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+			m_Bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_Top.load(std::memory_order_relaxed);
+
+			if (top > bottom)
+			{
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			T* item = m_Items[bottom & m_Mask].load(std::memory_order_relaxed);
+			if (top == bottom)
+			{
+				// Last item, race the thieves for it
+				if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					item = nullptr;
+				m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			return item;
+		}
+
+		// Any thread, nullptr when empty or when another thief won the race
+		T* Steal()
+		{
+			int64_t top = m_Top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+			if (top >= bottom)
+				return nullptr;
+
+			T* item = m_Items[top & m_Mask].load(std::memory_order_relaxed);
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+
+			return item;
+		}
+
+		bool IsEmpty() const { return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed); } // A hint, stale by the time it returns
+
+	private:
+		// Thieves and owner on separate cache lines. Padding instead of alignas, C++14 new ignores over-alignment.
+		std::atomic<int64_t> m_Top { 0 };
+		char m_TopPadding[64 - sizeof(std::atomic<int64_t>)];
+		std::atomic<int64_t> m_Bottom { 0 };
+		char m_BottomPadding[64 - sizeof(std::atomic<int64_t>)];
+		std::unique_ptr<std::atomic<T*>[]> m_Items;
+		uint32_t m_Mask = 0;
+	};
+}
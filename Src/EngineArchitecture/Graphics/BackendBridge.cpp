@@ -0,0 +1,116 @@
+#include "BackendBridge.h"
+#include "Pipeline.h"
+
+namespace Graphics
+{
+	namespace BackendBridge
+	{
+		bool CreateBuffer(RenderBackend* backend, ID3D11Device* device, const D3D11_BUFFER_DESC& desc, const void* initialData, ID3D11Buffer** buffer)
+		{
+			if (!backend)
+			{
+				D3D11_SUBRESOURCE_DATA data = {};
+				data.pSysMem = initialData;
+				return SUCCEEDED(device->CreateBuffer(&desc, initialData ? &data : nullptr, buffer));
+			}
+
+			BackendBufferDesc backendDesc;
+			backendDesc.kind =
+				(desc.BindFlags & D3D11_BIND_INDEX_BUFFER) ? BackendBufferKind::Index :
+				(desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) ? BackendBufferKind::Constant :
+				BackendBufferKind::Vertex;
+			backendDesc.size = desc.ByteWidth;
+			backendDesc.dynamic = desc.Usage == D3D11_USAGE_DYNAMIC;
+
+			*buffer = FromBackendHandle<ID3D11Buffer>(backend->CreateBuffer(backendDesc, initialData));
+			return *buffer != nullptr;
+		}
+
+		void* Map(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* buffer, D3D11_MAP mapType)
+		{
+			if (backend)
+				return backend->Map(ToBackendHandle(buffer), mapType == D3D11_MAP_WRITE_NO_OVERWRITE ? BackendMap::NoOverwrite : BackendMap::Discard);
+
+			D3D11_MAPPED_SUBRESOURCE mapped = {};
+			if (FAILED(context->Map(buffer, 0, mapType, 0, &mapped)))
+				return nullptr;
+
+			return mapped.pData;
+		}
+
+		void Unmap(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* buffer, uint32_t writtenOffset, uint32_t writtenSize)
+		{
+			if (backend)
+				backend->Unmap(ToBackendHandle(buffer), writtenOffset, writtenSize);
+			else
+				context->Unmap(buffer, 0);
+		}
+
+		void UpdateBuffer(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* buffer, uint32_t offset, const void* data, uint32_t size)
+		{
+			if (backend)
+			{
+				backend->UpdateBuffer(ToBackendHandle(buffer), offset, data, size);
+				return;
+			}
+
+			D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+			context->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+		}
+
+		void CopyBuffer(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* destination, uint32_t destinationOffset, ID3D11Buffer* source, uint32_t sourceOffset, uint32_t size)
+		{
+			if (backend)
+			{
+				backend->CopyBuffer(ToBackendHandle(destination), destinationOffset, ToBackendHandle(source), sourceOffset, size);
+				return;
+			}
+
+			D3D11_BOX box = { sourceOffset, 0, 0, sourceOffset + size, 1, 1 };
+			context->CopySubresourceRegion(destination, 0, destinationOffset, 0, 0, source, 0, &box);
+		}
+
+		void Release(RenderBackend* backend, ID3D11Buffer*& buffer)
+		{
+			if (!buffer)
+				return;
+
+			if (backend)
+				backend->Destroy(ToBackendHandle(buffer));
+			else
+				buffer->Release();
+
+			buffer = nullptr;
+		}
+
+		BackendPipelineDesc GetPipelineDesc(const PipelineDesc& desc)
+		{
+			BackendPipelineDesc backendDesc;
+
+			for (const D3D11_INPUT_ELEMENT_DESC& element : desc.vertexInputElement.GetInputElementDescriptions())
+			{
+				BackendVertexElement backendElement;
+				backendElement.semantic = element.SemanticName;
+				backendElement.semanticIndex = element.SemanticIndex;
+				backendElement.format = static_cast<BackendFormat>(element.Format);
+				backendElement.slot = element.InputSlot;
+				backendElement.offset = element.AlignedByteOffset;
+				backendElement.perInstance = element.InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA;
+				backendDesc.elements.push_back(backendElement);
+			}
+
+			backendDesc.vertexShaderEntry = desc.vertexShaderEntry;
+			backendDesc.pixelShaderEntry = desc.depthOnly ? nullptr : desc.pixelShaderEntry;
+			backendDesc.permutation = desc.permutation;
+
+			backendDesc.cullMode = static_cast<BackendCull>(desc.cullMode);
+			backendDesc.wireframe = desc.fillMode == D3D11_FILL_WIREFRAME;
+			backendDesc.depthEnabled = desc.depthEnabled;
+			backendDesc.depthWrite = desc.depthEnabled; // GetDepthStencilDesc always writes
+			backendDesc.depthFunc = static_cast<BackendCompare>(desc.depthFunc);
+			backendDesc.blendEnabled = desc.blendEnabled;
+			backendDesc.colorWrite = !desc.depthOnly;
+			return backendDesc;
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include "RenderBackend.h"
+
+namespace Graphics
+{
+	struct PipelineDesc;
+
+	// Resources created through a backend carry its handle in their D3D pointer fields, so everything that stores,
+	// compares and filters ID3D11Buffer* keeps working. The value only ever goes back to the backend, it is never dereferenced.
+	template <typename T>
+	T* FromBackendHandle(BackendHandle handle) { return reinterpret_cast<T*>(static_cast<uintptr_t>(handle)); }
+
+	inline BackendHandle ToBackendHandle(const void* object) { return static_cast<BackendHandle>(reinterpret_cast<uintptr_t>(object)); }
+
+	// Buffer calls shared by Buffer, BufferPool, ConstantBufferRing, UploadHeap and GeometryArena:
+	// they go to the backend when there is one and to the D3D11 device or context otherwise
+	namespace BackendBridge
+	{
+		bool CreateBuffer(RenderBackend* backend, ID3D11Device* device, const D3D11_BUFFER_DESC& desc, const void* initialData, ID3D11Buffer** buffer);
+		void* Map(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* buffer, D3D11_MAP mapType); // nullptr on failure
+		void Unmap(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* buffer, uint32_t writtenOffset, uint32_t writtenSize);
+		void UpdateBuffer(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* buffer, uint32_t offset, const void* data, uint32_t size);
+		void CopyBuffer(RenderBackend* backend, ID3D11DeviceContext* context, ID3D11Buffer* destination, uint32_t destinationOffset, ID3D11Buffer* source, uint32_t sourceOffset, uint32_t size);
+		void Release(RenderBackend* backend, ID3D11Buffer*& buffer);
+
+		BackendPipelineDesc GetPipelineDesc(const PipelineDesc& desc); // Semantic names point into desc
+	}
+}
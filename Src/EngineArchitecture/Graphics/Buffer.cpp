@@ -1,42 +1,139 @@
 #include "Buffer.h"
 #include "Device.h"
+#include "BufferPool.h"
+#include "IndexUtils.h"
+#include "BackendBridge.h"
+#include "../Core/Profiler.h"
+#include <cstring>
 #include <iostream>
 
 namespace Graphics
 {
+	static BufferUpdateStats s_TotalUpdateStats;
+
 	bool Buffer::Initialize(const Device& device, BufferType type, const void* data, uint32_t size, uint32_t stride)
 	{
 		m_Type = type;
 		m_Stride = stride;
 
+		std::vector<uint16_t> narrowed;
+		data = PrepareIndexData(data, size, narrowed);
+		m_Size = size;
+		m_Backend = device.GetBackend();
+
 		ID3D11Device* d3dDevice = device.GetDevice();
 
 		D3D11_BUFFER_DESC desc = {};
 		desc.ByteWidth = size;
-		desc.Usage = D3D11_USAGE_DEFAULT;
-		desc.Usage = (type == BufferType::ConstantBuffer) ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+
+		// Static geometry never changes after creation, let the driver place it for GPU reads only
+		desc.Usage =
+			(type == BufferType::ConstantBuffer || type == BufferType::InstanceBuffer) ? D3D11_USAGE_DYNAMIC :
+			data ? D3D11_USAGE_IMMUTABLE :
+			D3D11_USAGE_DEFAULT;
 
 		desc.BindFlags = 
-			(type == BufferType::VertexBuffer) ? D3D11_BIND_VERTEX_BUFFER :
+			(type == BufferType::VertexBuffer || type == BufferType::InstanceBuffer) ? D3D11_BIND_VERTEX_BUFFER :
 			(type == BufferType::IndexBuffer) ? D3D11_BIND_INDEX_BUFFER :
 			D3D11_BIND_CONSTANT_BUFFER;
 
-		desc.CPUAccessFlags = (type == BufferType::ConstantBuffer) ? D3D11_CPU_ACCESS_WRITE : 0;
+		desc.CPUAccessFlags = (desc.Usage == D3D11_USAGE_DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
 		desc.MiscFlags = 0;
 
-		D3D11_SUBRESOURCE_DATA initData = {};
-		initData.pSysMem = data;
+		m_Usage = desc.Usage;
 
-		HRESULT hr = d3dDevice->CreateBuffer(&desc, &initData, &m_Buffer);
-		if (FAILED(hr))
+		if (!BackendBridge::CreateBuffer(m_Backend, d3dDevice, desc, data, &m_Buffer))
 		{
 			std::cerr << "[Buffer] Failed to create buffer.\n";
 			return false;
 		}
 
+		if (type == BufferType::ConstantBuffer && data)
+			m_Shadow.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
 		return true;
 	}
 
+	bool Buffer::Initialize(BufferPool& pool, const Device& device, BufferType type, const void* data, uint32_t size, uint32_t stride)
+	{
+		m_Type = type;
+		m_Stride = stride;
+
+		std::vector<uint16_t> narrowed;
+		data = PrepareIndexData(data, size, narrowed);
+		m_Size = size;
+		m_Backend = device.GetBackend();
+		m_Usage = (type == BufferType::ConstantBuffer || type == BufferType::InstanceBuffer) ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+
+		uint32_t capacity = 0;
+		m_Buffer = pool.Acquire(type, m_Usage, size, capacity);
+		if (!m_Buffer)
+		{
+			std::cerr << "[Buffer] Failed to acquire pooled buffer.\n";
+			return false;
+		}
+
+		m_Pool = &pool;
+
+		if (!data)
+			return true;
+
+		// Pooled buffers are created without initial data, upload it into the (possibly recycled) buffer
+		ID3D11DeviceContext* context = device.GetContext();
+		if (m_Usage == D3D11_USAGE_DYNAMIC)
+		{
+			void* mapped = BackendBridge::Map(m_Backend, context, m_Buffer, D3D11_MAP_WRITE_DISCARD);
+			if (!mapped)
+			{
+				std::cerr << "[Buffer] Failed to map pooled buffer.\n";
+				return false;
+			}
+
+			memcpy(mapped, data, size);
+			BackendBridge::Unmap(m_Backend, context, m_Buffer, 0, size);
+
+			if (type == BufferType::ConstantBuffer)
+				m_Shadow.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+		}
+		else
+		{
+			BackendBridge::UpdateBuffer(m_Backend, context, m_Buffer, 0, data, size);
+		}
+
+		return true;
+	}
+
+	const void* Buffer::PrepareIndexData(const void* data, uint32_t& size, std::vector<uint16_t>& narrowed)
+	{
+		if (m_Type != BufferType::IndexBuffer)
+			return data;
+
+		if (m_Stride == 2)
+		{
+			m_Format = DXGI_FORMAT_R16_UINT;
+			return data;
+		}
+
+		m_Format = DXGI_FORMAT_R32_UINT;
+		m_Stride = 4;
+
+		// Indices that fit in 16 bits halve the index memory and bandwidth
+		const uint32_t* indices = static_cast<const uint32_t*>(data);
+		uint32_t count = size / sizeof(uint32_t);
+
+		if (!data || !CanNarrowIndices(indices, count))
+			return data;
+
+		narrowed.resize(count);
+		NarrowIndices(indices, narrowed.data(), count);
+
+		m_Format = DXGI_FORMAT_R16_UINT;
+		m_Stride = 2;
+		size = count * sizeof(uint16_t);
+
+		return narrowed.data();
+	}
+
 	void Buffer::Bind(ID3D11DeviceContext* context, uint32_t slot)
 	{
 		if (!m_Buffer || !context) return;
@@ -46,10 +143,11 @@ namespace Graphics
 		switch (m_Type)
 		{
 		case BufferType::VertexBuffer:
+		case BufferType::InstanceBuffer:
 			context->IASetVertexBuffers(slot, 1, &m_Buffer, &m_Stride, &offset);
 			break;
 		case BufferType::IndexBuffer:
-			context->IASetIndexBuffer(m_Buffer, DXGI_FORMAT_R32_UINT, 0);
+			context->IASetIndexBuffer(m_Buffer, m_Format, 0);
 			break;
 		case BufferType::ConstantBuffer:
 			context->VSSetConstantBuffers(slot, 1, &m_Buffer);
@@ -59,29 +157,64 @@ namespace Graphics
 
 	void Buffer::Update(ID3D11DeviceContext* context, const void* data, uint32_t size)
 	{
-		if (!m_Buffer || !context || m_Type != BufferType::ConstantBuffer)
+		if (!m_Buffer || (!context && !m_Backend) || m_Usage != D3D11_USAGE_DYNAMIC || size > m_Size)
 			return;
 
-		D3D11_MAPPED_SUBRESOURCE mapped = {};
-		HRESULT hr = context->Map(m_Buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-		if (SUCCEEDED(hr))
+		PROFILE_ZONE("Buffer::Update");
+
+		m_UpdateStats.updatesRequested++;
+		s_TotalUpdateStats.updatesRequested++;
+
+		// Mostly static objects hand in the same data every frame, compare against the shadow before touching the GPU.
+		// Instance streams change every frame and can be large, they skip the shadow.
+		if (m_Type == BufferType::ConstantBuffer && m_Shadow.size() == size && memcmp(m_Shadow.data(), data, size) == 0)
 		{
-			memcpy(mapped.pData, data, size);
-			context->Unmap(m_Buffer, 0);
+			m_UpdateStats.updatesSkipped++;
+			s_TotalUpdateStats.updatesSkipped++;
+			return;
+		}
+
+		// WRITE_DISCARD hands back fresh memory, so a changed buffer is always rewritten in full
+		void* mapped = BackendBridge::Map(m_Backend, context, m_Buffer, D3D11_MAP_WRITE_DISCARD);
+		if (mapped)
+		{
+			memcpy(mapped, data, size);
+			BackendBridge::Unmap(m_Backend, context, m_Buffer, 0, size);
+
+			if (m_Type == BufferType::ConstantBuffer)
+				m_Shadow.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+			m_UpdateStats.bytesWritten += size;
+			s_TotalUpdateStats.bytesWritten += size;
 		}
 		else
 		{
-			std::cerr << "[Buffer] Failed to map constant buffer.\n";
+			std::cerr << "[Buffer] Failed to map dynamic buffer.\n";
 		}
 	}
 
+	const BufferUpdateStats& Buffer::GetTotalUpdateStats()
+	{
+		return s_TotalUpdateStats;
+	}
+
+	void Buffer::ResetTotalUpdateStats()
+	{
+		s_TotalUpdateStats = {};
+	}
+
 	void Buffer::Release()
 	{
-		if (m_Buffer)
+		if (m_Buffer && m_Pool)
 		{
-			m_Buffer->Release();
+			m_Pool->Release(m_Buffer, m_Type, m_Usage, m_Size); // Recycled once in-flight frames retire
 			m_Buffer = nullptr;
+			m_Pool = nullptr;
 		}
+
+		BackendBridge::Release(m_Backend, m_Buffer);
+
+		m_Shadow.clear();
 	}
 
 	Buffer::~Buffer()
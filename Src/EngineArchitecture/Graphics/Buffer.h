@@ -3,6 +3,7 @@
 
 #include <d3d11.h>
 #include <cstdint>
+#include <vector>
 
 
 namespace Graphics
@@ -11,10 +12,20 @@ namespace Graphics
 	{
 		VertexBuffer,
 		IndexBuffer,
-		ConstantBuffer
+		ConstantBuffer,
+		InstanceBuffer // Per-instance vertex stream, rewritten every frame
 	};
 
 	class Device;
+	class BufferPool;
+	class RenderBackend;
+
+	struct BufferUpdateStats
+	{
+		uint64_t updatesRequested = 0;
+		uint64_t updatesSkipped = 0; // Update() calls whose data matched the shadow copy, no Map issued
+		uint64_t bytesWritten = 0; // Bytes actually copied into mapped GPU memory
+	};
 
 	class Buffer
 	{
@@ -23,18 +34,35 @@ namespace Graphics
 		~Buffer();
 
 		bool Initialize(const Device& device, BufferType type, const void* data, uint32_t size, uint32_t stride = 0);
+		bool Initialize(BufferPool& pool, const Device& device, BufferType type, const void* data, uint32_t size, uint32_t stride = 0); // Recycled buffer for runtime-created meshes
 		void Bind(ID3D11DeviceContext* context, uint32_t slot = 0);
-		void Update(ID3D11DeviceContext* context, const void* newData, uint32_t size);
+		void Update(ID3D11DeviceContext* context, const void* newData, uint32_t size); // context may be nullptr on a backend device
 
 		void Release();
 
 		ID3D11Buffer* GetBuffer() const { return m_Buffer; }
 		BufferType GetType() const { return m_Type; }
 		uint32_t GetStride() const { return m_Stride; }
+		uint32_t GetSize() const { return m_Size; }
+		DXGI_FORMAT GetFormat() const { return m_Format; } // Index format, R16_UINT when the indices fit
+		const BufferUpdateStats& GetUpdateStats() const { return m_UpdateStats; }
+
+		static const BufferUpdateStats& GetTotalUpdateStats(); // Summed over every buffer since the last reset
+		static void ResetTotalUpdateStats();
 
 	private:
+		const void* PrepareIndexData(const void* data, uint32_t& size, std::vector<uint16_t>& narrowed);
+
 		ID3D11Buffer* m_Buffer = nullptr;
 		BufferType m_Type = BufferType::VertexBuffer;
-		uint32_t m_Stride = 0; // Needed only for vertex buffers
+		uint32_t m_Stride = 0; // Vertex stride or index size
+		DXGI_FORMAT m_Format = DXGI_FORMAT_UNKNOWN; // Needed only for index buffers
+		uint32_t m_Size = 0;
+		D3D11_USAGE m_Usage = D3D11_USAGE_DEFAULT;
+		BufferPool* m_Pool = nullptr; // Owner of m_Buffer when it came from a pool
+		RenderBackend* m_Backend = nullptr; // m_Buffer is a backend handle when set
+
+		std::vector<uint8_t> m_Shadow; // CPU copy of the constant buffer contents, used to skip redundant updates
+		BufferUpdateStats m_UpdateStats;
 	};
 }
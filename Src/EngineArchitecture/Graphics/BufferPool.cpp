@@ -0,0 +1,159 @@
+#include "BufferPool.h"
+#include "Device.h"
+#include "BackendBridge.h"
+#include <iostream>
+
+namespace Graphics
+{
+	bool BufferPool::Initialize(const Device& device, uint32_t framesInFlight, uint64_t budget)
+	{
+		m_Device = device.GetDevice();
+		m_Backend = device.GetBackend();
+		m_Budget = budget;
+		m_Stats = {};
+
+		if (!m_Fence.Initialize(device, framesInFlight))
+		{
+			std::cerr << "[BufferPool] Failed to create frame fence.\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	uint32_t BufferPool::GetSizeClass(uint32_t size)
+	{
+		uint32_t sizeClass = MinSizeClass;
+		while ((1u << sizeClass) < size && sizeClass < 31)
+			sizeClass++;
+
+		return sizeClass;
+	}
+
+	ID3D11Buffer* BufferPool::Acquire(BufferType type, D3D11_USAGE usage, uint32_t size, uint32_t& capacity)
+	{
+		if ((!m_Device && !m_Backend) || usage == D3D11_USAGE_IMMUTABLE)
+			return nullptr;
+
+		uint32_t key = MakeKey(type, usage, GetSizeClass(size));
+		capacity = GetCapacity(key);
+
+		m_Stats.acquires++;
+		m_Stats.bytesWasted += capacity - size;
+
+		auto it = m_FreeLists.find(key);
+		if (it != m_FreeLists.end() && !it->second.empty())
+		{
+			ID3D11Buffer* buffer = it->second.back();
+			it->second.pop_back();
+
+			m_Stats.hits++;
+			m_Stats.bytesPooled -= capacity;
+			return buffer;
+		}
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = capacity;
+		desc.Usage = usage;
+
+		desc.BindFlags =
+			(type == BufferType::VertexBuffer || type == BufferType::InstanceBuffer) ? D3D11_BIND_VERTEX_BUFFER :
+			(type == BufferType::IndexBuffer) ? D3D11_BIND_INDEX_BUFFER :
+			D3D11_BIND_CONSTANT_BUFFER;
+
+		desc.CPUAccessFlags = (usage == D3D11_USAGE_DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
+		desc.MiscFlags = 0;
+
+		ID3D11Buffer* buffer = nullptr;
+		if (!BackendBridge::CreateBuffer(m_Backend, m_Device, desc, nullptr, &buffer))
+		{
+			std::cerr << "[BufferPool] Failed to create buffer.\n";
+			m_Stats.bytesWasted -= capacity - size;
+			return nullptr;
+		}
+
+		return buffer;
+	}
+
+	void BufferPool::Release(ID3D11Buffer* buffer, BufferType type, D3D11_USAGE usage, uint32_t size)
+	{
+		if (!buffer)
+			return;
+
+		uint32_t key = MakeKey(type, usage, GetSizeClass(size));
+
+		m_Stats.bytesWasted -= GetCapacity(key) - size;
+		m_Stats.bytesPending += GetCapacity(key);
+
+		// The GPU may still reference this buffer, keep it out of the free lists until its frame retires
+		m_Pending.push_back({ buffer, key, m_Fence.GetFrame() });
+	}
+
+	void BufferPool::BeginFrame(ID3D11DeviceContext* context)
+	{
+		m_Fence.Poll(context);
+
+		// Frames complete in order, so do the pending buffers
+		while (!m_Pending.empty() && m_Fence.IsComplete(m_Pending.front().frame))
+		{
+			const PendingBuffer& pending = m_Pending.front();
+			uint32_t capacity = GetCapacity(pending.key);
+
+			m_FreeLists[pending.key].push_back(pending.buffer);
+			m_Stats.bytesPending -= capacity;
+			m_Stats.bytesPooled += capacity;
+
+			m_Pending.pop_front();
+		}
+
+		if (m_Budget && m_Stats.bytesPooled > m_Budget)
+			Trim(m_Budget);
+	}
+
+	void BufferPool::EndFrame(ID3D11DeviceContext* context)
+	{
+		m_Fence.Signal(context);
+	}
+
+	void BufferPool::Trim(uint64_t targetBytes)
+	{
+		for (auto it = m_FreeLists.rbegin(); it != m_FreeLists.rend() && m_Stats.bytesPooled > targetBytes; ++it)
+		{
+			uint32_t capacity = GetCapacity(it->first);
+			std::vector<ID3D11Buffer*>& buffers = it->second;
+
+			while (!buffers.empty() && m_Stats.bytesPooled > targetBytes)
+			{
+				BackendBridge::Release(m_Backend, buffers.back());
+				buffers.pop_back();
+
+				m_Stats.bytesPooled -= capacity;
+				m_Stats.bytesTrimmed += capacity;
+			}
+		}
+	}
+
+	void BufferPool::Release()
+	{
+		for (auto& freeList : m_FreeLists)
+		{
+			for (ID3D11Buffer*& buffer : freeList.second)
+				BackendBridge::Release(m_Backend, buffer);
+		}
+		m_FreeLists.clear();
+
+		for (PendingBuffer& pending : m_Pending)
+			BackendBridge::Release(m_Backend, pending.buffer);
+		m_Pending.clear();
+
+		m_Stats.bytesPooled = 0;
+		m_Stats.bytesPending = 0;
+
+		m_Fence.Release();
+	}
+
+	BufferPool::~BufferPool()
+	{
+		Release();
+	}
+}
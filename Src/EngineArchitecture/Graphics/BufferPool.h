@@ -0,0 +1,77 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+#include "Buffer.h"
+#include "FrameFence.h"
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace Graphics
+{
+	class Device;
+	class RenderBackend;
+
+	struct BufferPoolStats
+	{
+		uint64_t acquires = 0;
+		uint64_t hits = 0; // Acquires served from a free list instead of CreateBuffer
+		uint64_t bytesPooled = 0; // Free buffers ready for reuse
+		uint64_t bytesPending = 0; // Released buffers still waiting for their frames to retire
+		uint64_t bytesWasted = 0; // Rounding to the size class on buffers currently in use
+		uint64_t bytesTrimmed = 0; // Total released back to the driver by Trim
+
+		float GetHitRate() const { return acquires ? static_cast<float>(hits) / static_cast<float>(acquires) : 0.0f; }
+	};
+
+	// Recycles buffers by (BufferType, usage, power-of-two size class).
+	// Released buffers are only reused once the GPU has finished the frame they were released in, so in-flight frames never see them change.
+	class BufferPool
+	{
+	public:
+		static constexpr uint32_t MinSizeClass = 8; // 256 bytes
+
+		BufferPool() = default;
+		~BufferPool();
+
+		bool Initialize(const Device& device, uint32_t framesInFlight = 3, uint64_t budget = 64 * 1024 * 1024);
+		void Release();
+
+		ID3D11Buffer* Acquire(BufferType type, D3D11_USAGE usage, uint32_t size, uint32_t& capacity);
+		void Release(ID3D11Buffer* buffer, BufferType type, D3D11_USAGE usage, uint32_t size);
+
+		void BeginFrame(ID3D11DeviceContext* context); // Recycles the buffers of frames the GPU has finished
+		void EndFrame(ID3D11DeviceContext* context);
+		void Trim(uint64_t targetBytes); // Frees pooled buffers, largest classes first, until at most targetBytes stay pooled
+
+		void SetBudget(uint64_t budget) { m_Budget = budget; }
+		const BufferPoolStats& GetStats() const { return m_Stats; }
+
+		static uint32_t GetSizeClass(uint32_t size);
+
+	private:
+		struct PendingBuffer
+		{
+			ID3D11Buffer* buffer = nullptr;
+			uint32_t key = 0;
+			uint64_t frame = 0; // Frame the buffer was released in, reused once the fence has passed it
+		};
+
+		static uint32_t MakeKey(BufferType type, D3D11_USAGE usage, uint32_t sizeClass) { return (sizeClass << 16) | (static_cast<uint32_t>(usage) << 8) | static_cast<uint32_t>(type); }
+		static uint32_t GetCapacity(uint32_t key) { return 1u << (key >> 16); }
+
+		ID3D11Device* m_Device = nullptr;
+		RenderBackend* m_Backend = nullptr; // Pooled buffers are backend handles when set
+
+		std::map<uint32_t, std::vector<ID3D11Buffer*>> m_FreeLists; // Ordered by size class so Trim can start from the largest
+		std::deque<PendingBuffer> m_Pending;
+		FrameFence m_Fence;
+
+		uint64_t m_Budget = 0;
+
+		BufferPoolStats m_Stats;
+	};
+}
@@ -2,11 +2,16 @@
 #include "Device.h"
 #include "Adapter.h"
 #include "CommandList.h"
+#include "BackendBridge.h"
+#include "CommandTrace.h"
+#include "../Core/Profiler.h"
 
+#include <cstring>
 #include <iostream>
 #include <dxgi.h>
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <cstdint>
 
 #pragma comment(lib, "d3d11.lib")
@@ -19,14 +24,36 @@ namespace Graphics
 
 		m_Context = context;
 
+		if (m_Context)
+			m_Context->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_Context1);
+
+		InvalidateState();
 	}
+
+	void CommandList::Initialize(RenderBackend& backend)
+	{
+		m_Context = nullptr;
+		m_Context1 = nullptr;
+		m_Backend = &backend;
+
+		InvalidateState();
+	}
+
 	void CommandList::Release()
 	{
+		if (m_Context1)
+		{
+			m_Context1->Release();
+			m_Context1 = nullptr;
+		}
+
 		if (m_Context)
 		{
 			m_Context->Release();
 			m_Context = nullptr;
 		}
+
+		m_Backend = nullptr;
 	}
 
 
@@ -37,6 +64,15 @@ namespace Graphics
 		TextureData depthData = pass.GetDepthTexture().GetData();
 
 		
+		if (m_Backend)
+		{
+			if (colorData.isRenderTarget())
+				m_Backend->ClearColor(ToBackendHandle(pass.GetColorTexture().GetRenderTargetView()), color);
+			if (depthData.isDepthStencil())
+				m_Backend->ClearDepth(ToBackendHandle(pass.GetDepthTexture().GetDepthStencilView()), 1.0f);
+			return;
+		}
+		
 		if (colorData.isRenderTarget()) 
 			m_Context->ClearRenderTargetView(pass.GetColorTexture().GetRenderTargetView(), color);
 
@@ -45,55 +81,184 @@ namespace Graphics
 	}
 
 
+	void CommandList::InvalidateState()
+	{
+		m_State = {};
+	}
+
+	bool CommandList::Finish(ID3D11CommandList** commandList)
+	{
+		if (!IsDeferred())
+			return false;
+
+		HRESULT hr = m_Context->FinishCommandList(FALSE, commandList);
+
+		// FALSE resets the deferred context to default state, the shadow has to follow
+		InvalidateState();
+
+		if (FAILED(hr))
+		{
+			std::cerr << "[CommandList] Failed to finish command list.\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CommandList::Filter(bool redundant, TraceOp op)
+	{
+		if (redundant)
+		{
+			m_Stats.filtered++;
+			if (m_Capture)
+				m_Capture->RecordRedundant(op);
+		}
+		else
+			m_Stats.submitted++;
+
+		return redundant;
+	}
+
 	void CommandList::SetRenderPass(const RenderPass& pass)
 	{
 		// TODO: Check if pass is valid
 		TextureData colorData = pass.GetColorTexture().GetData();
 		TextureData depthData = pass.GetDepthTexture().GetData();
 
+		if (!colorData.isRenderTarget())
+			return;
+
 		ID3D11RenderTargetView* rtvs[8] = {};
 		for (uint32_t i = 0; i < 1; ++i)
 			rtvs[i] = pass.GetColorTexture().GetRenderTargetView();
 
-		if (colorData.isRenderTarget() && depthData.isDepthStencil()) 
-			m_Context->OMSetRenderTargets(1, rtvs, pass.GetDepthTexture().GetDepthStencilView());
+		ID3D11DepthStencilView* dsv = depthData.isDepthStencil() ? pass.GetDepthTexture().GetDepthStencilView() : nullptr;
+
+		if (Filter(m_State.renderTarget == rtvs[0] && m_State.depthStencil == dsv, TraceOp::SetRenderTargets))
+			return;
 
-		else if (colorData.isRenderTarget() && !depthData.isDepthStencil()) 
-			m_Context->OMSetRenderTargets(1, rtvs, nullptr);
+		if (m_Backend)
+			m_Backend->SetRenderTargets(ToBackendHandle(rtvs[0]), ToBackendHandle(dsv));
+		else
+			m_Context->OMSetRenderTargets(1, rtvs, dsv);
 
+		m_State.renderTarget = rtvs[0];
+		m_State.depthStencil = dsv;
 	}
 
 	void CommandList::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
 	{
-		if (m_Context)
+		if (HasTarget() && !Filter(m_State.topology == topology, TraceOp::SetTopology))
 		{
-			m_Context->IASetPrimitiveTopology(topology);
+			if (m_Backend)
+				m_Backend->SetTopology(static_cast<BackendTopology>(topology));
+			else
+				m_Context->IASetPrimitiveTopology(topology);
+			m_State.topology = topology;
 		}
 	}
 
 	void CommandList::DrawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation)
 	{
-		if (m_Context)
+		if (HasTarget())
+		{
+			if (m_Backend)
+				m_Backend->DrawIndexed(indexCount, 1, startIndexLocation, baseVertexLocation, 0);
+			else
+				m_Context->DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+			m_Stats.submitted++;
+			m_Stats.draws++;
+			m_Stats.instances++;
+		}
+	}
+	void CommandList::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+	{
+		if (HasTarget())
 		{
-			m_Context->DrawIndexed(indexCount, startIndexLocation, baseVertexLocation);
+			if (m_Backend)
+				m_Backend->DrawIndexed(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+			else
+				m_Context->DrawIndexedInstanced(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+			m_Stats.submitted++;
+			m_Stats.draws++;
+			m_Stats.instances += instanceCount;
 		}
 	}
+
 	void CommandList::SetPipelineState(const Pipeline& pipelineState)
 	{
-		if (pipelineState.GetInputLayout())
-			m_Context->IASetInputLayout(pipelineState.GetInputLayout());
-		if (pipelineState.GetVertexShader())
-			m_Context->VSSetShader(pipelineState.GetVertexShader(), nullptr, 0);
-		if (pipelineState.GetPixelShader())
-			m_Context->PSSetShader(pipelineState.GetPixelShader(), nullptr, 0);
-		if (pipelineState.GetDepthStencilState())
-			m_Context->OMSetDepthStencilState(pipelineState.GetDepthStencilState(), 0);
-		if (pipelineState.GetRasterizerState())
-			m_Context->RSSetState(pipelineState.GetRasterizerState());
+		if (m_Backend)
+		{
+			BackendHandle pipeline = pipelineState.GetBackendPipeline();
+			if (pipeline && !Filter(m_State.pipeline == pipeline, TraceOp::SetPipeline))
+			{
+				m_Backend->SetPipeline(pipeline);
+				m_State.pipeline = pipeline;
+			}
+			return;
+		}
+
+		ID3D11InputLayout* inputLayout = pipelineState.GetInputLayout();
+		ID3D11VertexShader* vertexShader = pipelineState.GetVertexShader();
+		ID3D11PixelShader* pixelShader = pipelineState.GetPixelShader();
+		ID3D11DepthStencilState* depthStencilState = pipelineState.GetDepthStencilState();
+		ID3D11RasterizerState* rasterizerState = pipelineState.GetRasterizerState();
+		ID3D11BlendState* blendState = pipelineState.GetBlendState();
+
+		if (inputLayout && !Filter(m_State.inputLayout == inputLayout, TraceOp::SetPipeline))
+		{
+			m_Context->IASetInputLayout(inputLayout);
+			m_State.inputLayout = inputLayout;
+		}
+		if (vertexShader && !Filter(m_State.vertexShader == vertexShader, TraceOp::SetPipeline))
+		{
+			m_Context->VSSetShader(vertexShader, nullptr, 0);
+			m_State.vertexShader = vertexShader;
+		}
+		if (pixelShader && !Filter(m_State.pixelShader == pixelShader, TraceOp::SetPipeline))
+		{
+			m_Context->PSSetShader(pixelShader, nullptr, 0);
+			m_State.pixelShader = pixelShader;
+			m_State.pixelShaderUnbound = false;
+		}
+		else if (pipelineState.IsDepthOnly() && !Filter(m_State.pixelShaderUnbound, TraceOp::SetPipeline))
+		{
+			// Depth passes must not leave the previous pass shading every covered pixel
+			m_Context->PSSetShader(nullptr, nullptr, 0);
+			m_State.pixelShader = nullptr;
+			m_State.pixelShaderUnbound = true;
+		}
+		if (depthStencilState && !Filter(m_State.depthStencilState == depthStencilState, TraceOp::SetPipeline))
+		{
+			m_Context->OMSetDepthStencilState(depthStencilState, 0);
+			m_State.depthStencilState = depthStencilState;
+		}
+		if (rasterizerState && !Filter(m_State.rasterizerState == rasterizerState, TraceOp::SetPipeline))
+		{
+			m_Context->RSSetState(rasterizerState);
+			m_State.rasterizerState = rasterizerState;
+		}
+		if (blendState && !Filter(m_State.blendState == blendState, TraceOp::SetPipeline))
+		{
+			m_Context->OMSetBlendState(blendState, nullptr, 0xFFFFFFFF);
+			m_State.blendState = blendState;
+		}
 
 	}
 	void CommandList::SetViewport(float width, float height)
 	{
+		if (!HasTarget() || Filter(m_State.viewportWidth == width && m_State.viewportHeight == height, TraceOp::SetViewport))
+			return;
+
+		m_State.viewportWidth = width;
+		m_State.viewportHeight = height;
+
+		if (m_Backend)
+		{
+			m_Backend->SetViewport(width, height);
+			return;
+		}
+
 		D3D11_VIEWPORT viewport = {};
 		viewport.Width = width;
 		viewport.Height = height;
@@ -102,48 +267,138 @@ namespace Graphics
 		viewport.TopLeftX = 0.0f;
 		viewport.TopLeftY = 0.0f;
 
-		if (m_Context)
-		{
-			m_Context->RSSetViewports(1, &viewport);
-		}
+		m_Context->RSSetViewports(1, &viewport);
 	}
 
 
+	void CommandList::BindVertexBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t stride, uint32_t offset)
+	{
+		if (!HasTarget() || !buffer || slot >= D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT)
+			return;
+
+		VertexBufferBinding& binding = m_State.vertexBuffers[slot];
+		if (Filter(binding.buffer == buffer && binding.stride == stride && binding.offset == offset, TraceOp::SetVertexBuffer))
+			return;
+
+		if (m_Backend)
+			m_Backend->SetVertexBuffer(slot, ToBackendHandle(buffer), stride, offset);
+		else
+			m_Context->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+
+		binding.buffer = buffer;
+		binding.stride = stride;
+		binding.offset = offset;
+	}
+
 	void CommandList::SetVertexBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t size, uint32_t stride, void* data)
 	{
-		if (m_Context && buffer && data)
+		if (HasTarget() && buffer && data)
 		{
-			D3D11_MAPPED_SUBRESOURCE mappedResource;
-			if (SUCCEEDED(m_Context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+			PROFILE_ZONE("CommandList::SetVertexBuffer");
+			if (void* mapped = BackendBridge::Map(m_Backend, m_Context, buffer, D3D11_MAP_WRITE_DISCARD))
 			{
-				memcpy(mappedResource.pData, data, size);
-				m_Context->Unmap(buffer, 0);
-				m_Context->IASetVertexBuffers(slot, 1, &buffer, &stride, nullptr);
+				memcpy(mapped, data, size);
+				BackendBridge::Unmap(m_Backend, m_Context, buffer, 0, size);
+
+				// A renamed buffer stays bound, only the first call binds it
+				BindVertexBuffer(buffer, slot, stride, 0);
 			}
 		}
 	}
 
+	void CommandList::SetVertexBuffer(const Buffer& buffer, uint32_t slot)
+	{
+		if (buffer.GetType() == BufferType::VertexBuffer || buffer.GetType() == BufferType::InstanceBuffer)
+			BindVertexBuffer(buffer.GetBuffer(), slot, buffer.GetStride(), 0);
+	}
+
 	void CommandList::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, uint32_t offset)
 	{
-		if (m_Context && buffer)
-		{
+		if (!HasTarget() || !buffer)
+			return;
+
+		if (Filter(m_State.indexBuffer == buffer && m_State.indexFormat == format && m_State.indexOffset == offset, TraceOp::SetIndexBuffer))
+			return;
+
+		if (m_Backend)
+			m_Backend->SetIndexBuffer(ToBackendHandle(buffer), static_cast<BackendFormat>(format), offset);
+		else
 			m_Context->IASetIndexBuffer(buffer, format, offset);
+
+		m_State.indexBuffer = buffer;
+		m_State.indexFormat = format;
+		m_State.indexOffset = offset;
+	}
+	void CommandList::SetVertexBuffer(const TransientAllocation& allocation, uint32_t slot)
+	{
+		if (allocation.IsValid())
+			BindVertexBuffer(allocation.buffer, slot, allocation.stride, 0);
+	}
+
+	void CommandList::SetIndexBuffer(const TransientAllocation& allocation)
+	{
+		if (allocation.IsValid())
+		{
+			DXGI_FORMAT format = (allocation.stride == 2) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+			SetIndexBuffer(allocation.buffer, format, 0);
 		}
 	}
+
+	void CommandList::SetIndexBuffer(const Buffer& buffer)
+	{
+		if (buffer.GetType() == BufferType::IndexBuffer)
+			SetIndexBuffer(buffer.GetBuffer(), buffer.GetFormat(), 0);
+	}
+
+	void CommandList::BindConstantBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t firstConstant, uint32_t numConstants)
+	{
+		if (!HasTarget() || !buffer || slot >= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+			return;
+
+		ConstantBufferBinding& binding = m_State.constantBuffers[slot];
+		if (Filter(binding.buffer == buffer && binding.firstConstant == firstConstant && binding.numConstants == numConstants, TraceOp::SetConstantBuffer))
+			return;
+
+		if (m_Backend)
+			m_Backend->SetConstantBuffer(slot, ToBackendHandle(buffer), firstConstant, numConstants == WholeBuffer ? 0 : numConstants);
+		else if (numConstants == WholeBuffer)
+			m_Context->VSSetConstantBuffers(slot, 1, &buffer);
+		else if (m_Context1)
+			m_Context1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+		else
+			return;
+
+		binding.buffer = buffer;
+		binding.firstConstant = firstConstant;
+		binding.numConstants = numConstants;
+	}
+
 	void CommandList::SetConstantBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t size, uint32_t stride, void* data)
 	{
-		if (m_Context && buffer && data)
+		if (HasTarget() && buffer && data)
 		{
-			D3D11_MAPPED_SUBRESOURCE mappedResource;
-			if (SUCCEEDED(m_Context->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+			PROFILE_ZONE("CommandList::SetConstantBuffer");
+			if (void* mapped = BackendBridge::Map(m_Backend, m_Context, buffer, D3D11_MAP_WRITE_DISCARD))
 			{
-				memcpy(mappedResource.pData, data, size);
-				m_Context->Unmap(buffer, 0);
-				m_Context->VSSetConstantBuffers(slot, 1, &buffer);
+				memcpy(mapped, data, size);
+				BackendBridge::Unmap(m_Backend, m_Context, buffer, 0, size);
+				BindConstantBuffer(buffer, slot, 0, WholeBuffer);
 			}
 		}
 	}
 
+	void CommandList::SetConstantBuffer(const ConstantAllocation& allocation, uint32_t slot)
+	{
+		if (allocation.IsValid())
+			BindConstantBuffer(allocation.buffer, slot, allocation.GetFirstConstant(), allocation.GetNumConstants());
+	}
+
+	void CommandList::SetConstantBuffer(const Buffer& buffer, uint32_t slot)
+	{
+		if (buffer.GetType() == BufferType::ConstantBuffer)
+			BindConstantBuffer(buffer.GetBuffer(), slot, 0, WholeBuffer);
+	}
+
 
 
 
@@ -6,11 +6,16 @@
 #include "Texture.h"
 #include "RenderPass.h"
 #include "Pipeline.h"
+#include "ConstantBufferRing.h"
+#include "UploadHeap.h"
+#include "Buffer.h"
+#include "RenderBackend.h"
 
 #include <iostream>
 #include <dxgi.h>
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <cstdint>
 
 #pragma comment(lib, "d3d11.lib")
@@ -20,30 +25,109 @@ namespace Graphics
 {
 	class RenderPass;
 	class Pipeline;
+	class CommandCapture;
+	enum class TraceOp : uint8_t;
 
+	struct CommandListStats
+	{
+		uint32_t submitted = 0; // State and draw calls that reached the context
+		uint32_t filtered = 0; // State calls dropped because the state was already bound
+		uint32_t draws = 0;
+		uint32_t instances = 0; // Objects drawn, equals draws until instancing kicks in
+	};
+
+	// Shadows everything it binds and drops calls that would not change the context state.
+	// Code that binds directly on the context must call InvalidateState() afterwards.
+	// Initialized with a backend instead of a context, the filtered calls go to the backend.
 	class CommandList
 	{
 	public:
 		CommandList() = default;
 		~CommandList() = default;
 		void Initialize(ID3D11DeviceContext* context);
+		void Initialize(RenderBackend& backend);
 		void Release();
 		void ClearRenderPass(const RenderPass& pass, const float color[4]);
 		void SetViewport(float width, float height);
 
 		void SetVertexBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t size, uint32_t stride, void* data);
 		void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, uint32_t offset);
+		void SetVertexBuffer(const TransientAllocation& allocation, uint32_t slot); // Bound at offset 0, draw with GetFirstElement() as baseVertexLocation
+		void SetIndexBuffer(const TransientAllocation& allocation); // Bound at offset 0, draw with GetFirstElement() as startIndexLocation
+		void SetIndexBuffer(const Buffer& buffer); // Uses the format chosen when the buffer was created (R16_UINT or R32_UINT)
+		void SetVertexBuffer(const Buffer& buffer, uint32_t slot);
+		void BindVertexBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t stride, uint32_t offset);
 		void SetConstantBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t size, uint32_t stride, void* data);
+		void SetConstantBuffer(const ConstantAllocation& allocation, uint32_t slot);
+		void SetConstantBuffer(const Buffer& buffer, uint32_t slot);
 
 		void SetRenderPass(const RenderPass& pass);
 		void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
 		void DrawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation);
+		void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation);
 
 		void SetPipelineState(const Pipeline& pipelineState);
 
+		bool IsDeferred() const { return m_Context && m_Context->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED; }
+		bool Finish(ID3D11CommandList** commandList); // Deferred contexts only, the context starts over with default state
 
+		void InvalidateState(); // Forget the shadowed state, the next call of every kind reaches the context
+		void SetCapture(CommandCapture* capture) { m_Capture = capture; } // Filtered calls are recorded as Redundant, nullptr to stop
+		void ResetStats() { m_Stats = {}; } // Called once per frame
+		const CommandListStats& GetStats() const { return m_Stats; }
 
 	private:
+		static constexpr uint32_t WholeBuffer = ~0u; // Constant buffer bound without a first-constant range
+
+		struct VertexBufferBinding
+		{
+			ID3D11Buffer* buffer = nullptr;
+			uint32_t stride = 0;
+			uint32_t offset = 0;
+		};
+
+		struct ConstantBufferBinding
+		{
+			ID3D11Buffer* buffer = nullptr;
+			uint32_t firstConstant = 0;
+			uint32_t numConstants = WholeBuffer;
+		};
+
+		// Shadow of the bound state, nullptr/zero means "unknown" until the first call
+		struct State
+		{
+			BackendHandle pipeline = 0; // Backends take whole pipelines instead of the objects below
+			ID3D11InputLayout* inputLayout = nullptr;
+			ID3D11VertexShader* vertexShader = nullptr;
+			ID3D11PixelShader* pixelShader = nullptr;
+			bool pixelShaderUnbound = false; // Known null, set by depth-only pipelines
+			ID3D11DepthStencilState* depthStencilState = nullptr;
+			ID3D11RasterizerState* rasterizerState = nullptr;
+			ID3D11BlendState* blendState = nullptr;
+			D3D11_PRIMITIVE_TOPOLOGY topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+			VertexBufferBinding vertexBuffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+			ID3D11Buffer* indexBuffer = nullptr;
+			DXGI_FORMAT indexFormat = DXGI_FORMAT_UNKNOWN;
+			uint32_t indexOffset = 0;
+			ConstantBufferBinding constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+
+			float viewportWidth = 0.0f;
+			float viewportHeight = 0.0f;
+			ID3D11RenderTargetView* renderTarget = nullptr;
+			ID3D11DepthStencilView* depthStencil = nullptr;
+		};
+
+		bool Filter(bool redundant, TraceOp op); // Counts the call and returns true when it must be dropped
+		bool HasTarget() const { return m_Context || m_Backend; }
+		void BindConstantBuffer(ID3D11Buffer* buffer, uint32_t slot, uint32_t firstConstant, uint32_t numConstants);
+
 		ID3D11DeviceContext* m_Context = nullptr; // Direct3D device context for executing commands
+		ID3D11DeviceContext1* m_Context1 = nullptr; // 11.1 interface, needed to bind constant buffer ranges
+		RenderBackend* m_Backend = nullptr; // Replaces both contexts when set
+		CommandCapture* m_Capture = nullptr;
+
+		State m_State;
+		CommandListStats m_Stats;
 	};
 }
\ No newline at end of file
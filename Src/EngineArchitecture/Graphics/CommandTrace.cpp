@@ -0,0 +1,1280 @@
+#include "CommandTrace.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+
+namespace Graphics
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		double ElapsedMilliseconds(Clock::time_point start, Clock::time_point end)
+		{
+			return std::chrono::duration<double, std::milli>(end - start).count();
+		}
+
+		uint32_t ReadWord(const uint8_t* data)
+		{
+			return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+		}
+
+		void WriteWord(std::vector<uint8_t>& data, uint32_t value)
+		{
+			for (uint32_t i = 0; i < 4; ++i)
+				data.push_back(static_cast<uint8_t>(value >> (i * 8)));
+		}
+
+		uint32_t FloatBits(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		bool IsCreate(TraceOp op)
+		{
+			return op == TraceOp::CreateBuffer || op == TraceOp::CreateTexture || op == TraceOp::CreatePipeline;
+		}
+
+		// Old id to new id for an extracted range, whose resources are numbered again from 1
+		using IdMap = std::unordered_map<uint32_t, uint32_t>;
+
+		uint32_t Renumber(const IdMap& ids, uint32_t id)
+		{
+			if (id == 0)
+				return 0;
+
+			auto it = ids.find(id);
+			return (it != ids.end()) ? it->second : ~0u; // Never created, still missing when the range is replayed
+		}
+
+		const char* const OpNames[] =
+		{
+			"CreateBuffer", "CreateTexture", "CreatePipeline", "Destroy", "WriteBuffer", "UpdateBuffer", "CopyBuffer",
+			"SetPipeline", "SetVertexBuffer", "SetIndexBuffer", "SetConstantBuffer", "SetRenderTargets", "SetViewport",
+			"SetTopology", "ClearColor", "ClearDepth", "DrawIndexed", "Present", "Redundant"
+		};
+
+		static_assert(sizeof(OpNames) / sizeof(OpNames[0]) == static_cast<size_t>(TraceOp::Count), "One name per TraceOp");
+
+		// What the backend holds after every record so far: live resources and bindings. Used to find binds that changed
+		// nothing and to write the snapshot an extracted frame range starts with.
+		class TraceState
+		{
+		public:
+			// Returns true for a bind that left the state as it was
+			bool Apply(const TraceRecord& record, const uint8_t* begin, const uint8_t* end, bool keepContents);
+			void Snapshot(CommandTrace& trace, IdMap& ids) const; // Fills ids with the numbers the snapshot gives out
+			size_t GetResourceCount() const { return m_Resources.size(); }
+
+		private:
+			static constexpr uint32_t MaxVertexSlots = 32; // D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT
+			static constexpr uint32_t MaxConstantSlots = 14; // D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT
+
+			struct Resource
+			{
+				TraceOp op = TraceOp::CreateBuffer;
+				BackendBufferDesc buffer;
+				std::vector<uint8_t> memory; // Buffers, the contents as of the last record
+				std::vector<uint8_t> record; // Textures and pipelines, the record that created them
+			};
+
+			struct Binding
+			{
+				bool known = false; // Bound at least once, an unknown binding is never redundant
+				uint32_t values[3] = {};
+			};
+
+			static bool Bind(Binding& binding, uint32_t a, uint32_t b = 0, uint32_t c = 0);
+			void Forget(uint32_t id); // A destroyed resource is dropped from every binding
+			Resource* Find(uint32_t id);
+
+			std::map<uint32_t, Resource> m_Resources; // Ordered by id, the snapshot recreates them in creation order
+			Binding m_Pipeline;
+			Binding m_Targets;
+			Binding m_Viewport;
+			Binding m_Topology;
+			Binding m_IndexBuffer;
+			Binding m_VertexBuffers[MaxVertexSlots];
+			Binding m_ConstantBuffers[MaxConstantSlots];
+		};
+
+		bool TraceState::Bind(Binding& binding, uint32_t a, uint32_t b, uint32_t c)
+		{
+			bool redundant = binding.known && binding.values[0] == a && binding.values[1] == b && binding.values[2] == c;
+
+			binding.known = true;
+			binding.values[0] = a;
+			binding.values[1] = b;
+			binding.values[2] = c;
+			return redundant;
+		}
+
+		void TraceState::Forget(uint32_t id)
+		{
+			if (m_Pipeline.values[0] == id)
+				m_Pipeline.known = false;
+			if (m_Targets.values[0] == id || m_Targets.values[1] == id)
+				m_Targets.known = false;
+			if (m_IndexBuffer.values[0] == id)
+				m_IndexBuffer.known = false;
+			for (Binding& binding : m_VertexBuffers)
+				binding.known = binding.known && binding.values[0] != id;
+			for (Binding& binding : m_ConstantBuffers)
+				binding.known = binding.known && binding.values[0] != id;
+		}
+
+		TraceState::Resource* TraceState::Find(uint32_t id)
+		{
+			auto it = m_Resources.find(id);
+			return (it != m_Resources.end()) ? &it->second : nullptr;
+		}
+
+		bool TraceState::Apply(const TraceRecord& record, const uint8_t* begin, const uint8_t* end, bool keepContents)
+		{
+			switch (record.op)
+			{
+			case TraceOp::CreateBuffer:
+			{
+				Resource& resource = m_Resources[record.id];
+				resource.op = record.op;
+				resource.buffer = record.buffer;
+				if (keepContents)
+				{
+					resource.memory.assign(record.buffer.size, 0);
+					if (record.dataSize == record.buffer.size)
+						memcpy(resource.memory.data(), record.data, record.dataSize);
+				}
+				return false;
+			}
+			case TraceOp::CreateTexture:
+			case TraceOp::CreatePipeline:
+			{
+				Resource& resource = m_Resources[record.id];
+				resource.op = record.op;
+				if (keepContents)
+					resource.record.assign(begin, end);
+				return false;
+			}
+			case TraceOp::Destroy:
+				m_Resources.erase(record.id);
+				Forget(record.id);
+				return false;
+			case TraceOp::WriteBuffer:
+			case TraceOp::UpdateBuffer:
+			{
+				Resource* resource = keepContents ? Find(record.id) : nullptr;
+				uint32_t offset = (record.op == TraceOp::WriteBuffer) ? record.args[1] : record.args[0];
+				if (resource && static_cast<uint64_t>(offset) + record.dataSize <= resource->memory.size())
+					memcpy(resource->memory.data() + offset, record.data, record.dataSize);
+				return false;
+			}
+			case TraceOp::CopyBuffer:
+			{
+				Resource* destination = keepContents ? Find(record.id) : nullptr;
+				Resource* source = keepContents ? Find(record.secondId) : nullptr;
+				if (destination && source && static_cast<uint64_t>(record.args[0]) + record.args[2] <= destination->memory.size() &&
+					static_cast<uint64_t>(record.args[1]) + record.args[2] <= source->memory.size())
+					memmove(destination->memory.data() + record.args[0], source->memory.data() + record.args[1], record.args[2]);
+				return false;
+			}
+			case TraceOp::SetPipeline:
+				return Bind(m_Pipeline, record.id);
+			case TraceOp::SetVertexBuffer:
+				return record.args[0] < MaxVertexSlots && Bind(m_VertexBuffers[record.args[0]], record.id, record.args[1], record.args[2]);
+			case TraceOp::SetIndexBuffer:
+				return Bind(m_IndexBuffer, record.id, record.args[0], record.args[1]);
+			case TraceOp::SetConstantBuffer:
+				return record.args[0] < MaxConstantSlots && Bind(m_ConstantBuffers[record.args[0]], record.id, record.args[1], record.args[2]);
+			case TraceOp::SetRenderTargets:
+				return Bind(m_Targets, record.id, record.secondId);
+			case TraceOp::SetViewport:
+				return Bind(m_Viewport, FloatBits(record.values[0]), FloatBits(record.values[1]));
+			case TraceOp::SetTopology:
+				return Bind(m_Topology, record.args[0]);
+			default:
+				return false;
+			}
+		}
+
+		void TraceState::Snapshot(CommandTrace& trace, IdMap& ids) const
+		{
+			ids.clear();
+			for (const auto& entry : m_Resources)
+			{
+				const uint32_t id = static_cast<uint32_t>(ids.size()) + 1;
+				ids[entry.first] = id;
+
+				const Resource& resource = entry.second;
+				if (resource.op != TraceOp::CreateBuffer)
+				{
+					// Decoded again to carry its new id
+					CommandTrace single;
+					single.Append(resource.record.data(), resource.record.data() + resource.record.size());
+					TraceReader reader(single);
+					TraceRecord record;
+					reader.Next(record);
+					record.id = id;
+					trace.Write(record);
+					continue;
+				}
+
+				// Created with the contents it has now, whatever uploads led there
+				TraceRecord record;
+				record.op = TraceOp::CreateBuffer;
+				record.id = id;
+				record.buffer = resource.buffer;
+				record.data = resource.memory.data();
+				record.dataSize = static_cast<uint32_t>(resource.memory.size());
+				trace.Write(record);
+			}
+
+			auto bind = [&trace, &ids](TraceOp op, const Binding& binding, uint32_t slot)
+			{
+				if (!binding.known)
+					return;
+
+				TraceRecord record;
+				record.op = op;
+				switch (op)
+				{
+				case TraceOp::SetRenderTargets:
+					record.id = Renumber(ids, binding.values[0]);
+					record.secondId = Renumber(ids, binding.values[1]);
+					break;
+				case TraceOp::SetViewport:
+					memcpy(&record.values[0], &binding.values[0], sizeof(float));
+					memcpy(&record.values[1], &binding.values[1], sizeof(float));
+					break;
+				case TraceOp::SetTopology:
+					record.args[0] = binding.values[0];
+					break;
+				case TraceOp::SetIndexBuffer:
+					record.id = Renumber(ids, binding.values[0]);
+					record.args[0] = binding.values[1];
+					record.args[1] = binding.values[2];
+					break;
+				case TraceOp::SetVertexBuffer:
+				case TraceOp::SetConstantBuffer:
+					record.args[0] = slot;
+					record.id = Renumber(ids, binding.values[0]);
+					record.args[1] = binding.values[1];
+					record.args[2] = binding.values[2];
+					break;
+				default:
+					record.id = Renumber(ids, binding.values[0]);
+					break;
+				}
+				trace.Write(record);
+			};
+
+			bind(TraceOp::SetRenderTargets, m_Targets, 0);
+			bind(TraceOp::SetViewport, m_Viewport, 0);
+			bind(TraceOp::SetTopology, m_Topology, 0);
+			bind(TraceOp::SetPipeline, m_Pipeline, 0);
+			bind(TraceOp::SetIndexBuffer, m_IndexBuffer, 0);
+			for (uint32_t slot = 0; slot < MaxVertexSlots; ++slot)
+				bind(TraceOp::SetVertexBuffer, m_VertexBuffers[slot], slot);
+			for (uint32_t slot = 0; slot < MaxConstantSlots; ++slot)
+				bind(TraceOp::SetConstantBuffer, m_ConstantBuffers[slot], slot);
+		}
+	}
+
+	const char* GetTraceOpName(TraceOp op)
+	{
+		return (op < TraceOp::Count) ? OpNames[static_cast<uint32_t>(op)] : "Unknown";
+	}
+
+
+	void CommandTrace::Clear()
+	{
+		m_Data.clear();
+		WriteWord(m_Data, Magic);
+		WriteWord(m_Data, Version);
+	}
+
+	bool CommandTrace::Load(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "[CommandTrace] Failed to open " << path << ".\n";
+			return false;
+		}
+
+		m_Data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		if (m_Data.size() < 8 || ReadWord(m_Data.data()) != Magic || ReadWord(m_Data.data() + 4) != Version)
+		{
+			std::cerr << "[CommandTrace] " << path << " is not a command trace of version " << Version << ".\n";
+			Clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CommandTrace::Save(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(m_Data.data()), static_cast<std::streamsize>(m_Data.size()));
+
+		if (!file)
+		{
+			std::cerr << "[CommandTrace] Failed to write " << path << ".\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	void CommandTrace::WriteUInt(uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			m_Data.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		m_Data.push_back(static_cast<uint8_t>(value));
+	}
+
+	void CommandTrace::WriteInt(int32_t value)
+	{
+		uint32_t bits = static_cast<uint32_t>(value);
+		WriteUInt((bits << 1) ^ (value < 0 ? ~0u : 0u));
+	}
+
+	void CommandTrace::WriteFloat(float value)
+	{
+		WriteWord(m_Data, FloatBits(value));
+	}
+
+	void CommandTrace::WriteBytes(const void* data, uint32_t size)
+	{
+		WriteUInt(size);
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		m_Data.insert(m_Data.end(), bytes, bytes + size);
+	}
+
+	void CommandTrace::WriteString(const char* text)
+	{
+		if (!text)
+		{
+			WriteUInt(0);
+			return;
+		}
+
+		uint32_t length = static_cast<uint32_t>(strlen(text));
+		WriteUInt(length + 1);
+		m_Data.insert(m_Data.end(), text, text + length);
+	}
+
+	void CommandTrace::Write(const TraceRecord& record)
+	{
+		m_Data.push_back(static_cast<uint8_t>(record.op));
+
+		switch (record.op)
+		{
+		case TraceOp::CreateBuffer:
+			WriteUInt(record.id);
+			WriteUInt(static_cast<uint32_t>(record.buffer.kind));
+			WriteUInt(record.buffer.size);
+			WriteUInt(record.buffer.dynamic ? 1 : 0);
+			WriteBytes(record.data, record.dataSize);
+			break;
+		case TraceOp::CreateTexture:
+			WriteUInt(record.id);
+			WriteUInt(record.texture.width);
+			WriteUInt(record.texture.height);
+			WriteUInt(static_cast<uint32_t>(record.texture.format));
+			break;
+		case TraceOp::CreatePipeline:
+			WriteUInt(record.id);
+			WriteUInt(record.pipeline.elements.size());
+			for (const BackendVertexElement& element : record.pipeline.elements)
+			{
+				WriteString(element.semantic);
+				WriteUInt(element.semanticIndex);
+				WriteUInt(static_cast<uint32_t>(element.format));
+				WriteUInt(element.slot);
+				WriteUInt(element.offset);
+				WriteUInt(element.perInstance ? 1 : 0);
+			}
+			WriteString(record.pipeline.vertexShaderEntry);
+			WriteString(record.pipeline.pixelShaderEntry);
+			WriteUInt(record.pipeline.permutation);
+			WriteUInt(static_cast<uint32_t>(record.pipeline.cullMode));
+			WriteUInt(static_cast<uint32_t>(record.pipeline.depthFunc));
+			WriteUInt((record.pipeline.wireframe ? 1 : 0) | (record.pipeline.depthEnabled ? 2 : 0) | (record.pipeline.depthWrite ? 4 : 0) |
+				(record.pipeline.blendEnabled ? 8 : 0) | (record.pipeline.colorWrite ? 16 : 0));
+			break;
+		case TraceOp::Destroy:
+		case TraceOp::SetPipeline:
+		case TraceOp::Present:
+			WriteUInt(record.id);
+			break;
+		case TraceOp::WriteBuffer:
+			WriteUInt(record.id);
+			WriteUInt(record.args[0]);
+			WriteUInt(record.args[1]);
+			WriteBytes(record.data, record.dataSize);
+			break;
+		case TraceOp::UpdateBuffer:
+			WriteUInt(record.id);
+			WriteUInt(record.args[0]);
+			WriteBytes(record.data, record.dataSize);
+			break;
+		case TraceOp::CopyBuffer:
+			WriteUInt(record.id);
+			WriteUInt(record.secondId);
+			WriteUInt(record.args[0]);
+			WriteUInt(record.args[1]);
+			WriteUInt(record.args[2]);
+			break;
+		case TraceOp::SetVertexBuffer:
+		case TraceOp::SetConstantBuffer:
+			WriteUInt(record.id);
+			WriteUInt(record.args[0]);
+			WriteUInt(record.args[1]);
+			WriteUInt(record.args[2]);
+			break;
+		case TraceOp::SetIndexBuffer:
+			WriteUInt(record.id);
+			WriteUInt(record.args[0]);
+			WriteUInt(record.args[1]);
+			break;
+		case TraceOp::SetRenderTargets:
+			WriteUInt(record.id);
+			WriteUInt(record.secondId);
+			break;
+		case TraceOp::SetViewport:
+			WriteFloat(record.values[0]);
+			WriteFloat(record.values[1]);
+			break;
+		case TraceOp::SetTopology:
+		case TraceOp::Redundant:
+			WriteUInt(record.args[0]);
+			break;
+		case TraceOp::ClearColor:
+			WriteUInt(record.id);
+			for (uint32_t i = 0; i < 4; ++i)
+				WriteFloat(record.values[i]);
+			break;
+		case TraceOp::ClearDepth:
+			WriteUInt(record.id);
+			WriteFloat(record.values[0]);
+			break;
+		case TraceOp::DrawIndexed:
+			WriteUInt(record.args[0]);
+			WriteUInt(record.args[1]);
+			WriteUInt(record.args[2]);
+			WriteInt(static_cast<int32_t>(record.args[3]));
+			WriteUInt(record.args[4]);
+			break;
+		default:
+			break;
+		}
+	}
+
+	bool CommandTrace::Analyze(TraceStats& stats) const
+	{
+		stats = TraceStats();
+
+		TraceReader reader(*this);
+		TraceState state;
+		TraceRecord record;
+
+		while (reader.Next(record))
+		{
+			stats.records++;
+			stats.opCounts[static_cast<uint32_t>(record.op)]++;
+
+			switch (record.op)
+			{
+			case TraceOp::CreateBuffer:
+			case TraceOp::WriteBuffer:
+			case TraceOp::UpdateBuffer:
+				stats.bytesUploaded += record.dataSize;
+				break;
+			case TraceOp::CopyBuffer:
+				stats.bytesCopied += record.args[2];
+				break;
+			case TraceOp::DrawIndexed:
+				stats.draws++;
+				stats.instances += record.args[1];
+				stats.indices += static_cast<uint64_t>(record.args[0]) * record.args[1];
+				break;
+			case TraceOp::Present:
+				stats.frames++;
+				break;
+			case TraceOp::Redundant:
+				stats.filteredBinds++;
+				break;
+			default:
+				break;
+			}
+
+			if (state.Apply(record, reader.GetRecordBegin(), reader.GetRecordEnd(), false))
+				stats.redundantBinds++;
+
+			stats.peakResources = (state.GetResourceCount() > stats.peakResources) ? state.GetResourceCount() : stats.peakResources;
+		}
+
+		if (!reader.IsValid())
+		{
+			std::cerr << "[CommandTrace] Malformed trace, stopped after " << stats.records << " records.\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CommandTrace::Extract(uint32_t firstFrame, uint32_t frameCount, CommandTrace& range) const
+	{
+		range.Clear();
+
+		TraceReader reader(*this);
+		TraceState state;
+		TraceRecord record;
+		IdMap ids;
+		uint64_t frame = 0;
+		const uint64_t endFrame = static_cast<uint64_t>(firstFrame) + frameCount;
+		bool started = false;
+
+		while (frame < endFrame && reader.Next(record))
+		{
+			if (frame < firstFrame)
+			{
+				state.Apply(record, reader.GetRecordBegin(), reader.GetRecordEnd(), true);
+			}
+			else
+			{
+				if (!started)
+				{
+					state.Snapshot(range, ids);
+					started = true;
+				}
+
+				// Re-encoded with the range's ids, created ones continue after the snapshot
+				if (IsCreate(record.op))
+				{
+					const uint32_t id = static_cast<uint32_t>(ids.size()) + 1;
+					ids[record.id] = id;
+					record.id = id;
+				}
+				else
+				{
+					record.id = Renumber(ids, record.id);
+				}
+				record.secondId = Renumber(ids, record.secondId);
+				range.Write(record);
+			}
+
+			if (record.op == TraceOp::Present)
+				frame++;
+		}
+
+		if (!reader.IsValid())
+		{
+			std::cerr << "[CommandTrace] Malformed trace, cannot extract frames.\n";
+			return false;
+		}
+
+		if (!started)
+		{
+			std::cerr << "[CommandTrace] Frame " << firstFrame << " is past the end of the trace (" << frame << " frames).\n";
+			return false;
+		}
+
+		return true;
+	}
+
+
+	TraceReader::TraceReader(const CommandTrace& trace)
+	{
+		const std::vector<uint8_t>& data = trace.GetData();
+		m_Valid = data.size() >= 8 && ReadWord(data.data()) == CommandTrace::Magic && ReadWord(data.data() + 4) == CommandTrace::Version;
+		m_Cursor = data.data() + (m_Valid ? 8 : data.size());
+		m_End = data.data() + data.size();
+		m_RecordBegin = m_Cursor;
+	}
+
+	bool TraceReader::ReadUInt(uint64_t& value)
+	{
+		value = 0;
+		for (uint32_t shift = 0; shift < 64; shift += 7)
+		{
+			if (m_Cursor == m_End)
+				return false;
+
+			uint8_t byte = *m_Cursor++;
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	bool TraceReader::ReadUInt(uint32_t& value)
+	{
+		uint64_t wide = 0;
+		if (!ReadUInt(wide) || wide > 0xFFFFFFFFu)
+			return false;
+
+		value = static_cast<uint32_t>(wide);
+		return true;
+	}
+
+	bool TraceReader::ReadInt(int32_t& value)
+	{
+		uint32_t bits = 0;
+		if (!ReadUInt(bits))
+			return false;
+
+		value = static_cast<int32_t>((bits >> 1) ^ (0u - (bits & 1)));
+		return true;
+	}
+
+	bool TraceReader::ReadFloat(float& value)
+	{
+		if (m_End - m_Cursor < 4)
+			return false;
+
+		uint32_t bits = ReadWord(m_Cursor);
+		memcpy(&value, &bits, sizeof(value));
+		m_Cursor += 4;
+		return true;
+	}
+
+	bool TraceReader::ReadBytes(const uint8_t*& data, uint32_t& size)
+	{
+		if (!ReadUInt(size) || static_cast<uint64_t>(m_End - m_Cursor) < size)
+			return false;
+
+		data = size ? m_Cursor : nullptr;
+		m_Cursor += size;
+		return true;
+	}
+
+	bool TraceReader::ReadString(const char*& text, std::string& storage)
+	{
+		uint32_t length = 0;
+		if (!ReadUInt(length) || static_cast<uint64_t>(m_End - m_Cursor) < length)
+			return false;
+
+		if (length == 0)
+		{
+			text = nullptr;
+			return true;
+		}
+
+		storage.assign(reinterpret_cast<const char*>(m_Cursor), length - 1);
+		text = storage.c_str();
+		m_Cursor += length - 1;
+		return true;
+	}
+
+	bool TraceReader::ReadPipeline(BackendPipelineDesc& desc)
+	{
+		uint32_t count = 0;
+		if (!ReadUInt(count) || count > static_cast<uint64_t>(m_End - m_Cursor))
+			return false;
+
+		// Sized up front, the semantic pointers must not move while the rest is read
+		m_Semantics.resize(count);
+		desc.elements.assign(count, BackendVertexElement());
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			BackendVertexElement& element = desc.elements[i];
+			uint32_t format = 0;
+			uint32_t perInstance = 0;
+			if (!ReadString(element.semantic, m_Semantics[i]) || !ReadUInt(element.semanticIndex) || !ReadUInt(format) ||
+				!ReadUInt(element.slot) || !ReadUInt(element.offset) || !ReadUInt(perInstance))
+				return false;
+
+			element.format = static_cast<BackendFormat>(format);
+			element.perInstance = perInstance != 0;
+		}
+
+		uint32_t cullMode = 0;
+		uint32_t depthFunc = 0;
+		uint32_t flags = 0;
+		if (!ReadString(desc.vertexShaderEntry, m_VertexEntry) || !ReadString(desc.pixelShaderEntry, m_PixelEntry) ||
+			!ReadUInt(desc.permutation) || !ReadUInt(cullMode) || !ReadUInt(depthFunc) || !ReadUInt(flags))
+			return false;
+
+		desc.cullMode = static_cast<BackendCull>(cullMode);
+		desc.depthFunc = static_cast<BackendCompare>(depthFunc);
+		desc.wireframe = (flags & 1) != 0;
+		desc.depthEnabled = (flags & 2) != 0;
+		desc.depthWrite = (flags & 4) != 0;
+		desc.blendEnabled = (flags & 8) != 0;
+		desc.colorWrite = (flags & 16) != 0;
+		return true;
+	}
+
+	bool TraceReader::Next(TraceRecord& record)
+	{
+		if (!m_Valid || m_Cursor == m_End)
+			return false;
+
+		m_RecordBegin = m_Cursor;
+
+		uint8_t op = *m_Cursor++;
+		if (op >= static_cast<uint8_t>(TraceOp::Count))
+		{
+			m_Valid = false;
+			return false;
+		}
+
+		record.op = static_cast<TraceOp>(op);
+		record.id = 0;
+		record.secondId = 0;
+		memset(record.args, 0, sizeof(record.args));
+		memset(record.values, 0, sizeof(record.values));
+		record.data = nullptr;
+		record.dataSize = 0;
+
+		bool ok = true;
+		switch (record.op)
+		{
+		case TraceOp::CreateBuffer:
+		{
+			// Initial data covers the whole buffer or is absent
+			uint32_t kind = 0;
+			uint32_t dynamic = 0;
+			ok = ReadUInt(record.id) && ReadUInt(kind) && ReadUInt(record.buffer.size) && ReadUInt(dynamic) && ReadBytes(record.data, record.dataSize) &&
+				(record.dataSize == 0 || record.dataSize == record.buffer.size);
+			record.buffer.kind = static_cast<BackendBufferKind>(kind);
+			record.buffer.dynamic = dynamic != 0;
+			break;
+		}
+		case TraceOp::CreateTexture:
+		{
+			uint32_t format = 0;
+			ok = ReadUInt(record.id) && ReadUInt(record.texture.width) && ReadUInt(record.texture.height) && ReadUInt(format);
+			record.texture.format = static_cast<BackendFormat>(format);
+			break;
+		}
+		case TraceOp::CreatePipeline:
+			ok = ReadUInt(record.id) && ReadPipeline(record.pipeline);
+			break;
+		case TraceOp::Destroy:
+		case TraceOp::SetPipeline:
+		case TraceOp::Present:
+			ok = ReadUInt(record.id);
+			break;
+		case TraceOp::WriteBuffer:
+			ok = ReadUInt(record.id) && ReadUInt(record.args[0]) && ReadUInt(record.args[1]) && ReadBytes(record.data, record.dataSize);
+			break;
+		case TraceOp::UpdateBuffer:
+			ok = ReadUInt(record.id) && ReadUInt(record.args[0]) && ReadBytes(record.data, record.dataSize);
+			break;
+		case TraceOp::CopyBuffer:
+			ok = ReadUInt(record.id) && ReadUInt(record.secondId) && ReadUInt(record.args[0]) && ReadUInt(record.args[1]) && ReadUInt(record.args[2]);
+			break;
+		case TraceOp::SetVertexBuffer:
+		case TraceOp::SetConstantBuffer:
+			ok = ReadUInt(record.id) && ReadUInt(record.args[0]) && ReadUInt(record.args[1]) && ReadUInt(record.args[2]);
+			break;
+		case TraceOp::SetIndexBuffer:
+			ok = ReadUInt(record.id) && ReadUInt(record.args[0]) && ReadUInt(record.args[1]);
+			break;
+		case TraceOp::SetRenderTargets:
+			ok = ReadUInt(record.id) && ReadUInt(record.secondId);
+			break;
+		case TraceOp::SetViewport:
+			ok = ReadFloat(record.values[0]) && ReadFloat(record.values[1]);
+			break;
+		case TraceOp::SetTopology:
+		case TraceOp::Redundant:
+			ok = ReadUInt(record.args[0]);
+			break;
+		case TraceOp::ClearColor:
+			ok = ReadUInt(record.id) && ReadFloat(record.values[0]) && ReadFloat(record.values[1]) && ReadFloat(record.values[2]) && ReadFloat(record.values[3]);
+			break;
+		case TraceOp::ClearDepth:
+			ok = ReadUInt(record.id) && ReadFloat(record.values[0]);
+			break;
+		case TraceOp::DrawIndexed:
+		{
+			int32_t baseVertex = 0;
+			ok = ReadUInt(record.args[0]) && ReadUInt(record.args[1]) && ReadUInt(record.args[2]) && ReadInt(baseVertex) && ReadUInt(record.args[4]);
+			record.args[3] = static_cast<uint32_t>(baseVertex);
+			break;
+		}
+		default:
+			break;
+		}
+
+		// Ids are handed out in creation order, a replayer can index by them
+		if (ok && IsCreate(record.op))
+			ok = record.id == m_NextId++;
+
+		m_Valid = ok;
+		return ok;
+	}
+
+
+	uint32_t CommandCapture::AddResource(BackendHandle handle)
+	{
+		uint32_t id = m_NextId++;
+		m_Ids[handle] = id;
+		return id;
+	}
+
+	uint32_t CommandCapture::GetId(BackendHandle handle) const
+	{
+		auto it = m_Ids.find(handle);
+		return (it != m_Ids.end()) ? it->second : 0;
+	}
+
+	BackendHandle CommandCapture::CreateBuffer(const BackendBufferDesc& desc, const void* initialData)
+	{
+		BackendHandle handle = m_Target.CreateBuffer(desc, initialData);
+		if (!handle)
+			return 0;
+
+		TraceRecord record;
+		record.op = TraceOp::CreateBuffer;
+		record.id = AddResource(handle);
+		record.buffer = desc;
+		record.data = static_cast<const uint8_t*>(initialData);
+		record.dataSize = initialData ? desc.size : 0;
+		m_Trace.Write(record);
+		return handle;
+	}
+
+	BackendHandle CommandCapture::CreateTexture(const BackendTextureDesc& desc)
+	{
+		BackendHandle handle = m_Target.CreateTexture(desc);
+		if (!handle)
+			return 0;
+
+		TraceRecord record;
+		record.op = TraceOp::CreateTexture;
+		record.id = AddResource(handle);
+		record.texture = desc;
+		m_Trace.Write(record);
+		return handle;
+	}
+
+	BackendHandle CommandCapture::CreatePipeline(const BackendPipelineDesc& desc)
+	{
+		BackendHandle handle = m_Target.CreatePipeline(desc);
+		if (!handle)
+			return 0;
+
+		TraceRecord record;
+		record.op = TraceOp::CreatePipeline;
+		record.id = AddResource(handle);
+		record.pipeline = desc;
+		m_Trace.Write(record);
+		return handle;
+	}
+
+	void CommandCapture::Destroy(BackendHandle handle)
+	{
+		auto it = m_Ids.find(handle);
+		if (it != m_Ids.end())
+		{
+			TraceRecord record;
+			record.op = TraceOp::Destroy;
+			record.id = it->second;
+			m_Trace.Write(record);
+
+			m_Ids.erase(it);
+			m_Mapped.erase(handle);
+		}
+
+		m_Target.Destroy(handle);
+	}
+
+	void* CommandCapture::Map(BackendHandle buffer, BackendMap mode)
+	{
+		void* memory = m_Target.Map(buffer, mode);
+		if (memory)
+		{
+			Mapping& mapping = m_Mapped[buffer];
+			mapping.memory = static_cast<uint8_t*>(memory);
+			mapping.mode = mode;
+		}
+		return memory;
+	}
+
+	void CommandCapture::Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize)
+	{
+		// Copied out before the backend gets the memory back
+		auto it = m_Mapped.find(buffer);
+		if (it != m_Mapped.end())
+		{
+			TraceRecord record;
+			record.op = TraceOp::WriteBuffer;
+			record.id = GetId(buffer);
+			record.args[0] = static_cast<uint32_t>(it->second.mode);
+			record.args[1] = writtenOffset;
+			record.data = it->second.memory + writtenOffset;
+			record.dataSize = writtenSize;
+			if (record.id)
+				m_Trace.Write(record);
+
+			m_Mapped.erase(it);
+		}
+
+		m_Target.Unmap(buffer, writtenOffset, writtenSize);
+	}
+
+	void CommandCapture::UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size)
+	{
+		TraceRecord record;
+		record.op = TraceOp::UpdateBuffer;
+		record.id = GetId(buffer);
+		record.args[0] = offset;
+		record.data = static_cast<const uint8_t*>(data);
+		record.dataSize = data ? size : 0;
+		if (record.id && data)
+			m_Trace.Write(record);
+
+		m_Target.UpdateBuffer(buffer, offset, data, size);
+	}
+
+	void CommandCapture::CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size)
+	{
+		TraceRecord record;
+		record.op = TraceOp::CopyBuffer;
+		record.id = GetId(destination);
+		record.secondId = GetId(source);
+		record.args[0] = destinationOffset;
+		record.args[1] = sourceOffset;
+		record.args[2] = size;
+		m_Trace.Write(record);
+
+		m_Target.CopyBuffer(destination, destinationOffset, source, sourceOffset, size);
+	}
+
+	void CommandCapture::SetPipeline(BackendHandle pipeline)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetPipeline;
+		record.id = GetId(pipeline);
+		m_Trace.Write(record);
+
+		m_Target.SetPipeline(pipeline);
+	}
+
+	void CommandCapture::SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetVertexBuffer;
+		record.id = GetId(buffer);
+		record.args[0] = slot;
+		record.args[1] = stride;
+		record.args[2] = offset;
+		m_Trace.Write(record);
+
+		m_Target.SetVertexBuffer(slot, buffer, stride, offset);
+	}
+
+	void CommandCapture::SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetIndexBuffer;
+		record.id = GetId(buffer);
+		record.args[0] = static_cast<uint32_t>(format);
+		record.args[1] = offset;
+		m_Trace.Write(record);
+
+		m_Target.SetIndexBuffer(buffer, format, offset);
+	}
+
+	void CommandCapture::SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetConstantBuffer;
+		record.id = GetId(buffer);
+		record.args[0] = slot;
+		record.args[1] = firstConstant;
+		record.args[2] = numConstants;
+		m_Trace.Write(record);
+
+		m_Target.SetConstantBuffer(slot, buffer, firstConstant, numConstants);
+	}
+
+	void CommandCapture::SetRenderTargets(BackendHandle color, BackendHandle depth)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetRenderTargets;
+		record.id = GetId(color);
+		record.secondId = GetId(depth);
+		m_Trace.Write(record);
+
+		m_Target.SetRenderTargets(color, depth);
+	}
+
+	void CommandCapture::SetViewport(float width, float height)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetViewport;
+		record.values[0] = width;
+		record.values[1] = height;
+		m_Trace.Write(record);
+
+		m_Target.SetViewport(width, height);
+	}
+
+	void CommandCapture::SetTopology(BackendTopology topology)
+	{
+		TraceRecord record;
+		record.op = TraceOp::SetTopology;
+		record.args[0] = static_cast<uint32_t>(topology);
+		m_Trace.Write(record);
+
+		m_Target.SetTopology(topology);
+	}
+
+	void CommandCapture::ClearColor(BackendHandle color, const float rgba[4])
+	{
+		TraceRecord record;
+		record.op = TraceOp::ClearColor;
+		record.id = GetId(color);
+		memcpy(record.values, rgba, sizeof(record.values));
+		m_Trace.Write(record);
+
+		m_Target.ClearColor(color, rgba);
+	}
+
+	void CommandCapture::ClearDepth(BackendHandle depth, float value)
+	{
+		TraceRecord record;
+		record.op = TraceOp::ClearDepth;
+		record.id = GetId(depth);
+		record.values[0] = value;
+		m_Trace.Write(record);
+
+		m_Target.ClearDepth(depth, value);
+	}
+
+	void CommandCapture::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+	{
+		TraceRecord record;
+		record.op = TraceOp::DrawIndexed;
+		record.args[0] = indexCount;
+		record.args[1] = instanceCount;
+		record.args[2] = startIndex;
+		record.args[3] = static_cast<uint32_t>(baseVertex);
+		record.args[4] = startInstance;
+		m_Trace.Write(record);
+
+		m_Target.DrawIndexed(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+	void CommandCapture::Present(BackendHandle color)
+	{
+		TraceRecord record;
+		record.op = TraceOp::Present;
+		record.id = GetId(color);
+		m_Trace.Write(record);
+
+		m_Target.Present(color);
+	}
+
+	void CommandCapture::RecordRedundant(TraceOp op)
+	{
+		TraceRecord record;
+		record.op = TraceOp::Redundant;
+		record.args[0] = static_cast<uint32_t>(op);
+		m_Trace.Write(record);
+	}
+
+
+	bool CommandReplayer::Replay(const CommandTrace& trace, RenderBackend& backend, uint32_t firstFrame, uint32_t frameCount, bool timeCommands)
+	{
+		Release();
+		m_Backend = &backend;
+		m_Stats = TraceReplayStats();
+		m_LastPresented = 0;
+
+		if (firstFrame == 0 && frameCount == ~0u)
+			return Execute(trace, timeCommands);
+
+		CommandTrace range;
+		return trace.Extract(firstFrame, frameCount, range) && Execute(range, timeCommands);
+	}
+
+	void CommandReplayer::Release()
+	{
+		for (BackendHandle handle : m_Handles)
+		{
+			if (handle)
+				m_Backend->Destroy(handle);
+		}
+
+		m_Handles.clear();
+		m_BufferSizes.clear();
+		m_LastPresented = 0;
+	}
+
+	BackendHandle CommandReplayer::Resolve(uint32_t id)
+	{
+		if (id == 0)
+			return 0;
+
+		BackendHandle handle = GetHandle(id);
+		if (!handle)
+			m_Stats.missingResources++;
+
+		return handle;
+	}
+
+	bool CommandReplayer::IsInBuffer(uint32_t id, uint32_t offset, uint32_t size) const
+	{
+		return id < m_BufferSizes.size() && static_cast<uint64_t>(offset) + size <= m_BufferSizes[id];
+	}
+
+	bool CommandReplayer::Execute(const CommandTrace& trace, bool timeCommands)
+	{
+		TraceReader reader(trace);
+		TraceRecord record;
+		RenderBackend& backend = *m_Backend;
+
+		const Clock::time_point start = Clock::now();
+		Clock::time_point frameStart = start;
+
+		while (reader.Next(record))
+		{
+			const uint32_t op = static_cast<uint32_t>(record.op);
+			const Clock::time_point commandStart = timeCommands ? Clock::now() : start;
+
+			switch (record.op)
+			{
+			case TraceOp::CreateBuffer:
+			case TraceOp::CreateTexture:
+			case TraceOp::CreatePipeline:
+			{
+				BackendHandle handle =
+					(record.op == TraceOp::CreateBuffer) ? backend.CreateBuffer(record.buffer, record.data) :
+					(record.op == TraceOp::CreateTexture) ? backend.CreateTexture(record.texture) :
+					backend.CreatePipeline(record.pipeline);
+
+				// The reader checked the id is the next one, these grow by one entry per resource
+				m_Handles.resize(record.id + 1, 0);
+				m_BufferSizes.resize(record.id + 1, 0);
+				m_Handles[record.id] = handle;
+				m_BufferSizes[record.id] = (record.op == TraceOp::CreateBuffer) ? record.buffer.size : 0;
+
+				if (!handle)
+					m_Stats.missingResources++;
+				break;
+			}
+			case TraceOp::Destroy:
+				if (BackendHandle handle = Resolve(record.id))
+				{
+					backend.Destroy(handle);
+					m_Handles[record.id] = 0;
+				}
+				break;
+			case TraceOp::WriteBuffer:
+				if (BackendHandle handle = Resolve(record.id))
+				{
+					if (!IsInBuffer(record.id, record.args[1], record.dataSize))
+						m_Stats.malformedRecords++;
+					else if (uint8_t* memory = static_cast<uint8_t*>(backend.Map(handle, static_cast<BackendMap>(record.args[0]))))
+					{
+						memcpy(memory + record.args[1], record.data, record.dataSize);
+						backend.Unmap(handle, record.args[1], record.dataSize);
+					}
+				}
+				break;
+			case TraceOp::UpdateBuffer:
+				if (BackendHandle handle = Resolve(record.id))
+				{
+					if (!IsInBuffer(record.id, record.args[0], record.dataSize))
+						m_Stats.malformedRecords++;
+					else
+						backend.UpdateBuffer(handle, record.args[0], record.data, record.dataSize);
+				}
+				break;
+			case TraceOp::CopyBuffer:
+			{
+				BackendHandle destination = Resolve(record.id);
+				BackendHandle source = Resolve(record.secondId);
+				if (!destination || !source)
+					break;
+
+				if (!IsInBuffer(record.id, record.args[0], record.args[2]) || !IsInBuffer(record.secondId, record.args[1], record.args[2]))
+					m_Stats.malformedRecords++;
+				else
+					backend.CopyBuffer(destination, record.args[0], source, record.args[1], record.args[2]);
+				break;
+			}
+			case TraceOp::SetPipeline:
+				backend.SetPipeline(Resolve(record.id));
+				break;
+			case TraceOp::SetVertexBuffer:
+				backend.SetVertexBuffer(record.args[0], Resolve(record.id), record.args[1], record.args[2]);
+				break;
+			case TraceOp::SetIndexBuffer:
+				backend.SetIndexBuffer(Resolve(record.id), static_cast<BackendFormat>(record.args[0]), record.args[1]);
+				break;
+			case TraceOp::SetConstantBuffer:
+				backend.SetConstantBuffer(record.args[0], Resolve(record.id), record.args[1], record.args[2]);
+				break;
+			case TraceOp::SetRenderTargets:
+				backend.SetRenderTargets(Resolve(record.id), Resolve(record.secondId));
+				break;
+			case TraceOp::SetViewport:
+				backend.SetViewport(record.values[0], record.values[1]);
+				break;
+			case TraceOp::SetTopology:
+				backend.SetTopology(static_cast<BackendTopology>(record.args[0]));
+				break;
+			case TraceOp::ClearColor:
+				backend.ClearColor(Resolve(record.id), record.values);
+				break;
+			case TraceOp::ClearDepth:
+				backend.ClearDepth(Resolve(record.id), record.values[0]);
+				break;
+			case TraceOp::DrawIndexed:
+				backend.DrawIndexed(record.args[0], record.args[1], record.args[2], static_cast<int32_t>(record.args[3]), record.args[4]);
+				break;
+			case TraceOp::Present:
+				m_LastPresented = Resolve(record.id);
+				backend.Present(m_LastPresented);
+				break;
+			default:
+				break; // Redundant: never reached the backend when it was captured either
+			}
+
+			const Clock::time_point commandEnd = (timeCommands || record.op == TraceOp::Present) ? Clock::now() : start;
+			if (timeCommands)
+				m_Stats.milliseconds[op] += ElapsedMilliseconds(commandStart, commandEnd);
+			m_Stats.counts[op]++;
+
+			if (record.op == TraceOp::Present)
+			{
+				double frameMilliseconds = ElapsedMilliseconds(frameStart, commandEnd);
+				m_Stats.frameMilliseconds = (frameMilliseconds > m_Stats.frameMilliseconds) ? frameMilliseconds : m_Stats.frameMilliseconds;
+				m_Stats.frames++;
+				frameStart = commandEnd;
+			}
+		}
+
+		m_Stats.totalMilliseconds = ElapsedMilliseconds(start, Clock::now());
+
+		if (!reader.IsValid())
+		{
+			std::cerr << "[CommandReplayer] Malformed trace, replay stopped.\n";
+			return false;
+		}
+
+		if (m_Stats.malformedRecords)
+			std::cerr << "[CommandReplayer] Skipped " << m_Stats.malformedRecords << " uploads or copies outside their buffer.\n";
+
+		return true;
+	}
+}
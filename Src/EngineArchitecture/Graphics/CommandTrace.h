@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RenderBackend.h"
+
+namespace Graphics
+{
+	// One record per backend call, plus Redundant for the calls CommandList filtered out
+	enum class TraceOp : uint8_t
+	{
+		CreateBuffer,
+		CreateTexture,
+		CreatePipeline,
+		Destroy,
+		WriteBuffer, // Map/Unmap, only the range the caller wrote
+		UpdateBuffer,
+		CopyBuffer,
+		SetPipeline,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetConstantBuffer,
+		SetRenderTargets,
+		SetViewport,
+		SetTopology,
+		ClearColor,
+		ClearDepth,
+		DrawIndexed,
+		Present, // Ends a frame
+		Redundant, // Dropped by CommandList, args[0] is the op it would have been
+		Count
+	};
+
+	const char* GetTraceOpName(TraceOp op);
+
+	// A decoded record. Resources are referred to by trace ids, numbered in creation order from 1, never by backend handles.
+	struct TraceRecord
+	{
+		TraceOp op = TraceOp::Present;
+		uint32_t id = 0; // Created or destroyed resource, pipeline, buffer, destination or color target
+		uint32_t secondId = 0; // Depth target, copy source
+		uint32_t args[5] = {}; // Remaining integer arguments in the order of the RenderBackend method
+		float values[4] = {}; // Viewport size, clear color or depth
+		const uint8_t* data = nullptr; // Initial data or written bytes, points into the trace
+		uint32_t dataSize = 0;
+
+		BackendBufferDesc buffer;
+		BackendTextureDesc texture;
+		BackendPipelineDesc pipeline; // Strings point into the reader, valid until the next record
+	};
+
+	struct TraceStats
+	{
+		uint64_t records = 0;
+		uint64_t frames = 0; // Present records, commands after the last one are a partial frame
+		uint64_t opCounts[static_cast<uint32_t>(TraceOp::Count)] = {};
+		uint64_t draws = 0;
+		uint64_t instances = 0;
+		uint64_t indices = 0;
+		uint64_t bytesUploaded = 0; // Initial data, written ranges and UpdateBuffer
+		uint64_t bytesCopied = 0;
+		uint64_t filteredBinds = 0; // Redundant records, calls CommandList kept away from the backend
+		uint64_t redundantBinds = 0; // Binds that reached the backend without changing its state, should stay 0
+		uint64_t peakResources = 0;
+	};
+
+	// Compact binary command stream: a header followed by records of one op byte and LEB128 integers, floats are stored
+	// as their bits and data blocks are length prefixed. Written by CommandCapture, read by CommandReplayer.
+	class CommandTrace
+	{
+	public:
+		static constexpr uint32_t Magic = 0x52544344; // "DCTR"
+		static constexpr uint32_t Version = 1;
+
+		CommandTrace() { Clear(); }
+
+		void Clear(); // Header only
+		bool Load(const std::string& path);
+		bool Save(const std::string& path) const;
+
+		const std::vector<uint8_t>& GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Data.size(); }
+
+		// Walks the stream once: counts, upload volume and binds the backend did not need. False on a malformed trace.
+		bool Analyze(TraceStats& stats) const;
+
+		// Copies frames [firstFrame, firstFrame + frameCount) into a trace of their own. It starts with a snapshot of every
+		// resource alive at firstFrame, buffers with the contents they had then, and of the bound state, so it replays alone.
+		// Resources are numbered again from 1 in the range.
+		bool Extract(uint32_t firstFrame, uint32_t frameCount, CommandTrace& range) const;
+
+		void Write(const TraceRecord& record); // Encodes the fields the op uses, TraceReader::Next() is the inverse
+		void Append(const uint8_t* begin, const uint8_t* end) { m_Data.insert(m_Data.end(), begin, end); } // Records copied verbatim
+
+	private:
+		void WriteUInt(uint64_t value);
+		void WriteInt(int32_t value); // Zigzag, small negative values stay short
+		void WriteFloat(float value);
+		void WriteBytes(const void* data, uint32_t size);
+		void WriteString(const char* text); // nullptr and "" are told apart
+
+		std::vector<uint8_t> m_Data;
+	};
+
+	// Decodes a trace one record at a time
+	class TraceReader
+	{
+	public:
+		explicit TraceReader(const CommandTrace& trace);
+
+		bool IsValid() const { return m_Valid; } // Header matched, no record was cut short or created an id out of order
+		bool Next(TraceRecord& record); // False at the end or on a malformed record
+		const uint8_t* GetRecordBegin() const { return m_RecordBegin; } // Bytes of the last record, for verbatim copies
+		const uint8_t* GetRecordEnd() const { return m_Cursor; }
+
+	private:
+		bool ReadUInt(uint64_t& value);
+		bool ReadUInt(uint32_t& value);
+		bool ReadInt(int32_t& value);
+		bool ReadFloat(float& value);
+		bool ReadBytes(const uint8_t*& data, uint32_t& size);
+		bool ReadString(const char*& text, std::string& storage);
+		bool ReadPipeline(BackendPipelineDesc& desc);
+
+		const uint8_t* m_Cursor = nullptr;
+		const uint8_t* m_End = nullptr;
+		const uint8_t* m_RecordBegin = nullptr;
+		bool m_Valid = false;
+		uint32_t m_NextId = 1; // The id the next created resource must have
+
+		std::vector<std::string> m_Semantics; // Storage behind the pipeline strings of the current record
+		std::string m_VertexEntry;
+		std::string m_PixelEntry;
+	};
+
+	// Records every call into a trace and forwards it to the backend it wraps, so a captured run renders as usual.
+	// Initialize the engine with the capture instead of the backend, and hand it to CommandList::SetCapture() to
+	// also record the calls the command list filters out.
+	class CommandCapture : public RenderBackend
+	{
+	public:
+		explicit CommandCapture(RenderBackend& target) : m_Target(target) {}
+		CommandCapture(const CommandCapture&) = delete;
+		CommandCapture& operator=(const CommandCapture&) = delete;
+
+		const char* GetName() const override { return m_Target.GetName(); }
+
+		BackendHandle CreateBuffer(const BackendBufferDesc& desc, const void* initialData) override;
+		BackendHandle CreateTexture(const BackendTextureDesc& desc) override;
+		BackendHandle CreatePipeline(const BackendPipelineDesc& desc) override;
+		void Destroy(BackendHandle handle) override;
+
+		void* Map(BackendHandle buffer, BackendMap mode) override;
+		void Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize) override;
+		void UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size) override;
+		void CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size) override;
+
+		void SetPipeline(BackendHandle pipeline) override;
+		void SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset) override;
+		void SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset) override;
+		void SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+		void SetRenderTargets(BackendHandle color, BackendHandle depth) override;
+		void SetViewport(float width, float height) override;
+		void SetTopology(BackendTopology topology) override;
+		void ClearColor(BackendHandle color, const float rgba[4]) override;
+		void ClearDepth(BackendHandle depth, float value) override;
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+		void Present(BackendHandle color) override;
+
+		void RecordRedundant(TraceOp op); // From CommandList, the call never reaches the backend
+
+		const CommandTrace& GetTrace() const { return m_Trace; }
+		bool Save(const std::string& path) const { return m_Trace.Save(path); }
+
+	private:
+		struct Mapping
+		{
+			uint8_t* memory = nullptr;
+			BackendMap mode = BackendMap::Discard;
+		};
+
+		uint32_t AddResource(BackendHandle handle); // Returns the new trace id
+		uint32_t GetId(BackendHandle handle) const; // 0 for handles created before the capture
+
+		RenderBackend& m_Target;
+		CommandTrace m_Trace;
+		std::unordered_map<BackendHandle, uint32_t> m_Ids;
+		std::unordered_map<BackendHandle, Mapping> m_Mapped;
+		uint32_t m_NextId = 1;
+	};
+
+	struct TraceReplayStats
+	{
+		uint64_t frames = 0;
+		uint64_t counts[static_cast<uint32_t>(TraceOp::Count)] = {};
+		double milliseconds[static_cast<uint32_t>(TraceOp::Count)] = {}; // Time spent in the backend call, per op
+		double totalMilliseconds = 0.0; // Decoding included
+		double frameMilliseconds = 0.0; // Slowest frame
+		uint64_t missingResources = 0; // Records naming an id that failed to create or was never created
+		uint64_t malformedRecords = 0; // Uploads and copies reaching outside their buffer, skipped
+	};
+
+	// Re-issues a trace against any backend. Trace ids are mapped to whatever handles the backend hands out.
+	class CommandReplayer
+	{
+	public:
+		CommandReplayer() = default;
+		~CommandReplayer() = default;
+		CommandReplayer(const CommandReplayer&) = delete;
+		CommandReplayer& operator=(const CommandReplayer&) = delete;
+
+		// Frame range as in CommandTrace::Extract, frameCount ~0u runs to the end. timeCommands measures every call
+		// on its own, at the cost of two clock reads per record.
+		bool Replay(const CommandTrace& trace, RenderBackend& backend, uint32_t firstFrame = 0, uint32_t frameCount = ~0u, bool timeCommands = true);
+		void Release(); // Destroys what the replay created and is still alive, the backend must still exist
+
+		BackendHandle GetHandle(uint32_t id) const { return id < m_Handles.size() ? m_Handles[id] : 0; } // After Replay, e.g. to read a target back
+		BackendHandle GetLastPresented() const { return m_LastPresented; }
+		const TraceReplayStats& GetStats() const { return m_Stats; }
+
+	private:
+		bool Execute(const CommandTrace& trace, bool timeCommands);
+		BackendHandle Resolve(uint32_t id);
+		bool IsInBuffer(uint32_t id, uint32_t offset, uint32_t size) const;
+
+		RenderBackend* m_Backend = nullptr;
+		std::vector<BackendHandle> m_Handles; // Indexed by trace id
+		std::vector<uint32_t> m_BufferSizes; // Indexed by trace id, 0 for textures and pipelines
+		BackendHandle m_LastPresented = 0;
+		TraceReplayStats m_Stats;
+	};
+}
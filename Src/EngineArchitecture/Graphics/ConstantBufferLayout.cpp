@@ -0,0 +1,100 @@
+#include "ConstantBufferLayout.h"
+#include "Buffer.h"
+#include "Device.h"
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	bool ConstantBufferLayout::Initialize(const ShaderConstantBuffer& desc)
+	{
+		m_Variables = desc.variables;
+		m_Data.assign(desc.size, 0);
+		m_BindSlot = desc.bindSlot;
+		m_Dirty = true; // The first Commit() always uploads
+		m_Stats = {};
+		return true;
+	}
+
+	bool ConstantBufferLayout::Initialize(const ShaderReflection& reflection, const char* bufferName)
+	{
+		const ShaderConstantBuffer* desc = reflection.FindConstantBuffer(bufferName);
+		if (!desc)
+		{
+			std::cerr << "[ConstantBufferLayout] Shader has no cbuffer named " << bufferName << ".\n";
+			return false;
+		}
+
+		return Initialize(*desc);
+	}
+
+	int32_t ConstantBufferLayout::FindVariable(const char* name) const
+	{
+		for (size_t i = 0; i < m_Variables.size(); ++i)
+		{
+			if (m_Variables[i].name == name)
+				return static_cast<int32_t>(i);
+		}
+
+		return -1;
+	}
+
+	bool ConstantBufferLayout::SetVariable(int32_t index, const void* data, uint32_t size)
+	{
+		if (index < 0 || index >= static_cast<int32_t>(m_Variables.size()))
+			return false;
+
+		// Smaller writes are fine (a float3 into a float4), larger ones would spill into the next variable
+		const ShaderVariable& variable = m_Variables[index];
+		if (size > variable.size)
+		{
+			std::cerr << "[ConstantBufferLayout] " << variable.name << " is " << variable.size << " bytes, got " << size << ".\n";
+			return false;
+		}
+
+		uint8_t* target = m_Data.data() + variable.offset;
+		if (memcmp(target, data, size) == 0)
+		{
+			m_Stats.variablesSkipped++;
+			return true;
+		}
+
+		memcpy(target, data, size);
+		m_Dirty = true;
+		m_Stats.variablesWritten++;
+		return true;
+	}
+
+	bool ConstantBufferLayout::SetVariable(const char* name, const void* data, uint32_t size)
+	{
+		int32_t index = FindVariable(name);
+		if (index < 0)
+		{
+			std::cerr << "[ConstantBufferLayout] Unknown variable " << name << ".\n";
+			return false;
+		}
+
+		return SetVariable(index, data, size);
+	}
+
+	bool ConstantBufferLayout::CreateBuffer(const Device& device, Buffer& buffer) const
+	{
+		return buffer.Initialize(device, BufferType::ConstantBuffer, m_Data.data(), GetSize());
+	}
+
+	bool ConstantBufferLayout::CreateBuffer(BufferPool& pool, const Device& device, Buffer& buffer) const
+	{
+		return buffer.Initialize(pool, device, BufferType::ConstantBuffer, m_Data.data(), GetSize());
+	}
+
+	void ConstantBufferLayout::Commit(ID3D11DeviceContext* context, Buffer& buffer)
+	{
+		if (!m_Dirty)
+			return;
+
+		// Constant buffers are mapped with WRITE_DISCARD, so a dirty buffer is still uploaded whole
+		buffer.Update(context, m_Data.data(), GetSize());
+		m_Dirty = false;
+		m_Stats.commits++;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ShaderReflection.h"
+
+namespace Graphics
+{
+	class Device;
+	class Buffer;
+	class BufferPool;
+
+	struct ConstantLayoutStats
+	{
+		uint32_t variablesWritten = 0;
+		uint32_t variablesSkipped = 0; // SetVariable() calls whose value was already in the shadow
+		uint32_t commits = 0; // Uploads actually issued
+	};
+
+	// CPU image of one reflected cbuffer, written by variable name instead of through a hand-matched struct.
+	// Offsets come from the shader, so reordering or adding variables in HLSL needs no C++ change.
+	// Only variables whose value changed mark the buffer dirty; Commit() uploads nothing while it is clean.
+	class ConstantBufferLayout
+	{
+	public:
+		ConstantBufferLayout() = default;
+
+		bool Initialize(const ShaderConstantBuffer& desc);
+		bool Initialize(const ShaderReflection& reflection, const char* bufferName);
+
+		int32_t FindVariable(const char* name) const; // -1 when the shader does not declare it (or compiled it out)
+		bool SetVariable(int32_t index, const void* data, uint32_t size);
+		bool SetVariable(const char* name, const void* data, uint32_t size);
+
+		template <typename T>
+		bool Set(const char* name, const T& value) { return SetVariable(name, &value, sizeof(T)); }
+
+		bool CreateBuffer(const Device& device, Buffer& buffer) const; // Dynamic constant buffer with the current contents
+		bool CreateBuffer(BufferPool& pool, const Device& device, Buffer& buffer) const; // Same, recycled through the pool
+		void Commit(ID3D11DeviceContext* context, Buffer& buffer);
+
+		uint32_t GetSize() const { return static_cast<uint32_t>(m_Data.size()); }
+		uint32_t GetBindSlot() const { return m_BindSlot; }
+		const void* GetData() const { return m_Data.data(); }
+		bool IsDirty() const { return m_Dirty; }
+		const ConstantLayoutStats& GetStats() const { return m_Stats; }
+		void ResetStats() { m_Stats = {}; }
+
+	private:
+		std::vector<ShaderVariable> m_Variables;
+		std::vector<uint8_t> m_Data;
+		uint32_t m_BindSlot = 0;
+		bool m_Dirty = false;
+		ConstantLayoutStats m_Stats;
+	};
+}
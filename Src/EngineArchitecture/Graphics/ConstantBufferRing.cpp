@@ -0,0 +1,137 @@
+#include "ConstantBufferRing.h"
+#include "Device.h"
+#include "BackendBridge.h"
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	bool ConstantBufferRing::Initialize(const Device& device, uint32_t pageSize, uint32_t pageCount, uint32_t framesInFlight)
+	{
+		ID3D11Device* d3dDevice = device.GetDevice();
+		m_Backend = device.GetBackend();
+		if ((!d3dDevice && !m_Backend) || pageCount == 0 || framesInFlight == 0)
+			return false;
+
+		// Binding with offsets and NO_OVERWRITE on constant buffers both need the 11.1 runtime
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+		if (d3dDevice)
+			d3dDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+		if (d3dDevice && (!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer))
+		{
+			std::cerr << "[ConstantBufferRing] Constant buffer offsetting is not supported.\n";
+			return false;
+		}
+
+		m_PageSize = AlignSize(pageSize);
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = m_PageSize;
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		desc.MiscFlags = 0;
+
+		m_Pages.resize(pageCount);
+		for (Page& page : m_Pages)
+		{
+			if (!BackendBridge::CreateBuffer(m_Backend, d3dDevice, desc, nullptr, &page.buffer))
+			{
+				std::cerr << "[ConstantBufferRing] Failed to create ring page.\n";
+				Release();
+				return false;
+			}
+		}
+
+		if (!m_Fence.Initialize(device, framesInFlight))
+		{
+			std::cerr << "[ConstantBufferRing] Failed to create frame fence.\n";
+			Release();
+			return false;
+		}
+
+		m_CurrentPage = 0;
+		m_Head = 0;
+		m_NeedsDiscard = true;
+
+		return true;
+	}
+
+	void ConstantBufferRing::BeginFrame(ID3D11DeviceContext* context)
+	{
+		m_Fence.Poll(context);
+		m_Stats = {};
+	}
+
+	void ConstantBufferRing::EndFrame(ID3D11DeviceContext* context)
+	{
+		m_Fence.Signal(context);
+	}
+
+	bool ConstantBufferRing::Allocate(ID3D11DeviceContext* context, const void* data, uint32_t size, ConstantAllocation& allocation)
+	{
+		if ((!context && !m_Backend) || m_Pages.empty())
+			return false;
+
+		uint32_t alignedSize = AlignSize(size);
+		if (alignedSize > m_PageSize)
+		{
+			std::cerr << "[ConstantBufferRing] Allocation is larger than a ring page.\n";
+			return false;
+		}
+
+		// Wrap onto the next page; rename it if the GPU may still be reading it
+		if (m_Head + alignedSize > m_PageSize)
+		{
+			m_CurrentPage = (m_CurrentPage + 1) % static_cast<uint32_t>(m_Pages.size());
+			m_Head = 0;
+			m_NeedsDiscard = !IsRetired(m_Pages[m_CurrentPage]);
+		}
+
+		Page& page = m_Pages[m_CurrentPage];
+
+		D3D11_MAP mapType = m_NeedsDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+		void* mapped = BackendBridge::Map(m_Backend, context, page.buffer, mapType);
+		if (!mapped)
+		{
+			std::cerr << "[ConstantBufferRing] Failed to map ring page.\n";
+			return false;
+		}
+
+		memcpy(static_cast<uint8_t*>(mapped) + m_Head, data, size);
+		BackendBridge::Unmap(m_Backend, context, page.buffer, m_Head, size);
+
+		if (m_NeedsDiscard)
+			m_Stats.discards++;
+
+		m_NeedsDiscard = false;
+		page.lastFrame = m_Fence.GetFrame();
+
+		allocation.buffer = page.buffer;
+		allocation.offset = m_Head;
+		allocation.size = alignedSize;
+
+		m_Head += alignedSize;
+
+		m_Stats.allocations++;
+		m_Stats.bytesAllocated += alignedSize;
+
+		return true;
+	}
+
+	void ConstantBufferRing::Release()
+	{
+		for (Page& page : m_Pages)
+			BackendBridge::Release(m_Backend, page.buffer);
+		m_Pages.clear();
+
+		m_Fence.Release();
+		m_Backend = nullptr;
+	}
+
+	ConstantBufferRing::~ConstantBufferRing()
+	{
+		Release();
+	}
+}
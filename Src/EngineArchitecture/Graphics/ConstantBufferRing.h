@@ -0,0 +1,79 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <vector>
+#include "FrameFence.h"
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace Graphics
+{
+	class Device;
+	class RenderBackend;
+
+	// A slice of one of the ring pages, bound with VSSetConstantBuffers1
+	struct ConstantAllocation
+	{
+		ID3D11Buffer* buffer = nullptr;
+		uint32_t offset = 0; // Byte offset inside the page (multiple of 256)
+		uint32_t size = 0; // Aligned size in bytes (multiple of 256)
+
+		uint32_t GetFirstConstant() const { return offset / 16; } // Offsets are in shader constants (16 bytes)
+		uint32_t GetNumConstants() const { return size / 16; }
+		bool IsValid() const { return buffer != nullptr; }
+	};
+
+	struct ConstantRingStats
+	{
+		uint32_t allocations = 0; // Allocations made this frame
+		uint32_t discards = 0; // Pages that had to be renamed with WRITE_DISCARD this frame
+		uint64_t bytesAllocated = 0; // Aligned bytes handed out this frame
+	};
+
+	// Sub-allocates constant data from a few large DYNAMIC buffers instead of one buffer per object.
+	// Allocations are appended with MAP_WRITE_NO_OVERWRITE; when the ring wraps onto a page the GPU
+	// may still be reading, the page is renamed with MAP_WRITE_DISCARD. Pages retire through a FrameFence.
+	class ConstantBufferRing
+	{
+	public:
+		static constexpr uint32_t Alignment = 256; // Required by the first-constant offsets (16 constants)
+
+		ConstantBufferRing() = default;
+		~ConstantBufferRing();
+
+		bool Initialize(const Device& device, uint32_t pageSize = 256 * 1024, uint32_t pageCount = 4, uint32_t framesInFlight = 3);
+		void Release();
+
+		void BeginFrame(ID3D11DeviceContext* context);
+		void EndFrame(ID3D11DeviceContext* context);
+
+		bool Allocate(ID3D11DeviceContext* context, const void* data, uint32_t size, ConstantAllocation& allocation);
+
+		const ConstantRingStats& GetStats() const { return m_Stats; }
+		uint32_t GetPageSize() const { return m_PageSize; }
+		uint32_t GetPageCount() const { return static_cast<uint32_t>(m_Pages.size()); }
+
+		static uint32_t AlignSize(uint32_t size) { return (size + Alignment - 1) & ~(Alignment - 1); }
+
+	private:
+		struct Page
+		{
+			ID3D11Buffer* buffer = nullptr;
+			uint64_t lastFrame = 0; // Last frame that wrote into this page (0 = never used, first write discards)
+		};
+
+		bool IsRetired(const Page& page) const { return page.lastFrame != 0 && m_Fence.IsComplete(page.lastFrame); }
+
+		std::vector<Page> m_Pages;
+		FrameFence m_Fence;
+		RenderBackend* m_Backend = nullptr; // Pages are backend handles when set
+
+		uint32_t m_PageSize = 0;
+		uint32_t m_CurrentPage = 0;
+		uint32_t m_Head = 0; // Next free byte in the current page
+		bool m_NeedsDiscard = false; // Next write into the current page must rename it
+
+		ConstantRingStats m_Stats;
+	};
+}
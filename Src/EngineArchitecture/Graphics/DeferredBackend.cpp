@@ -0,0 +1,112 @@
+#include "DeferredBackend.h"
+
+namespace Graphics
+{
+	DeferredBackend::Command& DeferredBackend::Record(Op op, BackendHandle handle, BackendHandle secondHandle)
+	{
+		m_Commands.emplace_back();
+
+		Command& command = m_Commands.back();
+		command.op = op;
+		command.handles[0] = handle;
+		command.handles[1] = secondHandle;
+		return command;
+	}
+
+	void DeferredBackend::SetPipeline(BackendHandle pipeline)
+	{
+		Record(Op::SetPipeline, pipeline);
+	}
+
+	void DeferredBackend::SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset)
+	{
+		Command& command = Record(Op::SetVertexBuffer, buffer);
+		command.args[0] = slot;
+		command.args[1] = stride;
+		command.args[2] = offset;
+	}
+
+	void DeferredBackend::SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset)
+	{
+		Command& command = Record(Op::SetIndexBuffer, buffer);
+		command.args[0] = static_cast<uint32_t>(format);
+		command.args[1] = offset;
+	}
+
+	void DeferredBackend::SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+	{
+		Command& command = Record(Op::SetConstantBuffer, buffer);
+		command.args[0] = slot;
+		command.args[1] = firstConstant;
+		command.args[2] = numConstants;
+	}
+
+	void DeferredBackend::SetRenderTargets(BackendHandle color, BackendHandle depth)
+	{
+		Record(Op::SetRenderTargets, color, depth);
+	}
+
+	void DeferredBackend::SetViewport(float width, float height)
+	{
+		Command& command = Record(Op::SetViewport);
+		command.values[0] = width;
+		command.values[1] = height;
+	}
+
+	void DeferredBackend::SetTopology(BackendTopology topology)
+	{
+		Record(Op::SetTopology).args[0] = static_cast<uint32_t>(topology);
+	}
+
+	void DeferredBackend::ClearColor(BackendHandle color, const float rgba[4])
+	{
+		Command& command = Record(Op::ClearColor, color);
+		for (uint32_t i = 0; i < 4; ++i)
+			command.values[i] = rgba[i];
+	}
+
+	void DeferredBackend::ClearDepth(BackendHandle depth, float value)
+	{
+		Record(Op::ClearDepth, depth).values[0] = value;
+	}
+
+	void DeferredBackend::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+	{
+		Command& command = Record(Op::DrawIndexed);
+		command.args[0] = indexCount;
+		command.args[1] = instanceCount;
+		command.args[2] = startIndex;
+		command.args[3] = static_cast<uint32_t>(baseVertex);
+		command.args[4] = startInstance;
+	}
+
+	void DeferredBackend::Present(BackendHandle color)
+	{
+		Record(Op::Present, color);
+	}
+
+	void DeferredBackend::Execute()
+	{
+		for (const Command& command : m_Commands)
+		{
+			const uint32_t* args = command.args;
+
+			switch (command.op)
+			{
+			case Op::SetPipeline: m_Target.SetPipeline(command.handles[0]); break;
+			case Op::SetVertexBuffer: m_Target.SetVertexBuffer(args[0], command.handles[0], args[1], args[2]); break;
+			case Op::SetIndexBuffer: m_Target.SetIndexBuffer(command.handles[0], static_cast<BackendFormat>(args[0]), args[1]); break;
+			case Op::SetConstantBuffer: m_Target.SetConstantBuffer(args[0], command.handles[0], args[1], args[2]); break;
+			case Op::SetRenderTargets: m_Target.SetRenderTargets(command.handles[0], command.handles[1]); break;
+			case Op::SetViewport: m_Target.SetViewport(command.values[0], command.values[1]); break;
+			case Op::SetTopology: m_Target.SetTopology(static_cast<BackendTopology>(args[0])); break;
+			case Op::ClearColor: m_Target.ClearColor(command.handles[0], command.values); break;
+			case Op::ClearDepth: m_Target.ClearDepth(command.handles[0], command.values[0]); break;
+			case Op::DrawIndexed: m_Target.DrawIndexed(args[0], args[1], args[2], static_cast<int32_t>(args[3]), args[4]); break;
+			case Op::Present: m_Target.Present(command.handles[0]); break;
+			}
+		}
+
+		m_Commands.clear();
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "RenderBackend.h"
+
+namespace Graphics
+{
+	// The backend counterpart of a deferred context: commands are stored in memory and replayed on the target,
+	// in recording order, by Execute(). Each instance belongs to one recording thread at a time.
+	//
+	// Resource calls are not recorded, they go straight to the target and must not be made while another
+	// thread drives it. ParallelSubmitter only records state and draw calls, every upload happens before.
+	class DeferredBackend : public RenderBackend
+	{
+	public:
+		explicit DeferredBackend(RenderBackend& target) : m_Target(target) {}
+		DeferredBackend(const DeferredBackend&) = delete;
+		DeferredBackend& operator=(const DeferredBackend&) = delete;
+
+		const char* GetName() const override { return m_Target.GetName(); }
+
+		BackendHandle CreateBuffer(const BackendBufferDesc& desc, const void* initialData) override { return m_Target.CreateBuffer(desc, initialData); }
+		BackendHandle CreateTexture(const BackendTextureDesc& desc) override { return m_Target.CreateTexture(desc); }
+		BackendHandle CreatePipeline(const BackendPipelineDesc& desc) override { return m_Target.CreatePipeline(desc); }
+		void Destroy(BackendHandle handle) override { m_Target.Destroy(handle); }
+
+		void* Map(BackendHandle buffer, BackendMap mode) override { return m_Target.Map(buffer, mode); }
+		void Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize) override { m_Target.Unmap(buffer, writtenOffset, writtenSize); }
+		void UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size) override { m_Target.UpdateBuffer(buffer, offset, data, size); }
+		void CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size) override { m_Target.CopyBuffer(destination, destinationOffset, source, sourceOffset, size); }
+
+		void SetPipeline(BackendHandle pipeline) override;
+		void SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset) override;
+		void SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset) override;
+		void SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+		void SetRenderTargets(BackendHandle color, BackendHandle depth) override;
+		void SetViewport(float width, float height) override;
+		void SetTopology(BackendTopology topology) override;
+		void ClearColor(BackendHandle color, const float rgba[4]) override;
+		void ClearDepth(BackendHandle depth, float value) override;
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+		void Present(BackendHandle color) override;
+
+		void Execute(); // Replays on the target and starts over, on the thread that owns the target
+		void Reset() { m_Commands.clear(); } // Drops the recorded commands without executing them
+		size_t GetCommandCount() const { return m_Commands.size(); }
+
+	private:
+		enum class Op : uint8_t
+		{
+			SetPipeline,
+			SetVertexBuffer,
+			SetIndexBuffer,
+			SetConstantBuffer,
+			SetRenderTargets,
+			SetViewport,
+			SetTopology,
+			ClearColor,
+			ClearDepth,
+			DrawIndexed,
+			Present
+		};
+
+		// Arguments in the order of the RenderBackend method
+		struct Command
+		{
+			Op op = Op::Present;
+			BackendHandle handles[2] = {};
+			uint32_t args[5] = {};
+			float values[4] = {};
+		};
+
+		Command& Record(Op op, BackendHandle handle = 0, BackendHandle secondHandle = 0);
+
+		RenderBackend& m_Target;
+		std::vector<Command> m_Commands; // Capacity is kept across frames
+	};
+}
@@ -1,7 +1,6 @@
-#pragma once
-
 #include "Device.h"
 #include "Adapter.h" // Incluye para acceder a GetAdapter()
+#include "RenderBackend.h"
 
 #include <iostream>
 
@@ -47,8 +46,57 @@ namespace Graphics
 		return true;
 	}
 
+	bool Device::Initialize(RenderBackend& backend)
+	{
+		Release();
+		m_Backend = &backend;
+
+		std::cout << "[Device] Using the " << backend.GetName() << " backend.\n";
+		return true;
+	}
+
+	bool Device::CreateDeferredContexts(uint32_t count)
+	{
+		if (!m_Device)
+			return false;
+
+		D3D11_FEATURE_DATA_THREADING threading = {};
+		if (SUCCEEDED(m_Device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+			m_DriverCommandLists = threading.DriverCommandLists != FALSE;
+
+		while (m_DeferredContexts.size() < count)
+		{
+			ID3D11DeviceContext* context = nullptr;
+			if (FAILED(m_Device->CreateDeferredContext(0, &context)))
+			{
+				std::cerr << "[Device] Failed to create deferred context.\n";
+				return false;
+			}
+
+			m_DeferredContexts.push_back(context);
+		}
+
+		return true;
+	}
+
+	void Device::ExecuteCommandLists(ID3D11CommandList* const* commandLists, uint32_t count)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (!commandLists[i])
+				continue;
+
+			m_Context->ExecuteCommandList(commandLists[i], FALSE);
+			commandLists[i]->Release();
+		}
+	}
+
 	void Device::Release()
 	{
+		for (ID3D11DeviceContext* context : m_DeferredContexts)
+			context->Release();
+		m_DeferredContexts.clear();
+
 		if (m_Context)
 		{
 			m_Context->Release();
@@ -59,6 +107,8 @@ namespace Graphics
 			m_Device->Release();
 			m_Device = nullptr;
 		}
+
+		m_Backend = nullptr;
 	}
 
 	Device::~Device()
@@ -2,12 +2,14 @@
 
 #include <d3d11.h>
 #include <cstdint>
+#include <vector>
 
 #pragma comment(lib, "d3d11.lib")
 
 namespace Graphics
 {
 	class Adapter; // Forward declaration
+	class RenderBackend;
 	class Device
 	{
 	public:
@@ -15,13 +17,25 @@ namespace Graphics
 		~Device();
 
 		bool Initialize(const Adapter& adapter);
+		bool Initialize(RenderBackend& backend); // Headless: no D3D11 device or context, resources and commands go to the backend
 		void Release();
 
 		ID3D11Device* GetDevice() const { return m_Device; }
-		ID3D11DeviceContext* GetContext() const { return m_Context; }
+		ID3D11DeviceContext* GetContext() const { return m_Context; } // nullptr with a backend
+		RenderBackend* GetBackend() const { return m_Backend; } // Owned by the caller, must outlive every resource
+
+		// Deferred contexts for recording on worker threads, executed on the immediate context in the order given
+		bool CreateDeferredContexts(uint32_t count);
+		ID3D11DeviceContext* GetDeferredContext(uint32_t index) const { return m_DeferredContexts[index]; }
+		uint32_t GetDeferredContextCount() const { return static_cast<uint32_t>(m_DeferredContexts.size()); }
+		bool HasDriverCommandLists() const { return m_DriverCommandLists; } // false: the runtime emulates command lists
+		void ExecuteCommandLists(ID3D11CommandList* const* commandLists, uint32_t count);
 
 	private:
 		ID3D11Device* m_Device = nullptr;
 		ID3D11DeviceContext* m_Context = nullptr;
+		RenderBackend* m_Backend = nullptr;
+		std::vector<ID3D11DeviceContext*> m_DeferredContexts;
+		bool m_DriverCommandLists = false;
 	};
 }
@@ -79,5 +79,28 @@ namespace Graphics
         XMFLOAT4 Color;
     };
 
+    // Compressed layouts, see VertexCompression.h. Positions are UNORM16 inside the mesh bounds
+    // (decoded with a PositionQuantization), normals and tangents octahedral SNORM16, texcoords half floats.
+    struct VertexPositionColorPacked
+    {
+        uint16_t Position[4]; // w unused, keeps the element 8-byte aligned
+        uint8_t Color[4]; // RGBA8 UNORM
+    };
+
+    struct VertexPositionNormalTexPacked
+    {
+        uint16_t Position[4];
+        int16_t Normal[2];
+        uint16_t TexCoord[2];
+    };
+
+    struct VertexPositionNormalTangentTexPacked
+    {
+        uint16_t Position[4];
+        int16_t Normal[2];
+        int16_t Tangent[2];
+        uint16_t TexCoord[2];
+    };
+
 
 } // namespace Graphics
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "FrameFence.h"
+#include "Device.h"
+#include <iostream>
+
+namespace Graphics
+{
+	bool FrameFence::Initialize(const Device& device, uint32_t framesInFlight)
+	{
+		Release();
+
+		ID3D11Device* d3dDevice = device.GetDevice();
+		m_Headless = device.GetBackend() != nullptr;
+		m_Frame = 1;
+		m_CompletedFrame = 0;
+
+		if (m_Headless)
+			return true;
+
+		if (!d3dDevice || framesInFlight == 0)
+			return false;
+
+		D3D11_QUERY_DESC queryDesc = {};
+		queryDesc.Query = D3D11_QUERY_EVENT;
+
+		m_Queries.resize(framesInFlight);
+		for (Query& query : m_Queries)
+		{
+			if (FAILED(d3dDevice->CreateQuery(&queryDesc, &query.query)))
+			{
+				std::cerr << "[FrameFence] Failed to create frame query.\n";
+				Release();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void FrameFence::Poll(ID3D11DeviceContext* context)
+	{
+		if (!context)
+			return;
+
+		for (Query& query : m_Queries)
+		{
+			if (query.frame <= m_CompletedFrame)
+				continue;
+
+			if (context->GetData(query.query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK)
+				m_CompletedFrame = query.frame;
+		}
+	}
+
+	void FrameFence::Signal(ID3D11DeviceContext* context)
+	{
+		if (m_Headless)
+		{
+			m_CompletedFrame = m_Frame++;
+			return;
+		}
+
+		if (!context || m_Queries.empty())
+			return;
+
+		// Reusing a slot whose frame is still pending only makes the completion check more conservative
+		Query& query = m_Queries[m_Frame % m_Queries.size()];
+		context->End(query.query);
+		query.frame = m_Frame;
+
+		m_Frame++;
+	}
+
+	void FrameFence::Release()
+	{
+		for (Query& query : m_Queries)
+		{
+			if (query.query)
+			{
+				query.query->Release();
+				query.query = nullptr;
+			}
+		}
+		m_Queries.clear();
+	}
+
+	FrameFence::~FrameFence()
+	{
+		Release();
+	}
+}
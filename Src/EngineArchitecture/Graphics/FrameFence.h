@@ -0,0 +1,45 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <vector>
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace Graphics
+{
+	class Device;
+
+	// Tells which frames the GPU has finished. Signal() ends an event query after the last command of a frame,
+	// Poll() collects the finished ones without flushing. Backends have finished a frame once Present() returns
+	// and need no queries.
+	class FrameFence
+	{
+	public:
+		FrameFence() = default;
+		~FrameFence();
+
+		bool Initialize(const Device& device, uint32_t framesInFlight = 3);
+		void Release();
+
+		void Poll(ID3D11DeviceContext* context); // Start of the frame
+		void Signal(ID3D11DeviceContext* context); // End of the frame, starts recording the next one
+
+		uint64_t GetFrame() const { return m_Frame; } // Frame being recorded, the first one is 1
+		uint64_t GetCompletedFrame() const { return m_CompletedFrame; }
+		bool IsComplete(uint64_t frame) const { return frame <= m_CompletedFrame; }
+
+	private:
+		struct Query
+		{
+			ID3D11Query* query = nullptr;
+			uint64_t frame = 0; // Frame signaled by this query (0 = not issued)
+		};
+
+		std::vector<Query> m_Queries;
+		bool m_Headless = false; // Backend device, frames complete when they are signaled
+
+		uint64_t m_Frame = 1;
+		uint64_t m_CompletedFrame = 0;
+	};
+}
@@ -0,0 +1,295 @@
+#include "GeometryArena.h"
+#include "Device.h"
+#include "CommandList.h"
+#include "IndexUtils.h"
+#include "BackendBridge.h"
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	bool GeometryArena::Initialize(const Device& device, uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity, DXGI_FORMAT indexFormat)
+	{
+		return InitializeSplit(device, vertexStride, vertexStride, vertexCapacity, indexCapacity, indexFormat);
+	}
+
+	bool GeometryArena::InitializeSplit(const Device& device, uint32_t vertexStride, uint32_t positionStride, uint32_t vertexCapacity, uint32_t indexCapacity, DXGI_FORMAT indexFormat)
+	{
+		m_Device = device.GetDevice();
+		m_Backend = device.GetBackend();
+		if ((!m_Device && !m_Backend) || vertexStride == 0 || positionStride == 0 || positionStride > vertexStride)
+			return false;
+
+		m_VertexStride = positionStride;
+		m_AttributeStride = vertexStride - positionStride; // 0 keeps the arena interleaved
+		m_IndexFormat = indexFormat;
+		m_IndexSize = (indexFormat == DXGI_FORMAT_R16_UINT) ? 2 : 4;
+
+		m_VertexRanges.Reset(vertexCapacity);
+		m_IndexRanges.Reset(indexCapacity);
+
+		if (!CreateBuffers(&m_VertexBuffer, &m_AttributeBuffer, &m_IndexBuffer))
+		{
+			std::cerr << "[GeometryArena] Failed to create arena buffers.\n";
+			Release();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool GeometryArena::CreateBuffers(ID3D11Buffer** vertexBuffer, ID3D11Buffer** attributeBuffer, ID3D11Buffer** indexBuffer)
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = 0;
+
+		desc.ByteWidth = m_VertexRanges.GetCapacity() * m_VertexStride;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		if (!BackendBridge::CreateBuffer(m_Backend, m_Device, desc, nullptr, vertexBuffer))
+			return false;
+
+		*attributeBuffer = nullptr;
+		if (m_AttributeStride)
+		{
+			desc.ByteWidth = m_VertexRanges.GetCapacity() * m_AttributeStride;
+			if (!BackendBridge::CreateBuffer(m_Backend, m_Device, desc, nullptr, attributeBuffer))
+			{
+				BackendBridge::Release(m_Backend, *vertexBuffer);
+				return false;
+			}
+		}
+
+		desc.ByteWidth = m_IndexRanges.GetCapacity() * m_IndexSize;
+		desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		if (!BackendBridge::CreateBuffer(m_Backend, m_Device, desc, nullptr, indexBuffer))
+		{
+			BackendBridge::Release(m_Backend, *vertexBuffer);
+			BackendBridge::Release(m_Backend, *attributeBuffer);
+			return false;
+		}
+
+		return true;
+	}
+
+	GeometryHandle GeometryArena::Allocate(ID3D11DeviceContext* context, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		if ((!context && !m_Backend) || !m_VertexBuffer || !vertices || !indices || vertexCount == 0 || indexCount == 0)
+			return InvalidGeometry;
+
+		if (m_FreeEntries.empty() && m_Entries.size() >= MaxEntries)
+		{
+			std::cerr << "[GeometryArena] Out of mesh handles.\n";
+			return InvalidGeometry;
+		}
+
+		std::vector<uint16_t> narrowed;
+		const void* indexData = indices;
+
+		if (m_IndexSize == 2)
+		{
+			if (!CanNarrowIndices(indices, indexCount))
+			{
+				std::cerr << "[GeometryArena] Mesh indices do not fit in a 16-bit arena.\n";
+				return InvalidGeometry;
+			}
+
+			narrowed.resize(indexCount);
+			NarrowIndices(indices, narrowed.data(), indexCount);
+			indexData = narrowed.data();
+		}
+
+		uint32_t baseVertex = m_VertexRanges.Allocate(vertexCount);
+		if (baseVertex == RangeAllocator::InvalidOffset)
+		{
+			std::cerr << "[GeometryArena] Out of vertex space.\n";
+			return InvalidGeometry;
+		}
+
+		uint32_t firstIndex = m_IndexRanges.Allocate(indexCount);
+		if (firstIndex == RangeAllocator::InvalidOffset)
+		{
+			std::cerr << "[GeometryArena] Out of index space.\n";
+			m_VertexRanges.Free(baseVertex, vertexCount);
+			return InvalidGeometry;
+		}
+
+		if (m_AttributeStride)
+		{
+			// Deinterleave once here, draws never pay for it
+			const uint32_t vertexStride = m_VertexStride + m_AttributeStride;
+			const uint8_t* source = static_cast<const uint8_t*>(vertices);
+
+			m_SplitScratch.resize(static_cast<size_t>(vertexCount) * vertexStride);
+			uint8_t* positions = m_SplitScratch.data();
+			uint8_t* attributes = positions + static_cast<size_t>(vertexCount) * m_VertexStride;
+
+			for (uint32_t i = 0; i < vertexCount; ++i)
+			{
+				memcpy(positions + static_cast<size_t>(i) * m_VertexStride, source, m_VertexStride);
+				memcpy(attributes + static_cast<size_t>(i) * m_AttributeStride, source + m_VertexStride, m_AttributeStride);
+				source += vertexStride;
+			}
+
+			BackendBridge::UpdateBuffer(m_Backend, context, m_AttributeBuffer, baseVertex * m_AttributeStride, attributes, vertexCount * m_AttributeStride);
+			vertices = positions;
+		}
+
+		BackendBridge::UpdateBuffer(m_Backend, context, m_VertexBuffer, baseVertex * m_VertexStride, vertices, vertexCount * m_VertexStride);
+		BackendBridge::UpdateBuffer(m_Backend, context, m_IndexBuffer, firstIndex * m_IndexSize, indexData, indexCount * m_IndexSize);
+
+		uint32_t index;
+		if (!m_FreeEntries.empty())
+		{
+			index = m_FreeEntries.back();
+			m_FreeEntries.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(m_Entries.size());
+			m_Entries.emplace_back();
+		}
+
+		Entry& entry = m_Entries[index];
+		entry.live = true;
+		entry.range.firstIndex = firstIndex;
+		entry.range.baseVertex = static_cast<int32_t>(baseVertex);
+		entry.range.indexCount = indexCount;
+		entry.range.vertexCount = vertexCount;
+
+		return (entry.generation << IndexBits) | index;
+	}
+
+	const GeometryArena::Entry* GeometryArena::Find(GeometryHandle handle) const
+	{
+		const uint32_t index = handle & IndexMask;
+		if (handle == InvalidGeometry || index >= m_Entries.size())
+			return nullptr;
+
+		const Entry& entry = m_Entries[index];
+		if (!entry.live || entry.generation != (handle >> IndexBits))
+			return nullptr;
+
+		return &entry;
+	}
+
+	void GeometryArena::Free(GeometryHandle handle)
+	{
+		// A double Free after the entry was reused must not release the new mesh's ranges
+		if (!Find(handle))
+			return;
+
+		const uint32_t index = handle & IndexMask;
+		Entry& entry = m_Entries[index];
+		m_VertexRanges.Free(static_cast<uint32_t>(entry.range.baseVertex), entry.range.vertexCount);
+		m_IndexRanges.Free(entry.range.firstIndex, entry.range.indexCount);
+
+		const uint32_t generation = (entry.generation + 1) & GenerationMask;
+		entry = {};
+		entry.generation = generation;
+		m_FreeEntries.push_back(index);
+	}
+
+	const GeometryRange& GeometryArena::GetRange(GeometryHandle handle) const
+	{
+		static const GeometryRange s_EmptyRange;
+
+		const Entry* entry = Find(handle);
+		return entry ? entry->range : s_EmptyRange;
+	}
+
+	bool GeometryArena::Compact(ID3D11DeviceContext* context)
+	{
+		if ((!context && !m_Backend) || !m_VertexBuffer)
+			return false;
+
+		ID3D11Buffer* vertexBuffer = nullptr;
+		ID3D11Buffer* attributeBuffer = nullptr;
+		ID3D11Buffer* indexBuffer = nullptr;
+		if (!CreateBuffers(&vertexBuffer, &attributeBuffer, &indexBuffer))
+		{
+			std::cerr << "[GeometryArena] Failed to create compaction buffers.\n";
+			return false;
+		}
+
+		RangeAllocator vertexRanges;
+		RangeAllocator indexRanges;
+		vertexRanges.Reset(m_VertexRanges.GetCapacity());
+		indexRanges.Reset(m_IndexRanges.GetCapacity());
+
+		// Handles stay valid, only their ranges move
+		for (Entry& entry : m_Entries)
+		{
+			if (!entry.live)
+				continue;
+
+			GeometryRange& range = entry.range;
+			uint32_t baseVertex = vertexRanges.Allocate(range.vertexCount);
+			uint32_t firstIndex = indexRanges.Allocate(range.indexCount);
+
+			const uint32_t oldBaseVertex = static_cast<uint32_t>(range.baseVertex);
+			BackendBridge::CopyBuffer(m_Backend, context, vertexBuffer, baseVertex * m_VertexStride, m_VertexBuffer, oldBaseVertex * m_VertexStride, range.vertexCount * m_VertexStride);
+
+			if (m_AttributeStride)
+				BackendBridge::CopyBuffer(m_Backend, context, attributeBuffer, baseVertex * m_AttributeStride, m_AttributeBuffer, oldBaseVertex * m_AttributeStride, range.vertexCount * m_AttributeStride);
+
+			BackendBridge::CopyBuffer(m_Backend, context, indexBuffer, firstIndex * m_IndexSize, m_IndexBuffer, range.firstIndex * m_IndexSize, range.indexCount * m_IndexSize);
+
+			range.baseVertex = static_cast<int32_t>(baseVertex);
+			range.firstIndex = firstIndex;
+		}
+
+		BackendBridge::Release(m_Backend, m_VertexBuffer);
+		BackendBridge::Release(m_Backend, m_IndexBuffer);
+		BackendBridge::Release(m_Backend, m_AttributeBuffer);
+
+		m_VertexBuffer = vertexBuffer;
+		m_AttributeBuffer = attributeBuffer;
+		m_IndexBuffer = indexBuffer;
+		m_VertexRanges = vertexRanges;
+		m_IndexRanges = indexRanges;
+
+		return true;
+	}
+
+	void GeometryArena::Bind(CommandList& commandList, VertexStream streams)
+	{
+		if (!m_VertexBuffer)
+			return;
+
+		// Redundant after the first mesh of the arena, the command list filters those
+		if (!m_AttributeStride || HasStream(streams, VertexStream::Position))
+			commandList.BindVertexBuffer(m_VertexBuffer, PositionStreamSlot, m_VertexStride, 0);
+		if (m_AttributeStride && HasStream(streams, VertexStream::Attributes))
+			commandList.BindVertexBuffer(m_AttributeBuffer, AttributeStreamSlot, m_AttributeStride, 0);
+
+		commandList.SetIndexBuffer(m_IndexBuffer, m_IndexFormat, 0);
+	}
+
+	GeometryArenaStats GeometryArena::GetStats() const
+	{
+		GeometryArenaStats stats = {};
+		stats.meshes = static_cast<uint32_t>(m_Entries.size() - m_FreeEntries.size());
+		stats.verticesUsed = m_VertexRanges.GetUsed();
+		stats.indicesUsed = m_IndexRanges.GetUsed();
+		stats.freeVertexBlocks = m_VertexRanges.GetFreeBlockCount();
+		stats.freeIndexBlocks = m_IndexRanges.GetFreeBlockCount();
+		return stats;
+	}
+
+	void GeometryArena::Release()
+	{
+		BackendBridge::Release(m_Backend, m_VertexBuffer);
+		BackendBridge::Release(m_Backend, m_AttributeBuffer);
+		BackendBridge::Release(m_Backend, m_IndexBuffer);
+
+		m_Entries.clear();
+		m_FreeEntries.clear();
+	}
+
+	GeometryArena::~GeometryArena()
+	{
+		Release();
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <vector>
+#include "RangeAllocator.h"
+#include "VertexInputElement.h"
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace Graphics
+{
+	class Device;
+	class CommandList;
+	class RenderBackend;
+
+	// Entry index in the low bits, generation above: a handle freed and reused by another mesh no longer matches
+	using GeometryHandle = uint32_t;
+	static constexpr GeometryHandle InvalidGeometry = ~0u;
+
+	// Where a mesh lives inside the arena, ready for DrawIndexed
+	struct GeometryRange
+	{
+		uint32_t firstIndex = 0;
+		int32_t baseVertex = 0;
+		uint32_t indexCount = 0;
+		uint32_t vertexCount = 0;
+	};
+
+	struct GeometryArenaStats
+	{
+		uint32_t meshes = 0;
+		uint32_t verticesUsed = 0;
+		uint32_t indicesUsed = 0;
+		uint32_t freeVertexBlocks = 0; // More than one block means the arena is fragmented
+		uint32_t freeIndexBlocks = 0;
+	};
+
+	// Packs all static meshes of one vertex layout into a single vertex buffer and index buffer,
+	// so consecutive draws only change firstIndex/baseVertex and never rebind buffers.
+	// Indices are stored relative to baseVertex, which keeps most meshes in R16_UINT.
+	// A split arena keeps positions and the remaining attributes in two vertex buffers (same vertex ranges),
+	// so passes that only read positions fetch a fraction of the bytes.
+	class GeometryArena
+	{
+	public:
+		GeometryArena() = default;
+		~GeometryArena();
+
+		bool Initialize(const Device& device, uint32_t vertexStride, uint32_t vertexCapacity = 1024 * 1024, uint32_t indexCapacity = 4 * 1024 * 1024, DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT);
+		// Vertices are still passed interleaved to Allocate, the first positionStride bytes of each go to the position stream
+		bool InitializeSplit(const Device& device, uint32_t vertexStride, uint32_t positionStride, uint32_t vertexCapacity = 1024 * 1024, uint32_t indexCapacity = 4 * 1024 * 1024, DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT);
+		void Release();
+
+		GeometryHandle Allocate(ID3D11DeviceContext* context, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+		void Free(GeometryHandle handle); // Ignored for invalid, freed or stale handles
+
+		// Offline pass (level load, streaming idle): moves every live mesh to the front of new buffers.
+		// The buffers are replaced, so command lists that bound the arena must InvalidateState() afterwards.
+		bool Compact(ID3D11DeviceContext* context);
+
+		void Bind(CommandList& commandList, VertexStream streams = VertexStream::All); // Interleaved arenas bind their single buffer either way
+
+		const GeometryRange& GetRange(GeometryHandle handle) const; // Empty range (indexCount 0) for freed, stale or invalid handles
+		GeometryArenaStats GetStats() const;
+
+		uint32_t GetVertexStride() const { return m_VertexStride; } // Of the position stream when split
+		uint32_t GetAttributeStride() const { return m_AttributeStride; } // 0 when interleaved
+		DXGI_FORMAT GetIndexFormat() const { return m_IndexFormat; }
+		ID3D11Buffer* GetVertexBuffer() const { return m_VertexBuffer; } // Slot PositionStreamSlot
+		ID3D11Buffer* GetAttributeBuffer() const { return m_AttributeBuffer; } // Slot AttributeStreamSlot, nullptr when interleaved
+		ID3D11Buffer* GetIndexBuffer() const { return m_IndexBuffer; }
+		bool IsSplit() const { return m_AttributeStride != 0; }
+
+	private:
+		static constexpr uint32_t IndexBits = 20;
+		static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+		static constexpr uint32_t MaxEntries = IndexMask; // Index IndexMask with the last generation would be InvalidGeometry
+		static constexpr uint32_t GenerationMask = ~0u >> IndexBits;
+
+		struct Entry
+		{
+			GeometryRange range;
+			uint32_t generation = 0; // Bumped by Free(), wraps after 4096 reuses of the entry
+			bool live = false;
+		};
+
+		const Entry* Find(GeometryHandle handle) const; // nullptr unless the handle names a live mesh of this generation
+
+		bool CreateBuffers(ID3D11Buffer** vertexBuffer, ID3D11Buffer** attributeBuffer, ID3D11Buffer** indexBuffer);
+
+		ID3D11Device* m_Device = nullptr;
+		RenderBackend* m_Backend = nullptr; // The buffers are backend handles when set
+		ID3D11Buffer* m_VertexBuffer = nullptr;
+		ID3D11Buffer* m_AttributeBuffer = nullptr;
+		ID3D11Buffer* m_IndexBuffer = nullptr;
+
+		uint32_t m_VertexStride = 0;
+		uint32_t m_AttributeStride = 0;
+		uint32_t m_IndexSize = 2;
+		DXGI_FORMAT m_IndexFormat = DXGI_FORMAT_R16_UINT;
+
+		RangeAllocator m_VertexRanges;
+		RangeAllocator m_IndexRanges;
+
+		std::vector<Entry> m_Entries;
+		std::vector<uint32_t> m_FreeEntries;
+		std::vector<uint8_t> m_SplitScratch; // Deinterleaved positions, then attributes, of the mesh being uploaded
+	};
+}
@@ -0,0 +1,56 @@
+#include "IndexUtils.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define INDEX_UTILS_SSE2
+#endif
+
+namespace Graphics
+{
+	bool CanNarrowIndices(const uint32_t* indices, size_t count)
+	{
+		size_t i = 0;
+		uint32_t bits = 0;
+
+#if defined(INDEX_UTILS_SSE2)
+		// OR every index together, only the high 16 bits of the result matter
+		__m128i accumulator = _mm_setzero_si128();
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4));
+			accumulator = _mm_or_si128(accumulator, _mm_or_si128(a, b));
+		}
+
+		__m128i high = _mm_srli_epi32(accumulator, 16);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xFFFF)
+			return false;
+#endif
+
+		for (; i < count; ++i)
+			bits |= indices[i];
+
+		return (bits >> 16) == 0;
+	}
+
+	void NarrowIndices(const uint32_t* source, uint16_t* destination, size_t count)
+	{
+		size_t i = 0;
+
+#if defined(INDEX_UTILS_SSE2)
+		// _mm_packs_epi32 saturates signed values, so bias into [-32768, 32767] and undo it after packing
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i a = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), bias32);
+			__m128i b = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4)), bias32);
+			__m128i packed = _mm_add_epi16(_mm_packs_epi32(a, b), bias16);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+		}
+#endif
+
+		for (; i < count; ++i)
+			destination[i] = static_cast<uint16_t>(source[i]);
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace Graphics
+{
+	// True when every index fits in 16 bits, so the buffer can use DXGI_FORMAT_R16_UINT
+	bool CanNarrowIndices(const uint32_t* indices, size_t count);
+
+	// Converts 32-bit indices to 16-bit; the caller must have checked CanNarrowIndices
+	void NarrowIndices(const uint32_t* source, uint16_t* destination, size_t count);
+}
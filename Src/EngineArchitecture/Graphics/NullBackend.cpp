@@ -0,0 +1,233 @@
+#include "NullBackend.h"
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	namespace
+	{
+		uint32_t GetFormatSize(BackendFormat format)
+		{
+			switch (format)
+			{
+			case BackendFormat::RGBA32Float: return 16;
+			case BackendFormat::RGB32Float: return 12;
+			case BackendFormat::RG32Float: return 8;
+			case BackendFormat::R16UInt: return 2;
+			case BackendFormat::Unknown: return 0;
+			default: return 4;
+			}
+		}
+
+		uint64_t GetTriangleCount(BackendTopology topology, uint32_t indexCount)
+		{
+			switch (topology)
+			{
+			case BackendTopology::TriangleList: return indexCount / 3;
+			case BackendTopology::TriangleStrip: return indexCount > 2 ? indexCount - 2 : 0;
+			default: return 0;
+			}
+		}
+	}
+
+	BackendHandle NullBackend::AddResource(ResourceKind kind, uint64_t bytes)
+	{
+		BackendHandle handle = m_NextHandle++;
+
+		std::unique_ptr<Resource> resource(new Resource());
+		resource->kind = kind;
+		resource->bytes = bytes;
+		m_Resources.emplace(handle, std::move(resource));
+
+		m_Stats.liveResources++;
+		m_Stats.liveBytes += bytes;
+		m_Stats.peakBytes = (m_Stats.liveBytes > m_Stats.peakBytes) ? m_Stats.liveBytes : m_Stats.peakBytes;
+		return handle;
+	}
+
+	NullBackend::Resource* NullBackend::Find(BackendHandle handle)
+	{
+		auto it = m_Resources.find(handle);
+		return (it != m_Resources.end()) ? it->second.get() : nullptr;
+	}
+
+	BackendHandle NullBackend::CreateBuffer(const BackendBufferDesc& desc, const void* initialData)
+	{
+		if (desc.size == 0)
+			return 0;
+
+		BackendHandle handle = AddResource(ResourceKind::Buffer, desc.size);
+		if (desc.dynamic)
+			Find(handle)->memory.resize(desc.size);
+
+		if (initialData)
+			m_Stats.bytesUploaded += desc.size;
+
+		m_Stats.buffersCreated++;
+		return handle;
+	}
+
+	BackendHandle NullBackend::CreateTexture(const BackendTextureDesc& desc)
+	{
+		if (desc.width == 0 || desc.height == 0)
+			return 0;
+
+		m_Stats.texturesCreated++;
+		return AddResource(ResourceKind::Texture, static_cast<uint64_t>(desc.width) * desc.height * GetFormatSize(desc.format));
+	}
+
+	BackendHandle NullBackend::CreatePipeline(const BackendPipelineDesc& desc)
+	{
+		m_Stats.pipelinesCreated++;
+		return AddResource(ResourceKind::Pipeline, 0);
+	}
+
+	void NullBackend::Destroy(BackendHandle handle)
+	{
+		auto it = m_Resources.find(handle);
+		if (it == m_Resources.end())
+		{
+			std::cerr << "[NullBackend] Destroy of an unknown handle.\n";
+			return;
+		}
+
+		m_Stats.liveResources--;
+		m_Stats.liveBytes -= it->second->bytes;
+		m_Stats.destroyed++;
+		m_Resources.erase(it);
+	}
+
+	void* NullBackend::Map(BackendHandle buffer, BackendMap mode)
+	{
+		Resource* resource = Find(buffer);
+		if (!resource || resource->memory.empty())
+			return nullptr;
+
+		m_Stats.maps++;
+		Record(BackendCommandType::Map, buffer, 0, static_cast<uint32_t>(mode));
+		return resource->memory.data();
+	}
+
+	void NullBackend::Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize)
+	{
+		m_Stats.bytesUploaded += writtenSize;
+	}
+
+	void NullBackend::UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size)
+	{
+		Resource* resource = Find(buffer);
+		if (!resource || !data)
+			return;
+
+		// Dynamic buffers keep their contents, tests may read them back through Map()
+		if (offset + size <= resource->memory.size())
+			memcpy(resource->memory.data() + offset, data, size);
+
+		m_Stats.bytesUploaded += size;
+		Record(BackendCommandType::UpdateBuffer, buffer, 0, offset, size);
+	}
+
+	void NullBackend::CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size)
+	{
+		m_Stats.bytesCopied += size;
+		Record(BackendCommandType::CopyBuffer, destination, source, destinationOffset, sourceOffset, size);
+	}
+
+	void NullBackend::SetPipeline(BackendHandle pipeline)
+	{
+		StateChange(BackendCommandType::SetPipeline, pipeline);
+	}
+
+	void NullBackend::SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset)
+	{
+		StateChange(BackendCommandType::SetVertexBuffer, buffer, 0, slot, stride, offset);
+	}
+
+	void NullBackend::SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset)
+	{
+		StateChange(BackendCommandType::SetIndexBuffer, buffer, 0, static_cast<uint32_t>(format), offset);
+	}
+
+	void NullBackend::SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+	{
+		StateChange(BackendCommandType::SetConstantBuffer, buffer, 0, slot, firstConstant, numConstants);
+	}
+
+	void NullBackend::SetRenderTargets(BackendHandle color, BackendHandle depth)
+	{
+		StateChange(BackendCommandType::SetRenderTargets, color, depth);
+	}
+
+	void NullBackend::SetViewport(float width, float height)
+	{
+		StateChange(BackendCommandType::SetViewport, 0, 0, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+	}
+
+	void NullBackend::SetTopology(BackendTopology topology)
+	{
+		m_Topology = topology;
+		StateChange(BackendCommandType::SetTopology, 0, 0, static_cast<uint32_t>(topology));
+	}
+
+	void NullBackend::ClearColor(BackendHandle color, const float rgba[4])
+	{
+		m_Stats.clears++;
+		m_Stats.commands++;
+		Record(BackendCommandType::ClearColor, color);
+	}
+
+	void NullBackend::ClearDepth(BackendHandle depth, float value)
+	{
+		m_Stats.clears++;
+		m_Stats.commands++;
+		Record(BackendCommandType::ClearDepth, depth);
+	}
+
+	void NullBackend::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+	{
+		m_Stats.commands++;
+		m_Stats.draws++;
+		m_Stats.instances += instanceCount;
+		m_Stats.triangles += GetTriangleCount(m_Topology, indexCount) * instanceCount;
+		Record(BackendCommandType::DrawIndexed, 0, 0, indexCount, instanceCount, startIndex, static_cast<uint32_t>(baseVertex), startInstance);
+	}
+
+	void NullBackend::Present(BackendHandle color)
+	{
+		m_Stats.frames++;
+		Record(BackendCommandType::Present, color);
+	}
+
+	void NullBackend::StateChange(BackendCommandType type, BackendHandle handle, BackendHandle secondHandle, uint32_t a0, uint32_t a1, uint32_t a2)
+	{
+		m_Stats.commands++;
+		m_Stats.stateChanges++;
+		Record(type, handle, secondHandle, a0, a1, a2);
+	}
+
+	void NullBackend::Record(BackendCommandType type, BackendHandle handle, BackendHandle secondHandle, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4)
+	{
+		if (!m_Recording)
+			return;
+
+		BackendCommand command;
+		command.type = type;
+		command.handle = handle;
+		command.secondHandle = secondHandle;
+		command.args[0] = a0;
+		command.args[1] = a1;
+		command.args[2] = a2;
+		command.args[3] = a3;
+		command.args[4] = a4;
+		m_Commands.push_back(command);
+	}
+
+	void NullBackend::ResetStats()
+	{
+		NullBackendStats stats = {};
+		stats.liveResources = m_Stats.liveResources;
+		stats.liveBytes = m_Stats.liveBytes;
+		stats.peakBytes = m_Stats.liveBytes;
+		m_Stats = stats;
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "RenderBackend.h"
+
+namespace Graphics
+{
+	struct NullBackendStats
+	{
+		// Resources, live counts survive ResetStats()
+		uint64_t buffersCreated = 0;
+		uint64_t texturesCreated = 0;
+		uint64_t pipelinesCreated = 0;
+		uint64_t destroyed = 0;
+		uint32_t liveResources = 0;
+		uint64_t liveBytes = 0; // Buffer and texture memory a GPU would hold
+		uint64_t peakBytes = 0;
+		uint64_t bytesUploaded = 0; // Initial data, mapped ranges and UpdateBuffer
+		uint64_t bytesCopied = 0;
+		uint64_t maps = 0;
+
+		// Commands
+		uint64_t commands = 0; // Every command call, draws and clears included
+		uint64_t stateChanges = 0; // Pipeline, buffer, render target, viewport and topology binds
+		uint64_t draws = 0;
+		uint64_t instances = 0;
+		uint64_t triangles = 0;
+		uint64_t clears = 0;
+		uint64_t frames = 0; // Present calls
+	};
+
+	enum class BackendCommandType : uint8_t
+	{
+		SetPipeline,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetConstantBuffer,
+		SetRenderTargets,
+		SetViewport,
+		SetTopology,
+		ClearColor,
+		ClearDepth,
+		DrawIndexed,
+		Map,
+		UpdateBuffer,
+		CopyBuffer,
+		Present
+	};
+
+	// One recorded call, arguments in the order of the RenderBackend method
+	struct BackendCommand
+	{
+		BackendCommandType type = BackendCommandType::SetPipeline;
+		BackendHandle handle = 0; // Pipeline, buffer or color target
+		BackendHandle secondHandle = 0; // Depth target, copy source
+		uint32_t args[5] = {};
+	};
+
+	// Accepts every call and only keeps books, so a frame costs exactly what the engine spends on it.
+	// Dynamic buffers get CPU memory for Map(), nothing else is stored. Handles are sequential ids,
+	// two runs of the same scene record the same command stream.
+	class NullBackend : public RenderBackend
+	{
+	public:
+		NullBackend() = default;
+		NullBackend(const NullBackend&) = delete;
+		NullBackend& operator=(const NullBackend&) = delete;
+
+		const char* GetName() const override { return "Null"; }
+
+		BackendHandle CreateBuffer(const BackendBufferDesc& desc, const void* initialData) override;
+		BackendHandle CreateTexture(const BackendTextureDesc& desc) override;
+		BackendHandle CreatePipeline(const BackendPipelineDesc& desc) override;
+		void Destroy(BackendHandle handle) override;
+
+		void* Map(BackendHandle buffer, BackendMap mode) override;
+		void Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize) override;
+		void UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size) override;
+		void CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size) override;
+
+		void SetPipeline(BackendHandle pipeline) override;
+		void SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset) override;
+		void SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset) override;
+		void SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+		void SetRenderTargets(BackendHandle color, BackendHandle depth) override;
+		void SetViewport(float width, float height) override;
+		void SetTopology(BackendTopology topology) override;
+		void ClearColor(BackendHandle color, const float rgba[4]) override;
+		void ClearDepth(BackendHandle depth, float value) override;
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+		void Present(BackendHandle color) override;
+
+		void SetRecording(bool recording) { m_Recording = recording; } // Off by default, the stream grows every frame
+		bool IsRecording() const { return m_Recording; }
+		const std::vector<BackendCommand>& GetCommands() const { return m_Commands; }
+		void ClearCommands() { m_Commands.clear(); }
+
+		const NullBackendStats& GetStats() const { return m_Stats; }
+		void ResetStats(); // Per-run counters only, live resources stay counted
+		bool IsLive(BackendHandle handle) const { return m_Resources.count(handle) != 0; }
+
+	private:
+		enum class ResourceKind
+		{
+			Buffer,
+			Texture,
+			Pipeline
+		};
+
+		struct Resource
+		{
+			ResourceKind kind = ResourceKind::Buffer;
+			uint64_t bytes = 0;
+			std::vector<uint8_t> memory; // Dynamic buffers only
+		};
+
+		BackendHandle AddResource(ResourceKind kind, uint64_t bytes);
+		Resource* Find(BackendHandle handle);
+		void Record(BackendCommandType type, BackendHandle handle = 0, BackendHandle secondHandle = 0, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint32_t a3 = 0, uint32_t a4 = 0);
+		void StateChange(BackendCommandType type, BackendHandle handle = 0, BackendHandle secondHandle = 0, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0);
+
+		std::unordered_map<BackendHandle, std::unique_ptr<Resource>> m_Resources;
+		BackendHandle m_NextHandle = 1;
+		BackendTopology m_Topology = BackendTopology::Undefined;
+
+		bool m_Recording = false;
+		std::vector<BackendCommand> m_Commands;
+		NullBackendStats m_Stats;
+	};
+}
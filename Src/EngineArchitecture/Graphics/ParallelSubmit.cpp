@@ -0,0 +1,154 @@
+#include "ParallelSubmit.h"
+#include "Device.h"
+#include "RenderQueue.h"
+#include "../Core/JobSystem.h"
+#include <iostream>
+#include <thread>
+
+namespace Graphics
+{
+	bool ParallelSubmitter::Initialize(Device& device, uint32_t contextCount, uint32_t minBatchesPerChunk)
+	{
+		m_MinBatchesPerChunk = minBatchesPerChunk ? minBatchesPerChunk : 1;
+
+		if (RenderBackend* backend = device.GetBackend())
+		{
+			if (contextCount == 0)
+				return false;
+
+			m_CommandLists.resize(contextCount);
+			for (uint32_t i = 0; i < contextCount; ++i)
+			{
+				m_DeferredBackends.emplace_back(new DeferredBackend(*backend));
+				m_CommandLists[i].Initialize(*m_DeferredBackends[i]);
+			}
+
+			m_Recorded.assign(contextCount, nullptr);
+			return true;
+		}
+
+		if (contextCount == 0 || !device.CreateDeferredContexts(contextCount))
+		{
+			std::cerr << "[ParallelSubmitter] Failed to create deferred contexts.\n";
+			return false;
+		}
+
+		if (!device.HasDriverCommandLists())
+			std::cerr << "[ParallelSubmitter] Driver has no native command lists, the runtime will emulate them.\n";
+
+		m_CommandLists.resize(contextCount);
+		for (uint32_t i = 0; i < contextCount; ++i)
+		{
+			// CommandList::Release drops a reference, take one so the device keeps its own
+			ID3D11DeviceContext* context = device.GetDeferredContext(i);
+			context->AddRef();
+			m_CommandLists[i].Initialize(context);
+		}
+
+		m_Recorded.assign(contextCount, nullptr);
+
+		return true;
+	}
+
+	void ParallelSubmitter::Submit(Device& device, CommandList& immediate, const RenderQueue& queue, const ChunkSetup& setup)
+	{
+		m_Stats = {};
+
+		const size_t count = queue.GetBatchCount();
+		size_t chunkCount = (count + m_MinBatchesPerChunk - 1) / m_MinBatchesPerChunk;
+		if (chunkCount > m_CommandLists.size())
+			chunkCount = m_CommandLists.size();
+
+		// Small queues are not worth a thread hop
+		if (chunkCount < 2)
+		{
+			if (setup)
+				setup(immediate);
+			queue.Submit(immediate);
+			return;
+		}
+
+		const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+		auto record = [&](size_t chunk)
+		{
+			CommandList& commandList = m_CommandLists[chunk];
+
+			// Each deferred context starts from default state, so does its shadow
+			commandList.InvalidateState();
+			commandList.ResetStats();
+
+			if (setup)
+				setup(commandList);
+
+			size_t begin = chunk * chunkSize;
+			size_t end = (begin + chunkSize < count) ? begin + chunkSize : count;
+			queue.Submit(commandList, begin, end);
+
+			// Deferred backends hold their commands until they are replayed below
+			if (m_DeferredBackends.empty() && !commandList.Finish(&m_Recorded[chunk]))
+				m_Recorded[chunk] = nullptr;
+		};
+
+		// The calling thread records the first chunk itself
+		if (m_JobSystem)
+		{
+			Core::JobCounter recorded;
+			for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+				m_JobSystem->Run([&record, chunk]() { record(chunk); }, &recorded, "RecordChunk");
+
+			record(0);
+			m_JobSystem->Wait(recorded);
+		}
+		else
+		{
+			std::vector<std::thread> workers;
+			workers.reserve(chunkCount - 1);
+			for (size_t chunk = 1; chunk < chunkCount; ++chunk)
+				workers.emplace_back(record, chunk);
+
+			record(0);
+
+			for (std::thread& worker : workers)
+				worker.join();
+		}
+
+		if (!m_DeferredBackends.empty())
+		{
+			for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+				m_DeferredBackends[chunk]->Execute();
+		}
+		else
+			device.ExecuteCommandLists(m_Recorded.data(), static_cast<uint32_t>(chunkCount));
+
+		for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			const CommandListStats& stats = m_CommandLists[chunk].GetStats();
+			m_Stats.submitted += stats.submitted;
+			m_Stats.filtered += stats.filtered;
+			m_Stats.draws += stats.draws;
+			m_Stats.instances += stats.instances;
+			m_Recorded[chunk] = nullptr;
+		}
+
+		m_Stats.chunks = static_cast<uint32_t>(chunkCount);
+
+		// ExecuteCommandList(FALSE) leaves the immediate context in default state
+		immediate.InvalidateState();
+	}
+
+	void ParallelSubmitter::Release()
+	{
+		for (CommandList& commandList : m_CommandLists)
+			commandList.Release();
+
+		m_CommandLists.clear();
+		m_DeferredBackends.clear();
+		m_Recorded.clear();
+	}
+
+	ParallelSubmitter::~ParallelSubmitter()
+	{
+		Release();
+	}
+}
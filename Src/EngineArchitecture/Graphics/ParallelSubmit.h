@@ -0,0 +1,64 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "CommandList.h"
+#include "DeferredBackend.h"
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace Core
+{
+	class JobSystem;
+}
+
+namespace Graphics
+{
+	class Device;
+	class RenderQueue;
+
+	struct ParallelSubmitStats
+	{
+		uint32_t chunks = 0;    // Command lists executed last frame, 0 when the queue went straight to the immediate context
+		uint32_t submitted = 0; // State calls summed over every chunk
+		uint32_t filtered = 0;
+		uint32_t draws = 0;
+		uint32_t instances = 0;
+	};
+
+	// Splits the batches of a sorted RenderQueue into contiguous chunks, records each one on its own deferred context
+	// and executes the finished command lists on the immediate context in chunk order, so the GPU
+	// sees exactly the same draw order as a single threaded Submit(). On a backend device each chunk records into a
+	// DeferredBackend instead, replayed on the device backend in chunk order.
+	//
+	// Recording only reads the packets: constant allocations, uploads and every Map happen on the
+	// immediate context while the queue is filled and in PrepareInstances(). The constant ring must not wrap onto a page it
+	// already used this frame, a DISCARD would rename data the command lists still reference.
+	class ParallelSubmitter
+	{
+	public:
+		using ChunkSetup = std::function<void(CommandList&)>; // Binds render targets, viewport, frame constants
+
+		ParallelSubmitter() = default;
+		~ParallelSubmitter();
+
+		bool Initialize(Device& device, uint32_t contextCount, uint32_t minBatchesPerChunk = 256);
+		void Release();
+
+		void Submit(Device& device, CommandList& immediate, const RenderQueue& queue, const ChunkSetup& setup);
+		void SetJobSystem(Core::JobSystem* jobSystem) { m_JobSystem = jobSystem; } // Chunks become jobs instead of a thread each per frame
+
+		const ParallelSubmitStats& GetStats() const { return m_Stats; }
+
+	private:
+		std::vector<CommandList> m_CommandLists;
+		std::vector<std::unique_ptr<DeferredBackend>> m_DeferredBackends; // Backend devices only, one per command list
+		std::vector<ID3D11CommandList*> m_Recorded;
+		uint32_t m_MinBatchesPerChunk = 256;
+		Core::JobSystem* m_JobSystem = nullptr;
+		ParallelSubmitStats m_Stats;
+	};
+}
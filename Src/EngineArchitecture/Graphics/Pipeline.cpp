@@ -1,4 +1,8 @@
 #include "Pipeline.h"
+#include "PipelineCache.h"
+#include "ShaderPermutation.h"
+#include "BackendBridge.h"
+#include "../Core/Profiler.h"
 #include <d3dcompiler.h>
 #include <iostream>
 
@@ -6,47 +10,84 @@
 #pragma comment(lib, "D3DCompiler.lib")
 namespace Graphics
 {
-	void Graphics::Pipeline::Initialize(const Device& device, const PipelineDesc desc)
+    template <typename T>
+    static void SafeRelease(T*& object)
+    {
+        if (object)
+        {
+            object->Release();
+            object = nullptr;
+        }
+    }
+
+	bool Graphics::Pipeline::Initialize(const Device& device, const PipelineDesc desc)
 	{
+		PROFILE_ZONE("Pipeline::Initialize");
+
 		auto* device_ = device.GetDevice();
-		auto* context = device.GetContext();
 
-        D3D11_RASTERIZER_DESC rasterDesc = {};
-        rasterDesc.FillMode = desc.fillMode;
-        rasterDesc.CullMode = desc.cullMode; // No culling
-        rasterDesc.FrontCounterClockwise = FALSE;
+        Release();
 
+        D3D11_RASTERIZER_DESC rasterDesc = GetRasterizerDesc(desc);
         device_->CreateRasterizerState(&rasterDesc, &m_RasterizerState);
 
 
         if (desc.depthEnabled)
         {
-            D3D11_DEPTH_STENCIL_DESC depthDesc = {};
-            depthDesc.DepthEnable = TRUE;
-            depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-            depthDesc.DepthFunc = D3D11_COMPARISON_LESS;
-            depthDesc.StencilEnable = desc.stencilEnabled;
-            depthDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
-            depthDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+            D3D11_DEPTH_STENCIL_DESC depthDesc = GetDepthStencilDesc(desc);
             device_->CreateDepthStencilState(&depthDesc, &m_DepthStencilState);
         }
 
+        D3D11_BLEND_DESC blendDesc = GetBlendDesc(desc);
+        device_->CreateBlendState(&blendDesc, &m_BlendState);
+
 
 
         ID3DBlob* vsBlob = nullptr;
         ID3DBlob* psBlob = nullptr;
 
 
-        CompileShaderFromFile_(L"../../../../Assets/Shaders/EngineArchitecture/VertexShader.hlsl", "VS", "vs_5_0", &vsBlob);
-        CompileShaderFromFile_(L"../../../../Assets/Shaders/EngineArchitecture/PixelShader.hlsl", "PS", "ps_5_0", &psBlob);
+        std::vector<ShaderMacro> permutationDefines = GetPermutationDefines(desc.permutation);
+        std::vector<D3D_SHADER_MACRO> defines = ToD3DMacros(permutationDefines); // Points into permutationDefines
+        if (FAILED(CompileShaderFromFile_(desc.vertexShaderPath, desc.vertexShaderEntry, "vs_5_0", &vsBlob, defines.data())) || !vsBlob)
+        {
+            std::cerr << "[Pipeline] Failed to compile vertex shader " << desc.vertexShaderEntry << ".\n";
+            Release();
+            return false;
+        }
+
+        if (!desc.depthOnly && (FAILED(CompileShaderFromFile_(desc.pixelShaderPath, desc.pixelShaderEntry, "ps_5_0", &psBlob, defines.data())) || !psBlob))
+        {
+            std::cerr << "[Pipeline] Failed to compile pixel shader " << desc.pixelShaderEntry << ".\n";
+            vsBlob->Release();
+            Release();
+            return false;
+        }
 
 
 
         device_->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &m_VertexShader);
-        device_->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &m_PixelShader);
+        if (psBlob)
+            device_->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &m_PixelShader);
 
 
-        device_->CreateInputLayout(desc.vertexInputElement.GetInputElementDescriptions().data(), 2, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_InputLayout);
+        std::shared_ptr<ShaderReflection> vertexReflection = std::make_shared<ShaderReflection>();
+        std::shared_ptr<ShaderReflection> pixelReflection = std::make_shared<ShaderReflection>();
+        if (vertexReflection->Reflect(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize()))
+            m_VertexReflection = vertexReflection;
+        if (psBlob && pixelReflection->Reflect(psBlob->GetBufferPointer(), psBlob->GetBufferSize()))
+            m_PixelReflection = pixelReflection;
+
+        m_VertexSlots = desc.vertexInputElement.GetVertexSlots();
+        m_DepthOnly = desc.depthOnly;
+
+        // Same rule as the cache path: a layout that does not match the shader fails the pipeline
+        const auto& inputElements = desc.vertexInputElement.GetInputElementDescriptions();
+        bool inputsMatch = !m_VertexReflection || m_VertexReflection->ValidateInputLayout(inputElements);
+        if (inputsMatch)
+            device_->CreateInputLayout(inputElements.data(), static_cast<UINT>(inputElements.size()), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_InputLayout);
+        else
+            std::cerr << "[Pipeline] Vertex input elements do not match " << desc.vertexShaderEntry << ".\n";
 
         //D3D11_INPUT_ELEMENT_DESC layout[] =
         //{
@@ -57,14 +98,169 @@ namespace Graphics
         //device_->CreateInputLayout(layout, 2, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &m_InputLayout);
 
         vsBlob->Release();
-        psBlob->Release();
+        if (psBlob)
+            psBlob->Release();
 
+        if (!m_VertexShader || (!desc.depthOnly && !m_PixelShader) || !m_InputLayout)
+        {
+            std::cerr << "[Pipeline] Failed to create pipeline.\n";
+            Release();
+            return false;
+        }
+
+        return true;
 	}
 
-    HRESULT Pipeline::CompileShaderFromFile_(const wchar_t* filename, const char* entryPoint, const char* profile, ID3DBlob** blob)
+    bool Pipeline::Initialize(PipelineCache& cache, const PipelineDesc& desc)
+    {
+        PROFILE_ZONE("Pipeline::Initialize");
+
+        Release();
+
+        if (cache.GetBackend())
+            return InitializeBackend(*cache.GetBackend(), cache, desc);
+
+        ID3DBlob* vsBlob = nullptr;
+
+        m_RasterizerState = cache.GetRasterizerState(GetRasterizerDesc(desc));
+        m_DepthStencilState = desc.depthEnabled ? cache.GetDepthStencilState(GetDepthStencilDesc(desc)) : nullptr;
+        m_BlendState = cache.GetBlendState(GetBlendDesc(desc));
+        m_VertexShader = cache.GetVertexShader(desc.vertexShaderPath, desc.vertexShaderEntry, &vsBlob, desc.permutation);
+        m_PixelShader = desc.depthOnly ? nullptr : cache.GetPixelShader(desc.pixelShaderPath, desc.pixelShaderEntry, desc.permutation);
+
+        m_VertexReflection = cache.GetShaderReflection(desc.vertexShaderPath, desc.vertexShaderEntry, desc.permutation);
+        if (!desc.depthOnly)
+            m_PixelReflection = cache.GetShaderReflection(desc.pixelShaderPath, desc.pixelShaderEntry, desc.permutation);
+
+        m_VertexSlots = desc.vertexInputElement.GetVertexSlots();
+        m_DepthOnly = desc.depthOnly;
+
+        // A mismatch is caught here with the semantic named, instead of a bare E_INVALIDARG from CreateInputLayout
+        const auto& inputElements = desc.vertexInputElement.GetInputElementDescriptions();
+        bool inputsMatch = !m_VertexReflection || m_VertexReflection->ValidateInputLayout(inputElements);
+
+        if (vsBlob && inputsMatch)
+            m_InputLayout = cache.GetInputLayout(inputElements, vsBlob);
+
+        // The cache keeps its own reference, every pipeline holds one more so Release() stays uniform
+        IUnknown* objects[] = { m_RasterizerState, m_DepthStencilState, m_BlendState, m_VertexShader, m_PixelShader, m_InputLayout };
+        for (IUnknown* object : objects)
+        {
+            if (object)
+                object->AddRef();
+        }
+
+        if (!m_RasterizerState || !m_BlendState || !m_VertexShader || (!desc.depthOnly && !m_PixelShader) || !m_InputLayout || (desc.depthEnabled && !m_DepthStencilState))
+        {
+            std::cerr << "[Pipeline] Failed to build pipeline from cache.\n";
+            Release();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Pipeline::InitializeBackend(RenderBackend& backend, PipelineCache& cache, const PipelineDesc& desc)
+    {
+        // Shaders are still compiled and reflected, constant buffer layouts and input validation depend on them
+        m_VertexReflection = cache.PrepareShader(desc.vertexShaderPath, desc.vertexShaderEntry, "vs_5_0", desc.permutation);
+        if (!desc.depthOnly)
+            m_PixelReflection = cache.PrepareShader(desc.pixelShaderPath, desc.pixelShaderEntry, "ps_5_0", desc.permutation);
+
+        m_VertexSlots = desc.vertexInputElement.GetVertexSlots();
+        m_DepthOnly = desc.depthOnly;
+
+        if (!m_VertexReflection || (!desc.depthOnly && !m_PixelReflection))
+        {
+            std::cerr << "[Pipeline] Failed to compile shaders for the backend pipeline.\n";
+            Release();
+            return false;
+        }
+
+        if (!m_VertexReflection->ValidateInputLayout(desc.vertexInputElement.GetInputElementDescriptions()))
+        {
+            std::cerr << "[Pipeline] Vertex input elements do not match " << desc.vertexShaderEntry << ".\n";
+            Release();
+            return false;
+        }
+
+        m_BackendPipeline = backend.CreatePipeline(BackendBridge::GetPipelineDesc(desc));
+        if (!m_BackendPipeline)
+        {
+            std::cerr << "[Pipeline] Backend failed to create pipeline.\n";
+            Release();
+            return false;
+        }
+
+        m_Backend = &backend;
+        return true;
+    }
+
+    D3D11_RASTERIZER_DESC Pipeline::GetRasterizerDesc(const PipelineDesc& desc)
+    {
+        D3D11_RASTERIZER_DESC rasterDesc = {};
+        rasterDesc.FillMode = desc.fillMode;
+        rasterDesc.CullMode = desc.cullMode;
+        rasterDesc.FrontCounterClockwise = FALSE;
+        return rasterDesc;
+    }
+
+    D3D11_DEPTH_STENCIL_DESC Pipeline::GetDepthStencilDesc(const PipelineDesc& desc)
+    {
+        D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+        depthDesc.DepthEnable = TRUE;
+        depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+        depthDesc.DepthFunc = desc.depthFunc;
+        depthDesc.StencilEnable = desc.stencilEnabled;
+        depthDesc.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+        depthDesc.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+        return depthDesc;
+    }
+
+    D3D11_BLEND_DESC Pipeline::GetBlendDesc(const PipelineDesc& desc)
+    {
+        D3D11_BLEND_DESC blendDesc = {};
+        D3D11_RENDER_TARGET_BLEND_DESC& target = blendDesc.RenderTarget[0];
+        target.BlendEnable = desc.blendEnabled;
+        target.SrcBlend = desc.blendEnabled ? D3D11_BLEND_SRC_ALPHA : D3D11_BLEND_ONE;
+        target.DestBlend = desc.blendEnabled ? D3D11_BLEND_INV_SRC_ALPHA : D3D11_BLEND_ZERO;
+        target.BlendOp = D3D11_BLEND_OP_ADD;
+        target.SrcBlendAlpha = D3D11_BLEND_ONE;
+        target.DestBlendAlpha = D3D11_BLEND_ZERO;
+        target.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        target.RenderTargetWriteMask = desc.depthOnly ? 0 : D3D11_COLOR_WRITE_ENABLE_ALL; // Render targets may stay bound during a depth pass
+        return blendDesc;
+    }
+
+    void Pipeline::Release()
+    {
+        SafeRelease(m_InputLayout);
+        SafeRelease(m_VertexShader);
+        SafeRelease(m_PixelShader);
+        SafeRelease(m_DepthStencilState);
+        SafeRelease(m_RasterizerState);
+        SafeRelease(m_BlendState);
+
+        if (m_BackendPipeline)
+            m_Backend->Destroy(m_BackendPipeline);
+        m_BackendPipeline = 0;
+        m_Backend = nullptr;
+
+        m_VertexReflection.reset();
+        m_PixelReflection.reset();
+        m_VertexSlots = 0;
+        m_DepthOnly = false;
+    }
+
+    Pipeline::~Pipeline()
+    {
+        Release();
+    }
+
+    HRESULT Pipeline::CompileShaderFromFile_(const wchar_t* filename, const char* entryPoint, const char* profile, ID3DBlob** blob, const D3D_SHADER_MACRO* defines)
     {
         ID3DBlob* errorBlob = nullptr;
-        HRESULT hr = D3DCompileFromFile(filename, nullptr, nullptr, entryPoint, profile, 0, 0, blob, &errorBlob);
+        HRESULT hr = D3DCompileFromFile(filename, defines, nullptr, entryPoint, profile, 0, 0, blob, &errorBlob);
 
         if (FAILED(hr))
         {
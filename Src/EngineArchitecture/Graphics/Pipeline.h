@@ -1,7 +1,10 @@
 #pragma once
 #include <d3d11.h>
+#include <memory>
 #include "Device.h"
 #include "VertexInputElement.h"
+#include "ShaderReflection.h"
+#include "RenderBackend.h"
 
 
 #pragma comment(lib, "D3DCompiler.lib")
@@ -9,6 +12,7 @@
 namespace Graphics
 {
 	class Device;
+	class PipelineCache;
 
 	struct PipelineDesc
 	{
@@ -16,17 +20,31 @@ namespace Graphics
 		D3D11_CULL_MODE cullMode = D3D11_CULL_BACK;
 		bool depthEnabled = true;
 		bool stencilEnabled = false;
+		bool blendEnabled = false; // Straight alpha blending on render target 0
+		bool depthOnly = false; // No pixel shader and no color writes: depth prepasses and shadow maps
+		D3D11_COMPARISON_FUNC depthFunc = D3D11_COMPARISON_LESS; // LESS_EQUAL for color passes drawn over a depth prepass
 
-		Graphics::VertexInputElement vertexInputElement; // Vertex input element description
+		const wchar_t* vertexShaderPath = L"../../../../Assets/Shaders/EngineArchitecture/VertexShader.hlsl";
+		const char* vertexShaderEntry = "VS"; // "VSInstanced" reads the world matrix from the instance stream
+		const wchar_t* pixelShaderPath = L"../../../../Assets/Shaders/EngineArchitecture/PixelShader.hlsl";
+		const char* pixelShaderEntry = "PS"; // Ignored when depthOnly
+		uint32_t permutation = 0; // ShaderFeature bits, compiled in as USE_* defines
+
+		Graphics::VertexInputElement vertexInputElement; // Vertex input element description, also the streams the pipeline consumes
 	};
 
 	class Pipeline
 	{
 	public:
 		Pipeline() = default;
-		~Pipeline() = default;
-		void Initialize(const Device& device, const PipelineDesc desc);
-		HRESULT CompileShaderFromFile_(const wchar_t* filename, const char* entryPoint, const char* profile, ID3DBlob** blob);
+		~Pipeline();
+		bool Initialize(const Device& device, const PipelineDesc desc); // Compiles its own shaders, false when they fail or the input layout does not match
+		bool Initialize(PipelineCache& cache, const PipelineDesc& desc); // Shares state objects, shaders and layouts with every pipeline of the cache, or creates a backend pipeline
+		static HRESULT CompileShaderFromFile_(const wchar_t* filename, const char* entryPoint, const char* profile, ID3DBlob** blob, const D3D_SHADER_MACRO* defines = nullptr);
+
+		static D3D11_RASTERIZER_DESC GetRasterizerDesc(const PipelineDesc& desc);
+		static D3D11_DEPTH_STENCIL_DESC GetDepthStencilDesc(const PipelineDesc& desc);
+		static D3D11_BLEND_DESC GetBlendDesc(const PipelineDesc& desc);
 
 		void Release();
 		ID3D11InputLayout* GetInputLayout() const { return m_InputLayout; }
@@ -34,7 +52,16 @@ namespace Graphics
 		ID3D11PixelShader* GetPixelShader() const { return m_PixelShader; }
 		ID3D11DepthStencilState* GetDepthStencilState() const { return m_DepthStencilState; }
 		ID3D11RasterizerState* GetRasterizerState() const { return m_RasterizerState; }
+		ID3D11BlendState* GetBlendState() const { return m_BlendState; }
+		const ShaderReflection* GetVertexReflection() const { return m_VertexReflection.get(); } // Input signature, cbuffer sizes, offsets and slots
+		const ShaderReflection* GetPixelReflection() const { return m_PixelReflection.get(); }
+		uint32_t GetVertexSlots() const { return m_VertexSlots; } // One bit per input slot the vertex shader fetches per vertex
+		bool ConsumesVertexSlot(uint32_t slot) const { return (m_VertexSlots & (1u << slot)) != 0; }
+		bool IsDepthOnly() const { return m_DepthOnly; }
+		BackendHandle GetBackendPipeline() const { return m_BackendPipeline; } // Set instead of the D3D11 objects when the cache has a backend
 	private:
+		bool InitializeBackend(RenderBackend& backend, PipelineCache& cache, const PipelineDesc& desc);
+
 		ID3D11Device* m_Device = nullptr;
 		ID3D11DeviceContext* m_Context = nullptr;
 		ID3D11VertexShader* m_VertexShader = nullptr;
@@ -42,6 +69,13 @@ namespace Graphics
 		ID3D11InputLayout* m_InputLayout = nullptr;
 		ID3D11DepthStencilState* m_DepthStencilState = nullptr;
 		ID3D11RasterizerState* m_RasterizerState = nullptr;
+		ID3D11BlendState* m_BlendState = nullptr;
+		std::shared_ptr<const ShaderReflection> m_VertexReflection; // Shared with the PipelineCache when built through it
+		std::shared_ptr<const ShaderReflection> m_PixelReflection;
+		uint32_t m_VertexSlots = 0;
+		bool m_DepthOnly = false;
+		RenderBackend* m_Backend = nullptr;
+		BackendHandle m_BackendPipeline = 0;
 
 	};
 }
\ No newline at end of file
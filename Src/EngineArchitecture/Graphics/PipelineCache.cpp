@@ -0,0 +1,571 @@
+#include "PipelineCache.h"
+#include "Device.h"
+#include "ShaderCache.h"
+#include "ShaderBatch.h"
+#include "ShaderPermutation.h"
+#include "../Core/Profiler.h"
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <iostream>
+
+namespace Graphics
+{
+	namespace
+	{
+		// Serializes descriptions field by field, struct padding never ends up in a key
+		class KeyWriter
+		{
+		public:
+			template <typename T>
+			KeyWriter& operator<<(const T& value)
+			{
+				m_Key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+				return *this;
+			}
+
+			KeyWriter& String(const char* text)
+			{
+				if (text)
+					m_Key.append(text, strlen(text));
+				m_Key.push_back('\0');
+				return *this;
+			}
+
+			KeyWriter& String(const wchar_t* text)
+			{
+				if (text)
+					m_Key.append(reinterpret_cast<const char*>(text), wcslen(text) * sizeof(wchar_t));
+				m_Key.append(sizeof(wchar_t), '\0');
+				return *this;
+			}
+
+			std::string& Get() { return m_Key; }
+
+		private:
+			std::string m_Key;
+		};
+
+		KeyWriter& operator<<(KeyWriter& key, const D3D11_DEPTH_STENCILOP_DESC& op)
+		{
+			return key << op.StencilFailOp << op.StencilDepthFailOp << op.StencilPassOp << op.StencilFunc;
+		}
+
+		KeyWriter& WriteElements(KeyWriter& key, const std::vector<D3D11_INPUT_ELEMENT_DESC>& elements)
+		{
+			key << static_cast<uint32_t>(elements.size());
+			for (const D3D11_INPUT_ELEMENT_DESC& element : elements)
+			{
+				key.String(element.SemanticName);
+				key << element.SemanticIndex << element.Format << element.InputSlot << element.AlignedByteOffset << element.InputSlotClass << element.InstanceDataStepRate;
+			}
+			return key;
+		}
+
+		using Clock = std::chrono::steady_clock;
+
+		double MillisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		template <typename T>
+		void ReleaseAll(std::unordered_map<std::string, T*>& objects)
+		{
+			for (auto& entry : objects)
+			{
+				if (entry.second)
+					entry.second->Release();
+			}
+			objects.clear();
+		}
+	}
+
+	bool PipelineCache::Initialize(const Device& device)
+	{
+		m_Device = device.GetDevice();
+		m_Backend = device.GetBackend();
+		if (!m_Device && !m_Backend)
+		{
+			std::cerr << "[PipelineCache] Device is not initialized.\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	std::string PipelineCache::MakeKey(const PipelineDesc& desc)
+	{
+		KeyWriter key;
+		key << desc.fillMode << desc.cullMode << desc.depthEnabled << desc.stencilEnabled << desc.blendEnabled << desc.depthOnly << desc.depthFunc << desc.permutation;
+		key.String(desc.vertexShaderPath).String(desc.vertexShaderEntry);
+		if (!desc.depthOnly)
+			key.String(desc.pixelShaderPath).String(desc.pixelShaderEntry);
+		WriteElements(key, desc.vertexInputElement.GetInputElementDescriptions());
+		return std::move(key.Get());
+	}
+
+	std::shared_ptr<Pipeline> PipelineCache::GetPipeline(const PipelineDesc& desc)
+	{
+		std::string key = MakeKey(desc);
+
+		auto it = m_Pipelines.find(key);
+		if (it != m_Pipelines.end())
+		{
+			m_Stats.pipelineHits++;
+			return it->second;
+		}
+
+		m_Stats.pipelineMisses++;
+
+		// Only the sub-objects that miss cost anything, their time is counted where they are created
+		std::shared_ptr<Pipeline> pipeline = std::make_shared<Pipeline>();
+		if (!pipeline->Initialize(*this, desc))
+			return nullptr;
+
+		m_Pipelines.emplace(std::move(key), pipeline);
+		return pipeline;
+	}
+
+	ID3D11RasterizerState* PipelineCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+	{
+		KeyWriter key;
+		key << desc.FillMode << desc.CullMode << desc.FrontCounterClockwise << desc.DepthBias << desc.DepthBiasClamp << desc.SlopeScaledDepthBias
+			<< desc.DepthClipEnable << desc.ScissorEnable << desc.MultisampleEnable << desc.AntialiasedLineEnable;
+
+		auto it = m_RasterizerStates.find(key.Get());
+		if (it != m_RasterizerStates.end())
+		{
+			m_Stats.stateHits++;
+			return it->second;
+		}
+
+		m_Stats.stateMisses++;
+		Clock::time_point start = Clock::now();
+
+		ID3D11RasterizerState* state = nullptr;
+		if (FAILED(m_Device->CreateRasterizerState(&desc, &state)))
+		{
+			std::cerr << "[PipelineCache] Failed to create rasterizer state.\n";
+			return nullptr;
+		}
+
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		m_RasterizerStates.emplace(std::move(key.Get()), state);
+		return state;
+	}
+
+	ID3D11DepthStencilState* PipelineCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+	{
+		KeyWriter key;
+		key << desc.DepthEnable << desc.DepthWriteMask << desc.DepthFunc << desc.StencilEnable << desc.StencilReadMask << desc.StencilWriteMask
+			<< desc.FrontFace << desc.BackFace;
+
+		auto it = m_DepthStencilStates.find(key.Get());
+		if (it != m_DepthStencilStates.end())
+		{
+			m_Stats.stateHits++;
+			return it->second;
+		}
+
+		m_Stats.stateMisses++;
+		Clock::time_point start = Clock::now();
+
+		ID3D11DepthStencilState* state = nullptr;
+		if (FAILED(m_Device->CreateDepthStencilState(&desc, &state)))
+		{
+			std::cerr << "[PipelineCache] Failed to create depth-stencil state.\n";
+			return nullptr;
+		}
+
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		m_DepthStencilStates.emplace(std::move(key.Get()), state);
+		return state;
+	}
+
+	ID3D11BlendState* PipelineCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+	{
+		KeyWriter key;
+		key << desc.AlphaToCoverageEnable << desc.IndependentBlendEnable;
+
+		// Without independent blending only target 0 matters
+		uint32_t targetCount = desc.IndependentBlendEnable ? 8 : 1;
+		for (uint32_t i = 0; i < targetCount; ++i)
+		{
+			const D3D11_RENDER_TARGET_BLEND_DESC& target = desc.RenderTarget[i];
+			key << target.BlendEnable << target.SrcBlend << target.DestBlend << target.BlendOp
+				<< target.SrcBlendAlpha << target.DestBlendAlpha << target.BlendOpAlpha << target.RenderTargetWriteMask;
+		}
+
+		auto it = m_BlendStates.find(key.Get());
+		if (it != m_BlendStates.end())
+		{
+			m_Stats.stateHits++;
+			return it->second;
+		}
+
+		m_Stats.stateMisses++;
+		Clock::time_point start = Clock::now();
+
+		ID3D11BlendState* state = nullptr;
+		if (FAILED(m_Device->CreateBlendState(&desc, &state)))
+		{
+			std::cerr << "[PipelineCache] Failed to create blend state.\n";
+			return nullptr;
+		}
+
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		m_BlendStates.emplace(std::move(key.Get()), state);
+		return state;
+	}
+
+	ID3D11SamplerState* PipelineCache::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+	{
+		KeyWriter key;
+		key << desc.Filter << desc.AddressU << desc.AddressV << desc.AddressW << desc.MipLODBias << desc.MaxAnisotropy << desc.ComparisonFunc
+			<< desc.BorderColor << desc.MinLOD << desc.MaxLOD;
+
+		auto it = m_SamplerStates.find(key.Get());
+		if (it != m_SamplerStates.end())
+		{
+			m_Stats.stateHits++;
+			return it->second;
+		}
+
+		m_Stats.stateMisses++;
+		Clock::time_point start = Clock::now();
+
+		ID3D11SamplerState* state = nullptr;
+		if (FAILED(m_Device->CreateSamplerState(&desc, &state)))
+		{
+			std::cerr << "[PipelineCache] Failed to create sampler state.\n";
+			return nullptr;
+		}
+
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		m_SamplerStates.emplace(std::move(key.Get()), state);
+		return state;
+	}
+
+	void PipelineCache::CountShaderLookup(const std::string& key, bool hit)
+	{
+		// Already counted as a miss by CreatePipelines (also when it failed to compile)
+		if (!m_BatchedShaders.empty() && m_BatchedShaders.erase(key))
+			return;
+
+		if (hit)
+			m_Stats.shaderHits++;
+		else
+			m_Stats.shaderMisses++;
+	}
+
+	std::string PipelineCache::MakeShaderKey(const wchar_t* path, const char* entryPoint, uint32_t permutation)
+	{
+		KeyWriter key;
+		key.String(path).String(entryPoint) << permutation;
+		return std::move(key.Get());
+	}
+
+	ID3D11VertexShader* PipelineCache::GetVertexShader(const wchar_t* path, const char* entryPoint, ID3DBlob** bytecode, uint32_t permutation)
+	{
+		std::string key = MakeShaderKey(path, entryPoint, permutation);
+
+		auto it = m_VertexShaders.find(key);
+		CountShaderLookup(key, it != m_VertexShaders.end());
+		if (it != m_VertexShaders.end())
+		{
+			if (bytecode)
+				*bytecode = it->second.bytecode;
+			return it->second.shader;
+		}
+
+		Clock::time_point start = Clock::now();
+
+		ID3DBlob* compiled = nullptr;
+		if (FAILED(CompileShader(path, entryPoint, "vs_5_0", permutation, &compiled)))
+			return nullptr;
+
+		ID3D11VertexShader* shader = AddVertexShader(std::move(key), compiled);
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+
+		if (bytecode)
+			*bytecode = shader ? compiled : nullptr;
+		return shader;
+	}
+
+	ID3D11VertexShader* PipelineCache::AddVertexShader(std::string key, ID3DBlob* bytecode)
+	{
+		VertexShaderEntry entry;
+		entry.bytecode = bytecode;
+
+		if (!m_Backend && FAILED(m_Device->CreateVertexShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), nullptr, &entry.shader)))
+		{
+			std::cerr << "[PipelineCache] Failed to create vertex shader.\n";
+			bytecode->Release();
+			return nullptr;
+		}
+
+		m_Reflections[key] = ReflectShader(bytecode);
+		m_VertexShaders.emplace(std::move(key), entry);
+		return entry.shader;
+	}
+
+	ID3D11PixelShader* PipelineCache::GetPixelShader(const wchar_t* path, const char* entryPoint, uint32_t permutation)
+	{
+		std::string key = MakeShaderKey(path, entryPoint, permutation);
+
+		auto it = m_PixelShaders.find(key);
+		CountShaderLookup(key, it != m_PixelShaders.end());
+		if (it != m_PixelShaders.end())
+			return it->second;
+
+		Clock::time_point start = Clock::now();
+
+		ID3DBlob* blob = nullptr;
+		if (FAILED(CompileShader(path, entryPoint, "ps_5_0", permutation, &blob)))
+			return nullptr;
+
+		ID3D11PixelShader* shader = AddPixelShader(std::move(key), blob);
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		return shader;
+	}
+
+	ID3D11PixelShader* PipelineCache::AddPixelShader(std::string key, ID3DBlob* bytecode)
+	{
+		ID3D11PixelShader* shader = nullptr;
+		HRESULT hr = m_Backend ? S_OK : m_Device->CreatePixelShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), nullptr, &shader);
+
+		if (SUCCEEDED(hr))
+			m_Reflections[key] = ReflectShader(bytecode);
+		bytecode->Release();
+
+		if (FAILED(hr))
+		{
+			std::cerr << "[PipelineCache] Failed to create pixel shader.\n";
+			return nullptr;
+		}
+
+		m_PixelShaders.emplace(std::move(key), shader);
+		return shader;
+	}
+
+	std::shared_ptr<const ShaderReflection> PipelineCache::ReflectShader(ID3DBlob* bytecode)
+	{
+		std::shared_ptr<ShaderReflection> reflection = std::make_shared<ShaderReflection>();
+
+		bool reflected = m_ShaderCache ?
+			m_ShaderCache->Reflect(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), *reflection) :
+			reflection->Reflect(bytecode->GetBufferPointer(), bytecode->GetBufferSize());
+
+		return reflected ? reflection : nullptr;
+	}
+
+	std::shared_ptr<const ShaderReflection> PipelineCache::GetShaderReflection(const wchar_t* path, const char* entryPoint, uint32_t permutation) const
+	{
+		auto it = m_Reflections.find(MakeShaderKey(path, entryPoint, permutation));
+		return (it != m_Reflections.end()) ? it->second : nullptr;
+	}
+
+	std::shared_ptr<const ShaderReflection> PipelineCache::PrepareShader(const wchar_t* path, const char* entryPoint, const char* profile, uint32_t permutation)
+	{
+		std::string key = MakeShaderKey(path, entryPoint, permutation);
+
+		auto it = m_Reflections.find(key);
+		CountShaderLookup(key, it != m_Reflections.end());
+		if (it != m_Reflections.end())
+			return it->second;
+
+		Clock::time_point start = Clock::now();
+
+		ID3DBlob* bytecode = nullptr;
+		if (FAILED(CompileShader(path, entryPoint, profile, permutation, &bytecode)))
+			return nullptr;
+
+		bool vertexShader = profile[0] == 'v';
+		if (vertexShader)
+			AddVertexShader(key, bytecode);
+		else
+			AddPixelShader(key, bytecode);
+
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		return GetShaderReflection(path, entryPoint, permutation);
+	}
+
+	std::vector<std::shared_ptr<Pipeline>> PipelineCache::CreatePipelines(const std::vector<PipelineDesc>& descs, uint32_t threadCount)
+	{
+		PROFILE_ZONE("PipelineCache::CreatePipelines");
+
+		// Stage 1: every shader not cached yet, deduplicated, compiled concurrently
+		ShaderCompileBatch batch;
+		std::vector<std::pair<uint32_t, bool>> jobs; // Batch index, vertex shader
+		std::vector<std::string> keys;
+
+		for (const PipelineDesc& desc : descs)
+		{
+			std::vector<ShaderMacro> defines = GetPermutationDefines(desc.permutation);
+
+			std::string vertexKey = MakeShaderKey(desc.vertexShaderPath, desc.vertexShaderEntry, desc.permutation);
+			if (!m_VertexShaders.count(vertexKey))
+			{
+				size_t before = batch.GetCount();
+				uint32_t index = batch.Add({ desc.vertexShaderPath, desc.vertexShaderEntry, "vs_5_0", defines });
+				if (batch.GetCount() != before)
+				{
+					jobs.push_back({ index, true });
+					keys.push_back(std::move(vertexKey));
+				}
+			}
+
+			if (desc.depthOnly)
+				continue;
+
+			std::string pixelKey = MakeShaderKey(desc.pixelShaderPath, desc.pixelShaderEntry, desc.permutation);
+			if (!m_PixelShaders.count(pixelKey))
+			{
+				size_t before = batch.GetCount();
+				uint32_t index = batch.Add({ desc.pixelShaderPath, desc.pixelShaderEntry, "ps_5_0", defines });
+				if (batch.GetCount() != before)
+				{
+					jobs.push_back({ index, false });
+					keys.push_back(std::move(pixelKey));
+				}
+			}
+		}
+
+		// Counted as misses here, once each: the first lookup of these keys in stage 3 is not counted again
+		Clock::time_point start = Clock::now();
+		if (batch.GetCount())
+		{
+			batch.Compile(m_ShaderCache, threadCount);
+			m_Stats.shaderMisses += static_cast<uint32_t>(batch.GetCount());
+
+			const ShaderBatchStats& batchStats = batch.GetStats();
+			m_Stats.batches++;
+			m_Stats.shadersBatched += batchStats.compiled;
+			m_Stats.batchWallMilliseconds += batchStats.wallMilliseconds;
+			m_Stats.batchCompileMilliseconds += batchStats.compileMilliseconds;
+
+			std::vector<ShaderCompileTiming> timings = batch.GetTimings();
+			m_ShaderTimings.insert(m_ShaderTimings.end(), timings.begin(), timings.end());
+			m_BatchedShaders.insert(keys.begin(), keys.end());
+		}
+
+		// Stage 2: shader objects on this thread, in Add() order, so the cache does not depend on worker timing
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			ID3DBlob* bytecode = batch.TakeBytecode(jobs[i].first);
+			if (!bytecode)
+				continue; // Compile error already reported, GetPipeline fails for its pipelines
+
+			if (jobs[i].second)
+				AddVertexShader(std::move(keys[i]), bytecode);
+			else
+				AddPixelShader(std::move(keys[i]), bytecode);
+		}
+		m_Stats.creationMilliseconds += MillisecondsSince(start); // Wall time of the whole batch, not the sum over threads
+
+		// Stage 3: pipelines, their shaders are cache hits now
+		std::vector<std::shared_ptr<Pipeline>> pipelines;
+		pipelines.reserve(descs.size());
+		for (const PipelineDesc& desc : descs)
+			pipelines.push_back(GetPipeline(desc));
+
+		m_BatchedShaders.clear(); // Pipelines that failed before their shaders were looked up
+		return pipelines;
+	}
+
+	HRESULT PipelineCache::CompileShader(const wchar_t* path, const char* entryPoint, const char* profile, uint32_t permutation, ID3DBlob** blob)
+	{
+		std::vector<ShaderMacro> defines = GetPermutationDefines(permutation);
+
+		if (m_ShaderCache)
+			return m_ShaderCache->Compile(path, entryPoint, profile, defines, 0, blob);
+
+		std::vector<D3D_SHADER_MACRO> macros = ToD3DMacros(defines);
+		return Pipeline::CompileShaderFromFile_(path, entryPoint, profile, blob, macros.data());
+	}
+
+	std::shared_ptr<Pipeline> PipelineCache::GetPipeline(const PipelineDesc& desc, ID3DBlob* vertexBytecode, ID3DBlob* pixelBytecode)
+	{
+		std::string vertexKey = MakeShaderKey(desc.vertexShaderPath, desc.vertexShaderEntry, desc.permutation);
+		if (vertexBytecode && !m_VertexShaders.count(vertexKey))
+			AddVertexShader(std::move(vertexKey), vertexBytecode);
+		else if (vertexBytecode)
+			vertexBytecode->Release();
+
+		std::string pixelKey = MakeShaderKey(desc.pixelShaderPath, desc.pixelShaderEntry, desc.permutation);
+		if (pixelBytecode && !m_PixelShaders.count(pixelKey))
+			AddPixelShader(std::move(pixelKey), pixelBytecode);
+		else if (pixelBytecode)
+			pixelBytecode->Release();
+
+		return GetPipeline(desc);
+	}
+
+	ID3D11InputLayout* PipelineCache::GetInputLayout(const std::vector<D3D11_INPUT_ELEMENT_DESC>& elements, ID3DBlob* vertexShaderBytecode)
+	{
+		if (!vertexShaderBytecode)
+			return nullptr;
+
+		// Layouts only depend on the shader input signature, shaders with the same inputs share one
+		ID3DBlob* signature = nullptr;
+		if (FAILED(D3DGetInputSignatureBlob(vertexShaderBytecode->GetBufferPointer(), vertexShaderBytecode->GetBufferSize(), &signature)))
+		{
+			std::cerr << "[PipelineCache] Failed to read vertex shader input signature.\n";
+			return nullptr;
+		}
+
+		KeyWriter key;
+		WriteElements(key, elements);
+		key.Get().append(static_cast<const char*>(signature->GetBufferPointer()), signature->GetBufferSize());
+		signature->Release();
+
+		auto it = m_InputLayouts.find(key.Get());
+		if (it != m_InputLayouts.end())
+		{
+			m_Stats.inputLayoutHits++;
+			return it->second;
+		}
+
+		m_Stats.inputLayoutMisses++;
+		Clock::time_point start = Clock::now();
+
+		ID3D11InputLayout* layout = nullptr;
+		if (FAILED(m_Device->CreateInputLayout(elements.data(), static_cast<UINT>(elements.size()), vertexShaderBytecode->GetBufferPointer(), vertexShaderBytecode->GetBufferSize(), &layout)))
+		{
+			std::cerr << "[PipelineCache] Failed to create input layout.\n";
+			return nullptr;
+		}
+
+		m_Stats.creationMilliseconds += MillisecondsSince(start);
+		m_InputLayouts.emplace(std::move(key.Get()), layout);
+		return layout;
+	}
+
+	void PipelineCache::Release()
+	{
+		m_Pipelines.clear();
+		m_Reflections.clear();
+		m_BatchedShaders.clear();
+
+		ReleaseAll(m_RasterizerStates);
+		ReleaseAll(m_DepthStencilStates);
+		ReleaseAll(m_BlendStates);
+		ReleaseAll(m_SamplerStates);
+		ReleaseAll(m_PixelShaders);
+		ReleaseAll(m_InputLayouts);
+
+		for (auto& entry : m_VertexShaders)
+		{
+			if (entry.second.shader)
+				entry.second.shader->Release();
+			entry.second.bytecode->Release();
+		}
+		m_VertexShaders.clear();
+	}
+
+	PipelineCache::~PipelineCache()
+	{
+		Release();
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Pipeline.h"
+#include "ShaderBatch.h"
+
+#pragma comment(lib, "d3d11.lib")
+#pragma comment(lib, "D3DCompiler.lib")
+
+namespace Graphics
+{
+	class Device;
+	class ShaderCache;
+	class RenderBackend;
+
+	struct PipelineCacheStats
+	{
+		uint32_t pipelineHits = 0;
+		uint32_t pipelineMisses = 0;
+		uint32_t stateHits = 0; // Rasterizer, depth-stencil, blend and sampler states
+		uint32_t stateMisses = 0;
+		uint32_t shaderHits = 0;
+		uint32_t shaderMisses = 0;
+		uint32_t inputLayoutHits = 0;
+		uint32_t inputLayoutMisses = 0;
+		double creationMilliseconds = 0.0; // Spent compiling and creating objects on misses
+		uint32_t batches = 0; // CreatePipelines calls that had shaders to compile
+		uint32_t shadersBatched = 0;
+		double batchWallMilliseconds = 0.0;
+		double batchCompileMilliseconds = 0.0; // Sum over shaders, wall * threads at best
+	};
+
+	// Builds pipelines once per distinct PipelineDesc and hands out shared references.
+	// Every sub-object is cached on its own, so two pipelines that only differ in culling
+	// still share shaders, input layout, depth and blend state.
+	// On a backend device only bytecode and reflection are cached, each pipeline is one backend object.
+	class PipelineCache
+	{
+	public:
+		PipelineCache() = default;
+		~PipelineCache();
+
+		bool Initialize(const Device& device);
+		RenderBackend* GetBackend() const { return m_Backend; }
+		void Release(); // Pipelines handed out stay valid, they hold their own references
+		void SetShaderCache(ShaderCache* shaderCache) { m_ShaderCache = shaderCache; } // Optional, skips compiling bytecode seen on a previous run
+
+		std::shared_ptr<Pipeline> GetPipeline(const PipelineDesc& desc);
+
+		// Startup path: compiles the missing shaders of all descs on a thread pool, then builds the pipelines.
+		// Same order as descs, nullptr where a pipeline failed.
+		std::vector<std::shared_ptr<Pipeline>> CreatePipelines(const std::vector<PipelineDesc>& descs, uint32_t threadCount = 0);
+
+		// Bytecode compiled elsewhere (background threads): shaders missing from the cache are created from it,
+		// both references are consumed either way
+		std::shared_ptr<Pipeline> GetPipeline(const PipelineDesc& desc, ID3DBlob* vertexBytecode, ID3DBlob* pixelBytecode);
+
+		// Returned objects are owned by the cache, AddRef them to keep them past Release()
+		ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+		ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+		ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+		ID3D11SamplerState* GetSamplerState(const D3D11_SAMPLER_DESC& desc);
+		ID3D11VertexShader* GetVertexShader(const wchar_t* path, const char* entryPoint, ID3DBlob** bytecode = nullptr, uint32_t permutation = 0); // bytecode is borrowed
+		ID3D11PixelShader* GetPixelShader(const wchar_t* path, const char* entryPoint, uint32_t permutation = 0);
+		ID3D11InputLayout* GetInputLayout(const std::vector<D3D11_INPUT_ELEMENT_DESC>& elements, ID3DBlob* vertexShaderBytecode);
+
+		// Reflected once when the shader is created, nullptr for shaders the cache has not built
+		std::shared_ptr<const ShaderReflection> GetShaderReflection(const wchar_t* path, const char* entryPoint, uint32_t permutation = 0) const;
+
+		// Backend devices: compiles the shader if needed and returns its reflection, nullptr when it does not compile
+		std::shared_ptr<const ShaderReflection> PrepareShader(const wchar_t* path, const char* entryPoint, const char* profile, uint32_t permutation = 0);
+
+		static std::string MakeKey(const PipelineDesc& desc);
+
+		const PipelineCacheStats& GetStats() const { return m_Stats; }
+		void ResetStats() { m_Stats = {}; m_ShaderTimings.clear(); }
+
+		// Every shader compiled by CreatePipelines since the last ResetStats(), slowest first within each batch.
+		// Nothing is printed here, reports are up to the caller.
+		const std::vector<ShaderCompileTiming>& GetShaderTimings() const { return m_ShaderTimings; }
+
+	private:
+		struct VertexShaderEntry
+		{
+			ID3D11VertexShader* shader = nullptr; // nullptr on a backend device
+			ID3DBlob* bytecode = nullptr; // Kept for input layouts created later
+		};
+
+		HRESULT CompileShader(const wchar_t* path, const char* entryPoint, const char* profile, uint32_t permutation, ID3DBlob** blob);
+		static std::string MakeShaderKey(const wchar_t* path, const char* entryPoint, uint32_t permutation);
+		void CountShaderLookup(const std::string& key, bool hit);
+		ID3D11VertexShader* AddVertexShader(std::string key, ID3DBlob* bytecode); // Takes the bytecode reference
+		ID3D11PixelShader* AddPixelShader(std::string key, ID3DBlob* bytecode); // Releases the bytecode
+		std::shared_ptr<const ShaderReflection> ReflectShader(ID3DBlob* bytecode);
+
+		ID3D11Device* m_Device = nullptr;
+		RenderBackend* m_Backend = nullptr;
+		ShaderCache* m_ShaderCache = nullptr;
+
+		std::unordered_map<std::string, std::shared_ptr<Pipeline>> m_Pipelines;
+		std::unordered_map<std::string, ID3D11RasterizerState*> m_RasterizerStates;
+		std::unordered_map<std::string, ID3D11DepthStencilState*> m_DepthStencilStates;
+		std::unordered_map<std::string, ID3D11BlendState*> m_BlendStates;
+		std::unordered_map<std::string, ID3D11SamplerState*> m_SamplerStates;
+		std::unordered_map<std::string, VertexShaderEntry> m_VertexShaders;
+		std::unordered_map<std::string, ID3D11PixelShader*> m_PixelShaders;
+		std::unordered_map<std::string, ID3D11InputLayout*> m_InputLayouts;
+		std::unordered_map<std::string, std::shared_ptr<const ShaderReflection>> m_Reflections; // Same keys as the shaders
+		std::unordered_set<std::string> m_BatchedShaders; // Compiled by CreatePipelines, not looked up yet
+
+		PipelineCacheStats m_Stats;
+		std::vector<ShaderCompileTiming> m_ShaderTimings;
+	};
+}
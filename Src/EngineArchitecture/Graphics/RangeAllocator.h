@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+namespace Graphics
+{
+	// First-fit free-list allocator over [0, capacity) in abstract units (vertices, indices...).
+	// Freed ranges are coalesced with their neighbours; it never touches GPU memory itself.
+	class RangeAllocator
+	{
+	public:
+		static constexpr uint32_t InvalidOffset = ~0u;
+
+		RangeAllocator() = default;
+
+		void Reset(uint32_t capacity)
+		{
+			m_Capacity = capacity;
+			m_Used = 0;
+			m_FreeBlocks.clear();
+
+			if (capacity)
+				m_FreeBlocks[0] = capacity;
+		}
+
+		uint32_t Allocate(uint32_t size)
+		{
+			if (size == 0)
+				return InvalidOffset;
+
+			for (auto it = m_FreeBlocks.begin(); it != m_FreeBlocks.end(); ++it)
+			{
+				if (it->second < size)
+					continue;
+
+				uint32_t offset = it->first;
+				uint32_t remaining = it->second - size;
+
+				m_FreeBlocks.erase(it);
+				if (remaining)
+					m_FreeBlocks[offset + size] = remaining;
+
+				m_Used += size;
+				return offset;
+			}
+
+			return InvalidOffset;
+		}
+
+		void Free(uint32_t offset, uint32_t size)
+		{
+			if (offset == InvalidOffset || size == 0)
+				return;
+
+			m_Used -= size;
+
+			auto it = m_FreeBlocks.emplace(offset, size).first;
+
+			// Merge with the following block
+			auto next = std::next(it);
+			if (next != m_FreeBlocks.end() && it->first + it->second == next->first)
+			{
+				it->second += next->second;
+				m_FreeBlocks.erase(next);
+			}
+
+			// Merge with the previous block
+			if (it != m_FreeBlocks.begin())
+			{
+				auto previous = std::prev(it);
+				if (previous->first + previous->second == it->first)
+				{
+					previous->second += it->second;
+					m_FreeBlocks.erase(it);
+				}
+			}
+		}
+
+		uint32_t GetCapacity() const { return m_Capacity; }
+		uint32_t GetUsed() const { return m_Used; }
+		uint32_t GetFreeBlockCount() const { return static_cast<uint32_t>(m_FreeBlocks.size()); }
+
+		uint32_t GetLargestFreeBlock() const
+		{
+			uint32_t largest = 0;
+			for (const auto& block : m_FreeBlocks)
+				largest = (block.second > largest) ? block.second : largest;
+
+			return largest;
+		}
+
+	private:
+		std::map<uint32_t, uint32_t> m_FreeBlocks; // offset -> size
+		uint32_t m_Capacity = 0;
+		uint32_t m_Used = 0;
+	};
+}
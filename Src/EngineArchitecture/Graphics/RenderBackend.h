@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// No Direct3D types in here: backends build and run on any platform, the D3D11 side converts in BackendBridge.h
+
+namespace Graphics
+{
+	using BackendHandle = uint64_t; // 0 is no resource
+
+	// Values match DXGI_FORMAT, the D3D11 side converts with a cast
+	enum class BackendFormat : uint32_t
+	{
+		Unknown = 0,
+		RGBA32Float = 2,
+		RGB32Float = 6,
+		RGBA16Unorm = 11,
+		RG32Float = 16,
+		RGBA8Unorm = 28,
+		R32Float = 41,
+		R32UInt = 42,
+		D24UnormS8UInt = 45,
+		R16UInt = 57
+	};
+
+	// Values match D3D11_COMPARISON_FUNC
+	enum class BackendCompare : uint32_t
+	{
+		Never = 1,
+		Less = 2,
+		Equal = 3,
+		LessEqual = 4,
+		Greater = 5,
+		NotEqual = 6,
+		GreaterEqual = 7,
+		Always = 8
+	};
+
+	// Values match D3D11_CULL_MODE
+	enum class BackendCull : uint32_t
+	{
+		None = 1,
+		Front = 2,
+		Back = 3
+	};
+
+	// Values match D3D11_PRIMITIVE_TOPOLOGY
+	enum class BackendTopology : uint32_t
+	{
+		Undefined = 0,
+		PointList = 1,
+		LineList = 2,
+		LineStrip = 3,
+		TriangleList = 4,
+		TriangleStrip = 5
+	};
+
+	enum class BackendBufferKind : uint32_t
+	{
+		Vertex,
+		Index,
+		Constant
+	};
+
+	enum class BackendMap : uint32_t
+	{
+		Discard, // WRITE_DISCARD: previous contents are gone
+		NoOverwrite // WRITE_NO_OVERWRITE: append after what the GPU may still read
+	};
+
+	struct BackendBufferDesc
+	{
+		BackendBufferKind kind = BackendBufferKind::Vertex;
+		uint32_t size = 0;
+		bool dynamic = false; // Written with Map/Unmap, everything else goes through UpdateBuffer
+	};
+
+	struct BackendTextureDesc
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		BackendFormat format = BackendFormat::RGBA8Unorm; // D24UnormS8UInt for depth targets
+	};
+
+	struct BackendVertexElement
+	{
+		const char* semantic = nullptr; // Points into the PipelineDesc, valid during CreatePipeline only
+		uint32_t semanticIndex = 0;
+		BackendFormat format = BackendFormat::Unknown;
+		uint32_t slot = 0;
+		uint32_t offset = 0;
+		bool perInstance = false;
+	};
+
+	// Fixed-function state plus the input layout. Shaders are referenced by entry point, a backend that
+	// cannot run HLSL implements the few entry points it supports natively.
+	struct BackendPipelineDesc
+	{
+		std::vector<BackendVertexElement> elements;
+		const char* vertexShaderEntry = nullptr;
+		const char* pixelShaderEntry = nullptr; // nullptr for depth-only pipelines
+		uint32_t permutation = 0;
+
+		BackendCull cullMode = BackendCull::Back;
+		bool wireframe = false;
+		bool depthEnabled = true;
+		bool depthWrite = true;
+		BackendCompare depthFunc = BackendCompare::Less;
+		bool blendEnabled = false;
+		bool colorWrite = true;
+	};
+
+	// What the Graphics classes need from a GPU API once their own work is done: CommandList only calls
+	// the command methods for state that actually changed, so a backend sees exactly the filtered stream.
+	// Backends are driven from one thread at a time, like the D3D11 immediate context.
+	class RenderBackend
+	{
+	public:
+		virtual ~RenderBackend() = default;
+
+		virtual const char* GetName() const = 0;
+
+		// Resources
+		virtual BackendHandle CreateBuffer(const BackendBufferDesc& desc, const void* initialData) = 0;
+		virtual BackendHandle CreateTexture(const BackendTextureDesc& desc) = 0;
+		virtual BackendHandle CreatePipeline(const BackendPipelineDesc& desc) = 0;
+		virtual void Destroy(BackendHandle handle) = 0;
+
+		virtual void* Map(BackendHandle buffer, BackendMap mode) = 0; // Whole buffer, dynamic buffers only
+		virtual void Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize) = 0; // Range the caller wrote
+		virtual void UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size) = 0;
+		virtual void CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size) = 0;
+
+		// Commands
+		virtual void SetPipeline(BackendHandle pipeline) = 0;
+		virtual void SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset) = 0;
+		virtual void SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset) = 0;
+		virtual void SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants) = 0; // numConstants 0: whole buffer
+		virtual void SetRenderTargets(BackendHandle color, BackendHandle depth) = 0;
+		virtual void SetViewport(float width, float height) = 0;
+		virtual void SetTopology(BackendTopology topology) = 0;
+		virtual void ClearColor(BackendHandle color, const float rgba[4]) = 0;
+		virtual void ClearDepth(BackendHandle depth, float value) = 0;
+		virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) = 0;
+		virtual void Present(BackendHandle color) = 0; // End of frame, every earlier command has executed once it returns
+	};
+}
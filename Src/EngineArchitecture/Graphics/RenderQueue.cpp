@@ -0,0 +1,269 @@
+#include "RenderQueue.h"
+#include "CommandList.h"
+#include "Pipeline.h"
+#include "../Core/Profiler.h"
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	uint32_t RenderQueue::QuantizeDepth(float viewDepth)
+	{
+		const uint32_t maxDepth = (1u << DepthBits) - 1;
+
+		if (!(viewDepth > 0.0f)) // Also catches NaN
+			return 0;
+		if (viewDepth >= 1.0f)
+			return maxDepth;
+
+		return static_cast<uint32_t>(viewDepth * static_cast<float>(maxDepth));
+	}
+
+	uint64_t RenderQueue::MakeSortKey(RenderPassType pass, uint32_t pipelineId, uint32_t materialId, float viewDepth)
+	{
+		uint64_t passBits = static_cast<uint64_t>(pass) & 0xF;
+		uint64_t pipelineBits = pipelineId & ((1u << PipelineBits) - 1);
+		uint64_t materialBits = materialId & ((1u << MaterialBits) - 1);
+		uint64_t depthBits = QuantizeDepth(viewDepth);
+
+		if (pass == RenderPassType::Transparent)
+		{
+			// Blending needs far-to-near, so depth outranks state
+			uint64_t invertedDepth = ((1u << DepthBits) - 1) - depthBits;
+			return (passBits << 60) | (invertedDepth << 36) | (pipelineBits << 20) | materialBits;
+		}
+
+		// Opaque: group by state first, then near-to-far to help early-z
+		return (passBits << 60) | (pipelineBits << 44) | (materialBits << 24) | depthBits;
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_Packets.clear();
+		m_Entries.clear();
+		m_Batches.clear();
+		m_InstanceData.clear();
+	}
+
+	void RenderQueue::Reserve(size_t count)
+	{
+		m_Packets.reserve(count);
+		m_Entries.reserve(count);
+		m_Scratch.reserve(count);
+	}
+
+	void RenderQueue::Push(const DrawPacket& packet)
+	{
+		m_Entries.push_back({ packet.sortKey, static_cast<uint32_t>(m_Packets.size()), 0 });
+		m_Packets.push_back(packet);
+	}
+
+	void RenderQueue::Push(const DrawPacket& packet, const void* instanceData)
+	{
+		DrawPacket instanced = packet;
+		instanced.instance = static_cast<uint32_t>(m_InstanceData.size() / m_InstanceStride);
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(instanceData);
+		m_InstanceData.insert(m_InstanceData.end(), bytes, bytes + m_InstanceStride);
+
+		Push(instanced);
+	}
+
+	void RenderQueue::Sort()
+	{
+		const size_t count = m_Entries.size();
+		if (count < 2)
+		{
+			BuildBatches();
+			return;
+		}
+
+		// One pass builds the histograms of all 8 digits
+		uint32_t histograms[8][256] = {};
+		for (const SortEntry& entry : m_Entries)
+		{
+			uint64_t key = entry.key;
+			for (uint32_t digit = 0; digit < 8; ++digit)
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+
+		m_Scratch.resize(count);
+
+		SortEntry* source = m_Entries.data();
+		SortEntry* destination = m_Scratch.data();
+
+		for (uint32_t digit = 0; digit < 8; ++digit)
+		{
+			uint32_t* histogram = histograms[digit];
+			uint32_t shift = digit * 8;
+
+			// Every key shares this byte (common for pass/pipeline bits), the pass would not move anything
+			if (histogram[(source[0].key >> shift) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < 256; ++bucket)
+			{
+				uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const SortEntry& entry = source[i];
+				destination[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+			}
+
+			SortEntry* swap = source;
+			source = destination;
+			destination = swap;
+		}
+
+		if (source != m_Entries.data())
+			m_Entries.swap(m_Scratch);
+
+		BuildBatches();
+	}
+
+	bool RenderQueue::CanInstance(const DrawPacket& first, const DrawPacket& packet)
+	{
+		return packet.instance != NoInstance &&
+			packet.instancedPipeline == first.instancedPipeline &&
+			packet.vertexBuffer == first.vertexBuffer &&
+			packet.indexBuffer == first.indexBuffer &&
+			packet.vertexStride == first.vertexStride &&
+			packet.attributeBuffer == first.attributeBuffer &&
+			packet.indexFormat == first.indexFormat &&
+			packet.indexCount == first.indexCount &&
+			packet.startIndex == first.startIndex &&
+			packet.baseVertex == first.baseVertex;
+	}
+
+	void RenderQueue::BuildBatches()
+	{
+		m_Batches.clear();
+
+		const uint32_t count = static_cast<uint32_t>(m_Entries.size());
+		uint32_t order = 0;
+
+		while (order < count)
+		{
+			DrawBatch batch;
+			batch.first = order;
+			batch.count = 1;
+
+			const DrawPacket& first = GetPacket(order);
+			if (first.instance != NoInstance && first.instancedPipeline)
+			{
+				while (order + batch.count < count && batch.count < m_MaxInstancesPerBatch && CanInstance(first, GetPacket(order + batch.count)))
+					batch.count++;
+			}
+
+			m_Batches.push_back(batch);
+			order += batch.count;
+		}
+	}
+
+	void RenderQueue::BindVertexStreams(CommandList& commandList, const DrawPacket& packet, const Pipeline& pipeline)
+	{
+		// Only the streams the pipeline's layout reads, a depth pass over split geometry never touches the attributes
+		if (pipeline.ConsumesVertexSlot(PositionStreamSlot))
+			commandList.BindVertexBuffer(packet.vertexBuffer, PositionStreamSlot, packet.vertexStride, 0);
+		if (packet.attributeBuffer && pipeline.ConsumesVertexSlot(AttributeStreamSlot))
+			commandList.BindVertexBuffer(packet.attributeBuffer, AttributeStreamSlot, packet.attributeStride, 0);
+	}
+
+	bool RenderQueue::PrepareInstances(ID3D11DeviceContext* context, TransientUploadHeap& uploadHeap, ConstantBufferRing& constantRing)
+	{
+		PROFILE_ZONE("RenderQueue::PrepareInstances"); // Instance streams, the per-frame upload
+
+		uint32_t fallbacks = 0; // Packets drawn one by one because their batch did not fit
+		uint32_t dropped = 0; // Of those, packets left without constants, Submit skips them
+
+		for (DrawBatch& batch : m_Batches)
+		{
+			const DrawPacket& first = GetPacket(batch.first);
+			if (first.instance == NoInstance || !first.instancedPipeline)
+				continue;
+
+			// Sorting scattered the instances, gather them in draw order
+			m_InstanceScratch.resize(static_cast<size_t>(batch.count) * m_InstanceStride);
+			for (uint32_t i = 0; i < batch.count; ++i)
+			{
+				const uint8_t* source = m_InstanceData.data() + static_cast<size_t>(GetPacket(batch.first + i).instance) * m_InstanceStride;
+				memcpy(m_InstanceScratch.data() + static_cast<size_t>(i) * m_InstanceStride, source, m_InstanceStride);
+			}
+
+			if (uploadHeap.AllocateVertices(context, m_InstanceScratch.data(), batch.count, m_InstanceStride, batch.instances))
+				continue;
+
+			// The instance data is the per-object constant block, the non-instanced pipeline reads it from slot 1
+			for (uint32_t i = 0; i < batch.count; ++i)
+			{
+				DrawPacket& packet = m_Packets[m_Entries[batch.first + i].index];
+				const uint8_t* instance = m_InstanceScratch.data() + static_cast<size_t>(i) * m_InstanceStride;
+
+				if (!packet.constants.IsValid() && !constantRing.Allocate(context, instance, m_InstanceStride, packet.constants))
+					dropped++;
+			}
+
+			fallbacks += batch.count;
+		}
+
+		if (fallbacks)
+			std::cerr << "[RenderQueue] Instance data did not fit in the upload heap, " << fallbacks << " packets drawn one by one.\n";
+		if (dropped)
+			std::cerr << "[RenderQueue] Constant ring is full as well, " << dropped << " packets skipped.\n";
+
+		return fallbacks == 0;
+	}
+
+	void RenderQueue::Submit(CommandList& commandList) const
+	{
+		Submit(commandList, 0, m_Batches.size());
+	}
+
+	void RenderQueue::Submit(CommandList& commandList, size_t begin, size_t end) const
+	{
+		commandList.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		// Consecutive packets mostly share state, CommandList drops the repeated binds
+		for (size_t b = begin; b < end && b < m_Batches.size(); ++b)
+		{
+			const DrawBatch& batch = m_Batches[b];
+
+			if (batch.instances.IsValid())
+			{
+				const DrawPacket& packet = GetPacket(batch.first);
+
+				commandList.SetPipelineState(*packet.instancedPipeline);
+				BindVertexStreams(commandList, packet, *packet.instancedPipeline);
+				commandList.SetVertexBuffer(batch.instances, InstanceSlot);
+				commandList.SetIndexBuffer(packet.indexBuffer, packet.indexFormat, 0);
+				commandList.DrawIndexedInstanced(packet.indexCount, batch.count, packet.startIndex, packet.baseVertex, batch.instances.GetFirstElement());
+				continue;
+			}
+
+			for (uint32_t i = 0; i < batch.count; ++i)
+			{
+				const DrawPacket& packet = GetPacket(batch.first + i);
+
+				// Instanced-only packets have nothing in slot 1 to draw with
+				if (packet.instance != NoInstance && !packet.constants.IsValid())
+					continue;
+
+				if (packet.pipeline)
+				{
+					commandList.SetPipelineState(*packet.pipeline);
+					BindVertexStreams(commandList, packet, *packet.pipeline);
+				}
+				else
+					commandList.BindVertexBuffer(packet.vertexBuffer, PositionStreamSlot, packet.vertexStride, 0);
+				commandList.SetIndexBuffer(packet.indexBuffer, packet.indexFormat, 0);
+				commandList.SetConstantBuffer(packet.constants, 1);
+				commandList.DrawIndexed(packet.indexCount, packet.startIndex, packet.baseVertex);
+			}
+		}
+	}
+}
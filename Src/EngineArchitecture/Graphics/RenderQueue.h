@@ -0,0 +1,115 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "ConstantBufferRing.h"
+#include "UploadHeap.h"
+
+namespace Graphics
+{
+	class Pipeline;
+	class CommandList;
+
+	static constexpr uint32_t NoInstance = ~0u;
+
+	enum class RenderPassType : uint32_t
+	{
+		Depth = 0,
+		Opaque = 1,
+		Transparent = 2,
+		Overlay = 3
+	};
+
+	// One draw, everything CommandList needs to issue it. Kept POD so the queue can be filled and copied freely.
+	struct DrawPacket
+	{
+		uint64_t sortKey = 0;
+		const Pipeline* pipeline = nullptr;
+		ID3D11Buffer* vertexBuffer = nullptr;
+		ID3D11Buffer* indexBuffer = nullptr;
+		uint32_t vertexStride = 0;
+		ID3D11Buffer* attributeBuffer = nullptr; // Split geometry only, bound to AttributeStreamSlot when the pipeline reads it
+		uint32_t attributeStride = 0;
+		DXGI_FORMAT indexFormat = DXGI_FORMAT_R16_UINT;
+		ConstantAllocation constants; // Per-object data, bound to slot 1
+		uint32_t indexCount = 0;
+		uint32_t startIndex = 0;
+		int32_t baseVertex = 0;
+		const Pipeline* instancedPipeline = nullptr; // Same shading, world matrix read from the instance stream
+		uint32_t instance = NoInstance; // Into the queue instance data, set by Push
+	};
+
+	// Consecutive packets (in sorted order) drawn with one call. Packets that carry instance data and
+	// share instanced pipeline, buffers and index range collapse into one DrawIndexedInstanced.
+	struct DrawBatch
+	{
+		uint32_t first = 0; // Sorted order
+		uint32_t count = 0;
+		TransientAllocation instances; // Valid after PrepareInstances(), otherwise the packets are drawn one by one with their constants
+	};
+
+	// Collects draw packets for a frame, sorts them by key with an LSD radix sort and submits them in order.
+	//
+	// Key layout (most significant first):
+	//   opaque:      pass (4) | pipeline (16) | material (20) | depth front-to-back (24)
+	//   transparent: pass (4) | depth back-to-front (24) | pipeline (16) | material (20)
+	class RenderQueue
+	{
+	public:
+		static constexpr uint32_t DepthBits = 24;
+		static constexpr uint32_t PipelineBits = 16;
+		static constexpr uint32_t MaterialBits = 20;
+		static constexpr uint32_t InstanceSlot = 1; // Vertex stream of the instanced pipelines
+
+		RenderQueue() = default;
+
+		static uint64_t MakeSortKey(RenderPassType pass, uint32_t pipelineId, uint32_t materialId, float viewDepth);
+		static uint32_t QuantizeDepth(float viewDepth); // viewDepth normalized to [0, 1]
+
+		void Clear();
+		void Reserve(size_t count);
+		void Push(const DrawPacket& packet);
+		void Push(const DrawPacket& packet, const void* instanceData); // instanceData is GetInstanceStride() bytes, copied
+
+		// Packets only batch when they end up adjacent: put the mesh in the material bits of the key
+		void SetInstanceStride(uint32_t stride) { m_InstanceStride = stride; } // Before the first Push of a frame
+		void SetMaxInstancesPerBatch(uint32_t count) { m_MaxInstancesPerBatch = count ? count : 1; }
+		uint32_t GetInstanceStride() const { return m_InstanceStride; }
+
+		void Sort(); // Also groups the sorted packets into batches
+		// Immediate context, before any Submit. Batches that do not fit the heap fall back to one draw per packet:
+		// packets without constants get their instance data from the ring and are drawn with their non-instanced pipeline.
+		bool PrepareInstances(ID3D11DeviceContext* context, TransientUploadHeap& uploadHeap, ConstantBufferRing& constantRing);
+		void Submit(CommandList& commandList) const;
+		void Submit(CommandList& commandList, size_t begin, size_t end) const; // Batch range [begin, end)
+
+		size_t GetCount() const { return m_Packets.size(); }
+		const DrawPacket& GetPacket(size_t order) const { return m_Packets[m_Entries[order].index]; } // In sorted order after Sort()
+		size_t GetBatchCount() const { return m_Batches.size(); }
+		const DrawBatch& GetBatch(size_t index) const { return m_Batches[index]; }
+
+	private:
+		struct SortEntry
+		{
+			uint64_t key;
+			uint32_t index; // Into m_Packets, packets themselves never move
+			uint32_t padding;
+		};
+
+		static bool CanInstance(const DrawPacket& first, const DrawPacket& packet);
+		static void BindVertexStreams(CommandList& commandList, const DrawPacket& packet, const Pipeline& pipeline);
+		void BuildBatches();
+
+		std::vector<DrawPacket> m_Packets;
+		std::vector<SortEntry> m_Entries;
+		std::vector<SortEntry> m_Scratch;
+
+		std::vector<DrawBatch> m_Batches;
+		std::vector<uint8_t> m_InstanceData; // m_InstanceStride bytes per instanced packet, in push order
+		std::vector<uint8_t> m_InstanceScratch; // One batch gathered contiguously for the upload
+		uint32_t m_InstanceStride = 64; // float4x4 world
+		uint32_t m_MaxInstancesPerBatch = 4096;
+	};
+}
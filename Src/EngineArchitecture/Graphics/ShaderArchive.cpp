@@ -0,0 +1,377 @@
+#include "ShaderArchive.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Graphics
+{
+	uint64_t ShaderArchive::Hash(const void* data, size_t size, uint64_t seed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	uint32_t ShaderArchive::Checksum(const void* data, size_t size)
+	{
+		uint64_t hash = Hash(data, size, 0x9E3779B97F4A7C15ull);
+		return static_cast<uint32_t>(hash ^ (hash >> 32));
+	}
+
+	bool ShaderArchive::Open(const std::string& path)
+	{
+		Close();
+		m_Path = path;
+
+		if (!Map())
+			return true; // Nothing on disk yet, the first Flush() creates the file
+
+		if (!LoadIndex())
+		{
+			std::cerr << "[ShaderArchive] Invalid archive, starting over: " << path << "\n";
+			Unmap();
+			m_Index.clear();
+			m_DataEnd = sizeof(Header);
+		}
+
+		return true;
+	}
+
+	bool ShaderArchive::LoadIndex()
+	{
+		if (m_ViewSize < sizeof(Header))
+			return false;
+
+		Header header;
+		memcpy(&header, m_View, sizeof(Header));
+
+		if (header.magic != Magic || header.version != Version)
+			return false;
+
+		uint64_t indexSize = static_cast<uint64_t>(header.entryCount) * sizeof(IndexEntry);
+		if (header.indexOffset < sizeof(Header) || header.indexOffset > m_ViewSize || indexSize > m_ViewSize - header.indexOffset)
+			return false;
+
+		m_Index.reserve(header.entryCount);
+
+		for (uint32_t i = 0; i < header.entryCount; ++i)
+		{
+			IndexEntry entry;
+			memcpy(&entry, m_View + header.indexOffset + i * sizeof(IndexEntry), sizeof(IndexEntry));
+
+			// Blobs live between the header and the index, anything else is corruption
+			if (entry.offset < sizeof(Header) || entry.offset > header.indexOffset || entry.size > header.indexOffset - entry.offset)
+				return false;
+
+			m_Index[entry.key] = { entry.offset, entry.size, entry.checksum };
+		}
+
+		m_DataEnd = header.indexOffset + indexSize;
+		return true;
+	}
+
+	bool ShaderArchive::Find(uint64_t key, const void** data, size_t* size) const
+	{
+		auto pending = m_Pending.find(key);
+		if (pending != m_Pending.end())
+		{
+			*data = pending->second.data();
+			*size = pending->second.size();
+			return true;
+		}
+
+		auto it = m_Index.find(key);
+		if (it == m_Index.end() || !m_View)
+			return false;
+
+		const uint8_t* blob = m_View + it->second.offset;
+		if (Checksum(blob, it->second.size) != it->second.checksum)
+		{
+			std::cerr << "[ShaderArchive] Corrupt blob, it will be rebuilt.\n";
+			return false;
+		}
+
+		*data = blob;
+		*size = it->second.size;
+		return true;
+	}
+
+	void ShaderArchive::Store(uint64_t key, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		m_Pending[key].assign(bytes, bytes + size);
+	}
+
+	bool ShaderArchive::WriteIndex(std::ostream& file, const std::unordered_map<uint64_t, Location>& index, uint64_t indexOffset)
+	{
+		std::vector<IndexEntry> entries;
+		entries.reserve(index.size());
+		for (const auto& entry : index)
+			entries.push_back({ entry.first, entry.second.offset, entry.second.size, entry.second.checksum });
+
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry));
+		file.flush();
+
+		// Last, so the file only ever refers to complete data
+		Header header = {};
+		header.magic = Magic;
+		header.version = Version;
+		header.entryCount = static_cast<uint32_t>(entries.size());
+		header.indexOffset = indexOffset;
+
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.flush();
+		return !file.fail();
+	}
+
+	bool ShaderArchive::NeedsCompaction() const
+	{
+		uint64_t live = static_cast<uint64_t>(m_Index.size()) * sizeof(IndexEntry);
+		for (const auto& entry : m_Index)
+			live += entry.second.size;
+
+		uint64_t dead = m_DataEnd - sizeof(Header) - live;
+		return dead > CompactThreshold && dead > live;
+	}
+
+	bool ShaderArchive::Flush()
+	{
+		if (m_Pending.empty() || m_Path.empty())
+			return true;
+
+		if (m_View && NeedsCompaction())
+			return Compact();
+
+		// The mapping must go before the file is written
+		Unmap();
+
+		std::fstream file(m_Path, std::ios::in | std::ios::out | std::ios::binary);
+		if (!file)
+		{
+			file.open(m_Path, std::ios::out | std::ios::binary | std::ios::trunc);
+			m_Index.clear();
+			m_DataEnd = sizeof(Header);
+		}
+
+		if (!file)
+		{
+			std::cerr << "[ShaderArchive] Failed to open archive for writing: " << m_Path << "\n";
+			return false;
+		}
+
+		if (m_DataEnd == sizeof(Header))
+		{
+			// Fresh file: a placeholder header keeps the blobs at their final offsets
+			Header empty = {};
+			file.seekp(0);
+			file.write(reinterpret_cast<const char*>(&empty), sizeof(Header));
+		}
+
+		// Past the current index, a replaced key leaves its old blob as dead space
+		std::unordered_map<uint64_t, Location> index = m_Index;
+		uint64_t dataEnd = m_DataEnd;
+
+		file.seekp(static_cast<std::streamoff>(dataEnd));
+		for (auto& pending : m_Pending)
+		{
+			const std::vector<uint8_t>& blob = pending.second;
+			file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+			index[pending.first] = { dataEnd, static_cast<uint32_t>(blob.size()), Checksum(blob.data(), blob.size()) };
+			dataEnd += blob.size();
+		}
+
+		bool written = WriteIndex(file, index, dataEnd);
+		file.close();
+
+		if (!written || file.fail())
+		{
+			std::cerr << "[ShaderArchive] Failed to write archive: " << m_Path << "\n";
+			Map(); // The old header is still the valid one
+			return false;
+		}
+
+		m_Index.swap(index);
+		m_DataEnd = dataEnd + static_cast<uint64_t>(m_Index.size()) * sizeof(IndexEntry);
+		m_Pending.clear();
+
+		// Older, longer archives keep their stale tail, the header bounds what is read
+		return Map();
+	}
+
+	bool ShaderArchive::Compact()
+	{
+		// Live blobs and pending ones into a new file, the archive stays untouched until the rename
+		std::string temporary = m_Path + ".tmp";
+		std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+
+		Header empty = {};
+		file.write(reinterpret_cast<const char*>(&empty), sizeof(Header));
+
+		std::unordered_map<uint64_t, Location> index;
+		uint64_t dataEnd = sizeof(Header);
+
+		for (const auto& entry : m_Index)
+		{
+			const uint8_t* blob = m_View + entry.second.offset;
+			if (m_Pending.count(entry.first) || Checksum(blob, entry.second.size) != entry.second.checksum)
+				continue; // Replaced, or corrupt and rebuilt on the next miss
+
+			file.write(reinterpret_cast<const char*>(blob), entry.second.size);
+			index[entry.first] = { dataEnd, entry.second.size, entry.second.checksum };
+			dataEnd += entry.second.size;
+		}
+
+		for (const auto& pending : m_Pending)
+		{
+			const std::vector<uint8_t>& blob = pending.second;
+			file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+			index[pending.first] = { dataEnd, static_cast<uint32_t>(blob.size()), Checksum(blob.data(), blob.size()) };
+			dataEnd += blob.size();
+		}
+
+		bool written = WriteIndex(file, index, dataEnd);
+		file.close();
+
+		// Windows cannot replace a mapped file
+		Unmap();
+
+#ifdef _WIN32
+		bool replaced = written && !file.fail() && MoveFileExA(temporary.c_str(), m_Path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		bool replaced = written && !file.fail() && std::rename(temporary.c_str(), m_Path.c_str()) == 0;
+#endif
+
+		if (!replaced)
+		{
+			std::cerr << "[ShaderArchive] Failed to compact archive: " << m_Path << "\n";
+			std::remove(temporary.c_str());
+			Map();
+			return false;
+		}
+
+		m_Index.swap(index);
+		m_DataEnd = dataEnd + static_cast<uint64_t>(m_Index.size()) * sizeof(IndexEntry);
+		m_Pending.clear();
+		return Map();
+	}
+
+	void ShaderArchive::Close()
+	{
+		if (!m_Pending.empty())
+			Flush();
+
+		Unmap();
+		m_Index.clear();
+		m_Pending.clear();
+		m_DataEnd = sizeof(Header);
+	}
+
+#ifdef _WIN32
+	bool ShaderArchive::Map()
+	{
+		HANDLE file = CreateFileA(m_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size = {};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_View = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_View)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_File = file;
+		m_Mapping = mapping;
+		m_ViewSize = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	void ShaderArchive::Unmap()
+	{
+		if (m_View)
+			UnmapViewOfFile(m_View);
+		if (m_Mapping)
+			CloseHandle(static_cast<HANDLE>(m_Mapping));
+		if (m_File)
+			CloseHandle(static_cast<HANDLE>(m_File));
+
+		m_View = nullptr;
+		m_ViewSize = 0;
+		m_Mapping = nullptr;
+		m_File = nullptr;
+	}
+#else
+	bool ShaderArchive::Map()
+	{
+		int descriptor = open(m_Path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			return false;
+
+		struct stat info = {};
+		if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+		{
+			close(descriptor);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor); // The mapping keeps the file alive
+
+		if (view == MAP_FAILED)
+			return false;
+
+		m_View = static_cast<const uint8_t*>(view);
+		m_ViewSize = static_cast<size_t>(info.st_size);
+		return true;
+	}
+
+	void ShaderArchive::Unmap()
+	{
+		if (m_View)
+			munmap(const_cast<uint8_t*>(m_View), m_ViewSize);
+
+		m_View = nullptr;
+		m_ViewSize = 0;
+	}
+#endif
+
+	ShaderArchive::~ShaderArchive()
+	{
+		Close();
+	}
+}
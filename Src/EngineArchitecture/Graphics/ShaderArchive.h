@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics
+{
+	// Single-file, content-addressed blob store used by ShaderCache.
+	//
+	// Layout: Header | blob | ... | IndexEntry[entryCount] (dead) | blob | ... | IndexEntry[entryCount]
+	// The file is memory-mapped read-only; new blobs stay in memory until Flush(), which appends them
+	// after the current index, appends the merged index and rewrites the header last. If the process dies
+	// in between, the old header still points at the old index, and nothing before it was overwritten.
+	// Superseded indices and replaced blobs are dead space; once it outweighs the live data, Flush()
+	// compacts into a temporary file and renames it over the archive.
+	class ShaderArchive
+	{
+	public:
+		static constexpr uint32_t Magic = 0x43444853; // "SHDC"
+		static constexpr uint32_t Version = 1;
+		static constexpr uint64_t CompactThreshold = 256 * 1024; // Dead bytes tolerated regardless of the live size
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entryCount;
+			uint32_t reserved;
+			uint64_t indexOffset; // Also the end of the blob data
+		};
+
+		struct IndexEntry
+		{
+			uint64_t key;
+			uint64_t offset;
+			uint32_t size;
+			uint32_t checksum; // Of the blob, checked before a blob is handed out
+		};
+
+		ShaderArchive() = default;
+		~ShaderArchive();
+
+		ShaderArchive(const ShaderArchive&) = delete;
+		ShaderArchive& operator=(const ShaderArchive&) = delete;
+
+		bool Open(const std::string& path); // A missing or invalid file starts an empty archive
+		bool Flush(); // Writes pending blobs, the archive stays open
+		void Close();
+
+		bool Find(uint64_t key, const void** data, size_t* size) const;
+		void Store(uint64_t key, const void* data, size_t size);
+
+		size_t GetEntryCount() const { return m_Index.size(); }
+		size_t GetPendingCount() const { return m_Pending.size(); }
+		uint64_t GetDataEnd() const { return m_DataEnd; }
+
+		static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ull); // FNV-1a
+		static uint32_t Checksum(const void* data, size_t size);
+
+	private:
+		struct Location
+		{
+			uint64_t offset;
+			uint32_t size;
+			uint32_t checksum;
+		};
+
+		bool Map();
+		void Unmap();
+		bool LoadIndex();
+		bool NeedsCompaction() const;
+		bool Compact();
+		static bool WriteIndex(std::ostream& file, const std::unordered_map<uint64_t, Location>& index, uint64_t indexOffset);
+
+		std::string m_Path;
+
+		const uint8_t* m_View = nullptr;
+		size_t m_ViewSize = 0;
+		void* m_File = nullptr; // Platform handles of the mapping
+		void* m_Mapping = nullptr;
+
+		uint64_t m_DataEnd = sizeof(Header); // End of the current index, where the next Flush() appends
+		std::unordered_map<uint64_t, Location> m_Index;
+		std::unordered_map<uint64_t, std::vector<uint8_t>> m_Pending;
+	};
+}
@@ -0,0 +1,168 @@
+#include "ShaderBatch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace Graphics
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		double MillisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+	}
+
+	std::string ShaderCompileBatch::MakeKey(const ShaderCompileRequest& request)
+	{
+		std::string key(reinterpret_cast<const char*>(request.path.c_str()), request.path.size() * sizeof(wchar_t));
+		key.push_back('\0');
+		key += request.entryPoint;
+		key.push_back('\0');
+		key += request.profile;
+		key.push_back('\0');
+		key.append(reinterpret_cast<const char*>(&request.flags), sizeof(request.flags));
+
+		for (const ShaderMacro& macro : request.macros)
+		{
+			key += macro.name;
+			key.push_back('=');
+			key += macro.definition;
+			key.push_back('\0');
+		}
+
+		return key;
+	}
+
+	uint32_t ShaderCompileBatch::Add(const ShaderCompileRequest& request)
+	{
+		m_Stats.requested++;
+
+		std::string key = MakeKey(request);
+		auto it = m_Lookup.find(key);
+		if (it != m_Lookup.end())
+			return it->second;
+
+		uint32_t index = static_cast<uint32_t>(m_Requests.size());
+		m_Requests.push_back(request);
+		m_Results.emplace_back();
+		m_Lookup.emplace(std::move(key), index);
+		return index;
+	}
+
+	HRESULT ShaderCompileBatch::CompileOne(const ShaderCompileRequest& request, ShaderCache* shaderCache, ID3DBlob** blob)
+	{
+		if (shaderCache)
+			return shaderCache->Compile(request.path.c_str(), request.entryPoint.c_str(), request.profile.c_str(), request.macros, request.flags, blob);
+
+		std::vector<D3D_SHADER_MACRO> defines;
+		for (const ShaderMacro& macro : request.macros)
+			defines.push_back({ macro.name.c_str(), macro.definition.c_str() });
+		defines.push_back({ nullptr, nullptr });
+
+		ID3DBlob* errors = nullptr;
+		HRESULT hr = D3DCompileFromFile(request.path.c_str(), defines.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE, request.entryPoint.c_str(), request.profile.c_str(), request.flags, 0, blob, &errors);
+
+		if (errors)
+		{
+			if (FAILED(hr))
+				std::cerr << "Shader Error: " << static_cast<const char*>(errors->GetBufferPointer()) << std::endl;
+			errors->Release();
+		}
+
+		return hr;
+	}
+
+	bool ShaderCompileBatch::Compile(ShaderCache* shaderCache, uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		const uint32_t count = static_cast<uint32_t>(m_Requests.size());
+		threadCount = std::min(threadCount, std::max(count, 1u));
+
+		Clock::time_point start = Clock::now();
+
+		// Workers pull the next pending tuple, each result slot is written by exactly one worker
+		std::atomic<uint32_t> next { 0 };
+		auto work = [&]()
+		{
+			for (uint32_t index = next++; index < count; index = next++)
+			{
+				ShaderCompileResult& result = m_Results[index];
+				if (result.result != E_PENDING)
+					continue; // Compiled by an earlier Compile() call
+
+				Clock::time_point shaderStart = Clock::now();
+				result.result = CompileOne(m_Requests[index], shaderCache, &result.bytecode);
+				result.milliseconds = MillisecondsSince(shaderStart);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threadCount - 1);
+		for (uint32_t i = 1; i < threadCount; ++i)
+			workers.emplace_back(work);
+
+		work();
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		m_Stats.threads = threadCount;
+		m_Stats.wallMilliseconds = MillisecondsSince(start);
+		m_Stats.compiled = count;
+		m_Stats.failed = 0;
+		m_Stats.compileMilliseconds = 0.0;
+
+		for (const ShaderCompileResult& result : m_Results)
+		{
+			m_Stats.compileMilliseconds += result.milliseconds;
+			if (FAILED(result.result))
+				m_Stats.failed++;
+		}
+
+		return m_Stats.failed == 0;
+	}
+
+	ID3DBlob* ShaderCompileBatch::TakeBytecode(uint32_t index)
+	{
+		ID3DBlob* bytecode = m_Results[index].bytecode;
+		m_Results[index].bytecode = nullptr;
+		return bytecode;
+	}
+
+	std::vector<ShaderCompileTiming> ShaderCompileBatch::GetTimings() const
+	{
+		std::vector<ShaderCompileTiming> timings;
+		timings.reserve(m_Requests.size());
+		for (size_t i = 0; i < m_Requests.size(); ++i)
+			timings.push_back({ m_Requests[i].path, m_Requests[i].entryPoint, m_Requests[i].profile, m_Results[i].milliseconds, FAILED(m_Results[i].result) });
+
+		std::stable_sort(timings.begin(), timings.end(), [](const ShaderCompileTiming& a, const ShaderCompileTiming& b) { return a.milliseconds > b.milliseconds; });
+		return timings;
+	}
+
+	void ShaderCompileBatch::Release()
+	{
+		for (ShaderCompileResult& result : m_Results)
+		{
+			if (result.bytecode)
+				result.bytecode->Release();
+		}
+
+		m_Requests.clear();
+		m_Results.clear();
+		m_Lookup.clear();
+		m_Stats = {};
+	}
+
+	ShaderCompileBatch::~ShaderCompileBatch()
+	{
+		Release();
+	}
+}
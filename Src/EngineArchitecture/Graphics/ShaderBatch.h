@@ -0,0 +1,83 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ShaderCache.h"
+
+#pragma comment(lib, "D3DCompiler.lib")
+
+namespace Graphics
+{
+	struct ShaderCompileRequest
+	{
+		std::wstring path;
+		std::string entryPoint;
+		std::string profile;
+		std::vector<ShaderMacro> macros;
+		uint32_t flags = 0;
+	};
+
+	struct ShaderCompileResult
+	{
+		ID3DBlob* bytecode = nullptr; // Owned by the batch until TakeBytecode()
+		HRESULT result = E_PENDING;
+		double milliseconds = 0.0; // Wall time of this shader on its worker
+	};
+
+	// One compiled shader of a batch, for reports
+	struct ShaderCompileTiming
+	{
+		std::wstring path;
+		std::string entryPoint;
+		std::string profile;
+		double milliseconds = 0.0;
+		bool failed = false;
+	};
+
+	struct ShaderBatchStats
+	{
+		uint32_t requested = 0; // Add() calls
+		uint32_t compiled = 0; // Unique tuples, each compiled once
+		uint32_t failed = 0;
+		uint32_t threads = 0;
+		double wallMilliseconds = 0.0;
+		double compileMilliseconds = 0.0; // Sum over shaders, wall * threads at best
+	};
+
+	// Collects (file, entry, profile, defines, flags) tuples, drops duplicates and compiles them
+	// concurrently. Results come back in Add() order regardless of which worker finished first.
+	class ShaderCompileBatch
+	{
+	public:
+		ShaderCompileBatch() = default;
+		~ShaderCompileBatch();
+
+		ShaderCompileBatch(const ShaderCompileBatch&) = delete;
+		ShaderCompileBatch& operator=(const ShaderCompileBatch&) = delete;
+
+		uint32_t Add(const ShaderCompileRequest& request); // Same tuple, same index
+		bool Compile(ShaderCache* shaderCache = nullptr, uint32_t threadCount = 0); // 0 uses every hardware thread
+		void Release();
+
+		size_t GetCount() const { return m_Requests.size(); }
+		const ShaderCompileRequest& GetRequest(uint32_t index) const { return m_Requests[index]; }
+		const ShaderCompileResult& GetResult(uint32_t index) const { return m_Results[index]; }
+		ID3DBlob* TakeBytecode(uint32_t index); // Caller releases it
+
+		const ShaderBatchStats& GetStats() const { return m_Stats; }
+		std::vector<ShaderCompileTiming> GetTimings() const; // Per-shader times, slowest first
+
+	private:
+		static std::string MakeKey(const ShaderCompileRequest& request);
+		static HRESULT CompileOne(const ShaderCompileRequest& request, ShaderCache* shaderCache, ID3DBlob** blob);
+
+		std::vector<ShaderCompileRequest> m_Requests;
+		std::vector<ShaderCompileResult> m_Results;
+		std::unordered_map<std::string, uint32_t> m_Lookup;
+		ShaderBatchStats m_Stats;
+	};
+}
@@ -0,0 +1,249 @@
+#include "ShaderCache.h"
+#include <chrono>
+#include <codecvt>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <locale>
+#include <memory>
+
+namespace Graphics
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		double MillisecondsSince(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		bool ReadFile(const std::wstring& path, std::vector<char>& data)
+		{
+#if defined(_WIN32)
+			std::ifstream file(path, std::ios::binary); // MSVC takes the wide path as is
+#else
+			std::ifstream file(std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(path), std::ios::binary);
+#endif
+			if (!file)
+				return false;
+
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
+
+		std::wstring GetDirectory(const std::wstring& path)
+		{
+			size_t slash = path.find_last_of(L"/\\");
+			return (slash == std::wstring::npos) ? std::wstring() : path.substr(0, slash + 1);
+		}
+
+		// Resolves #include "file" relative to the file that contains the directive, the same way D3DCompileFromFile does.
+		// The preprocessor opens and closes includes in nesting order, so the innermost open file is the includer.
+		class ShaderInclude : public ID3DInclude
+		{
+		public:
+			explicit ShaderInclude(const std::wstring& directory) : m_Directory(directory) {}
+
+			HRESULT __stdcall Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID, LPCVOID* data, UINT* bytes) override
+			{
+				const std::wstring& directory = m_Files.empty() ? m_Directory : m_Files.back()->directory;
+				std::wstring path = directory + std::wstring(fileName, fileName + strlen(fileName));
+
+				std::unique_ptr<File> file(new File());
+				if (!ReadFile(path, file->data))
+					return E_FAIL;
+
+				file->directory = GetDirectory(path);
+				*data = file->data.data();
+				*bytes = static_cast<UINT>(file->data.size());
+				m_Files.push_back(std::move(file));
+				return S_OK;
+			}
+
+			HRESULT __stdcall Close(LPCVOID data) override
+			{
+				for (size_t i = m_Files.size(); i-- > 0;)
+				{
+					if (m_Files[i]->data.data() == data)
+					{
+						m_Files.erase(m_Files.begin() + i);
+						break;
+					}
+				}
+				return S_OK;
+			}
+
+		private:
+			struct File
+			{
+				std::vector<char> data;
+				std::wstring directory; // Where its own includes are looked up
+			};
+
+			std::wstring m_Directory; // Of the shader being compiled
+			std::vector<std::unique_ptr<File>> m_Files; // Open includes, innermost last
+		};
+
+		void PrintErrors(ID3DBlob* errors)
+		{
+			if (errors)
+			{
+				std::cerr << "Shader Error: " << static_cast<const char*>(errors->GetBufferPointer()) << std::endl;
+				errors->Release();
+			}
+		}
+	}
+
+	bool ShaderCache::Initialize(const std::string& archivePath, ShaderCompiler* compiler)
+	{
+		m_Compiler = compiler ? compiler : &m_D3DCompiler;
+		m_CompilerVersion = m_Compiler->GetVersion();
+		return m_Archive.Open(archivePath);
+	}
+
+	uint64_t ShaderCache::MakeKey(const void* preprocessed, size_t size, const char* entryPoint, const char* profile, const std::vector<ShaderMacro>& macros, uint32_t flags,
+		const std::string& compilerVersion)
+	{
+		// Strings keep their terminator so "ab"+"c" and "a"+"bc" hash differently
+		uint64_t key = ShaderArchive::Hash(preprocessed, size);
+		key = ShaderArchive::Hash(entryPoint, strlen(entryPoint) + 1, key);
+		key = ShaderArchive::Hash(profile, strlen(profile) + 1, key);
+		key = ShaderArchive::Hash(&flags, sizeof(flags), key);
+		key = ShaderArchive::Hash(compilerVersion.c_str(), compilerVersion.size() + 1, key);
+
+		for (const ShaderMacro& macro : macros)
+		{
+			key = ShaderArchive::Hash(macro.name.c_str(), macro.name.size() + 1, key);
+			key = ShaderArchive::Hash(macro.definition.c_str(), macro.definition.size() + 1, key);
+		}
+
+		return key;
+	}
+
+	HRESULT ShaderCache::Compile(const wchar_t* path, const char* entryPoint, const char* profile, const std::vector<ShaderMacro>& macros, uint32_t flags, ID3DBlob** blob)
+	{
+		std::vector<char> source;
+		if (!ReadFile(path, source))
+		{
+			std::wcerr << L"[ShaderCache] Failed to read " << path << L".\n";
+			return E_FAIL;
+		}
+
+		std::vector<D3D_SHADER_MACRO> defines;
+		for (const ShaderMacro& macro : macros)
+			defines.push_back({ macro.name.c_str(), macro.definition.c_str() });
+		defines.push_back({ nullptr, nullptr });
+
+		std::wstring widePath(path);
+		std::string sourceName(widePath.begin(), widePath.end()); // Only shows up in error messages
+		ShaderInclude include(GetDirectory(widePath));
+
+		// Preprocessing is much cheaper than compiling and pulls in every include the shader depends on
+		Clock::time_point start = Clock::now();
+
+		ID3DBlob* preprocessed = nullptr;
+		ID3DBlob* errors = nullptr;
+		HRESULT hr = m_Compiler->Preprocess(source.data(), source.size(), sourceName.c_str(), defines.data(), &include, &preprocessed, &errors);
+		double preprocessMilliseconds = MillisecondsSince(start);
+
+		if (FAILED(hr))
+		{
+			PrintErrors(errors);
+			return hr;
+		}
+		if (errors)
+			errors->Release();
+
+		uint64_t key = MakeKey(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize(), entryPoint, profile, macros, flags, m_CompilerVersion);
+		preprocessed->Release();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stats.preprocessMilliseconds += preprocessMilliseconds;
+
+			const void* cached = nullptr;
+			size_t cachedSize = 0;
+			if (m_Archive.Find(key, &cached, &cachedSize))
+			{
+				hr = m_Compiler->CreateBlob(cachedSize, blob);
+				if (SUCCEEDED(hr))
+				{
+					memcpy((*blob)->GetBufferPointer(), cached, cachedSize);
+					m_Stats.hits++;
+					return S_OK;
+				}
+			}
+
+			m_Stats.misses++;
+		}
+
+		// Two threads missing on the same key both compile it, ShaderCompileBatch dedups before that happens
+		start = Clock::now();
+
+		errors = nullptr;
+		hr = m_Compiler->Compile(source.data(), source.size(), sourceName.c_str(), defines.data(), &include, entryPoint, profile, flags, blob, &errors);
+		double compileMilliseconds = MillisecondsSince(start);
+
+		if (FAILED(hr))
+		{
+			PrintErrors(errors);
+			return hr;
+		}
+		if (errors)
+			errors->Release(); // Warnings
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stats.compileMilliseconds += compileMilliseconds;
+		m_Archive.Store(key, (*blob)->GetBufferPointer(), (*blob)->GetBufferSize());
+		return S_OK;
+	}
+
+	bool ShaderCache::Reflect(const void* bytecode, size_t size, ShaderReflection& reflection)
+	{
+		// Its own seed keeps reflection keys apart from the bytecode keys
+		uint64_t key = ShaderArchive::Hash(bytecode, size, 0x5245464C45435421ull);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			const void* cached = nullptr;
+			size_t cachedSize = 0;
+			if (m_Archive.Find(key, &cached, &cachedSize) && reflection.Deserialize(cached, cachedSize))
+			{
+				m_Stats.reflectionHits++;
+				return true;
+			}
+
+			m_Stats.reflectionMisses++;
+		}
+
+		if (!reflection.Reflect(bytecode, size))
+			return false;
+
+		std::vector<uint8_t> data;
+		reflection.Serialize(data);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Archive.Store(key, data.data(), data.size());
+		return true;
+	}
+
+	bool ShaderCache::Flush()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Archive.Flush();
+	}
+
+	void ShaderCache::Release()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Archive.Close();
+	}
+
+	ShaderCache::~ShaderCache()
+	{
+		Release();
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ShaderArchive.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+
+#pragma comment(lib, "D3DCompiler.lib")
+
+namespace Graphics
+{
+	struct ShaderMacro
+	{
+		std::string name;
+		std::string definition;
+	};
+
+	struct ShaderCacheStats
+	{
+		uint32_t hits = 0;
+		uint32_t misses = 0;
+		double preprocessMilliseconds = 0.0; // Paid on every request, hit or miss
+		double compileMilliseconds = 0.0;
+		uint32_t reflectionHits = 0;
+		uint32_t reflectionMisses = 0;
+	};
+
+	// Compiles HLSL through a persistent bytecode archive. The key hashes the preprocessed source,
+	// which already has every transitive #include expanded, plus macros, entry point, profile, flags and
+	// compiler version, so editing any included file invalidates exactly the shaders that use it.
+	// Compile() may be called from several threads, only the archive lookups are serialized.
+	class ShaderCache
+	{
+	public:
+		ShaderCache() = default;
+		~ShaderCache();
+
+		bool Initialize(const std::string& archivePath, ShaderCompiler* compiler = nullptr); // nullptr compiles with d3dcompiler
+		void Release(); // Flushes new bytecode to disk
+
+		HRESULT Compile(const wchar_t* path, const char* entryPoint, const char* profile, const std::vector<ShaderMacro>& macros, uint32_t flags, ID3DBlob** blob);
+		HRESULT Compile(const wchar_t* path, const char* entryPoint, const char* profile, ID3DBlob** blob) { return Compile(path, entryPoint, profile, {}, 0, blob); }
+		bool Flush();
+
+		// Reflection data is stored in the archive under the hash of the bytecode, later runs skip D3DReflect
+		bool Reflect(const void* bytecode, size_t size, ShaderReflection& reflection);
+
+		static uint64_t MakeKey(const void* preprocessed, size_t size, const char* entryPoint, const char* profile, const std::vector<ShaderMacro>& macros, uint32_t flags,
+			const std::string& compilerVersion);
+
+		const ShaderCacheStats& GetStats() const { return m_Stats; }
+
+	private:
+		D3DShaderCompiler m_D3DCompiler;
+		ShaderCompiler* m_Compiler = &m_D3DCompiler;
+		std::string m_CompilerVersion; // Queried once in Initialize()
+
+		ShaderArchive m_Archive;
+		ShaderCacheStats m_Stats;
+		std::mutex m_Mutex; // Guards the archive and the stats
+	};
+}
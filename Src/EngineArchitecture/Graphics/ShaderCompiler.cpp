@@ -0,0 +1,210 @@
+#include "ShaderCompiler.h"
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#pragma comment(lib, "version.lib")
+#endif
+
+namespace Graphics
+{
+	namespace
+	{
+		// Heap-backed ID3DBlob for the compilers that do not get one from d3dcompiler
+		class MemoryBlob : public ID3DBlob
+		{
+		public:
+			explicit MemoryBlob(size_t size) : m_Data(size) {}
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void** object) override
+			{
+				*object = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			ULONG STDMETHODCALLTYPE AddRef() override { return ++m_References; }
+
+			ULONG STDMETHODCALLTYPE Release() override
+			{
+				ULONG references = --m_References;
+				if (references == 0)
+					delete this;
+				return references;
+			}
+
+			LPVOID STDMETHODCALLTYPE GetBufferPointer() override { return m_Data.data(); }
+			SIZE_T STDMETHODCALLTYPE GetBufferSize() override { return m_Data.size(); }
+
+		private:
+			virtual ~MemoryBlob() = default;
+
+			std::vector<uint8_t> m_Data;
+			std::atomic<ULONG> m_References { 1 };
+		};
+	}
+
+	std::string D3DShaderCompiler::GetVersion() const
+	{
+		std::string version = std::string(D3DCOMPILER_DLL_A) + " " + std::to_string(D3D_COMPILER_VERSION);
+
+#ifdef _WIN32
+		// Windows updates and redistributables replace the DLL under the same name, its file version tells them apart
+		HMODULE module = GetModuleHandleA(D3DCOMPILER_DLL_A);
+		char path[MAX_PATH];
+		if (!module || !GetModuleFileNameA(module, path, MAX_PATH))
+			return version;
+
+		DWORD size = GetFileVersionInfoSizeA(path, nullptr);
+		std::vector<uint8_t> info(size);
+		VS_FIXEDFILEINFO* fixed = nullptr;
+		UINT length = 0;
+
+		if (size && GetFileVersionInfoA(path, 0, size, info.data()) && VerQueryValueA(info.data(), "\\", reinterpret_cast<void**>(&fixed), &length) && fixed)
+		{
+			version += " " + std::to_string(HIWORD(fixed->dwFileVersionMS)) + "." + std::to_string(LOWORD(fixed->dwFileVersionMS)) +
+				"." + std::to_string(HIWORD(fixed->dwFileVersionLS)) + "." + std::to_string(LOWORD(fixed->dwFileVersionLS));
+		}
+#endif
+
+		return version;
+	}
+
+	HRESULT D3DShaderCompiler::Preprocess(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include, ID3DBlob** preprocessed, ID3DBlob** errors)
+	{
+		return D3DPreprocess(source, size, sourceName, defines, include, preprocessed, errors);
+	}
+
+	HRESULT D3DShaderCompiler::Compile(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include,
+		const char* entryPoint, const char* profile, uint32_t flags, ID3DBlob** bytecode, ID3DBlob** errors)
+	{
+		return D3DCompile(source, size, sourceName, defines, include, entryPoint, profile, flags, 0, bytecode, errors);
+	}
+
+	HRESULT D3DShaderCompiler::CreateBlob(size_t size, ID3DBlob** blob)
+	{
+		return D3DCreateBlob(size, blob);
+	}
+
+	HRESULT NullShaderCompiler::Expand(const char* text, size_t size, ID3DInclude* include, uint32_t depth, std::string& output, std::string& error)
+	{
+		if (depth > MaxIncludeDepth)
+		{
+			error = "Includes nested too deeply.";
+			return E_FAIL;
+		}
+
+		const char* end = text + size;
+		while (text < end)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(text, '\n', end - text));
+			if (!lineEnd)
+				lineEnd = end;
+
+			std::string line(text, lineEnd);
+			text = (lineEnd < end) ? lineEnd + 1 : end;
+
+			size_t directive = line.find_first_not_of(" \t");
+			if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+			{
+				output += line;
+				output += '\n';
+				continue;
+			}
+
+			size_t open = line.find_first_of("\"<", directive + 8);
+			size_t close = (open == std::string::npos) ? open : line.find_first_of("\">", open + 1);
+			if (close == std::string::npos)
+			{
+				error = "Malformed #include: " + line;
+				return E_FAIL;
+			}
+
+			std::string fileName = line.substr(open + 1, close - open - 1);
+			D3D_INCLUDE_TYPE type = (line[open] == '<') ? D3D_INCLUDE_SYSTEM : D3D_INCLUDE_LOCAL;
+
+			LPCVOID data = nullptr;
+			UINT bytes = 0;
+			if (!include || FAILED(include->Open(type, fileName.c_str(), nullptr, &data, &bytes)))
+			{
+				error = "Cannot open include file: " + fileName;
+				return E_FAIL;
+			}
+
+			HRESULT hr = Expand(static_cast<const char*>(data), bytes, include, depth + 1, output, error);
+			include->Close(data); // Same nesting order as the real preprocessor
+			if (FAILED(hr))
+				return hr;
+		}
+
+		return S_OK;
+	}
+
+	HRESULT NullShaderCompiler::Preprocess(const void* source, size_t size, const char*, const D3D_SHADER_MACRO* defines, ID3DInclude* include, ID3DBlob** preprocessed, ID3DBlob** errors)
+	{
+		m_PreprocessCount++;
+
+		std::string output;
+		for (const D3D_SHADER_MACRO* define = defines; define && define->Name; ++define)
+			output += std::string("#define ") + define->Name + " " + (define->Definition ? define->Definition : "") + "\n";
+
+		std::string error;
+		HRESULT hr = Expand(static_cast<const char*>(source), size, include, 0, output, error);
+
+		if (errors)
+			*errors = nullptr;
+		if (FAILED(hr))
+		{
+			if (errors)
+				CreateTextBlob(error, errors);
+			return hr;
+		}
+
+		return CreateTextBlob(output, preprocessed);
+	}
+
+	HRESULT NullShaderCompiler::Compile(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include,
+		const char* entryPoint, const char* profile, uint32_t flags, ID3DBlob** bytecode, ID3DBlob** errors)
+	{
+		m_CompileCount++;
+
+		std::string text = std::string(profile) + " " + entryPoint + " " + std::to_string(flags) + "\n";
+		for (const D3D_SHADER_MACRO* define = defines; define && define->Name; ++define)
+			text += std::string("#define ") + define->Name + " " + (define->Definition ? define->Definition : "") + "\n";
+
+		std::string error;
+		HRESULT hr = Expand(static_cast<const char*>(source), size, include, 0, text, error);
+
+		// The entry point must appear in the source itself, not just in the header line above
+		if (SUCCEEDED(hr) && text.find(entryPoint, text.find('\n')) == std::string::npos)
+		{
+			error = std::string(sourceName) + ": entry point " + entryPoint + " not found.";
+			hr = E_FAIL;
+		}
+
+		if (errors)
+			*errors = nullptr;
+		if (FAILED(hr))
+		{
+			if (errors)
+				CreateTextBlob(error, errors);
+			return hr;
+		}
+
+		return CreateTextBlob(text, bytecode);
+	}
+
+	HRESULT NullShaderCompiler::CreateBlob(size_t size, ID3DBlob** blob)
+	{
+		*blob = new MemoryBlob(size);
+		return S_OK;
+	}
+
+	HRESULT NullShaderCompiler::CreateTextBlob(const std::string& text, ID3DBlob** blob)
+	{
+		HRESULT hr = CreateBlob(text.size() + 1, blob); // Terminated, errors are printed as C strings
+		if (SUCCEEDED(hr))
+			memcpy((*blob)->GetBufferPointer(), text.c_str(), text.size() + 1);
+		return hr;
+	}
+}
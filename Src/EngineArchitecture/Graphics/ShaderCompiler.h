@@ -0,0 +1,68 @@
+#pragma once
+
+#include <d3dcompiler.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+#pragma comment(lib, "D3DCompiler.lib")
+
+namespace Graphics
+{
+	// The HLSL compiler behind ShaderCache, the same calls as d3dcompiler. Every method may be called from several threads.
+	class ShaderCompiler
+	{
+	public:
+		virtual ~ShaderCompiler() = default;
+
+		// Identifies the exact compiler build. Part of every cache key, so a compiler update rebuilds the bytecode.
+		virtual std::string GetVersion() const = 0;
+
+		virtual HRESULT Preprocess(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include, ID3DBlob** preprocessed, ID3DBlob** errors) = 0;
+		virtual HRESULT Compile(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include,
+			const char* entryPoint, const char* profile, uint32_t flags, ID3DBlob** bytecode, ID3DBlob** errors) = 0;
+		virtual HRESULT CreateBlob(size_t size, ID3DBlob** blob) = 0;
+	};
+
+	// d3dcompiler_47, the version names the DLL that is actually loaded
+	class D3DShaderCompiler : public ShaderCompiler
+	{
+	public:
+		std::string GetVersion() const override;
+
+		HRESULT Preprocess(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include, ID3DBlob** preprocessed, ID3DBlob** errors) override;
+		HRESULT Compile(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include,
+			const char* entryPoint, const char* profile, uint32_t flags, ID3DBlob** bytecode, ID3DBlob** errors) override;
+		HRESULT CreateBlob(size_t size, ID3DBlob** blob) override;
+	};
+
+	// Stand-in without d3dcompiler (tests). Preprocessing expands #include lines through the ID3DInclude and
+	// prepends the defines, the "bytecode" is the preprocessed text behind a profile/entry point line.
+	// Compiling fails when the entry point does not appear in the source.
+	class NullShaderCompiler : public ShaderCompiler
+	{
+	public:
+		explicit NullShaderCompiler(const std::string& version = "NullShaderCompiler 1") : m_Version(version) {}
+
+		std::string GetVersion() const override { return m_Version; }
+
+		HRESULT Preprocess(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include, ID3DBlob** preprocessed, ID3DBlob** errors) override;
+		HRESULT Compile(const void* source, size_t size, const char* sourceName, const D3D_SHADER_MACRO* defines, ID3DInclude* include,
+			const char* entryPoint, const char* profile, uint32_t flags, ID3DBlob** bytecode, ID3DBlob** errors) override;
+		HRESULT CreateBlob(size_t size, ID3DBlob** blob) override;
+
+		uint32_t GetPreprocessCount() const { return m_PreprocessCount.load(); }
+		uint32_t GetCompileCount() const { return m_CompileCount.load(); }
+
+		static constexpr uint32_t MaxIncludeDepth = 32;
+
+	private:
+		HRESULT Expand(const char* text, size_t size, ID3DInclude* include, uint32_t depth, std::string& output, std::string& error);
+		HRESULT CreateTextBlob(const std::string& text, ID3DBlob** blob);
+
+		std::string m_Version;
+		std::atomic<uint32_t> m_PreprocessCount { 0 };
+		std::atomic<uint32_t> m_CompileCount { 0 };
+	};
+}
@@ -0,0 +1,237 @@
+#include "ShaderPermutation.h"
+#include "PipelineCache.h"
+#include "ShaderBatch.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace Graphics
+{
+	std::vector<ShaderMacro> GetPermutationDefines(uint32_t permutation)
+	{
+		static const char* names[ShaderFeatureCount] = { "USE_VERTEX_COLOR", "USE_INSTANCING", "USE_SKINNING", "USE_FOG" };
+
+		std::vector<ShaderMacro> defines;
+		for (uint32_t bit = 0; bit < ShaderFeatureCount; ++bit)
+		{
+			if (permutation & (1u << bit))
+				defines.push_back({ names[bit], "1" });
+		}
+
+		return defines;
+	}
+
+	std::vector<D3D_SHADER_MACRO> ToD3DMacros(const std::vector<ShaderMacro>& macros)
+	{
+		std::vector<D3D_SHADER_MACRO> result;
+		result.reserve(macros.size() + 1);
+
+		for (const ShaderMacro& macro : macros)
+			result.push_back({ macro.name.c_str(), macro.definition.c_str() });
+
+		result.push_back({ nullptr, nullptr });
+		return result;
+	}
+
+	bool ShaderPermutationSet::Initialize(PipelineCache& pipelineCache, ShaderCache* shaderCache, DescBuilder builder, uint32_t fallbackPermutation)
+	{
+		m_PipelineCache = &pipelineCache;
+		m_ShaderCache = shaderCache;
+		m_Builder = builder;
+
+		// The fallback is the one variant that is always built synchronously
+		m_Fallback = m_PipelineCache->GetPipeline(m_Builder(fallbackPermutation));
+		if (!m_Fallback)
+		{
+			std::cerr << "[ShaderPermutationSet] Failed to build the fallback pipeline.\n";
+			return false;
+		}
+
+		m_Variants[fallbackPermutation].pipeline = m_Fallback;
+		return true;
+	}
+
+	ShaderPermutationSet::CompiledShaders ShaderPermutationSet::CompileVariant(PipelineDesc desc, ShaderCache* shaderCache)
+	{
+		std::vector<ShaderMacro> defines = GetPermutationDefines(desc.permutation);
+
+		ShaderCompileBatch batch;
+		uint32_t vertex = batch.Add({ desc.vertexShaderPath, desc.vertexShaderEntry, "vs_5_0", defines });
+		uint32_t pixel = desc.depthOnly ? 0 : batch.Add({ desc.pixelShaderPath, desc.pixelShaderEntry, "ps_5_0", defines });
+		batch.Compile(shaderCache, 2);
+
+		CompiledShaders shaders;
+		shaders.vertex = batch.TakeBytecode(vertex);
+		shaders.pixel = desc.depthOnly ? nullptr : batch.TakeBytecode(pixel);
+		return shaders;
+	}
+
+	ShaderPermutationSet::Variant& ShaderPermutationSet::Request(uint32_t permutation)
+	{
+		auto it = m_Variants.find(permutation);
+		if (it != m_Variants.end())
+			return it->second;
+
+		m_Usage.push_back(permutation);
+
+		Variant& variant = m_Variants[permutation];
+		variant.pending = std::async(std::launch::async, &ShaderPermutationSet::CompileVariant, m_Builder(permutation), m_ShaderCache);
+		return variant;
+	}
+
+	const Pipeline* ShaderPermutationSet::Get(uint32_t permutation)
+	{
+		Variant& variant = Request(permutation);
+		if (variant.pipeline)
+			return variant.pipeline.get();
+
+		m_FallbackRequests++;
+		return m_Fallback.get();
+	}
+
+	bool ShaderPermutationSet::IsReady(uint32_t permutation) const
+	{
+		auto it = m_Variants.find(permutation);
+		return it != m_Variants.end() && it->second.pipeline;
+	}
+
+	void ShaderPermutationSet::Update()
+	{
+		for (auto& entry : m_Variants)
+		{
+			Variant& variant = entry.second;
+			if (!variant.pending.valid())
+				continue;
+
+			if (variant.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				continue;
+
+			// D3D objects and the pipeline cache stay on this thread, only bytecode came from the worker
+			CompiledShaders shaders = variant.pending.get();
+			PipelineDesc desc = m_Builder(entry.first);
+			if (shaders.vertex && (shaders.pixel || desc.depthOnly))
+				variant.pipeline = m_PipelineCache->GetPipeline(desc, shaders.vertex, shaders.pixel);
+			else
+			{
+				if (shaders.vertex)
+					shaders.vertex->Release();
+				if (shaders.pixel)
+					shaders.pixel->Release();
+			}
+
+			if (!variant.pipeline)
+			{
+				std::cerr << "[ShaderPermutationSet] Permutation 0x" << std::hex << entry.first << std::dec << " failed, keeping the fallback.\n";
+				variant.failed = true;
+			}
+		}
+	}
+
+	void ShaderPermutationSet::Precompile(const std::vector<uint32_t>& permutations)
+	{
+		std::vector<uint32_t> missing;
+		std::vector<PipelineDesc> descs;
+
+		for (uint32_t permutation : permutations)
+		{
+			if (m_Variants.count(permutation))
+				continue;
+
+			m_Variants[permutation];
+			m_Usage.push_back(permutation);
+			missing.push_back(permutation);
+			descs.push_back(m_Builder(permutation));
+		}
+
+		if (descs.empty())
+			return;
+
+		std::vector<std::shared_ptr<Pipeline>> pipelines = m_PipelineCache->CreatePipelines(descs);
+		for (size_t i = 0; i < missing.size(); ++i)
+		{
+			Variant& variant = m_Variants[missing[i]];
+			variant.pipeline = pipelines[i];
+			variant.failed = !pipelines[i];
+		}
+	}
+
+	bool ShaderPermutationSet::SaveUsageLog(const std::string& path) const
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			std::cerr << "[ShaderPermutationSet] Failed to write usage log: " << path << "\n";
+			return false;
+		}
+
+		file << "# Shader permutations in first-use order, one hex key per line\n";
+		for (uint32_t permutation : m_Usage)
+			file << std::hex << permutation << "\n";
+
+		return true;
+	}
+
+	bool ShaderPermutationSet::ReplayUsageLog(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			return false; // First run, nothing recorded yet
+
+		std::vector<uint32_t> permutations;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#')
+				continue;
+
+			permutations.push_back(static_cast<uint32_t>(strtoul(line.c_str(), nullptr, 16)));
+		}
+
+		Precompile(permutations);
+		return true;
+	}
+
+	ShaderPermutationStats ShaderPermutationSet::GetStats() const
+	{
+		ShaderPermutationStats stats;
+		for (const auto& entry : m_Variants)
+		{
+			if (entry.second.pipeline)
+				stats.variants++;
+			else if (entry.second.failed)
+				stats.failed++;
+			else
+				stats.pending++;
+		}
+
+		stats.fallbackRequests = m_FallbackRequests;
+		return stats;
+	}
+
+	void ShaderPermutationSet::Release()
+	{
+		for (auto& entry : m_Variants)
+		{
+			Variant& variant = entry.second;
+			if (!variant.pending.valid())
+				continue;
+
+			CompiledShaders shaders = variant.pending.get();
+			if (shaders.vertex)
+				shaders.vertex->Release();
+			if (shaders.pixel)
+				shaders.pixel->Release();
+		}
+
+		m_Variants.clear();
+		m_Usage.clear();
+		m_Fallback.reset();
+		m_FallbackRequests = 0;
+	}
+
+	ShaderPermutationSet::~ShaderPermutationSet()
+	{
+		Release();
+	}
+}
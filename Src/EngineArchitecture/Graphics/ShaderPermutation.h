@@ -0,0 +1,99 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3dcompiler.h>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Pipeline.h"
+#include "ShaderCache.h"
+
+namespace Graphics
+{
+	class PipelineCache;
+
+	// One bit per optional shader feature, each maps to a USE_* define
+	enum class ShaderFeature : uint32_t
+	{
+		VertexColor = 1 << 0, // USE_VERTEX_COLOR
+		Instancing = 1 << 1,  // USE_INSTANCING
+		Skinning = 1 << 2,    // USE_SKINNING
+		Fog = 1 << 3          // USE_FOG
+	};
+
+	static constexpr uint32_t ShaderFeatureCount = 4;
+
+	inline uint32_t operator|(ShaderFeature a, ShaderFeature b) { return static_cast<uint32_t>(a) | static_cast<uint32_t>(b); }
+	inline uint32_t operator|(uint32_t a, ShaderFeature b) { return a | static_cast<uint32_t>(b); }
+	inline bool HasFeature(uint32_t permutation, ShaderFeature feature) { return (permutation & static_cast<uint32_t>(feature)) != 0; }
+
+	std::vector<ShaderMacro> GetPermutationDefines(uint32_t permutation);
+	std::vector<D3D_SHADER_MACRO> ToD3DMacros(const std::vector<ShaderMacro>& macros); // Null terminated, points into macros
+
+	struct ShaderPermutationStats
+	{
+		uint32_t variants = 0; // Ready to draw with
+		uint32_t pending = 0; // Compiling in the background
+		uint32_t failed = 0;
+		uint32_t fallbackRequests = 0; // Get() calls answered with the fallback
+	};
+
+	// Pipelines for every permutation of one shader pair, created on first use.
+	//
+	// Get() never blocks: an unknown permutation starts compiling on a background thread and the
+	// fallback pipeline is returned until Update() (main thread, once per frame) picks the result up.
+	// Every permutation ever requested is logged in first-use order; replaying that log on the next
+	// run compiles exactly those variants up front, in parallel, before the first frame.
+	class ShaderPermutationSet
+	{
+	public:
+		using DescBuilder = std::function<PipelineDesc(uint32_t permutation)>; // Input layout and entry points per permutation
+
+		ShaderPermutationSet() = default;
+		~ShaderPermutationSet();
+
+		bool Initialize(PipelineCache& pipelineCache, ShaderCache* shaderCache, DescBuilder builder, uint32_t fallbackPermutation);
+		void Release(); // Waits for background compiles
+
+		const Pipeline* Get(uint32_t permutation);
+		bool IsReady(uint32_t permutation) const;
+		void Update();
+
+		void Precompile(const std::vector<uint32_t>& permutations); // Blocking, uses every core
+		bool SaveUsageLog(const std::string& path) const;
+		bool ReplayUsageLog(const std::string& path);
+
+		const std::vector<uint32_t>& GetUsage() const { return m_Usage; }
+		ShaderPermutationStats GetStats() const;
+
+	private:
+		struct CompiledShaders
+		{
+			ID3DBlob* vertex = nullptr;
+			ID3DBlob* pixel = nullptr;
+		};
+
+		struct Variant
+		{
+			std::shared_ptr<Pipeline> pipeline;
+			std::future<CompiledShaders> pending;
+			bool failed = false;
+		};
+
+		static CompiledShaders CompileVariant(PipelineDesc desc, ShaderCache* shaderCache);
+		Variant& Request(uint32_t permutation);
+
+		PipelineCache* m_PipelineCache = nullptr;
+		ShaderCache* m_ShaderCache = nullptr;
+		DescBuilder m_Builder;
+
+		std::shared_ptr<Pipeline> m_Fallback;
+		std::unordered_map<uint32_t, Variant> m_Variants;
+		std::vector<uint32_t> m_Usage;
+		uint32_t m_FallbackRequests = 0;
+	};
+}
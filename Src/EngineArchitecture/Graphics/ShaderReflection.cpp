@@ -0,0 +1,349 @@
+#include "ShaderReflection.h"
+#include <d3dcompiler.h>
+#include <d3d11shader.h>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	namespace
+	{
+		constexpr uint32_t SerializedMagic = 0x4C465253; // "SRFL"
+		constexpr uint32_t SerializedVersion = 1;
+
+		class ByteWriter
+		{
+		public:
+			explicit ByteWriter(std::vector<uint8_t>& data) : m_Data(data) {}
+
+			void U32(uint32_t value)
+			{
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+				m_Data.insert(m_Data.end(), bytes, bytes + sizeof(value));
+			}
+
+			void String(const std::string& text)
+			{
+				U32(static_cast<uint32_t>(text.size()));
+				m_Data.insert(m_Data.end(), text.begin(), text.end());
+			}
+
+		private:
+			std::vector<uint8_t>& m_Data;
+		};
+
+		// Every read is bounds checked, a truncated blob fails instead of reading past the archive
+		class ByteReader
+		{
+		public:
+			ByteReader(const void* data, size_t size) : m_Data(static_cast<const uint8_t*>(data)), m_Size(size) {}
+
+			bool U32(uint32_t& value)
+			{
+				if (m_Size - m_Offset < sizeof(value))
+					return false;
+
+				memcpy(&value, m_Data + m_Offset, sizeof(value));
+				m_Offset += sizeof(value);
+				return true;
+			}
+
+			bool String(std::string& text)
+			{
+				uint32_t length = 0;
+				if (!U32(length) || m_Size - m_Offset < length)
+					return false;
+
+				text.assign(reinterpret_cast<const char*>(m_Data + m_Offset), length);
+				m_Offset += length;
+				return true;
+			}
+
+			bool AtEnd() const { return m_Offset == m_Size; }
+
+		private:
+			const uint8_t* m_Data;
+			size_t m_Size;
+			size_t m_Offset = 0;
+		};
+
+		// Component count and register type the input assembler produces for a vertex format, false if unknown
+		bool GetFormatInfo(DXGI_FORMAT format, uint32_t& components, uint32_t& type)
+		{
+			switch (format)
+			{
+			case DXGI_FORMAT_R32G32B32A32_FLOAT: components = 4; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R32G32B32A32_UINT: components = 4; type = D3D_REGISTER_COMPONENT_UINT32; return true;
+			case DXGI_FORMAT_R32G32B32A32_SINT: components = 4; type = D3D_REGISTER_COMPONENT_SINT32; return true;
+			case DXGI_FORMAT_R32G32B32_FLOAT: components = 3; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R32G32B32_UINT: components = 3; type = D3D_REGISTER_COMPONENT_UINT32; return true;
+			case DXGI_FORMAT_R32G32B32_SINT: components = 3; type = D3D_REGISTER_COMPONENT_SINT32; return true;
+			case DXGI_FORMAT_R32G32_FLOAT: components = 2; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R32G32_UINT: components = 2; type = D3D_REGISTER_COMPONENT_UINT32; return true;
+			case DXGI_FORMAT_R32G32_SINT: components = 2; type = D3D_REGISTER_COMPONENT_SINT32; return true;
+			case DXGI_FORMAT_R32_FLOAT: components = 1; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R32_UINT: components = 1; type = D3D_REGISTER_COMPONENT_UINT32; return true;
+			case DXGI_FORMAT_R32_SINT: components = 1; type = D3D_REGISTER_COMPONENT_SINT32; return true;
+
+			// Normalized formats arrive in the shader as floats
+			case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			case DXGI_FORMAT_R16G16B16A16_UNORM:
+			case DXGI_FORMAT_R16G16B16A16_SNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_SNORM:
+			case DXGI_FORMAT_B8G8R8A8_UNORM:
+			case DXGI_FORMAT_R10G10B10A2_UNORM: components = 4; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R11G11B10_FLOAT: components = 3; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R16G16_FLOAT:
+			case DXGI_FORMAT_R16G16_UNORM:
+			case DXGI_FORMAT_R16G16_SNORM: components = 2; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+			case DXGI_FORMAT_R16_FLOAT:
+			case DXGI_FORMAT_R16_UNORM: components = 1; type = D3D_REGISTER_COMPONENT_FLOAT32; return true;
+
+			case DXGI_FORMAT_R16G16B16A16_UINT:
+			case DXGI_FORMAT_R8G8B8A8_UINT:
+			case DXGI_FORMAT_R10G10B10A2_UINT: components = 4; type = D3D_REGISTER_COMPONENT_UINT32; return true;
+			case DXGI_FORMAT_R16G16B16A16_SINT:
+			case DXGI_FORMAT_R8G8B8A8_SINT: components = 4; type = D3D_REGISTER_COMPONENT_SINT32; return true;
+			case DXGI_FORMAT_R16G16_UINT: components = 2; type = D3D_REGISTER_COMPONENT_UINT32; return true;
+			case DXGI_FORMAT_R16G16_SINT: components = 2; type = D3D_REGISTER_COMPONENT_SINT32; return true;
+
+			default: return false;
+			}
+		}
+
+		// HLSL semantics are case-insensitive
+		bool SameSemantic(const char* a, const std::string& b)
+		{
+			size_t length = strlen(a);
+			if (length != b.size())
+				return false;
+
+			for (size_t i = 0; i < length; ++i)
+			{
+				if (toupper(static_cast<unsigned char>(a[i])) != toupper(static_cast<unsigned char>(b[i])))
+					return false;
+			}
+
+			return true;
+		}
+	}
+
+	const ShaderVariable* ShaderConstantBuffer::FindVariable(const char* variableName) const
+	{
+		for (const ShaderVariable& variable : variables)
+		{
+			if (variable.name == variableName)
+				return &variable;
+		}
+
+		return nullptr;
+	}
+
+	bool ShaderReflection::Reflect(const void* bytecode, size_t size)
+	{
+		m_Inputs.clear();
+		m_ConstantBuffers.clear();
+
+		ID3D11ShaderReflection* reflection = nullptr;
+		if (FAILED(D3DReflect(bytecode, size, IID_ID3D11ShaderReflection, reinterpret_cast<void**>(&reflection))))
+		{
+			std::cerr << "[ShaderReflection] Failed to reflect shader bytecode.\n";
+			return false;
+		}
+
+		D3D11_SHADER_DESC shaderDesc = {};
+		reflection->GetDesc(&shaderDesc);
+
+		for (UINT i = 0; i < shaderDesc.InputParameters; ++i)
+		{
+			D3D11_SIGNATURE_PARAMETER_DESC parameterDesc = {};
+			reflection->GetInputParameterDesc(i, &parameterDesc);
+
+			ShaderInputParameter input;
+			input.semanticName = parameterDesc.SemanticName;
+			input.semanticIndex = parameterDesc.SemanticIndex;
+			input.componentType = parameterDesc.ComponentType;
+			input.systemValue = parameterDesc.SystemValueType != D3D_NAME_UNDEFINED;
+
+			// The mask is contiguous from x, its highest bit gives the declared width
+			for (uint32_t mask = parameterDesc.Mask; mask; mask >>= 1)
+				input.componentCount++;
+
+			m_Inputs.push_back(input);
+		}
+
+		for (UINT i = 0; i < shaderDesc.ConstantBuffers; ++i)
+		{
+			ID3D11ShaderReflectionConstantBuffer* constantBuffer = reflection->GetConstantBufferByIndex(i);
+
+			D3D11_SHADER_BUFFER_DESC bufferDesc = {};
+			constantBuffer->GetDesc(&bufferDesc);
+			if (bufferDesc.Type != D3D_CT_CBUFFER)
+				continue; // tbuffers and structured buffers are bound as resources
+
+			ShaderConstantBuffer buffer;
+			buffer.name = bufferDesc.Name;
+			buffer.size = bufferDesc.Size;
+
+			D3D11_SHADER_INPUT_BIND_DESC bindDesc = {};
+			if (SUCCEEDED(reflection->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc)))
+				buffer.bindSlot = bindDesc.BindPoint;
+
+			for (UINT v = 0; v < bufferDesc.Variables; ++v)
+			{
+				D3D11_SHADER_VARIABLE_DESC variableDesc = {};
+				constantBuffer->GetVariableByIndex(v)->GetDesc(&variableDesc);
+				buffer.variables.push_back({ variableDesc.Name, variableDesc.StartOffset, variableDesc.Size });
+			}
+
+			m_ConstantBuffers.push_back(std::move(buffer));
+		}
+
+		reflection->Release();
+		return true;
+	}
+
+	void ShaderReflection::Serialize(std::vector<uint8_t>& data) const
+	{
+		data.clear();
+
+		ByteWriter writer(data);
+		writer.U32(SerializedMagic);
+		writer.U32(SerializedVersion);
+
+		writer.U32(static_cast<uint32_t>(m_Inputs.size()));
+		for (const ShaderInputParameter& input : m_Inputs)
+		{
+			writer.String(input.semanticName);
+			writer.U32(input.semanticIndex);
+			writer.U32(input.componentType);
+			writer.U32(input.componentCount);
+			writer.U32(input.systemValue ? 1 : 0);
+		}
+
+		writer.U32(static_cast<uint32_t>(m_ConstantBuffers.size()));
+		for (const ShaderConstantBuffer& buffer : m_ConstantBuffers)
+		{
+			writer.String(buffer.name);
+			writer.U32(buffer.size);
+			writer.U32(buffer.bindSlot);
+			writer.U32(static_cast<uint32_t>(buffer.variables.size()));
+
+			for (const ShaderVariable& variable : buffer.variables)
+			{
+				writer.String(variable.name);
+				writer.U32(variable.offset);
+				writer.U32(variable.size);
+			}
+		}
+	}
+
+	bool ShaderReflection::Deserialize(const void* data, size_t size)
+	{
+		m_Inputs.clear();
+		m_ConstantBuffers.clear();
+
+		ByteReader reader(data, size);
+
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint32_t inputCount = 0;
+		if (!reader.U32(magic) || !reader.U32(version) || magic != SerializedMagic || version != SerializedVersion || !reader.U32(inputCount))
+			return false;
+
+		for (uint32_t i = 0; i < inputCount; ++i)
+		{
+			ShaderInputParameter input;
+			uint32_t systemValue = 0;
+			if (!reader.String(input.semanticName) || !reader.U32(input.semanticIndex) || !reader.U32(input.componentType) ||
+				!reader.U32(input.componentCount) || !reader.U32(systemValue))
+				return false;
+
+			input.systemValue = systemValue != 0;
+			m_Inputs.push_back(std::move(input));
+		}
+
+		uint32_t bufferCount = 0;
+		if (!reader.U32(bufferCount))
+			return false;
+
+		for (uint32_t i = 0; i < bufferCount; ++i)
+		{
+			ShaderConstantBuffer buffer;
+			uint32_t variableCount = 0;
+			if (!reader.String(buffer.name) || !reader.U32(buffer.size) || !reader.U32(buffer.bindSlot) || !reader.U32(variableCount))
+				return false;
+
+			for (uint32_t v = 0; v < variableCount; ++v)
+			{
+				ShaderVariable variable;
+				if (!reader.String(variable.name) || !reader.U32(variable.offset) || !reader.U32(variable.size))
+					return false;
+
+				buffer.variables.push_back(std::move(variable));
+			}
+
+			m_ConstantBuffers.push_back(std::move(buffer));
+		}
+
+		return reader.AtEnd();
+	}
+
+	bool ShaderReflection::ValidateInputLayout(const std::vector<D3D11_INPUT_ELEMENT_DESC>& elements) const
+	{
+		bool valid = true;
+
+		for (const ShaderInputParameter& input : m_Inputs)
+		{
+			if (input.systemValue)
+				continue;
+
+			const D3D11_INPUT_ELEMENT_DESC* match = nullptr;
+			for (const D3D11_INPUT_ELEMENT_DESC& element : elements)
+			{
+				if (element.SemanticName && element.SemanticIndex == input.semanticIndex && SameSemantic(element.SemanticName, input.semanticName))
+				{
+					match = &element;
+					break;
+				}
+			}
+
+			if (!match)
+			{
+				std::cerr << "[ShaderReflection] Input layout has no element for " << input.semanticName << input.semanticIndex << ".\n";
+				valid = false;
+				continue;
+			}
+
+			uint32_t components = 0;
+			uint32_t type = 0;
+			if (!GetFormatInfo(match->Format, components, type))
+				continue; // Exotic format, CreateInputLayout has the final word
+
+			if (type != input.componentType)
+			{
+				std::cerr << "[ShaderReflection] " << input.semanticName << input.semanticIndex << " format does not match the shader type (float/int/uint).\n";
+				valid = false;
+			}
+
+			// Missing components are legal (the input assembler fills in 0, 0, 0, 1) but usually a mistake
+			if (components < input.componentCount)
+				std::cerr << "[ShaderReflection] " << input.semanticName << input.semanticIndex << " provides " << components << " of " << input.componentCount << " components.\n";
+		}
+
+		return valid;
+	}
+
+	const ShaderConstantBuffer* ShaderReflection::FindConstantBuffer(const char* name) const
+	{
+		for (const ShaderConstantBuffer& buffer : m_ConstantBuffers)
+		{
+			if (buffer.name == name)
+				return &buffer;
+		}
+
+		return nullptr;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "D3DCompiler.lib")
+#pragma comment(lib, "dxguid.lib")
+
+namespace Graphics
+{
+	struct ShaderInputParameter
+	{
+		std::string semanticName;
+		uint32_t semanticIndex = 0;
+		uint32_t componentType = 0; // D3D_REGISTER_COMPONENT_TYPE
+		uint32_t componentCount = 0; // Components the shader actually declares (float3 -> 3)
+		bool systemValue = false; // SV_VertexID, SV_InstanceID... never come from the input layout
+	};
+
+	struct ShaderVariable
+	{
+		std::string name;
+		uint32_t offset = 0; // Bytes from the start of the cbuffer
+		uint32_t size = 0;
+	};
+
+	struct ShaderConstantBuffer
+	{
+		std::string name;
+		uint32_t size = 0; // Already padded to 16 bytes by the compiler
+		uint32_t bindSlot = 0; // register(bN)
+		std::vector<ShaderVariable> variables;
+
+		const ShaderVariable* FindVariable(const char* variableName) const;
+	};
+
+	// What a compiled shader expects from the CPU side: its input signature and every cbuffer,
+	// with sizes, variable offsets and bind slots. Built once from the bytecode with D3DReflect
+	// and small enough to be stored next to the bytecode in the ShaderCache archive.
+	class ShaderReflection
+	{
+	public:
+		ShaderReflection() = default;
+
+		bool Reflect(const void* bytecode, size_t size);
+
+		void Serialize(std::vector<uint8_t>& data) const;
+		bool Deserialize(const void* data, size_t size);
+
+		// Every non system-value input needs an element with the same semantic and a compatible format
+		bool ValidateInputLayout(const std::vector<D3D11_INPUT_ELEMENT_DESC>& elements) const;
+
+		const ShaderConstantBuffer* FindConstantBuffer(const char* name) const;
+		const std::vector<ShaderInputParameter>& GetInputs() const { return m_Inputs; }
+		const std::vector<ShaderConstantBuffer>& GetConstantBuffers() const { return m_ConstantBuffers; }
+
+	private:
+		std::vector<ShaderInputParameter> m_Inputs;
+		std::vector<ShaderConstantBuffer> m_ConstantBuffers;
+	};
+}
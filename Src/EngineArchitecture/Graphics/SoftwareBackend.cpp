@@ -0,0 +1,1391 @@
+#include "SoftwareBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "../Core/JobSystem.h"
+#include "../Core/Profiler.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define SOFTWARE_RASTER_SSE2
+#endif
+
+namespace Graphics
+{
+	namespace
+	{
+		using Clock = std::chrono::steady_clock;
+
+		double ElapsedMilliseconds(Clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+
+		constexpr int32_t SubpixelBits = 4;
+		constexpr int32_t SubpixelScale = 1 << SubpixelBits;
+		constexpr int32_t HalfPixel = SubpixelScale / 2;
+		constexpr float GuardBandPixels = 8000.0f; // Snapped coordinates stay under 2^13 pixels, edge values inside a tile fit in int32
+		constexpr float DepthScale = 16777215.0f; // D24 UNORM
+		constexpr uint32_t DepthMask = 0x00FFFFFF;
+		constexpr uint32_t TrianglesPerBatch = 4096; // Setup and binning job size
+		constexpr uint32_t VerticesPerJob = 2048;
+
+		// ShaderFeature bits (ShaderPermutation.h), the D3D11 headers stay out of this file
+		constexpr uint32_t FeatureVertexColor = 1 << 0;
+		constexpr uint32_t FeatureInstancing = 1 << 1;
+		constexpr uint32_t FeatureSkinning = 1 << 2;
+		constexpr uint32_t FeatureFog = 1 << 3;
+
+		// Row vectors like DirectXMath: out = v * M
+		struct Matrix
+		{
+			float m[4][4];
+		};
+
+		// Constant buffers and the instance stream carry transposed matrices, M[row][column] is stored at [column * 4 + row]
+		Matrix LoadTransposed(const float* data)
+		{
+			Matrix result;
+			for (int row = 0; row < 4; ++row)
+				for (int column = 0; column < 4; ++column)
+					result.m[row][column] = data[column * 4 + row];
+			return result;
+		}
+
+		Matrix Multiply(const Matrix& a, const Matrix& b)
+		{
+			Matrix result;
+			for (int row = 0; row < 4; ++row)
+				for (int column = 0; column < 4; ++column)
+					result.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column] + a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+			return result;
+		}
+
+		void Transform(const float v[4], const Matrix& m, float out[4])
+		{
+			for (int column = 0; column < 4; ++column)
+				out[column] = v[0] * m.m[0][column] + v[1] * m.m[1][column] + v[2] * m.m[2][column] + v[3] * m.m[3][column];
+		}
+
+		uint32_t GetFormatSize(BackendFormat format)
+		{
+			switch (format)
+			{
+			case BackendFormat::RGBA32Float: return 16;
+			case BackendFormat::RGB32Float: return 12;
+			case BackendFormat::RG32Float: return 8;
+			case BackendFormat::RGBA16Unorm: return 8;
+			case BackendFormat::R32Float: return 4;
+			case BackendFormat::RGBA8Unorm: return 4;
+			default: return 0; // Not a vertex format this backend decodes
+			}
+		}
+
+		// Missing components read as (0, 0, 0, 1), like the input assembler
+		void Decode(const uint8_t* data, BackendFormat format, float out[4])
+		{
+			out[0] = out[1] = out[2] = 0.0f;
+			out[3] = 1.0f;
+
+			switch (format)
+			{
+			case BackendFormat::RGBA32Float: memcpy(out, data, 16); break;
+			case BackendFormat::RGB32Float: memcpy(out, data, 12); break;
+			case BackendFormat::RG32Float: memcpy(out, data, 8); break;
+			case BackendFormat::R32Float: memcpy(out, data, 4); break;
+			case BackendFormat::RGBA16Unorm:
+			{
+				uint16_t values[4];
+				memcpy(values, data, sizeof(values));
+				for (int i = 0; i < 4; ++i)
+					out[i] = values[i] / 65535.0f;
+				break;
+			}
+			case BackendFormat::RGBA8Unorm:
+				for (int i = 0; i < 4; ++i)
+					out[i] = data[i] / 255.0f;
+				break;
+			default:
+				break;
+			}
+		}
+
+		inline float Saturate(float value)
+		{
+			return (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f : value;
+		}
+
+		uint32_t PackColor(float r, float g, float b, float a)
+		{
+			return static_cast<uint32_t>(std::lrint(Saturate(r) * 255.0f)) | (static_cast<uint32_t>(std::lrint(Saturate(g) * 255.0f)) << 8) |
+				(static_cast<uint32_t>(std::lrint(Saturate(b) * 255.0f)) << 16) | (static_cast<uint32_t>(std::lrint(Saturate(a) * 255.0f)) << 24);
+		}
+
+		// Straight alpha: SRC_ALPHA, INV_SRC_ALPHA on color, the source alpha replaces the destination one (Pipeline::GetBlendDesc)
+		uint32_t BlendColor(uint32_t source, uint32_t destination)
+		{
+			float alpha = (source >> 24) / 255.0f;
+			uint32_t result = source & 0xFF000000;
+			for (int shift = 0; shift < 24; shift += 8)
+			{
+				float value = ((source >> shift) & 0xFF) * alpha + ((destination >> shift) & 0xFF) * (1.0f - alpha);
+				result |= static_cast<uint32_t>(std::lrint(value)) << shift;
+			}
+			return result;
+		}
+
+		inline int32_t FloorDiv(int32_t value, int32_t divisor)
+		{
+			return (value >= 0) ? value / divisor : -((-value + divisor - 1) / divisor);
+		}
+
+		// Narrows [first, last] to the columns where value + step * (x - x0) >= 0. Rows of wide triangles only visit the
+		// groups that hold covered pixels instead of the empty half of the bounds.
+		inline void NarrowSpan(int32_t value, int32_t step, int32_t x0, int32_t& first, int32_t& last)
+		{
+			if (step > 0)
+			{
+				if (value < 0)
+					first = std::max(first, x0 + (-value + step - 1) / step);
+			}
+			else if (step < 0)
+			{
+				last = (value < 0) ? x0 - 1 : std::min(last, x0 + value / -step);
+			}
+			else if (value < 0)
+			{
+				last = x0 - 1;
+			}
+		}
+
+#if defined(SOFTWARE_RASTER_SSE2)
+		// D24 values are below 2^24, signed compares give the unsigned result
+		inline __m128i CompareDepth(BackendCompare func, __m128i value, __m128i stored)
+		{
+			switch (func)
+			{
+			case BackendCompare::Never: return _mm_setzero_si128();
+			case BackendCompare::Less: return _mm_cmplt_epi32(value, stored);
+			case BackendCompare::Equal: return _mm_cmpeq_epi32(value, stored);
+			case BackendCompare::LessEqual: return _mm_or_si128(_mm_cmplt_epi32(value, stored), _mm_cmpeq_epi32(value, stored));
+			case BackendCompare::Greater: return _mm_cmpgt_epi32(value, stored);
+			case BackendCompare::NotEqual: return _mm_xor_si128(_mm_cmpeq_epi32(value, stored), _mm_set1_epi32(-1));
+			case BackendCompare::GreaterEqual: return _mm_or_si128(_mm_cmpgt_epi32(value, stored), _mm_cmpeq_epi32(value, stored));
+			default: return _mm_set1_epi32(-1);
+			}
+		}
+
+		inline __m128i Select(__m128i mask, __m128i a, __m128i b) // a where mask is set, b elsewhere
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		inline __m128i ToUnorm8(__m128 value)
+		{
+			return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f)));
+		}
+
+		inline int CountLanes(__m128i mask)
+		{
+			static const int bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+			return bits[_mm_movemask_ps(_mm_castsi128_ps(mask))];
+		}
+#else
+		bool CompareDepth(BackendCompare func, uint32_t value, uint32_t stored)
+		{
+			switch (func)
+			{
+			case BackendCompare::Never: return false;
+			case BackendCompare::Less: return value < stored;
+			case BackendCompare::Equal: return value == stored;
+			case BackendCompare::LessEqual: return value <= stored;
+			case BackendCompare::Greater: return value > stored;
+			case BackendCompare::NotEqual: return value != stored;
+			case BackendCompare::GreaterEqual: return value >= stored;
+			default: return true;
+			}
+		}
+#endif
+	}
+
+	// Everything DrawIndexed resolved: memory pointers into the bound buffers and the constant matrices
+	struct SoftwareBackend::DrawContext
+	{
+		struct Stream
+		{
+			const uint8_t* data = nullptr;
+			uint32_t stride = 0;
+			BackendFormat format = BackendFormat::Unknown;
+			bool perInstance = false;
+
+			const uint8_t* Fetch(int64_t vertex, uint32_t instance) const { return data + (perInstance ? instance : vertex) * stride; }
+		};
+
+		const PipelineState* pipeline = nullptr;
+		const uint8_t* indices = nullptr;
+		bool index32 = false;
+		bool strip = false;
+		int32_t baseVertex = 0;
+		uint32_t minIndex = 0; // Shaded vertices are [minIndex, minIndex + vertexCount) of every instance
+		uint32_t vertexCount = 0;
+		uint32_t triangleCount = 0; // Per instance
+		uint32_t instanceCount = 0;
+		uint32_t startInstance = 0;
+
+		Stream position;
+		Stream color;
+		Stream world[4];
+		Matrix viewProjection;
+		Matrix world0; // ObjectBuffer
+		float positionOffset[4] = {};
+		float positionScale[4] = {};
+
+		uint32_t GetIndex(uint32_t i) const
+		{
+			if (index32)
+			{
+				uint32_t value;
+				memcpy(&value, indices + i * 4, 4);
+				return value;
+			}
+
+			uint16_t value;
+			memcpy(&value, indices + i * 2, 2);
+			return value;
+		}
+	};
+
+	// Screen space triangle ready for the tiles: edges in fixed point, attributes as planes over pixel centers
+	struct SoftwareBackend::Triangle
+	{
+		int32_t minX, minY, maxX, maxY; // Pixels whose centers may be covered, inclusive, inside the clip rectangle
+		int32_t edgeX[3], edgeY[3]; // Edge start, subpixels
+		int32_t edgeDX[3], edgeDY[3];
+		int32_t edgeBias[3]; // -1 on edges that are neither top nor left: a center exactly on them belongs to the neighbour
+		float planes[6][3]; // z, 1/w, r/w, g/w, b/w, a/w: value = p[0] + p[1] * x + p[2] * y
+	};
+
+	// One setup job's triangles, binned per tile in a flat array (binStart has a tile count + 1 offsets)
+	struct SoftwareBackend::Batch
+	{
+		RasterState state;
+		BackendCull cull = BackendCull::Back;
+		std::vector<Triangle> triangles;
+		std::vector<uint32_t> binStart;
+		std::vector<uint32_t> binTriangles;
+		uint64_t culled = 0;
+		uint64_t clipped = 0;
+	};
+
+	SoftwareBackend::SoftwareBackend(Core::JobSystem* jobs)
+		: m_Jobs(jobs)
+	{
+		if (!m_Jobs)
+		{
+			m_OwnedJobs.reset(new Core::JobSystem());
+			m_OwnedJobs->Initialize();
+			m_OwnedJobs->SetProfiler(Core::Profiler::GetJobProfiler()); // Tiles and batches show up as zones while profiling
+			m_Jobs = m_OwnedJobs.get();
+		}
+	}
+
+	SoftwareBackend::~SoftwareBackend()
+	{
+		if (m_OwnedJobs)
+			m_OwnedJobs->Shutdown();
+	}
+
+	SoftwareBackend::Buffer* SoftwareBackend::FindBuffer(BackendHandle handle)
+	{
+		auto it = m_Buffers.find(handle);
+		return (it != m_Buffers.end()) ? it->second.get() : nullptr;
+	}
+
+	SoftwareBackend::Texture* SoftwareBackend::FindTexture(BackendHandle handle)
+	{
+		auto it = m_Textures.find(handle);
+		return (it != m_Textures.end()) ? it->second.get() : nullptr;
+	}
+
+	BackendHandle SoftwareBackend::CreateBuffer(const BackendBufferDesc& desc, const void* initialData)
+	{
+		if (desc.size == 0)
+			return 0;
+
+		std::unique_ptr<Buffer> buffer(new Buffer());
+		buffer->memory.resize(desc.size);
+		if (initialData)
+			memcpy(buffer->memory.data(), initialData, desc.size);
+
+		BackendHandle handle = m_NextHandle++;
+		m_Buffers.emplace(handle, std::move(buffer));
+		return handle;
+	}
+
+	BackendHandle SoftwareBackend::CreateTexture(const BackendTextureDesc& desc)
+	{
+		if (desc.width == 0 || desc.height == 0)
+			return 0;
+
+		if (desc.format != BackendFormat::RGBA8Unorm && desc.format != BackendFormat::D24UnormS8UInt)
+		{
+			std::cerr << "[SoftwareBackend] Only RGBA8 color and D24S8 depth textures are supported.\n";
+			return 0;
+		}
+
+		std::unique_ptr<Texture> texture(new Texture());
+		texture->width = desc.width;
+		texture->height = desc.height;
+		texture->pitch = (desc.width + 3) & ~3u;
+		texture->depth = desc.format == BackendFormat::D24UnormS8UInt;
+		texture->pixels.resize(static_cast<size_t>(texture->pitch) * desc.height, 0);
+
+		BackendHandle handle = m_NextHandle++;
+		m_Textures.emplace(handle, std::move(texture));
+		return handle;
+	}
+
+	BackendHandle SoftwareBackend::CreatePipeline(const BackendPipelineDesc& desc)
+	{
+		std::unique_ptr<PipelineState> pipeline(new PipelineState());
+
+		// The VertexShader.hlsl entry points, see the HLSL for what each one reads
+		const std::string vertexEntry = desc.vertexShaderEntry ? desc.vertexShaderEntry : "";
+		bool readsColor = false;
+		if (vertexEntry == "VS" || vertexEntry == "VSPacked")
+		{
+			readsColor = true;
+			pipeline->packed = vertexEntry == "VSPacked";
+		}
+		else if (vertexEntry == "VSInstanced")
+		{
+			readsColor = true;
+			pipeline->instanced = true;
+		}
+		else if (vertexEntry == "VSDepthInstanced")
+		{
+			pipeline->instanced = true;
+		}
+		else if (vertexEntry == "VSPermutation")
+		{
+			if (desc.permutation & (FeatureSkinning | FeatureFog))
+			{
+				std::cerr << "[SoftwareBackend] Skinning and fog permutations are not supported.\n";
+				return 0;
+			}
+
+			readsColor = (desc.permutation & FeatureVertexColor) != 0;
+			pipeline->instanced = (desc.permutation & FeatureInstancing) != 0;
+		}
+		else if (vertexEntry != "VSDepth")
+		{
+			std::cerr << "[SoftwareBackend] Vertex shader " << vertexEntry << " is not supported.\n";
+			return 0;
+		}
+
+		// Both pixel shaders return the interpolated color
+		if (desc.pixelShaderEntry && strcmp(desc.pixelShaderEntry, "PS") != 0 && strcmp(desc.pixelShaderEntry, "PSPermutation") != 0)
+		{
+			std::cerr << "[SoftwareBackend] Pixel shader " << desc.pixelShaderEntry << " is not supported.\n";
+			return 0;
+		}
+
+		for (const BackendVertexElement& element : desc.elements)
+		{
+			InputElement* input = nullptr;
+			if (strcmp(element.semantic, "POSITION") == 0 && element.semanticIndex == 0)
+				input = &pipeline->position;
+			else if (strcmp(element.semantic, "COLOR") == 0 && element.semanticIndex == 0)
+				input = readsColor ? &pipeline->color : nullptr;
+			else if (strcmp(element.semantic, "WORLD") == 0 && element.semanticIndex < 4)
+				input = pipeline->instanced ? &pipeline->world[element.semanticIndex] : nullptr;
+
+			if (!input)
+				continue; // Not read by the entry point
+
+			if (GetFormatSize(element.format) == 0 || element.slot >= MaxVertexSlots)
+			{
+				std::cerr << "[SoftwareBackend] Unsupported format or slot for " << element.semantic << ".\n";
+				return 0;
+			}
+
+			input->present = true;
+			input->slot = element.slot;
+			input->offset = element.offset;
+			input->format = element.format;
+			input->perInstance = element.perInstance;
+		}
+
+		bool missingWorld = false;
+		for (const InputElement& row : pipeline->world)
+			missingWorld |= pipeline->instanced && !row.present;
+
+		if (!pipeline->position.present || (readsColor && !pipeline->color.present) || missingWorld)
+		{
+			std::cerr << "[SoftwareBackend] Input layout lacks an element " << vertexEntry << " reads.\n";
+			return 0;
+		}
+
+		pipeline->cull = desc.cullMode;
+		pipeline->raster.depthTest = desc.depthEnabled;
+		pipeline->raster.depthWrite = desc.depthEnabled && desc.depthWrite;
+		pipeline->raster.depthFunc = desc.depthFunc;
+		pipeline->raster.colorWrite = desc.colorWrite && desc.pixelShaderEntry;
+		pipeline->raster.blend = desc.blendEnabled;
+
+		BackendHandle handle = m_NextHandle++;
+		m_Pipelines.emplace(handle, std::move(pipeline));
+		return handle;
+	}
+
+	void SoftwareBackend::Destroy(BackendHandle handle)
+	{
+		if (m_Buffers.erase(handle))
+			return; // Draws copied what they read at DrawIndexed
+
+		auto pipeline = m_Pipelines.find(handle);
+		if (pipeline != m_Pipelines.end())
+		{
+			if (m_Pipeline == pipeline->second.get())
+				m_Pipeline = nullptr;
+
+			m_Pipelines.erase(pipeline);
+			return;
+		}
+
+		auto texture = m_Textures.find(handle);
+		if (texture == m_Textures.end())
+		{
+			std::cerr << "[SoftwareBackend] Destroy of an unknown handle.\n";
+			return;
+		}
+
+		if (handle == m_ColorHandle || handle == m_DepthHandle)
+		{
+			Flush();
+			SetRenderTargets(handle == m_ColorHandle ? 0 : m_ColorHandle, handle == m_DepthHandle ? 0 : m_DepthHandle);
+		}
+
+		if (handle == m_LastPresented)
+			m_LastPresented = 0;
+
+		m_Textures.erase(texture);
+	}
+
+	void* SoftwareBackend::Map(BackendHandle buffer, BackendMap mode)
+	{
+		// Discard can hand back the same memory: vertices were already shaded for every earlier draw
+		Buffer* resource = FindBuffer(buffer);
+		return resource ? resource->memory.data() : nullptr;
+	}
+
+	void SoftwareBackend::Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize)
+	{
+	}
+
+	void SoftwareBackend::UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size)
+	{
+		Buffer* resource = FindBuffer(buffer);
+		if (!resource || !data || static_cast<uint64_t>(offset) + size > resource->memory.size())
+			return;
+
+		memcpy(resource->memory.data() + offset, data, size);
+	}
+
+	void SoftwareBackend::CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size)
+	{
+		Buffer* target = FindBuffer(destination);
+		Buffer* origin = FindBuffer(source);
+		if (!target || !origin || static_cast<uint64_t>(destinationOffset) + size > target->memory.size() || static_cast<uint64_t>(sourceOffset) + size > origin->memory.size())
+			return;
+
+		memmove(target->memory.data() + destinationOffset, origin->memory.data() + sourceOffset, size); // GeometryArena compacts within one buffer
+	}
+
+	void SoftwareBackend::SetPipeline(BackendHandle pipeline)
+	{
+		auto it = m_Pipelines.find(pipeline);
+		m_Pipeline = (it != m_Pipelines.end()) ? it->second.get() : nullptr;
+	}
+
+	void SoftwareBackend::SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset)
+	{
+		if (slot >= MaxVertexSlots)
+			return;
+
+		m_VertexBuffers[slot].buffer = buffer;
+		m_VertexBuffers[slot].stride = stride;
+		m_VertexBuffers[slot].offset = offset;
+	}
+
+	void SoftwareBackend::SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset)
+	{
+		m_IndexBuffer = buffer;
+		m_IndexFormat = format;
+		m_IndexOffset = offset;
+	}
+
+	void SoftwareBackend::SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants)
+	{
+		if (slot >= MaxConstantSlots)
+			return;
+
+		m_ConstantBuffers[slot].buffer = buffer;
+		m_ConstantBuffers[slot].firstConstant = firstConstant;
+	}
+
+	void SoftwareBackend::SetRenderTargets(BackendHandle color, BackendHandle depth)
+	{
+		if (color == m_ColorHandle && depth == m_DepthHandle)
+			return;
+
+		Flush();
+		m_ColorHandle = color;
+		m_DepthHandle = depth;
+		m_ColorTarget = FindTexture(color);
+		m_DepthTarget = FindTexture(depth);
+
+		if (m_ColorTarget && m_ColorTarget->depth)
+			m_ColorTarget = nullptr;
+
+		if (m_DepthTarget && !m_DepthTarget->depth)
+			m_DepthTarget = nullptr;
+
+		UpdateTileGrid();
+	}
+
+	void SoftwareBackend::SetViewport(float width, float height)
+	{
+		if (width == m_ViewportWidth && height == m_ViewportHeight)
+			return;
+
+		Flush(); // Binned triangles were snapped to the old viewport
+		m_ViewportWidth = width;
+		m_ViewportHeight = height;
+		UpdateTileGrid();
+	}
+
+	void SoftwareBackend::SetTopology(BackendTopology topology)
+	{
+		m_Topology = topology;
+	}
+
+	void SoftwareBackend::UpdateTileGrid()
+	{
+		uint32_t width = static_cast<uint32_t>(m_ViewportWidth);
+		uint32_t height = static_cast<uint32_t>(m_ViewportHeight);
+		for (const Texture* target : { m_ColorTarget, m_DepthTarget })
+		{
+			if (target)
+			{
+				width = std::min(width, target->width);
+				height = std::min(height, target->height);
+			}
+		}
+
+		if (!m_ColorTarget && !m_DepthTarget)
+			width = height = 0;
+
+		m_ClipWidth = width;
+		m_ClipHeight = height;
+		m_TilesX = (width + TileSize - 1) / TileSize;
+		m_TilesY = (height + TileSize - 1) / TileSize;
+
+		// |x/w| <= guard band keeps the viewport transform inside GuardBandPixels
+		float extent = std::max(std::max(m_ViewportWidth, m_ViewportHeight), 1.0f);
+		m_GuardBand = std::max(2.0f * GuardBandPixels / extent - 1.0f, 1.0f);
+	}
+
+	void SoftwareBackend::ClearColor(BackendHandle color, const float rgba[4])
+	{
+		Texture* texture = FindTexture(color);
+		if (!texture || texture->depth)
+			return;
+
+		Flush();
+		Clock::time_point start = Clock::now();
+		std::fill(texture->pixels.begin(), texture->pixels.end(), PackColor(rgba[0], rgba[1], rgba[2], rgba[3]));
+		m_Stats.clears++;
+		m_Stats.rasterMilliseconds += ElapsedMilliseconds(start);
+	}
+
+	void SoftwareBackend::ClearDepth(BackendHandle depth, float value)
+	{
+		Texture* texture = FindTexture(depth);
+		if (!texture || !texture->depth)
+			return;
+
+		Flush();
+		Clock::time_point start = Clock::now();
+		std::fill(texture->pixels.begin(), texture->pixels.end(), static_cast<uint32_t>(std::lrint(Saturate(value) * DepthScale))); // Stencil cleared to 0
+		m_Stats.clears++;
+		m_Stats.rasterMilliseconds += ElapsedMilliseconds(start);
+	}
+
+	bool SoftwareBackend::PrepareDraw(DrawContext& draw, uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+	{
+		const PipelineState* pipeline = m_Pipeline;
+		if (!pipeline || (m_Topology != BackendTopology::TriangleList && m_Topology != BackendTopology::TriangleStrip) || m_TilesX == 0 || m_TilesY == 0)
+			return false;
+
+		draw.pipeline = pipeline;
+		draw.strip = m_Topology == BackendTopology::TriangleStrip;
+		draw.triangleCount = draw.strip ? indexCount - 2 : indexCount / 3;
+		draw.instanceCount = instanceCount;
+		draw.startInstance = startInstance;
+		draw.baseVertex = baseVertex;
+
+		// Indices
+		const Buffer* indexBuffer = FindBuffer(m_IndexBuffer);
+		draw.index32 = m_IndexFormat == BackendFormat::R32UInt;
+		const uint64_t indexSize = draw.index32 ? 4 : 2;
+		if (!indexBuffer || m_IndexOffset + (static_cast<uint64_t>(startIndex) + indexCount) * indexSize > indexBuffer->memory.size())
+			return false;
+
+		draw.indices = indexBuffer->memory.data() + m_IndexOffset + startIndex * indexSize;
+
+		uint32_t minIndex = UINT32_MAX;
+		uint32_t maxIndex = 0;
+		for (uint32_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t index = draw.GetIndex(i);
+			minIndex = std::min(minIndex, index);
+			maxIndex = std::max(maxIndex, index);
+		}
+
+		if (static_cast<int64_t>(minIndex) + baseVertex < 0)
+			return false;
+
+		draw.minIndex = minIndex;
+		draw.vertexCount = maxIndex - minIndex + 1;
+
+		// Streams, with the last vertex and instance they will fetch checked against the buffer
+		auto resolve = [&](const InputElement& element, DrawContext::Stream& stream) -> bool
+		{
+			if (!element.present)
+				return true;
+
+			const VertexBinding& binding = m_VertexBuffers[element.slot];
+			const Buffer* buffer = FindBuffer(binding.buffer);
+			if (!buffer)
+				return false;
+
+			int64_t last = element.perInstance ? static_cast<int64_t>(startInstance) + instanceCount - 1 : static_cast<int64_t>(maxIndex) + baseVertex;
+			uint64_t end = binding.offset + element.offset + static_cast<uint64_t>(last) * binding.stride + GetFormatSize(element.format);
+			if (end > buffer->memory.size())
+				return false;
+
+			stream.data = buffer->memory.data() + binding.offset + element.offset;
+			stream.stride = binding.stride;
+			stream.format = element.format;
+			stream.perInstance = element.perInstance;
+			return true;
+		};
+
+		bool streams = resolve(pipeline->position, draw.position) && resolve(pipeline->color, draw.color);
+		for (uint32_t row = 0; row < 4; ++row)
+			streams = streams && resolve(pipeline->world[row], draw.world[row]);
+
+		if (!streams)
+			return false;
+
+		// Constants: MatrrixBuffer (b0) View and Projection, ObjectBuffer (b1) World, PackingBuffer (b2) offset and scale
+		auto constants = [&](uint32_t slot, uint32_t size) -> const float*
+		{
+			const ConstantBinding& binding = m_ConstantBuffers[slot];
+			const Buffer* buffer = FindBuffer(binding.buffer);
+			uint64_t offset = static_cast<uint64_t>(binding.firstConstant) * 16;
+			if (!buffer || offset + size > buffer->memory.size())
+				return nullptr;
+
+			return reinterpret_cast<const float*>(buffer->memory.data() + offset);
+		};
+
+		const float* camera = constants(0, 128);
+		if (!camera)
+			return false;
+
+		draw.viewProjection = Multiply(LoadTransposed(camera), LoadTransposed(camera + 16));
+
+		if (!pipeline->instanced)
+		{
+			const float* object = constants(1, 64);
+			if (!object)
+				return false;
+
+			draw.world0 = LoadTransposed(object);
+		}
+
+		if (pipeline->packed)
+		{
+			const float* packing = constants(2, 32);
+			if (!packing)
+				return false;
+
+			memcpy(draw.positionOffset, packing, 16);
+			memcpy(draw.positionScale, packing + 4, 16);
+		}
+
+		return true;
+	}
+
+	void SoftwareBackend::ShadeVertices(const DrawContext& draw, uint32_t begin, uint32_t end)
+	{
+		const PipelineState& pipeline = *draw.pipeline;
+		uint32_t instance = draw.startInstance + begin / draw.vertexCount;
+		uint32_t local = begin % draw.vertexCount;
+		Matrix worldViewProjection = {};
+
+		for (uint32_t i = begin; i < end; ++i, ++local)
+		{
+			if (local == draw.vertexCount)
+			{
+				local = 0;
+				instance++;
+			}
+
+			int64_t vertex = static_cast<int64_t>(draw.minIndex + local) + draw.baseVertex;
+			if (local == 0 || i == begin)
+			{
+				Matrix world = draw.world0;
+				if (pipeline.instanced)
+				{
+					float rows[16];
+					for (uint32_t row = 0; row < 4; ++row)
+						Decode(draw.world[row].Fetch(vertex, instance), draw.world[row].format, rows + row * 4);
+
+					world = LoadTransposed(rows);
+				}
+
+				worldViewProjection = Multiply(world, draw.viewProjection);
+			}
+
+			ClipVertex& output = m_Vertices[i];
+
+			float position[4];
+			Decode(draw.position.Fetch(vertex, instance), draw.position.format, position);
+			if (pipeline.packed)
+			{
+				for (int c = 0; c < 3; ++c)
+					position[c] = draw.positionOffset[c] + position[c] * draw.positionScale[c];
+			}
+
+			position[3] = 1.0f;
+			Transform(position, worldViewProjection, output.position);
+
+			if (pipeline.color.present)
+				Decode(draw.color.Fetch(vertex, instance), draw.color.format, output.color);
+			else
+				output.color[0] = output.color[1] = output.color[2] = output.color[3] = 1.0f;
+		}
+	}
+
+	void SoftwareBackend::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+	{
+		m_Stats.draws++;
+		m_Stats.instances += instanceCount;
+
+		DrawContext draw;
+		if (indexCount < 3 || instanceCount == 0 || !PrepareDraw(draw, indexCount, instanceCount, startIndex, baseVertex, startInstance))
+		{
+			m_Stats.drawsSkipped++;
+			return;
+		}
+
+		Clock::time_point start = Clock::now();
+
+		// Vertices of every instance first, then the triangles in jobs of TrianglesPerBatch that each bin into their own batch
+		uint32_t vertices = draw.vertexCount * instanceCount;
+		if (m_Vertices.size() < vertices)
+			m_Vertices.resize(vertices);
+
+		m_Jobs->ParallelFor(vertices, VerticesPerJob, [this, &draw](uint32_t begin, uint32_t end) { ShadeVertices(draw, begin, end); }, "SoftwareVertices");
+
+		uint32_t triangles = draw.triangleCount * instanceCount;
+		uint32_t batches = (triangles + TrianglesPerBatch - 1) / TrianglesPerBatch;
+		while (m_Batches.size() < m_BatchCount + batches)
+			m_Batches.emplace_back(new Batch());
+
+		uint32_t firstBatch = m_BatchCount;
+		m_Jobs->ParallelFor(batches, 1, [this, &draw, firstBatch, triangles](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				Batch& batch = *m_Batches[firstBatch + i];
+				uint32_t first = i * TrianglesPerBatch;
+				SetupTriangles(draw, batch, first, std::min(first + TrianglesPerBatch, triangles));
+				BinTriangles(batch);
+			}
+		}, "SoftwareSetup");
+
+		m_BatchCount += batches;
+
+		m_Stats.verticesShaded += vertices;
+		m_Stats.trianglesSubmitted += triangles;
+		for (uint32_t i = firstBatch; i < m_BatchCount; ++i)
+		{
+			const Batch& batch = *m_Batches[i];
+			m_Stats.trianglesCulled += batch.culled;
+			m_Stats.trianglesClipped += batch.clipped;
+			m_Stats.trianglesBinned += batch.triangles.size();
+			m_Stats.binEntries += batch.binTriangles.size();
+		}
+
+		m_Stats.geometryMilliseconds += ElapsedMilliseconds(start);
+	}
+
+	void SoftwareBackend::SetupTriangles(const DrawContext& draw, Batch& batch, uint32_t begin, uint32_t end) const
+	{
+		batch.state = draw.pipeline->raster;
+		batch.cull = draw.pipeline->cull;
+		batch.triangles.clear();
+		batch.culled = 0;
+		batch.clipped = 0;
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			uint32_t instance = i / draw.triangleCount;
+			uint32_t triangle = i % draw.triangleCount;
+
+			uint32_t corners[3];
+			if (draw.strip)
+			{
+				// Odd strip triangles swap their first two vertices to keep the winding
+				corners[0] = draw.GetIndex(triangle + (triangle & 1));
+				corners[1] = draw.GetIndex(triangle + 1 - (triangle & 1));
+				corners[2] = draw.GetIndex(triangle + 2);
+			}
+			else
+			{
+				corners[0] = draw.GetIndex(triangle * 3);
+				corners[1] = draw.GetIndex(triangle * 3 + 1);
+				corners[2] = draw.GetIndex(triangle * 3 + 2);
+			}
+
+			const ClipVertex* vertices[3];
+			for (int c = 0; c < 3; ++c)
+				vertices[c] = &m_Vertices[instance * draw.vertexCount + corners[c] - draw.minIndex];
+
+			ClipAndSetup(vertices, batch);
+		}
+	}
+
+	void SoftwareBackend::ClipAndSetup(const ClipVertex* vertices[3], Batch& batch) const
+	{
+		// Near (z >= 0), far (z <= w) and the guard band on x and y, as distances that are negative outside
+		const float band = m_GuardBand;
+		auto distance = [band](const ClipVertex& v, int plane) -> float
+		{
+			const float* p = v.position;
+			switch (plane)
+			{
+			case 0: return p[2];
+			case 1: return p[3] - p[2];
+			case 2: return band * p[3] - p[0];
+			case 3: return band * p[3] + p[0];
+			case 4: return band * p[3] - p[1];
+			default: return band * p[3] + p[1];
+			}
+		};
+
+		bool inside = true;
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			int outside = 0;
+			for (int c = 0; c < 3; ++c)
+				outside += distance(*vertices[c], plane) < 0.0f;
+
+			if (outside == 3)
+			{
+				batch.culled++;
+				return;
+			}
+
+			inside &= outside == 0;
+		}
+
+		if (inside)
+		{
+			SetupTriangle(*vertices[0], *vertices[1], *vertices[2], batch);
+			return;
+		}
+
+		// Sutherland-Hodgman against the planes the triangle crosses, then a fan over the polygon
+		ClipVertex polygon[2][9];
+		int count = 3;
+		for (int c = 0; c < 3; ++c)
+			polygon[0][c] = *vertices[c];
+
+		int current = 0;
+		for (int plane = 0; plane < 6 && count >= 3; ++plane)
+		{
+			const ClipVertex* input = polygon[current];
+			ClipVertex* output = polygon[current ^ 1];
+			int outputCount = 0;
+
+			for (int i = 0; i < count; ++i)
+			{
+				const ClipVertex& a = input[i];
+				const ClipVertex& b = input[(i + 1) % count];
+				float da = distance(a, plane);
+				float db = distance(b, plane);
+
+				if (da >= 0.0f)
+					output[outputCount++] = a;
+
+				if ((da >= 0.0f) != (db >= 0.0f))
+				{
+					float t = da / (da - db);
+					ClipVertex& v = output[outputCount++];
+					for (int k = 0; k < 4; ++k)
+					{
+						v.position[k] = a.position[k] + (b.position[k] - a.position[k]) * t;
+						v.color[k] = a.color[k] + (b.color[k] - a.color[k]) * t;
+					}
+				}
+			}
+
+			count = outputCount;
+			current ^= 1;
+		}
+
+		batch.clipped++;
+		for (int i = 1; i + 1 < count; ++i)
+			SetupTriangle(polygon[current][0], polygon[current][i], polygon[current][i + 1], batch);
+	}
+
+	void SoftwareBackend::SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, Batch& batch) const
+	{
+		const ClipVertex* corners[3] = { &v0, &v1, &v2 };
+		int32_t x[3], y[3];
+		float attributes[3][6]; // z, 1/w, color/w
+
+		for (int c = 0; c < 3; ++c)
+		{
+			const float* p = corners[c]->position;
+			float invW = 1.0f / p[3];
+			float sx = (p[0] * invW * 0.5f + 0.5f) * m_ViewportWidth;
+			float sy = (0.5f - p[1] * invW * 0.5f) * m_ViewportHeight;
+			x[c] = static_cast<int32_t>(std::lrint(sx * SubpixelScale));
+			y[c] = static_cast<int32_t>(std::lrint(sy * SubpixelScale));
+
+			attributes[c][0] = p[2] * invW;
+			attributes[c][1] = invW;
+			for (int k = 0; k < 4; ++k)
+				attributes[c][2 + k] = corners[c]->color[k] * invW;
+		}
+
+		// Positive area is clockwise on screen, the front face (FrontCounterClockwise is FALSE)
+		int64_t area = static_cast<int64_t>(x[1] - x[0]) * (y[2] - y[0]) - static_cast<int64_t>(x[2] - x[0]) * (y[1] - y[0]);
+		if (area == 0 || (batch.cull == BackendCull::Back && area < 0) || (batch.cull == BackendCull::Front && area > 0))
+		{
+			batch.culled++;
+			return;
+		}
+
+		int order[3] = { 0, 1, 2 };
+		if (area < 0)
+		{
+			std::swap(order[1], order[2]);
+			area = -area;
+		}
+
+		Triangle triangle;
+
+		// Pixels whose centers (x * 16 + 8) fall inside the snapped bounds
+		int32_t minX = std::min(std::min(x[0], x[1]), x[2]);
+		int32_t maxX = std::max(std::max(x[0], x[1]), x[2]);
+		int32_t minY = std::min(std::min(y[0], y[1]), y[2]);
+		int32_t maxY = std::max(std::max(y[0], y[1]), y[2]);
+		triangle.minX = std::max(FloorDiv(minX - HalfPixel + SubpixelScale - 1, SubpixelScale), 0);
+		triangle.minY = std::max(FloorDiv(minY - HalfPixel + SubpixelScale - 1, SubpixelScale), 0);
+		triangle.maxX = std::min(FloorDiv(maxX - HalfPixel, SubpixelScale), static_cast<int32_t>(m_ClipWidth) - 1);
+		triangle.maxY = std::min(FloorDiv(maxY - HalfPixel, SubpixelScale), static_cast<int32_t>(m_ClipHeight) - 1);
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+		{
+			batch.culled++;
+			return;
+		}
+
+		// Top-left rule: with clockwise winding in y-down space, top edges run right and left edges run up
+		for (int e = 0; e < 3; ++e)
+		{
+			int a = order[e];
+			int b = order[(e + 1) % 3];
+			int32_t dx = x[b] - x[a];
+			int32_t dy = y[b] - y[a];
+			triangle.edgeX[e] = x[a];
+			triangle.edgeY[e] = y[a];
+			triangle.edgeDX[e] = dx;
+			triangle.edgeDY[e] = dy;
+			triangle.edgeBias[e] = ((dy == 0 && dx > 0) || dy < 0) ? 0 : -1;
+		}
+
+		// Attribute planes over pixel coordinates, from the snapped positions
+		const float scale = 1.0f / SubpixelScale;
+		float x0 = x[0] * scale, y0 = y[0] * scale;
+		float x1 = x[1] * scale - x0, y1 = y[1] * scale - y0;
+		float x2 = x[2] * scale - x0, y2 = y[2] * scale - y0;
+		float invDet = 1.0f / (x1 * y2 - x2 * y1);
+		for (int k = 0; k < 6; ++k)
+		{
+			float a1 = attributes[1][k] - attributes[0][k];
+			float a2 = attributes[2][k] - attributes[0][k];
+			float dx = (a1 * y2 - a2 * y1) * invDet;
+			float dy = (a2 * x1 - a1 * x2) * invDet;
+			triangle.planes[k][0] = attributes[0][k] - dx * x0 - dy * y0;
+			triangle.planes[k][1] = dx;
+			triangle.planes[k][2] = dy;
+		}
+
+		batch.triangles.push_back(triangle);
+	}
+
+	void SoftwareBackend::BinTriangles(Batch& batch) const
+	{
+		// Count per tile, prefix sum, fill: the bins keep submission order. The fill advances every start to the
+		// next tile's, one shift puts them back.
+		const uint32_t tiles = m_TilesX * m_TilesY;
+		std::vector<uint32_t>& start = batch.binStart;
+		start.assign(tiles + 1, 0);
+
+		for (const Triangle& triangle : batch.triangles)
+		{
+			for (uint32_t ty = triangle.minY / TileSize; ty <= triangle.maxY / TileSize; ++ty)
+				for (uint32_t tx = triangle.minX / TileSize; tx <= triangle.maxX / TileSize; ++tx)
+					start[ty * m_TilesX + tx]++;
+		}
+
+		uint32_t total = 0;
+		for (uint32_t tile = 0; tile <= tiles; ++tile)
+		{
+			uint32_t count = start[tile];
+			start[tile] = total;
+			total += count;
+		}
+
+		batch.binTriangles.resize(total);
+		for (uint32_t i = 0; i < batch.triangles.size(); ++i)
+		{
+			const Triangle& triangle = batch.triangles[i];
+			for (uint32_t ty = triangle.minY / TileSize; ty <= triangle.maxY / TileSize; ++ty)
+				for (uint32_t tx = triangle.minX / TileSize; tx <= triangle.maxX / TileSize; ++tx)
+					batch.binTriangles[start[ty * m_TilesX + tx]++] = i;
+		}
+
+		for (uint32_t tile = tiles - 1; tile > 0; --tile)
+			start[tile] = start[tile - 1];
+
+		start[0] = 0;
+	}
+
+	void SoftwareBackend::Flush()
+	{
+		if (m_BatchCount == 0)
+			return;
+
+		Clock::time_point start = Clock::now();
+		m_PixelsWritten = 0;
+		m_Jobs->ParallelFor(m_TilesX * m_TilesY, 1, [this](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t tile = begin; tile < end; ++tile)
+				RasterizeTile(tile);
+		}, "SoftwareRaster");
+
+		m_BatchCount = 0;
+		m_Stats.pixelsWritten += m_PixelsWritten;
+		m_Stats.rasterMilliseconds += ElapsedMilliseconds(start);
+	}
+
+	void SoftwareBackend::RasterizeTile(uint32_t tile)
+	{
+		int32_t left = static_cast<int32_t>((tile % m_TilesX) * TileSize);
+		int32_t top = static_cast<int32_t>((tile / m_TilesX) * TileSize);
+		int32_t right = std::min(left + static_cast<int32_t>(TileSize), static_cast<int32_t>(m_ClipWidth));
+		int32_t bottom = std::min(top + static_cast<int32_t>(TileSize), static_cast<int32_t>(m_ClipHeight));
+
+		uint64_t pixels = 0;
+		for (uint32_t b = 0; b < m_BatchCount; ++b)
+		{
+			const Batch& batch = *m_Batches[b];
+			for (uint32_t i = batch.binStart[tile]; i < batch.binStart[tile + 1]; ++i)
+				pixels += RasterizeTriangle(batch.triangles[batch.binTriangles[i]], batch.state, left, top, right, bottom, m_ColorTarget, m_DepthTarget);
+		}
+
+		m_PixelsWritten += pixels;
+	}
+
+	uint32_t SoftwareBackend::RasterizeTriangle(const Triangle& triangle, const RasterState& state, int32_t left, int32_t top, int32_t right, int32_t bottom, Texture* color, Texture* depth)
+	{
+		const int32_t x0 = std::max(triangle.minX, left);
+		const int32_t y0 = std::max(triangle.minY, top);
+		const int32_t x1 = std::min(triangle.maxX, right - 1);
+		const int32_t y1 = std::min(triangle.maxY, bottom - 1);
+		if (x0 > x1 || y0 > y1)
+			return 0;
+
+		// Edge values at the rectangle corners in 64 bits: an edge that has them all outside rejects the triangle, one that has
+		// them all inside needs no test. A crossing edge varies by less than 2^29 over a tile, the per-pixel values fit in int32.
+		int32_t edge[3], stepX[3], stepY[3];
+		for (int e = 0; e < 3; ++e)
+		{
+			int64_t px = static_cast<int64_t>(x0) * SubpixelScale + HalfPixel - triangle.edgeX[e];
+			int64_t py = static_cast<int64_t>(y0) * SubpixelScale + HalfPixel - triangle.edgeY[e];
+			int64_t value = triangle.edgeDX[e] * py - triangle.edgeDY[e] * px + triangle.edgeBias[e];
+			int64_t dx = -static_cast<int64_t>(triangle.edgeDY[e]) * SubpixelScale;
+			int64_t dy = static_cast<int64_t>(triangle.edgeDX[e]) * SubpixelScale;
+
+			int64_t corners[4] = { value, value + dx * (x1 - x0), value + dy * (y1 - y0), value + dx * (x1 - x0) + dy * (y1 - y0) };
+			int64_t low = std::min(std::min(corners[0], corners[1]), std::min(corners[2], corners[3]));
+			int64_t high = std::max(std::max(corners[0], corners[1]), std::max(corners[2], corners[3]));
+			if (high < 0)
+				return 0;
+
+			bool covered = low >= 0;
+			edge[e] = covered ? 0 : static_cast<int32_t>(value);
+			stepX[e] = covered ? 0 : static_cast<int32_t>(dx);
+			stepY[e] = covered ? 0 : static_cast<int32_t>(dy);
+		}
+
+		const bool testDepth = depth && state.depthTest;
+		const bool writeDepth = testDepth && state.depthWrite;
+		const bool writeColor = color && state.colorWrite;
+		const float* zPlane = triangle.planes[0];
+		const float* wPlane = triangle.planes[1];
+		const bool narrow = x1 - x0 >= 16; // Three divisions a row cost more than the few groups they skip on small triangles
+		uint32_t pixels = 0;
+
+#if defined(SOFTWARE_RASTER_SSE2)
+		// Groups of four pixels aligned to four: tiles start on a multiple of 64 and rows are padded, a group never leaves the tile
+		const __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+		const __m128 laneCenters = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128i firstX = _mm_set1_epi32(x0);
+		const __m128i lastX = _mm_set1_epi32(x1 + 1);
+		const __m128i minusOne = _mm_set1_epi32(-1);
+		const __m128i depthMask = _mm_set1_epi32(DepthMask);
+
+		__m128i laneSteps[3], groupSteps[3];
+		for (int e = 0; e < 3; ++e)
+		{
+			laneSteps[e] = _mm_set_epi32(3 * stepX[e], 2 * stepX[e], stepX[e], 0);
+			groupSteps[e] = _mm_set1_epi32(4 * stepX[e]);
+		}
+
+		for (int32_t y = y0; y <= y1; ++y)
+		{
+			const int32_t row = y - y0;
+			int32_t first = x0;
+			int32_t last = x1;
+			for (int e = 0; e < 3 && narrow; ++e)
+				NarrowSpan(edge[e] + stepY[e] * row, stepX[e], x0, first, last);
+
+			if (first > last)
+				continue;
+
+			const int32_t startX = first & ~3;
+			__m128i values[3];
+			for (int e = 0; e < 3; ++e)
+				values[e] = _mm_add_epi32(_mm_set1_epi32(edge[e] + stepY[e] * row + stepX[e] * (startX - x0)), laneSteps[e]);
+
+			const float centerY = y + 0.5f;
+			uint32_t* colorRow = color ? color->pixels.data() + static_cast<size_t>(y) * color->pitch : nullptr;
+			uint32_t* depthRow = depth ? depth->pixels.data() + static_cast<size_t>(y) * depth->pitch : nullptr;
+
+			for (int32_t x = startX; x <= last; x += 4)
+			{
+				__m128i xs = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+				__m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(values[0], values[1]), values[2]), minusOne);
+				__m128i bounds = _mm_andnot_si128(_mm_cmplt_epi32(xs, firstX), _mm_cmplt_epi32(xs, lastX));
+				__m128i mask = _mm_and_si128(inside, bounds);
+
+				for (int e = 0; e < 3; ++e)
+					values[e] = _mm_add_epi32(values[e], groupSteps[e]);
+
+				if (_mm_movemask_epi8(mask) == 0)
+					continue;
+
+				const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneCenters);
+				auto plane = [&](const float* p) { return _mm_add_ps(_mm_set1_ps(p[0] + p[2] * centerY), _mm_mul_ps(_mm_set1_ps(p[1]), centerX)); };
+
+				if (testDepth)
+				{
+					__m128 z = _mm_min_ps(_mm_max_ps(plane(zPlane), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+					__m128i value = _mm_cvtps_epi32(_mm_mul_ps(z, _mm_set1_ps(DepthScale)));
+					__m128i stored = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depthRow + x));
+					mask = _mm_and_si128(mask, CompareDepth(state.depthFunc, value, _mm_and_si128(stored, depthMask)));
+					if (_mm_movemask_epi8(mask) == 0)
+						continue;
+
+					if (writeDepth)
+					{
+						__m128i written = _mm_or_si128(_mm_andnot_si128(depthMask, stored), value);
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(depthRow + x), Select(mask, written, stored));
+					}
+				}
+
+				if (writeColor)
+				{
+					// Perspective correct: color/w and 1/w are linear on screen
+					__m128 w = _mm_div_ps(_mm_set1_ps(1.0f), plane(wPlane));
+					__m128i r = ToUnorm8(_mm_mul_ps(plane(triangle.planes[2]), w));
+					__m128i g = ToUnorm8(_mm_mul_ps(plane(triangle.planes[3]), w));
+					__m128i b = ToUnorm8(_mm_mul_ps(plane(triangle.planes[4]), w));
+					__m128i a = ToUnorm8(_mm_mul_ps(plane(triangle.planes[5]), w));
+					__m128i packed = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+
+					__m128i stored = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colorRow + x));
+					if (state.blend)
+					{
+						alignas(16) uint32_t source[4], destination[4];
+						_mm_store_si128(reinterpret_cast<__m128i*>(source), packed);
+						_mm_store_si128(reinterpret_cast<__m128i*>(destination), stored);
+						for (int i = 0; i < 4; ++i)
+							source[i] = BlendColor(source[i], destination[i]);
+
+						packed = _mm_load_si128(reinterpret_cast<const __m128i*>(source));
+					}
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(colorRow + x), Select(mask, packed, stored));
+				}
+
+				pixels += CountLanes(mask);
+			}
+		}
+#else
+		for (int32_t y = y0; y <= y1; ++y)
+		{
+			const int32_t row = y - y0;
+			int32_t first = x0;
+			int32_t last = x1;
+			for (int e = 0; e < 3 && narrow; ++e)
+				NarrowSpan(edge[e] + stepY[e] * row, stepX[e], x0, first, last);
+
+			const float centerY = y + 0.5f;
+			uint32_t* colorRow = color ? color->pixels.data() + static_cast<size_t>(y) * color->pitch : nullptr;
+			uint32_t* depthRow = depth ? depth->pixels.data() + static_cast<size_t>(y) * depth->pitch : nullptr;
+
+			for (int32_t x = first; x <= last; ++x)
+			{
+				const int32_t column = x - x0;
+				if ((edge[0] + stepY[0] * row + stepX[0] * column) < 0 || (edge[1] + stepY[1] * row + stepX[1] * column) < 0 ||
+					(edge[2] + stepY[2] * row + stepX[2] * column) < 0)
+					continue;
+
+				const float centerX = x + 0.5f;
+				auto plane = [&](const float* p) { return (p[0] + p[2] * centerY) + p[1] * centerX; }; // Same order as the SIMD path, same bits
+
+				if (testDepth)
+				{
+					uint32_t value = static_cast<uint32_t>(std::lrint(Saturate(plane(zPlane)) * DepthScale));
+					if (!CompareDepth(state.depthFunc, value, depthRow[x] & DepthMask))
+						continue;
+
+					if (writeDepth)
+						depthRow[x] = (depthRow[x] & ~DepthMask) | value;
+				}
+
+				if (writeColor)
+				{
+					float w = 1.0f / plane(wPlane);
+					uint32_t packed = PackColor(plane(triangle.planes[2]) * w, plane(triangle.planes[3]) * w, plane(triangle.planes[4]) * w, plane(triangle.planes[5]) * w);
+					colorRow[x] = state.blend ? BlendColor(packed, colorRow[x]) : packed;
+				}
+
+				pixels++;
+			}
+		}
+#endif
+
+		return pixels;
+	}
+
+	void SoftwareBackend::Present(BackendHandle color)
+	{
+		Flush();
+		m_Stats.frames++;
+		m_LastPresented = color;
+
+		if (!m_FrameOutput.empty())
+		{
+			char number[16];
+			snprintf(number, sizeof(number), "%05llu", static_cast<unsigned long long>(m_Stats.frames - 1));
+			SaveImage(color, m_FrameOutput + number + ".bmp");
+		}
+	}
+
+	bool SoftwareBackend::ReadPixels(BackendHandle texture, std::vector<uint32_t>& pixels, uint32_t& width, uint32_t& height)
+	{
+		const Texture* resource = FindTexture(texture);
+		if (!resource)
+			return false;
+
+		Flush();
+		width = resource->width;
+		height = resource->height;
+		pixels.resize(static_cast<size_t>(width) * height);
+		for (uint32_t y = 0; y < height; ++y)
+			memcpy(pixels.data() + static_cast<size_t>(y) * width, resource->pixels.data() + static_cast<size_t>(y) * resource->pitch, width * sizeof(uint32_t));
+
+		return true;
+	}
+
+	bool SoftwareBackend::SaveImage(BackendHandle texture, const std::string& path)
+	{
+		std::vector<uint32_t> pixels;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		const Texture* resource = FindTexture(texture);
+		if (!resource || resource->depth || !ReadPixels(texture, pixels, width, height))
+		{
+			std::cerr << "[SoftwareBackend] SaveImage needs a color target.\n";
+			return false;
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "[SoftwareBackend] Failed to open " << path << ".\n";
+			return false;
+		}
+
+		// BITMAPFILEHEADER and BITMAPINFOHEADER, little endian, rows bottom-up in BGR padded to four bytes
+		const uint32_t rowSize = (width * 3 + 3) & ~3u;
+		const uint32_t imageSize = rowSize * height;
+		uint8_t header[54] = { 'B', 'M' };
+		auto put = [&header](uint32_t offset, uint32_t value, uint32_t bytes)
+		{
+			for (uint32_t i = 0; i < bytes; ++i)
+				header[offset + i] = static_cast<uint8_t>(value >> (i * 8));
+		};
+
+		put(2, 54 + imageSize, 4);
+		put(10, 54, 4);
+		put(14, 40, 4);
+		put(18, width, 4);
+		put(22, height, 4);
+		put(26, 1, 2);
+		put(28, 24, 2);
+		put(34, imageSize, 4);
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+		std::vector<uint8_t> row(rowSize, 0);
+		for (uint32_t y = height; y-- > 0;)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				uint32_t pixel = pixels[static_cast<size_t>(y) * width + x];
+				row[x * 3 + 0] = static_cast<uint8_t>(pixel >> 16);
+				row[x * 3 + 1] = static_cast<uint8_t>(pixel >> 8);
+				row[x * 3 + 2] = static_cast<uint8_t>(pixel);
+			}
+
+			file.write(reinterpret_cast<const char*>(row.data()), rowSize);
+		}
+
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RenderBackend.h"
+
+namespace Core
+{
+	class JobSystem;
+}
+
+namespace Graphics
+{
+	struct SoftwareBackendStats
+	{
+		uint64_t draws = 0;
+		uint64_t drawsSkipped = 0; // Missing buffers, constants or targets, or a topology other than triangles
+		uint64_t instances = 0;
+		uint64_t verticesShaded = 0;
+		uint64_t trianglesSubmitted = 0;
+		uint64_t trianglesCulled = 0; // Back or front facing, zero area, outside the frustum or between pixel centers
+		uint64_t trianglesClipped = 0; // Crossed the near, far or guard band planes
+		uint64_t trianglesBinned = 0;
+		uint64_t binEntries = 0; // Triangle-tile pairs, trianglesBinned times the average tiles touched
+		uint64_t pixelsWritten = 0; // Passed coverage and the depth test
+		uint64_t clears = 0;
+		uint64_t frames = 0;
+		double geometryMilliseconds = 0.0; // Vertex shading, clipping, setup and binning
+		double rasterMilliseconds = 0.0; // Tile rasterization and clears
+	};
+
+	// Renders on the CPU, for machines without a GPU. Buffers and textures live in system memory, color targets are RGBA8 and
+	// depth targets D24 (stencil is kept but never tested). DrawIndexed shades vertices, clips and sets up the triangles right away,
+	// so later Map/Discard calls cannot change a draw that was already issued, then sorts them into 64x64 pixel tiles. Tiles are
+	// rasterized in parallel on the job system when the target is cleared, switched, read back or presented, each tile walks its
+	// triangles in submission order and evaluates the edge functions for four pixels at a time.
+	//
+	// No HLSL runs here: the VertexShader.hlsl and PixelShader.hlsl entry points are implemented natively, CreatePipeline fails for
+	// anything else. Wireframe pipelines are filled.
+	class SoftwareBackend : public RenderBackend
+	{
+	public:
+		explicit SoftwareBackend(Core::JobSystem* jobs = nullptr); // nullptr: owns a job system with a worker per hardware thread
+		~SoftwareBackend() override;
+		SoftwareBackend(const SoftwareBackend&) = delete;
+		SoftwareBackend& operator=(const SoftwareBackend&) = delete;
+
+		const char* GetName() const override { return "Software"; }
+
+		BackendHandle CreateBuffer(const BackendBufferDesc& desc, const void* initialData) override;
+		BackendHandle CreateTexture(const BackendTextureDesc& desc) override;
+		BackendHandle CreatePipeline(const BackendPipelineDesc& desc) override;
+		void Destroy(BackendHandle handle) override;
+
+		void* Map(BackendHandle buffer, BackendMap mode) override;
+		void Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize) override;
+		void UpdateBuffer(BackendHandle buffer, uint32_t offset, const void* data, uint32_t size) override;
+		void CopyBuffer(BackendHandle destination, uint32_t destinationOffset, BackendHandle source, uint32_t sourceOffset, uint32_t size) override;
+
+		void SetPipeline(BackendHandle pipeline) override;
+		void SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset) override;
+		void SetIndexBuffer(BackendHandle buffer, BackendFormat format, uint32_t offset) override;
+		void SetConstantBuffer(uint32_t slot, BackendHandle buffer, uint32_t firstConstant, uint32_t numConstants) override;
+		void SetRenderTargets(BackendHandle color, BackendHandle depth) override;
+		void SetViewport(float width, float height) override;
+		void SetTopology(BackendTopology topology) override;
+		void ClearColor(BackendHandle color, const float rgba[4]) override;
+		void ClearDepth(BackendHandle depth, float value) override;
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+		void Present(BackendHandle color) override;
+
+		// Read back: pending draws are rasterized first. Color pixels are RGBA8 in memory order (R in the low byte), depth pixels
+		// the D24 value in the low 24 bits. Rows are top-down without padding.
+		bool ReadPixels(BackendHandle texture, std::vector<uint32_t>& pixels, uint32_t& width, uint32_t& height);
+		bool SaveImage(BackendHandle texture, const std::string& path); // 24-bit BMP of a color target
+		void SetFrameOutput(const std::string& prefix) { m_FrameOutput = prefix; } // Present writes <prefix>00000.bmp, <prefix>00001.bmp, ... empty to stop
+		BackendHandle GetLastPresented() const { return m_LastPresented; }
+
+		const SoftwareBackendStats& GetStats() const { return m_Stats; }
+		void ResetStats() { m_Stats = SoftwareBackendStats(); }
+
+		static constexpr uint32_t TileSize = 64; // Pixels, a multiple of the four pixel SIMD step
+
+	private:
+		struct Buffer
+		{
+			std::vector<uint8_t> memory;
+		};
+
+		struct Texture
+		{
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t pitch = 0; // Pixels per row, a multiple of four so SIMD groups never leave the row
+			bool depth = false;
+			std::vector<uint32_t> pixels;
+		};
+
+		struct InputElement
+		{
+			bool present = false;
+			uint32_t slot = 0;
+			uint32_t offset = 0;
+			BackendFormat format = BackendFormat::Unknown;
+			bool perInstance = false;
+		};
+
+		struct RasterState
+		{
+			bool depthTest = true;
+			bool depthWrite = true;
+			BackendCompare depthFunc = BackendCompare::Less;
+			bool colorWrite = true;
+			bool blend = false;
+		};
+
+		struct PipelineState
+		{
+			InputElement position;
+			InputElement color; // Absent: white, like the permutation shader without USE_VERTEX_COLOR
+			InputElement world[4]; // Instanced entry points, the rows of the transposed world matrix
+			bool instanced = false; // World from the instance stream instead of ObjectBuffer
+			bool packed = false; // VSPacked: PackingBuffer offset and scale applied to the position
+			BackendCull cull = BackendCull::Back;
+			RasterState raster;
+		};
+
+		struct VertexBinding
+		{
+			BackendHandle buffer = 0;
+			uint32_t stride = 0;
+			uint32_t offset = 0;
+		};
+
+		struct ConstantBinding
+		{
+			BackendHandle buffer = 0;
+			uint32_t firstConstant = 0;
+		};
+
+		struct ClipVertex
+		{
+			float position[4]; // Clip space
+			float color[4];
+		};
+
+		struct DrawContext;
+		struct Triangle;
+		struct Batch;
+
+		static constexpr uint32_t MaxVertexSlots = 16;
+		static constexpr uint32_t MaxConstantSlots = 14;
+
+		Buffer* FindBuffer(BackendHandle handle);
+		Texture* FindTexture(BackendHandle handle);
+		bool PrepareDraw(DrawContext& draw, uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance);
+		void ShadeVertices(const DrawContext& draw, uint32_t begin, uint32_t end);
+		void SetupTriangles(const DrawContext& draw, Batch& batch, uint32_t begin, uint32_t end) const;
+		void ClipAndSetup(const ClipVertex* vertices[3], Batch& batch) const;
+		void SetupTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, Batch& batch) const;
+		void BinTriangles(Batch& batch) const;
+		void RasterizeTile(uint32_t tile);
+		static uint32_t RasterizeTriangle(const Triangle& triangle, const RasterState& state, int32_t left, int32_t top, int32_t right, int32_t bottom, Texture* color, Texture* depth); // Right and bottom exclusive, returns the pixels written
+		void Flush(); // Rasterizes every binned triangle, before anything reads or replaces the targets
+		void UpdateTileGrid();
+
+		Core::JobSystem* m_Jobs = nullptr;
+		std::unique_ptr<Core::JobSystem> m_OwnedJobs;
+
+		std::unordered_map<BackendHandle, std::unique_ptr<Buffer>> m_Buffers;
+		std::unordered_map<BackendHandle, std::unique_ptr<Texture>> m_Textures;
+		std::unordered_map<BackendHandle, std::unique_ptr<PipelineState>> m_Pipelines;
+		BackendHandle m_NextHandle = 1;
+
+		// Bound state
+		const PipelineState* m_Pipeline = nullptr;
+		VertexBinding m_VertexBuffers[MaxVertexSlots];
+		BackendHandle m_IndexBuffer = 0;
+		BackendFormat m_IndexFormat = BackendFormat::R16UInt;
+		uint32_t m_IndexOffset = 0;
+		ConstantBinding m_ConstantBuffers[MaxConstantSlots];
+		BackendHandle m_ColorHandle = 0;
+		BackendHandle m_DepthHandle = 0;
+		Texture* m_ColorTarget = nullptr;
+		Texture* m_DepthTarget = nullptr;
+		float m_ViewportWidth = 0.0f;
+		float m_ViewportHeight = 0.0f;
+		BackendTopology m_Topology = BackendTopology::Undefined;
+
+		// Binned work waiting for Flush(), batches are reused across frames to keep their memory
+		std::vector<ClipVertex> m_Vertices;
+		std::vector<std::unique_ptr<Batch>> m_Batches;
+		uint32_t m_BatchCount = 0;
+		uint32_t m_TilesX = 0;
+		uint32_t m_TilesY = 0;
+		uint32_t m_ClipWidth = 0; // Viewport and targets intersected
+		uint32_t m_ClipHeight = 0;
+		float m_GuardBand = 1.0f; // Clip space x and y limit that keeps snapped coordinates in the fixed point range
+		std::atomic<uint64_t> m_PixelsWritten { 0 };
+
+		BackendHandle m_LastPresented = 0;
+		std::string m_FrameOutput;
+		SoftwareBackendStats m_Stats;
+	};
+}
@@ -5,11 +5,15 @@
 #include "Device.h"
 #include "EngineData.h"
 #include "SwapChain.h"
+#include "BackendBridge.h"
 
 namespace Graphics
 {
 	bool SwapChain::Initialize(const Device& device, HWND hwnd, uint32_t width, uint32_t height)
 	{
+		if (device.GetBackend())
+			return InitializeBackend(*device.GetBackend(), width, height);
+
 		ID3D11Device* d3dDevice = device.GetDevice();
 		if (!d3dDevice)
 		{
@@ -114,10 +118,53 @@ namespace Graphics
 
 
 
+	bool SwapChain::InitializeBackend(RenderBackend& backend, uint32_t width, uint32_t height)
+	{
+		BackendTextureDesc colorDesc;
+		colorDesc.width = width;
+		colorDesc.height = height;
+		colorDesc.format = BackendFormat::RGBA8Unorm;
+
+		BackendTextureDesc depthDesc = colorDesc;
+		depthDesc.format = BackendFormat::D24UnormS8UInt;
+
+		BackendHandle color = backend.CreateTexture(colorDesc);
+		BackendHandle depth = backend.CreateTexture(depthDesc);
+		if (!color || !depth)
+		{
+			if (color)
+				backend.Destroy(color);
+			if (depth)
+				backend.Destroy(depth);
+			return false;
+		}
+
+		m_Backend = &backend;
+
+		// Views and textures are the same backend handles, CommandList passes them straight back
+		backBuffer = FromBackendHandle<ID3D11Texture2D>(color);
+		depthBuffer = FromBackendHandle<ID3D11Texture2D>(depth);
+		renderTargetView = FromBackendHandle<ID3D11RenderTargetView>(color);
+		depthStencilView = FromBackendHandle<ID3D11DepthStencilView>(depth);
+
+		TextureData data = {};
+		data.width = static_cast<float>(width);
+		data.height = static_cast<float>(height);
+		data.flags = static_cast<TextureFlags>(static_cast<int>(TextureFlags::RenderTarget) | static_cast<int>(TextureFlags::DepthStencil));
+		data.iswapChain = true;
+
+		m_RenderPass.m_Color.InitializeFromSwapChain(data, renderTargetView, depthStencilView, backBuffer);
+		m_RenderPass.m_Depth.InitializeFromSwapChain(data, renderTargetView, depthStencilView, depthBuffer);
+
+		return true;
+	}
+
 	void SwapChain::Present(bool vsync)
 	{
 		if (m_SwapChain)
 			m_SwapChain->Present(vsync ? 1 : 0, 0);
+		else if (m_Backend)
+			m_Backend->Present(ToBackendHandle(renderTargetView));
 	}
 
 	void SwapChain::Release()
@@ -127,6 +174,17 @@ namespace Graphics
 			m_SwapChain->Release();
 			m_SwapChain = nullptr;
 		}
+
+		if (m_Backend)
+		{
+			m_Backend->Destroy(ToBackendHandle(backBuffer));
+			m_Backend->Destroy(ToBackendHandle(depthBuffer));
+			backBuffer = nullptr;
+			depthBuffer = nullptr;
+			renderTargetView = nullptr;
+			depthStencilView = nullptr;
+			m_Backend = nullptr;
+		}
 	}
 
 	ID3D11Texture2D* SwapChain::GetBackBuffer() const
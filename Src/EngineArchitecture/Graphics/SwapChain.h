@@ -13,6 +13,7 @@ namespace Graphics
 {
 	class Device;
 	class RenderPass;
+	class RenderBackend;
 
 	class SwapChain
 	{
@@ -20,7 +21,7 @@ namespace Graphics
 		SwapChain() = default;
 		~SwapChain();
 
-		bool Initialize(const Device& device, HWND hwnd, uint32_t width, uint32_t height);
+		bool Initialize(const Device& device, HWND hwnd, uint32_t width, uint32_t height); // hwnd is ignored with a backend device
 		void Present(bool vsync);
 		void Release();
 		ID3D11Texture2D* GetBackBuffer() const;
@@ -32,7 +33,10 @@ namespace Graphics
 
 
 	private:
+		bool InitializeBackend(RenderBackend& backend, uint32_t width, uint32_t height); // Offscreen color and depth targets
+
 		IDXGISwapChain* m_SwapChain = nullptr;
+		RenderBackend* m_Backend = nullptr;
 
 		ID3D11Texture2D* backBuffer = nullptr;
 		ID3D11Texture2D* depthBuffer = nullptr; 
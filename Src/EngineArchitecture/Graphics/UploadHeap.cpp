@@ -0,0 +1,164 @@
+#include "UploadHeap.h"
+#include "Device.h"
+#include "BackendBridge.h"
+#include <cstring>
+#include <iostream>
+
+namespace Graphics
+{
+	bool TransientUploadHeap::Initialize(const Device& device, uint32_t vertexHeapSize, uint32_t indexHeapSize)
+	{
+		m_Device = device.GetDevice();
+		m_Backend = device.GetBackend();
+		if (!m_Device && !m_Backend)
+			return false;
+
+		if (!CreateHeap(m_VertexHeap, vertexHeapSize, D3D11_BIND_VERTEX_BUFFER) ||
+			!CreateHeap(m_IndexHeap, indexHeapSize, D3D11_BIND_INDEX_BUFFER))
+		{
+			std::cerr << "[UploadHeap] Failed to create transient heap.\n";
+			Release();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool TransientUploadHeap::CreateHeap(Heap& heap, uint32_t size, UINT bindFlags)
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = size;
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.BindFlags = bindFlags;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		desc.MiscFlags = 0;
+
+		if (!BackendBridge::CreateBuffer(m_Backend, m_Device, desc, nullptr, &heap.buffer))
+			return false;
+
+		heap.size = size;
+		heap.head = 0;
+		heap.needsDiscard = true;
+		heap.bindFlags = bindFlags;
+		heap.frameAllocations = 0;
+		heap.frameBytes = 0;
+		heap.requiredSize = 0;
+		return true;
+	}
+
+	bool TransientUploadHeap::Grow(Heap& heap)
+	{
+		uint32_t size = heap.size;
+		while (size < heap.requiredSize)
+			size *= 2;
+
+		// Draws of earlier frames keep the old buffer alive until the GPU is done with it
+		BackendBridge::Release(m_Backend, heap.buffer);
+
+		if (!CreateHeap(heap, size, heap.bindFlags))
+		{
+			std::cerr << "[UploadHeap] Failed to grow transient heap.\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	void TransientUploadHeap::BeginFrame()
+	{
+		m_Stats = {};
+
+		for (Heap* heap : { &m_VertexHeap, &m_IndexHeap })
+		{
+			heap->frameAllocations = 0;
+			heap->frameBytes = 0;
+
+			if (heap->buffer && heap->requiredSize > heap->size)
+				Grow(*heap);
+		}
+	}
+
+	bool TransientUploadHeap::AllocateVertices(ID3D11DeviceContext* context, const void* vertices, uint32_t vertexCount, uint32_t stride, TransientAllocation& allocation)
+	{
+		if (!Write(context, m_VertexHeap, vertices, vertexCount * stride, stride, allocation))
+			return false;
+
+		m_Stats.vertexBytes += allocation.size;
+		return true;
+	}
+
+	bool TransientUploadHeap::AllocateIndices(ID3D11DeviceContext* context, const void* indices, uint32_t indexCount, DXGI_FORMAT format, TransientAllocation& allocation)
+	{
+		uint32_t indexSize = (format == DXGI_FORMAT_R16_UINT) ? 2 : 4;
+
+		if (!Write(context, m_IndexHeap, indices, indexCount * indexSize, indexSize, allocation))
+			return false;
+
+		m_Stats.indexBytes += allocation.size;
+		return true;
+	}
+
+	bool TransientUploadHeap::Write(ID3D11DeviceContext* context, Heap& heap, const void* data, uint32_t size, uint32_t alignment, TransientAllocation& allocation)
+	{
+		if ((!context && !m_Backend) || !heap.buffer || !data || size == 0 || alignment == 0)
+			return false;
+
+		// Round the head up to the element size so the offset maps to a whole vertex/index
+		uint32_t offset = ((heap.head + alignment - 1) / alignment) * alignment;
+		if (offset + size > heap.size)
+		{
+			// Renaming would orphan the allocations this frame has not drawn yet, only wrap while there are none
+			if (heap.frameAllocations > 0 || size > heap.size)
+			{
+				uint32_t required = heap.frameBytes + size + alignment;
+				heap.requiredSize = (required > heap.requiredSize) ? required : heap.requiredSize;
+
+				if (m_Stats.overflows++ == 0)
+					std::cerr << "[UploadHeap] Transient heap is full for this frame, it grows at the next BeginFrame.\n";
+				return false;
+			}
+
+			offset = 0;
+			heap.needsDiscard = true;
+		}
+
+		D3D11_MAP mapType = heap.needsDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+		void* mapped = BackendBridge::Map(m_Backend, context, heap.buffer, mapType);
+		if (!mapped)
+		{
+			std::cerr << "[UploadHeap] Failed to map transient heap.\n";
+			return false;
+		}
+
+		memcpy(static_cast<uint8_t*>(mapped) + offset, data, size);
+		BackendBridge::Unmap(m_Backend, context, heap.buffer, offset, size);
+
+		if (heap.needsDiscard)
+			m_Stats.discards++;
+
+		heap.needsDiscard = false;
+		heap.frameBytes += offset + size - ((offset >= heap.head) ? heap.head : 0);
+		heap.frameAllocations++;
+		heap.head = offset + size;
+
+		allocation.buffer = heap.buffer;
+		allocation.offset = offset;
+		allocation.size = size;
+		allocation.stride = alignment;
+
+		m_Stats.allocations++;
+		return true;
+	}
+
+	void TransientUploadHeap::Release()
+	{
+		BackendBridge::Release(m_Backend, m_VertexHeap.buffer);
+		BackendBridge::Release(m_Backend, m_IndexHeap.buffer);
+	}
+
+	TransientUploadHeap::~TransientUploadHeap()
+	{
+		Release();
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <d3d11.h>
+#include <cstdint>
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace Graphics
+{
+	class Device;
+	class RenderBackend;
+
+	// Geometry written into the transient heap this frame. The heap buffers are bound at offset 0,
+	// so the allocation is addressed through DrawIndexed's startIndexLocation/baseVertexLocation.
+	struct TransientAllocation
+	{
+		ID3D11Buffer* buffer = nullptr;
+		uint32_t offset = 0; // Byte offset, always a multiple of stride
+		uint32_t size = 0;
+		uint32_t stride = 0; // Vertex stride or index size
+
+		uint32_t GetFirstElement() const { return stride ? offset / stride : 0; } // baseVertexLocation or startIndexLocation
+		uint32_t GetCount() const { return stride ? size / stride : 0; }
+		bool IsValid() const { return buffer != nullptr; }
+	};
+
+	struct UploadHeapStats
+	{
+		uint64_t vertexBytes = 0; // Bytes uploaded into the vertex heap this frame
+		uint64_t indexBytes = 0; // Bytes uploaded into the index heap this frame
+		uint32_t allocations = 0;
+		uint32_t discards = 0; // Times a heap wrapped and was renamed with WRITE_DISCARD
+		uint32_t overflows = 0; // Allocations refused because the heap was full of this frame's data
+	};
+
+	// Per-frame linear allocator for streaming geometry (UI, debug lines, particles).
+	// Data is appended with MAP_WRITE_NO_OVERWRITE; a full heap that only holds older frames is renamed with WRITE_DISCARD and restarts at 0.
+	// Allocations must stay valid until the frame is submitted, so a heap that fills up within one frame refuses
+	// further allocations and grows at the next BeginFrame().
+	class TransientUploadHeap
+	{
+	public:
+		TransientUploadHeap() = default;
+		~TransientUploadHeap();
+
+		bool Initialize(const Device& device, uint32_t vertexHeapSize = 4 * 1024 * 1024, uint32_t indexHeapSize = 1024 * 1024);
+		void Release();
+
+		void BeginFrame(); // Grows the heaps that overflowed last frame
+
+		bool AllocateVertices(ID3D11DeviceContext* context, const void* vertices, uint32_t vertexCount, uint32_t stride, TransientAllocation& allocation);
+		bool AllocateIndices(ID3D11DeviceContext* context, const void* indices, uint32_t indexCount, DXGI_FORMAT format, TransientAllocation& allocation);
+
+		ID3D11Buffer* GetVertexBuffer() const { return m_VertexHeap.buffer; }
+		ID3D11Buffer* GetIndexBuffer() const { return m_IndexHeap.buffer; }
+		uint32_t GetVertexHeapSize() const { return m_VertexHeap.size; }
+		uint32_t GetIndexHeapSize() const { return m_IndexHeap.size; }
+		const UploadHeapStats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Heap
+		{
+			ID3D11Buffer* buffer = nullptr;
+			uint32_t size = 0;
+			uint32_t head = 0; // Next free byte
+			bool needsDiscard = true; // First map after creation or wrap renames the buffer
+			UINT bindFlags = 0;
+			uint32_t frameAllocations = 0; // Allocations the current frame still has to draw from
+			uint32_t frameBytes = 0; // Bytes they occupy, alignment padding included
+			uint32_t requiredSize = 0; // Set on overflow, the heap is recreated at least this large
+		};
+
+		bool CreateHeap(Heap& heap, uint32_t size, UINT bindFlags);
+		bool Grow(Heap& heap);
+		bool Write(ID3D11DeviceContext* context, Heap& heap, const void* data, uint32_t size, uint32_t alignment, TransientAllocation& allocation);
+
+		Heap m_VertexHeap;
+		Heap m_IndexHeap;
+		ID3D11Device* m_Device = nullptr; // Kept to grow the heaps
+		RenderBackend* m_Backend = nullptr; // Heaps are backend handles when set
+		UploadHeapStats m_Stats;
+	};
+}
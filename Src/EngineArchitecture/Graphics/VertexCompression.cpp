@@ -0,0 +1,679 @@
+#include "VertexCompression.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <immintrin.h>
+#define VERTEX_COMPRESSION_SSE2
+
+// AVX2 and F16C are only used after the CPU reported them, the rest of the file stays SSE2
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define VERTEX_COMPRESSION_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define VERTEX_COMPRESSION_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+#endif
+
+namespace Graphics
+{
+	namespace
+	{
+		inline const uint8_t* Element(const void* base, size_t stride, size_t index)
+		{
+			return static_cast<const uint8_t*>(base) + index * stride;
+		}
+
+		inline uint8_t* Element(void* base, size_t stride, size_t index)
+		{
+			return static_cast<uint8_t*>(base) + index * stride;
+		}
+
+		inline float LoadFloat(const uint8_t* element, size_t component)
+		{
+			float value;
+			memcpy(&value, element + component * sizeof(float), sizeof(float));
+			return value;
+		}
+
+		inline float Clamp(float value, float low, float high)
+		{
+			return std::min(std::max(value, low), high);
+		}
+
+		// Same rounding as _mm_cvtps_epi32 (nearest even), so every path produces identical bits
+		inline int32_t Round(float value)
+		{
+			return static_cast<int32_t>(std::lrint(value));
+		}
+
+		inline int16_t EncodeSnorm16(float value)
+		{
+			return static_cast<int16_t>(Round(Clamp(value, -1.0f, 1.0f) * 32767.0f));
+		}
+
+		inline float SignNotZero(float value)
+		{
+			return (value >= 0.0f) ? 1.0f : -1.0f;
+		}
+
+		void EncodeOctahedralScalar(const uint8_t* direction, uint8_t* destination)
+		{
+			float x = LoadFloat(direction, 0);
+			float y = LoadFloat(direction, 1);
+			float z = LoadFloat(direction, 2);
+
+			// Project onto the octahedron |x| + |y| + |z| = 1, then fold the lower half over the diagonals
+			float sum = std::max(std::fabs(x) + std::fabs(y) + std::fabs(z), FLT_MIN);
+			float px = x / sum;
+			float py = y / sum;
+
+			if (z < 0.0f)
+			{
+				float foldedX = (1.0f - std::fabs(py)) * SignNotZero(px);
+				float foldedY = (1.0f - std::fabs(px)) * SignNotZero(py);
+				px = foldedX;
+				py = foldedY;
+			}
+
+			int16_t encoded[2] = { EncodeSnorm16(px), EncodeSnorm16(py) };
+			memcpy(destination, encoded, sizeof(encoded));
+		}
+
+#if defined(VERTEX_COMPRESSION_SSE2)
+		inline void Store32(uint8_t* destination, __m128i value)
+		{
+			int32_t bits = _mm_cvtsi128_si32(value);
+			memcpy(destination, &bits, sizeof(bits));
+		}
+
+		// Four dwords of value to four strided destinations
+		inline void Store32x4(uint8_t* destination, size_t stride, __m128i value)
+		{
+			Store32(destination, value);
+			Store32(destination + stride, _mm_srli_si128(value, 4));
+			Store32(destination + stride * 2, _mm_srli_si128(value, 8));
+			Store32(destination + stride * 3, _mm_srli_si128(value, 12));
+		}
+
+		// Two qwords of value to two strided destinations
+		inline void Store64x2(uint8_t* destination, size_t stride, __m128i value)
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(destination), value);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(destination + stride), _mm_unpackhi_epi64(value, value));
+		}
+
+		// _mm_packs_epi32 saturates signed values, so bias into [-32768, 32767] and undo it after packing
+		inline __m128i PackUnorm16(__m128i a, __m128i b)
+		{
+			const __m128i bias32 = _mm_set1_epi32(0x8000);
+			const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+			return _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32)), bias16);
+		}
+
+		size_t EncodePositionsSSE2(const void* positions, size_t stride, size_t count, const PositionQuantization& quantization, void* destination, size_t destinationStride)
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 range = _mm_set1_ps(65535.0f);
+			const __m128 offset[3] = { _mm_set1_ps(quantization.offset.x), _mm_set1_ps(quantization.offset.y), _mm_set1_ps(quantization.offset.z) };
+			const __m128 inverse[3] = { _mm_set1_ps(1.0f / quantization.scale.x), _mm_set1_ps(1.0f / quantization.scale.y), _mm_set1_ps(1.0f / quantization.scale.z) };
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const uint8_t* p0 = Element(positions, stride, i);
+				const uint8_t* p1 = p0 + stride;
+				const uint8_t* p2 = p1 + stride;
+				const uint8_t* p3 = p2 + stride;
+
+				__m128i q[4];
+				for (size_t axis = 0; axis < 3; ++axis)
+				{
+					__m128 value = _mm_set_ps(LoadFloat(p3, axis), LoadFloat(p2, axis), LoadFloat(p1, axis), LoadFloat(p0, axis));
+					value = _mm_mul_ps(_mm_sub_ps(value, offset[axis]), inverse[axis]);
+					value = _mm_min_ps(_mm_max_ps(value, zero), one);
+					q[axis] = _mm_cvtps_epi32(_mm_mul_ps(value, range));
+				}
+				q[3] = _mm_setzero_si128();
+
+				// x0..x3 y0..y3 | z0..z3 w0..w3 -> x0 y0 z0 w0 x1 y1 z1 w1 | x2 ... w3
+				__m128i xy = PackUnorm16(q[0], q[1]);
+				__m128i zw = PackUnorm16(q[2], q[3]);
+				__m128i xzLow = _mm_unpacklo_epi16(xy, zw);
+				__m128i ywHigh = _mm_unpackhi_epi16(xy, zw);
+
+				uint8_t* out = Element(destination, destinationStride, i);
+				Store64x2(out, destinationStride, _mm_unpacklo_epi16(xzLow, ywHigh));
+				Store64x2(out + destinationStride * 2, destinationStride, _mm_unpackhi_epi16(xzLow, ywHigh));
+			}
+
+			return i;
+		}
+
+		// Octahedral projection and fold for four directions at once
+		void OctahedralSSE2(__m128 x, __m128 y, __m128 z, __m128& outX, __m128& outY)
+		{
+			const __m128 signMask = _mm_set1_ps(-0.0f);
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			__m128 absX = _mm_andnot_ps(signMask, x);
+			__m128 absY = _mm_andnot_ps(signMask, y);
+			__m128 absZ = _mm_andnot_ps(signMask, z);
+			__m128 sum = _mm_max_ps(_mm_add_ps(_mm_add_ps(absX, absY), absZ), _mm_set1_ps(FLT_MIN));
+
+			__m128 px = _mm_div_ps(x, sum);
+			__m128 py = _mm_div_ps(y, sum);
+
+			// SignNotZero: +1 for px >= 0, so -0.0 folds like +0.0 in every path. Copying the sign bit would give -1.
+			__m128 signX = _mm_or_ps(_mm_andnot_ps(_mm_cmpge_ps(px, _mm_setzero_ps()), signMask), one);
+			__m128 signY = _mm_or_ps(_mm_andnot_ps(_mm_cmpge_ps(py, _mm_setzero_ps()), signMask), one);
+			__m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, py)), signX);
+			__m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, px)), signY);
+
+			__m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+			outX = _mm_or_ps(_mm_and_ps(lower, foldedX), _mm_andnot_ps(lower, px));
+			outY = _mm_or_ps(_mm_and_ps(lower, foldedY), _mm_andnot_ps(lower, py));
+		}
+
+		size_t EncodeOctahedralSSE2(const void* directions, size_t stride, size_t count, void* destination, size_t destinationStride)
+		{
+			const __m128 low = _mm_set1_ps(-1.0f);
+			const __m128 high = _mm_set1_ps(1.0f);
+			const __m128 range = _mm_set1_ps(32767.0f);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const uint8_t* d0 = Element(directions, stride, i);
+				const uint8_t* d1 = d0 + stride;
+				const uint8_t* d2 = d1 + stride;
+				const uint8_t* d3 = d2 + stride;
+
+				__m128 x = _mm_set_ps(LoadFloat(d3, 0), LoadFloat(d2, 0), LoadFloat(d1, 0), LoadFloat(d0, 0));
+				__m128 y = _mm_set_ps(LoadFloat(d3, 1), LoadFloat(d2, 1), LoadFloat(d1, 1), LoadFloat(d0, 1));
+				__m128 z = _mm_set_ps(LoadFloat(d3, 2), LoadFloat(d2, 2), LoadFloat(d1, 2), LoadFloat(d0, 2));
+
+				__m128 ox, oy;
+				OctahedralSSE2(x, y, z, ox, oy);
+
+				__m128i qx = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(ox, low), high), range));
+				__m128i qy = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(oy, low), high), range));
+
+				// ox0..ox3 oy0..oy3 -> ox0 oy0 ox1 oy1 ...
+				__m128i packed = _mm_packs_epi32(qx, qy);
+				Store32x4(Element(destination, destinationStride, i), destinationStride, _mm_unpacklo_epi16(packed, _mm_srli_si128(packed, 8)));
+			}
+
+			return i;
+		}
+
+		size_t EncodeColorsSSE2(const void* colors, size_t stride, size_t count, void* destination, size_t destinationStride)
+		{
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 range = _mm_set1_ps(255.0f);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128i q[4];
+				for (size_t k = 0; k < 4; ++k)
+				{
+					__m128 color = _mm_loadu_ps(reinterpret_cast<const float*>(Element(colors, stride, i + k)));
+					q[k] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color, zero), one), range));
+				}
+
+				// Values are already in [0, 255], both packs are exact
+				__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+				Store32x4(Element(destination, destinationStride, i), destinationStride, bytes);
+			}
+
+			return i;
+		}
+
+		bool DetectAVX2()
+		{
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7)
+				return false;
+
+			// AVX state must be enabled by the OS (OSXSAVE + XCR0), F16C comes with every AVX2 CPU but is checked anyway
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			bool f16c = (info[2] & (1 << 29)) != 0;
+			if (!osxsave || !avx || !f16c || (_xgetbv(0) & 6) != 6)
+				return false;
+
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			unsigned int eax, ebx, ecx, edx;
+			if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_F16C))
+				return false;
+
+			return __builtin_cpu_supports("avx2"); // Includes the OS check
+#endif
+		}
+
+		VERTEX_COMPRESSION_TARGET_AVX2
+		inline void Store64x2(uint8_t* destination, size_t stride, __m256i value, size_t laneStride)
+		{
+			Store64x2(destination, stride, _mm256_castsi256_si128(value));
+			Store64x2(destination + laneStride, stride, _mm256_extracti128_si256(value, 1));
+		}
+
+		VERTEX_COMPRESSION_TARGET_AVX2
+		size_t EncodePositionsAVX2(const void* positions, size_t stride, size_t count, const PositionQuantization& quantization, void* destination, size_t destinationStride)
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 range = _mm256_set1_ps(65535.0f);
+			const __m256 offset[3] = { _mm256_set1_ps(quantization.offset.x), _mm256_set1_ps(quantization.offset.y), _mm256_set1_ps(quantization.offset.z) };
+			const __m256 inverse[3] = { _mm256_set1_ps(1.0f / quantization.scale.x), _mm256_set1_ps(1.0f / quantization.scale.y), _mm256_set1_ps(1.0f / quantization.scale.z) };
+			const __m256i bias32 = _mm256_set1_epi32(0x8000);
+			const __m256i bias16 = _mm256_set1_epi16(static_cast<short>(0x8000));
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const uint8_t* p[8];
+				for (size_t k = 0; k < 8; ++k)
+					p[k] = Element(positions, stride, i + k);
+
+				__m256i q[4];
+				for (size_t axis = 0; axis < 3; ++axis)
+				{
+					__m256 value = _mm256_set_ps(LoadFloat(p[7], axis), LoadFloat(p[6], axis), LoadFloat(p[5], axis), LoadFloat(p[4], axis),
+						LoadFloat(p[3], axis), LoadFloat(p[2], axis), LoadFloat(p[1], axis), LoadFloat(p[0], axis));
+					value = _mm256_mul_ps(_mm256_sub_ps(value, offset[axis]), inverse[axis]);
+					value = _mm256_min_ps(_mm256_max_ps(value, zero), one);
+					q[axis] = _mm256_sub_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(value, range)), bias32);
+				}
+				q[3] = _mm256_sub_epi32(_mm256_setzero_si256(), bias32);
+
+				// Packs and unpacks stay inside 128-bit lanes: lane 0 ends up with vertices 0-3, lane 1 with 4-7
+				__m256i xy = _mm256_add_epi16(_mm256_packs_epi32(q[0], q[1]), bias16);
+				__m256i zw = _mm256_add_epi16(_mm256_packs_epi32(q[2], q[3]), bias16);
+				__m256i xzLow = _mm256_unpacklo_epi16(xy, zw);
+				__m256i ywHigh = _mm256_unpackhi_epi16(xy, zw);
+
+				uint8_t* out = Element(destination, destinationStride, i);
+				Store64x2(out, destinationStride, _mm256_unpacklo_epi16(xzLow, ywHigh), destinationStride * 4);
+				Store64x2(out + destinationStride * 2, destinationStride, _mm256_unpackhi_epi16(xzLow, ywHigh), destinationStride * 4);
+			}
+
+			return i;
+		}
+
+		VERTEX_COMPRESSION_TARGET_AVX2
+		size_t EncodeOctahedralAVX2(const void* directions, size_t stride, size_t count, void* destination, size_t destinationStride)
+		{
+			const __m256 signMask = _mm256_set1_ps(-0.0f);
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 range = _mm256_set1_ps(32767.0f);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const uint8_t* d[8];
+				for (size_t k = 0; k < 8; ++k)
+					d[k] = Element(directions, stride, i + k);
+
+				__m256 axes[3];
+				for (size_t axis = 0; axis < 3; ++axis)
+				{
+					axes[axis] = _mm256_set_ps(LoadFloat(d[7], axis), LoadFloat(d[6], axis), LoadFloat(d[5], axis), LoadFloat(d[4], axis),
+						LoadFloat(d[3], axis), LoadFloat(d[2], axis), LoadFloat(d[1], axis), LoadFloat(d[0], axis));
+				}
+
+				__m256 absX = _mm256_andnot_ps(signMask, axes[0]);
+				__m256 absY = _mm256_andnot_ps(signMask, axes[1]);
+				__m256 absZ = _mm256_andnot_ps(signMask, axes[2]);
+				__m256 sum = _mm256_max_ps(_mm256_add_ps(_mm256_add_ps(absX, absY), absZ), _mm256_set1_ps(FLT_MIN));
+
+				__m256 px = _mm256_div_ps(axes[0], sum);
+				__m256 py = _mm256_div_ps(axes[1], sum);
+
+				__m256 signX = _mm256_or_ps(_mm256_andnot_ps(_mm256_cmp_ps(px, _mm256_setzero_ps(), _CMP_GE_OQ), signMask), one); // SignNotZero, see OctahedralSSE2
+				__m256 signY = _mm256_or_ps(_mm256_andnot_ps(_mm256_cmp_ps(py, _mm256_setzero_ps(), _CMP_GE_OQ), signMask), one);
+				__m256 foldedX = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, py)), signX);
+				__m256 foldedY = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_andnot_ps(signMask, px)), signY);
+
+				__m256 lower = _mm256_cmp_ps(axes[2], _mm256_setzero_ps(), _CMP_LT_OQ);
+				__m256 ox = _mm256_blendv_ps(px, foldedX, lower);
+				__m256 oy = _mm256_blendv_ps(py, foldedY, lower);
+
+				__m256i qx = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(ox, _mm256_set1_ps(-1.0f)), one), range));
+				__m256i qy = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(oy, _mm256_set1_ps(-1.0f)), one), range));
+
+				__m256i packed = _mm256_packs_epi32(qx, qy);
+				__m256i interleaved = _mm256_unpacklo_epi16(packed, _mm256_srli_si256(packed, 8));
+
+				uint8_t* out = Element(destination, destinationStride, i);
+				Store32x4(out, destinationStride, _mm256_castsi256_si128(interleaved));
+				Store32x4(out + destinationStride * 4, destinationStride, _mm256_extracti128_si256(interleaved, 1));
+			}
+
+			return i;
+		}
+
+		VERTEX_COMPRESSION_TARGET_AVX2
+		size_t EncodeHalf2F16C(const void* values, size_t stride, size_t count, void* destination, size_t destinationStride)
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const uint8_t* v0 = Element(values, stride, i);
+				const uint8_t* v1 = v0 + stride;
+				const uint8_t* v2 = v1 + stride;
+				const uint8_t* v3 = v2 + stride;
+
+				__m256 pairs = _mm256_set_ps(LoadFloat(v3, 1), LoadFloat(v3, 0), LoadFloat(v2, 1), LoadFloat(v2, 0),
+					LoadFloat(v1, 1), LoadFloat(v1, 0), LoadFloat(v0, 1), LoadFloat(v0, 0));
+
+				Store32x4(Element(destination, destinationStride, i), destinationStride, _mm256_cvtps_ph(pairs, _MM_FROUND_TO_NEAREST_INT));
+			}
+
+			return i;
+		}
+
+		VERTEX_COMPRESSION_TARGET_AVX2
+		size_t EncodeColorsAVX2(const void* colors, size_t stride, size_t count, void* destination, size_t destinationStride)
+		{
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 range = _mm256_set1_ps(255.0f);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				// Vertex k in the low lane of pair k / 2 for even k, the high lane for odd k
+				__m256i q[4];
+				for (size_t k = 0; k < 4; ++k)
+				{
+					__m128 even = _mm_loadu_ps(reinterpret_cast<const float*>(Element(colors, stride, i + k * 2)));
+					__m128 odd = _mm_loadu_ps(reinterpret_cast<const float*>(Element(colors, stride, i + k * 2 + 1)));
+					__m256 color = _mm256_insertf128_ps(_mm256_castps128_ps256(even), odd, 1);
+					q[k] = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(color, zero), one), range));
+				}
+
+				// Lane 0 holds vertices 0, 2, 4, 6 and lane 1 holds 1, 3, 5, 7
+				__m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(q[0], q[1]), _mm256_packs_epi32(q[2], q[3]));
+				uint8_t* out = Element(destination, destinationStride, i);
+				Store32x4(out, destinationStride * 2, _mm256_castsi256_si128(bytes));
+				Store32x4(out + destinationStride, destinationStride * 2, _mm256_extracti128_si256(bytes, 1));
+			}
+
+			return i;
+		}
+
+		const bool s_HasAVX2 = DetectAVX2();
+#else
+		const bool s_HasAVX2 = false;
+#endif
+	}
+
+	bool HasVertexCompressionAVX2()
+	{
+		return s_HasAVX2;
+	}
+
+	PositionQuantization ComputePositionQuantization(const void* positions, size_t stride, size_t count)
+	{
+		PositionQuantization quantization;
+		if (count == 0)
+			return quantization;
+
+		float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint8_t* position = Element(positions, stride, i);
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				float value = LoadFloat(position, axis);
+				low[axis] = std::min(low[axis], value);
+				high[axis] = std::max(high[axis], value);
+			}
+		}
+
+		float* offset = &quantization.offset.x;
+		float* scale = &quantization.scale.x;
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			offset[axis] = low[axis];
+			scale[axis] = (high[axis] > low[axis]) ? high[axis] - low[axis] : 1.0f; // Flat axis, every vertex encodes to 0
+		}
+
+		return quantization;
+	}
+
+	void EncodePositions(const void* positions, size_t stride, size_t count, const PositionQuantization& quantization, void* destination, size_t destinationStride)
+	{
+		size_t i = 0;
+
+#if defined(VERTEX_COMPRESSION_SSE2)
+		if (s_HasAVX2)
+			i = EncodePositionsAVX2(positions, stride, count, quantization, destination, destinationStride);
+
+		const size_t done = i;
+		i += EncodePositionsSSE2(Element(positions, stride, done), stride, count - done, quantization, Element(destination, destinationStride, done), destinationStride);
+#endif
+
+		const float* offset = &quantization.offset.x;
+		const float* scale = &quantization.scale.x;
+		for (; i < count; ++i)
+		{
+			const uint8_t* position = Element(positions, stride, i);
+
+			uint16_t encoded[4] = { 0, 0, 0, 0 };
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				float normalized = (LoadFloat(position, axis) - offset[axis]) * (1.0f / scale[axis]);
+				encoded[axis] = static_cast<uint16_t>(Round(Clamp(normalized, 0.0f, 1.0f) * 65535.0f));
+			}
+
+			memcpy(Element(destination, destinationStride, i), encoded, sizeof(encoded));
+		}
+	}
+
+	void EncodeOctahedral(const void* directions, size_t stride, size_t count, void* destination, size_t destinationStride)
+	{
+		size_t i = 0;
+
+#if defined(VERTEX_COMPRESSION_SSE2)
+		if (s_HasAVX2)
+			i = EncodeOctahedralAVX2(directions, stride, count, destination, destinationStride);
+
+		const size_t done = i;
+		i += EncodeOctahedralSSE2(Element(directions, stride, done), stride, count - done, Element(destination, destinationStride, done), destinationStride);
+#endif
+
+		for (; i < count; ++i)
+			EncodeOctahedralScalar(Element(directions, stride, i), Element(destination, destinationStride, i));
+	}
+
+	void EncodeHalf2(const void* values, size_t stride, size_t count, void* destination, size_t destinationStride)
+	{
+		size_t i = 0;
+
+#if defined(VERTEX_COMPRESSION_SSE2)
+		// SSE2 has no half conversion, without F16C everything goes through the scalar path
+		if (s_HasAVX2)
+			i = EncodeHalf2F16C(values, stride, count, destination, destinationStride);
+#endif
+
+		for (; i < count; ++i)
+		{
+			const uint8_t* value = Element(values, stride, i);
+			uint16_t encoded[2] = { FloatToHalf(LoadFloat(value, 0)), FloatToHalf(LoadFloat(value, 1)) };
+			memcpy(Element(destination, destinationStride, i), encoded, sizeof(encoded));
+		}
+	}
+
+	void EncodeColors(const void* colors, size_t stride, size_t count, void* destination, size_t destinationStride)
+	{
+		size_t i = 0;
+
+#if defined(VERTEX_COMPRESSION_SSE2)
+		if (s_HasAVX2)
+			i = EncodeColorsAVX2(colors, stride, count, destination, destinationStride);
+
+		const size_t done = i;
+		i += EncodeColorsSSE2(Element(colors, stride, done), stride, count - done, Element(destination, destinationStride, done), destinationStride);
+#endif
+
+		for (; i < count; ++i)
+		{
+			const uint8_t* color = Element(colors, stride, i);
+
+			uint8_t encoded[4];
+			for (size_t channel = 0; channel < 4; ++channel)
+				encoded[channel] = static_cast<uint8_t>(Round(Clamp(LoadFloat(color, channel), 0.0f, 1.0f) * 255.0f));
+
+			memcpy(Element(destination, destinationStride, i), encoded, sizeof(encoded));
+		}
+	}
+
+	XMFLOAT3 DecodePosition(const uint16_t encoded[4], const PositionQuantization& quantization)
+	{
+		return XMFLOAT3(
+			quantization.offset.x + quantization.scale.x * (encoded[0] / 65535.0f),
+			quantization.offset.y + quantization.scale.y * (encoded[1] / 65535.0f),
+			quantization.offset.z + quantization.scale.z * (encoded[2] / 65535.0f));
+	}
+
+	XMFLOAT3 DecodeOctahedral(const int16_t encoded[2])
+	{
+		// SNORM16 maps -32768 and -32767 both to -1
+		float x = std::max(encoded[0] / 32767.0f, -1.0f);
+		float y = std::max(encoded[1] / 32767.0f, -1.0f);
+		float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+		// Unfold the lower half
+		float t = std::max(-z, 0.0f);
+		x += (x >= 0.0f) ? -t : t;
+		y += (y >= 0.0f) ? -t : t;
+
+		float length = std::sqrt(x * x + y * y + z * z);
+		return XMFLOAT3(x / length, y / length, z / length);
+	}
+
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		uint32_t magnitude = bits & 0x7FFFFFFF;
+
+		if (magnitude >= 0x7F800000)
+			return static_cast<uint16_t>(sign | 0x7C00 | ((magnitude > 0x7F800000) ? 0x200 : 0)); // Inf, NaN stays NaN
+
+		if (magnitude >= 0x477FF000)
+			return static_cast<uint16_t>(sign | 0x7C00); // 65520 and up round to infinity
+
+		if (magnitude < 0x38800000)
+		{
+			// Half subnormals: the float mantissa (with its implicit bit) shifted down to units of 2^-24
+			if (magnitude < 0x33000000)
+				return static_cast<uint16_t>(sign);
+
+			uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+			uint32_t shift = 126 - (magnitude >> 23);
+			uint32_t result = mantissa >> shift;
+			uint32_t remainder = mantissa & ((1u << shift) - 1);
+			uint32_t halfway = 1u << (shift - 1);
+
+			if (remainder > halfway || (remainder == halfway && (result & 1)))
+				result++;
+
+			return static_cast<uint16_t>(sign | result);
+		}
+
+		// Rebias the exponent from 127 to 15 and drop 13 mantissa bits, a carry may bump the exponent (correctly)
+		uint32_t result = (magnitude >> 13) - (112 << 10);
+		uint32_t remainder = magnitude & 0x1FFF;
+
+		if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+			result++;
+
+		return static_cast<uint16_t>(sign | result);
+	}
+
+	float HalfToFloat(uint16_t value)
+	{
+		uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+		uint32_t exponent = (value >> 10) & 0x1F;
+		uint32_t mantissa = value & 0x3FF;
+		uint32_t bits;
+
+		if (exponent == 0x1F)
+		{
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+		else if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			// Subnormal half, exact as a float
+			float magnitude = mantissa * (1.0f / 16777216.0f);
+			memcpy(&bits, &magnitude, sizeof(bits));
+			bits |= sign;
+		}
+
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	PositionQuantization CompressVertices(const VertexPositionColor* vertices, size_t count, VertexPositionColorPacked* packed)
+	{
+		const size_t stride = sizeof(VertexPositionColor);
+		const size_t packedStride = sizeof(VertexPositionColorPacked);
+
+		PositionQuantization quantization = ComputePositionQuantization(&vertices->Position, stride, count);
+		EncodePositions(&vertices->Position, stride, count, quantization, packed->Position, packedStride);
+		EncodeColors(&vertices->Color, stride, count, packed->Color, packedStride);
+		return quantization;
+	}
+
+	PositionQuantization CompressVertices(const VertexPositionNormalTex* vertices, size_t count, VertexPositionNormalTexPacked* packed)
+	{
+		const size_t stride = sizeof(VertexPositionNormalTex);
+		const size_t packedStride = sizeof(VertexPositionNormalTexPacked);
+
+		PositionQuantization quantization = ComputePositionQuantization(&vertices->Position, stride, count);
+		EncodePositions(&vertices->Position, stride, count, quantization, packed->Position, packedStride);
+		EncodeOctahedral(&vertices->Normal, stride, count, packed->Normal, packedStride);
+		EncodeHalf2(&vertices->TexCoord, stride, count, packed->TexCoord, packedStride);
+		return quantization;
+	}
+
+	PositionQuantization CompressVertices(const VertexPositionNormalTangentTex* vertices, size_t count, VertexPositionNormalTangentTexPacked* packed)
+	{
+		const size_t stride = sizeof(VertexPositionNormalTangentTex);
+		const size_t packedStride = sizeof(VertexPositionNormalTangentTexPacked);
+
+		PositionQuantization quantization = ComputePositionQuantization(&vertices->Position, stride, count);
+		EncodePositions(&vertices->Position, stride, count, quantization, packed->Position, packedStride);
+		EncodeOctahedral(&vertices->Normal, stride, count, packed->Normal, packedStride);
+		EncodeOctahedral(&vertices->Tangent, stride, count, packed->Tangent, packedStride);
+		EncodeHalf2(&vertices->TexCoord, stride, count, packed->TexCoord, packedStride);
+		return quantization;
+	}
+}
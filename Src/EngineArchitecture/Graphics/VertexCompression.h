@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "EngineData.h"
+
+namespace Graphics
+{
+	// Decoded position = offset + scale * unorm, per axis; the shader gets both through PackingBuffer
+	struct PositionQuantization
+	{
+		XMFLOAT3 offset = { 0.0f, 0.0f, 0.0f }; // Bounds minimum
+		XMFLOAT3 scale = { 1.0f, 1.0f, 1.0f }; // Bounds extent, 1 on flat axes
+	};
+
+	// Attribute encoders over strided arrays, so they read and write interleaved vertices in place.
+	// SSE2 everywhere, AVX2 (and F16C for halves) when the CPU has it, scalar for the tail.
+	PositionQuantization ComputePositionQuantization(const void* positions, size_t stride, size_t count); // XMFLOAT3 or XMFLOAT4 (w ignored)
+	void EncodePositions(const void* positions, size_t stride, size_t count, const PositionQuantization& quantization, void* destination, size_t destinationStride); // -> 4 x UNORM16
+	void EncodeOctahedral(const void* directions, size_t stride, size_t count, void* destination, size_t destinationStride); // Unit XMFLOAT3 -> 2 x SNORM16
+	void EncodeHalf2(const void* values, size_t stride, size_t count, void* destination, size_t destinationStride); // XMFLOAT2 -> 2 x FLOAT16
+	void EncodeColors(const void* colors, size_t stride, size_t count, void* destination, size_t destinationStride); // XMFLOAT4 -> RGBA8 UNORM
+
+	// Scalar decoders, the same math as the shaders; used on the CPU side (picking, bounds) and to check the encoders
+	XMFLOAT3 DecodePosition(const uint16_t encoded[4], const PositionQuantization& quantization);
+	XMFLOAT3 DecodeOctahedral(const int16_t encoded[2]);
+	uint16_t FloatToHalf(float value); // Round to nearest even, like F16C
+	float HalfToFloat(uint16_t value);
+
+	// Whole meshes: 32 -> 12, 32 -> 16 and 44 -> 20 bytes per vertex. Returns the quantization to bind with the mesh.
+	PositionQuantization CompressVertices(const VertexPositionColor* vertices, size_t count, VertexPositionColorPacked* packed);
+	PositionQuantization CompressVertices(const VertexPositionNormalTex* vertices, size_t count, VertexPositionNormalTexPacked* packed);
+	PositionQuantization CompressVertices(const VertexPositionNormalTangentTex* vertices, size_t count, VertexPositionNormalTangentTexPacked* packed);
+
+	bool HasVertexCompressionAVX2(); // Which path the encoders take on this CPU
+}
@@ -2,20 +2,95 @@
 #include <d3d11.h>
 #include <vector>
 #include <string>
+#include <cstdint>
 #include "EngineData.h"
+#include "VertexTraits.h"
 
 
 namespace Graphics
 {
+    // Input slots of split geometry. Slot 1 stays the instance stream (RenderQueue::InstanceSlot).
+    static constexpr UINT PositionStreamSlot = 0;
+    static constexpr UINT AttributeStreamSlot = 2;
+
+    enum class VertexStream : uint32_t
+    {
+        Position = 1 << 0, // POSITION alone, what depth prepasses and shadow maps read
+        Attributes = 1 << 1, // Everything after the position
+        All = Position | Attributes
+    };
+
+    inline bool HasStream(VertexStream streams, VertexStream stream) { return (static_cast<uint32_t>(streams) & static_cast<uint32_t>(stream)) != 0; }
+
     class VertexInputElement
     {
     public:
         VertexInputElement() = default;
 
+        // Whole vertex struct at once, formats and offsets from VertexTraits (checked against the struct at compile time)
+        template <typename TVertex>
+        void AddVertex(UINT slot = 0)
+        {
+            for (D3D11_INPUT_ELEMENT_DESC desc : VertexTraits<TVertex>::GetElements())
+            {
+                desc.InputSlot = slot;
+                inputElementDescriptions.push_back(desc);
+            }
+
+            currentOffset = sizeof(TVertex);
+            SetSlotStride(slot, sizeof(TVertex));
+        }
+
+        // Same struct split in a position stream and an attribute stream (GeometryArena::InitializeSplit).
+        // Pipelines that only declare VertexStream::Position never fetch the attributes.
+        template <typename TVertex>
+        void AddVertexStreams(VertexStream streams = VertexStream::All)
+        {
+            constexpr auto elements = VertexTraits<TVertex>::GetElements();
+            constexpr UINT positionStride = GetPositionStreamStride<TVertex>();
+
+            for (size_t i = 0; i < elements.size(); ++i)
+            {
+                D3D11_INPUT_ELEMENT_DESC desc = elements[i];
+                bool isPosition = (i == 0);
+
+                if (!HasStream(streams, isPosition ? VertexStream::Position : VertexStream::Attributes))
+                    continue;
+
+                desc.InputSlot = isPosition ? PositionStreamSlot : AttributeStreamSlot;
+                desc.AlignedByteOffset = isPosition ? 0 : desc.AlignedByteOffset - positionStride;
+                inputElementDescriptions.push_back(desc);
+            }
+
+            if (HasStream(streams, VertexStream::Position))
+                SetSlotStride(PositionStreamSlot, positionStride);
+            if (HasStream(streams, VertexStream::Attributes))
+                SetSlotStride(AttributeStreamSlot, GetAttributeStreamStride<TVertex>());
+        }
+
+        template <typename TVertex>
+        static VertexInputElement Create(UINT slot = 0)
+        {
+            VertexInputElement layout {};
+            layout.AddVertex<TVertex>(slot);
+            return layout;
+        }
+
+        template <typename TVertex>
+        static VertexInputElement CreateStreams(VertexStream streams = VertexStream::All)
+        {
+            VertexInputElement layout {};
+            layout.AddVertexStreams<TVertex>(streams);
+            return layout;
+        }
+
+        // Element by element, for layouts without a vertex struct. Position and Color are float4, like VertexPositionColor.
         void Add(VertexType type, UINT slot = 0)
         {
             D3D11_INPUT_ELEMENT_DESC desc{};
+            desc.SemanticIndex = 0;
             desc.InputSlot = slot;
+            desc.AlignedByteOffset = currentOffset;
             desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
             desc.InstanceDataStepRate = 0;
 
@@ -24,26 +99,56 @@ namespace Graphics
             case VertexType::Position:
                 desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
                 desc.SemanticName = "POSITION";
-                desc.SemanticIndex = 0;
-                desc.AlignedByteOffset = currentOffset; // 4 * 4 bytes
+                break;
             case VertexType::Normal:
+                desc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+                desc.SemanticName = "NORMAL";
+                break;
             case VertexType::Tangent:
+                desc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+                desc.SemanticName = "TANGENT";
+                break;
             case VertexType::Bitangent:
-                desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+                desc.Format = DXGI_FORMAT_R32G32B32_FLOAT;
+                desc.SemanticName = "BINORMAL";
                 break;
             case VertexType::TextureCoordinate:
                 desc.Format = DXGI_FORMAT_R32G32_FLOAT;
+                desc.SemanticName = "TEXCOORD";
                 break;
             case VertexType::Color:
                 desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
                 desc.SemanticName = "COLOR";
-                desc.SemanticIndex = 0;
-                desc.AlignedByteOffset = currentOffset; // 4 * 4 bytes
                 break;
             }
 
             inputElementDescriptions.push_back(desc);
-            currentOffset += Size(type); 
+            currentOffset += GetVertexFormatSize(desc.Format);
+            SetSlotStride(slot, currentOffset);
+        }
+
+        // Per-instance element, read once every stepRate instances. semanticName must outlive the pipeline (string literal).
+        void AddInstance(const char* semanticName, UINT semanticIndex, DXGI_FORMAT format, UINT size, UINT slot = 1, UINT stepRate = 1)
+        {
+            D3D11_INPUT_ELEMENT_DESC desc{};
+            desc.SemanticName = semanticName;
+            desc.SemanticIndex = semanticIndex;
+            desc.Format = format;
+            desc.InputSlot = slot;
+            desc.AlignedByteOffset = instanceOffset;
+            desc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+            desc.InstanceDataStepRate = stepRate;
+
+            inputElementDescriptions.push_back(desc);
+            instanceOffset += size;
+            SetSlotStride(slot, instanceOffset);
+        }
+
+        // A float4x4 as four float4 rows, semanticName0..3 in the shader
+        void AddInstanceMatrix(const char* semanticName, UINT slot = 1)
+        {
+            for (UINT row = 0; row < 4; ++row)
+                AddInstance(semanticName, row, DXGI_FORMAT_R32G32B32A32_FLOAT, 16, slot);
         }
 
         void Reset()
@@ -51,6 +156,24 @@ namespace Graphics
             inputElementDescriptions.clear();
             semanticStorage.clear();
             currentOffset = 0;
+            instanceOffset = 0;
+            slotStrides.clear();
+        }
+
+        UINT GetInstanceStride() const { return instanceOffset; }
+        UINT GetSlotStride(UINT slot) const { return slot < slotStrides.size() ? slotStrides[slot] : 0; } // 0 for slots the layout does not read
+
+        // One bit per input slot with per-vertex elements, the streams a pipeline built from this layout consumes
+        uint32_t GetVertexSlots() const
+        {
+            uint32_t slots = 0;
+            for (const D3D11_INPUT_ELEMENT_DESC& desc : inputElementDescriptions)
+            {
+                if (desc.InputSlotClass == D3D11_INPUT_PER_VERTEX_DATA)
+                    slots |= 1u << desc.InputSlot;
+            }
+
+            return slots;
         }
 
         const std::vector<D3D11_INPUT_ELEMENT_DESC>& GetInputElementDescriptions() const
@@ -62,19 +185,15 @@ namespace Graphics
         std::vector<D3D11_INPUT_ELEMENT_DESC> inputElementDescriptions;
         std::vector<std::string> semanticStorage;
         UINT currentOffset = 0;
+        UINT instanceOffset = 0; // Per-instance elements live in their own stream
+        std::vector<UINT> slotStrides; // Bytes per vertex (or instance) of every slot the layout reads
 
-        uint32_t Size(VertexType type)
+        void SetSlotStride(UINT slot, UINT stride)
         {
-            switch (type)
-            {
-            case VertexType::Position: return 16;
-            case VertexType::Normal: return 16;
-            case VertexType::TextureCoordinate: return 16;
-            case VertexType::Color: return 16;
-            case VertexType::Tangent: return 16;
-            case VertexType::Bitangent: return 16;
-            default: return 0;
-            }
+            if (slot >= slotStrides.size())
+                slotStrides.resize(slot + 1, 0);
+
+            slotStrides[slot] = stride;
         }
 
     };
@@ -0,0 +1,196 @@
+#pragma once
+#include <d3d11.h>
+#include <array>
+#include <cstddef>
+#include "EngineData.h"
+
+
+namespace Graphics
+{
+    // Bytes the input assembler reads for a vertex format, 0 for formats vertex structs do not use
+    constexpr UINT GetVertexFormatSize(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+        case DXGI_FORMAT_R32G32B32_FLOAT: return 12;
+        case DXGI_FORMAT_R32G32_FLOAT: return 8;
+        case DXGI_FORMAT_R32_FLOAT: return 4;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R16G16B16A16_SNORM: return 8;
+        case DXGI_FORMAT_R16G16_FLOAT:
+        case DXGI_FORMAT_R16G16_UNORM:
+        case DXGI_FORMAT_R16G16_SNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UINT: return 4;
+        default: return 0;
+        }
+    }
+
+    constexpr D3D11_INPUT_ELEMENT_DESC VertexElement(const char* semanticName, DXGI_FORMAT format, size_t offset, UINT semanticIndex = 0)
+    {
+        return { semanticName, semanticIndex, format, 0, static_cast<UINT>(offset), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+    }
+
+    // Per-vertex-struct layout, specialized next to each struct. Unknown types fail to compile instead of
+    // producing an empty layout at runtime.
+    // GetElements() returns by value so the traits stay header-only without out-of-class definitions (C++14).
+    template <typename TVertex>
+    struct VertexTraits;
+
+    template <>
+    struct VertexTraits<VertexPosition>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 1> GetElements()
+        {
+            return { { VertexElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPosition, Position)) } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionTex>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 2> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionTex, Position)),
+                VertexElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, offsetof(VertexPositionTex, TexCoord)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionNormal>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 2> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormal, Position)),
+                VertexElement("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormal, Normal)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionNormalTex>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 3> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormalTex, Position)),
+                VertexElement("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormalTex, Normal)),
+                VertexElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, offsetof(VertexPositionNormalTex, TexCoord)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionNormalTangentTex>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 4> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormalTangentTex, Position)),
+                VertexElement("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormalTangentTex, Normal)),
+                VertexElement("TANGENT", DXGI_FORMAT_R32G32B32_FLOAT, offsetof(VertexPositionNormalTangentTex, Tangent)),
+                VertexElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, offsetof(VertexPositionNormalTangentTex, TexCoord)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionColor>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 2> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R32G32B32A32_FLOAT, offsetof(VertexPositionColor, Position)),
+                VertexElement("COLOR", DXGI_FORMAT_R32G32B32A32_FLOAT, offsetof(VertexPositionColor, Color)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionColorPacked>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 2> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, offsetof(VertexPositionColorPacked, Position)),
+                VertexElement("COLOR", DXGI_FORMAT_R8G8B8A8_UNORM, offsetof(VertexPositionColorPacked, Color)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionNormalTexPacked>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 3> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, offsetof(VertexPositionNormalTexPacked, Position)),
+                VertexElement("NORMAL", DXGI_FORMAT_R16G16_SNORM, offsetof(VertexPositionNormalTexPacked, Normal)),
+                VertexElement("TEXCOORD", DXGI_FORMAT_R16G16_FLOAT, offsetof(VertexPositionNormalTexPacked, TexCoord)),
+            } };
+        }
+    };
+
+    template <>
+    struct VertexTraits<VertexPositionNormalTangentTexPacked>
+    {
+        static constexpr std::array<D3D11_INPUT_ELEMENT_DESC, 4> GetElements()
+        {
+            return { {
+                VertexElement("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, offsetof(VertexPositionNormalTangentTexPacked, Position)),
+                VertexElement("NORMAL", DXGI_FORMAT_R16G16_SNORM, offsetof(VertexPositionNormalTangentTexPacked, Normal)),
+                VertexElement("TANGENT", DXGI_FORMAT_R16G16_SNORM, offsetof(VertexPositionNormalTangentTexPacked, Tangent)),
+                VertexElement("TEXCOORD", DXGI_FORMAT_R16G16_FLOAT, offsetof(VertexPositionNormalTangentTexPacked, TexCoord)),
+            } };
+        }
+    };
+
+    // True when the elements cover the struct byte for byte: no gaps, no overlaps, nothing past the end
+    template <typename TVertex>
+    constexpr bool IsVertexLayoutTight()
+    {
+        constexpr auto elements = VertexTraits<TVertex>::GetElements();
+
+        UINT expectedOffset = 0;
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            UINT size = GetVertexFormatSize(elements[i].Format);
+            if (size == 0 || elements[i].AlignedByteOffset != expectedOffset)
+                return false;
+
+            expectedOffset += size;
+        }
+
+        return expectedOffset == sizeof(TVertex);
+    }
+
+    // Split streams: the first element (the position) alone in one buffer, the rest back to back in another.
+    // Every vertex struct starts with Position, so the split is a byte offset into the interleaved vertex.
+    template <typename TVertex>
+    constexpr UINT GetPositionStreamStride()
+    {
+        constexpr auto elements = VertexTraits<TVertex>::GetElements();
+        return GetVertexFormatSize(elements[0].Format);
+    }
+
+    template <typename TVertex>
+    constexpr UINT GetAttributeStreamStride()
+    {
+        return static_cast<UINT>(sizeof(TVertex)) - GetPositionStreamStride<TVertex>();
+    }
+
+    static_assert(IsVertexLayoutTight<VertexPosition>(), "VertexTraits<VertexPosition> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionTex>(), "VertexTraits<VertexPositionTex> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionNormal>(), "VertexTraits<VertexPositionNormal> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionNormalTex>(), "VertexTraits<VertexPositionNormalTex> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionNormalTangentTex>(), "VertexTraits<VertexPositionNormalTangentTex> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionColor>(), "VertexTraits<VertexPositionColor> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionColorPacked>(), "VertexTraits<VertexPositionColorPacked> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionNormalTexPacked>(), "VertexTraits<VertexPositionNormalTexPacked> does not match the struct");
+    static_assert(IsVertexLayoutTight<VertexPositionNormalTangentTexPacked>(), "VertexTraits<VertexPositionNormalTangentTexPacked> does not match the struct");
+}
@@ -0,0 +1,187 @@
+#include "TestFramework.h"
+#include "Graphics/CommandList.h"
+#include "Graphics/CommandTrace.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+
+using namespace Graphics;
+
+namespace
+{
+	// Records every call that gets through the filter
+	struct RecordingList
+	{
+		NullBackend backend;
+		CommandList commandList;
+		ID3D11Buffer* buffers[3] = {};
+
+		RecordingList()
+		{
+			BackendBufferDesc desc;
+			desc.size = 1024;
+			desc.dynamic = true;
+			for (ID3D11Buffer*& buffer : buffers)
+				buffer = FromBackendHandle<ID3D11Buffer>(backend.CreateBuffer(desc, nullptr));
+
+			backend.SetRecording(true);
+			commandList.Initialize(backend);
+		}
+
+		uint32_t Count(BackendCommandType type) const
+		{
+			uint32_t count = 0;
+			for (const BackendCommand& command : backend.GetCommands())
+				count += (command.type == type) ? 1 : 0;
+			return count;
+		}
+	};
+}
+
+TEST_CASE(RepeatedVertexBufferBindsAreFiltered)
+{
+	RecordingList list;
+
+	list.commandList.BindVertexBuffer(list.buffers[0], 0, 16, 0);
+	list.commandList.BindVertexBuffer(list.buffers[0], 0, 16, 0);
+	CHECK(list.Count(BackendCommandType::SetVertexBuffer) == 1);
+
+	// Any difference in buffer, stride, offset or slot reaches the backend
+	list.commandList.BindVertexBuffer(list.buffers[1], 0, 16, 0);
+	list.commandList.BindVertexBuffer(list.buffers[1], 0, 32, 0);
+	list.commandList.BindVertexBuffer(list.buffers[1], 0, 32, 64);
+	list.commandList.BindVertexBuffer(list.buffers[1], 1, 32, 64);
+	CHECK(list.Count(BackendCommandType::SetVertexBuffer) == 5);
+
+	const CommandListStats& stats = list.commandList.GetStats();
+	CHECK(stats.submitted == 5);
+	CHECK(stats.filtered == 1);
+}
+
+TEST_CASE(InvalidSlotsAndNullBuffersNeverReachTheBackend)
+{
+	RecordingList list;
+
+	list.commandList.BindVertexBuffer(nullptr, 0, 16, 0);
+	list.commandList.BindVertexBuffer(list.buffers[0], D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, 16, 0);
+	list.commandList.SetIndexBuffer(nullptr, DXGI_FORMAT_R16_UINT, 0);
+	list.commandList.SetConstantBuffer(ConstantAllocation(), 0);
+
+	CHECK(list.backend.GetCommands().empty());
+	CHECK(list.commandList.GetStats().submitted == 0);
+	CHECK(list.commandList.GetStats().filtered == 0);
+}
+
+TEST_CASE(IndexBufferFilterComparesFormatAndOffset)
+{
+	RecordingList list;
+
+	list.commandList.SetIndexBuffer(list.buffers[0], DXGI_FORMAT_R16_UINT, 0);
+	list.commandList.SetIndexBuffer(list.buffers[0], DXGI_FORMAT_R16_UINT, 0);
+	list.commandList.SetIndexBuffer(list.buffers[0], DXGI_FORMAT_R32_UINT, 0);
+	list.commandList.SetIndexBuffer(list.buffers[0], DXGI_FORMAT_R32_UINT, 128);
+
+	CHECK(list.Count(BackendCommandType::SetIndexBuffer) == 3);
+	CHECK(list.backend.GetCommands().back().args[0] == static_cast<uint32_t>(BackendFormat::R32UInt));
+	CHECK(list.backend.GetCommands().back().args[1] == 128);
+}
+
+TEST_CASE(ConstantRangesAreFilteredPerRange)
+{
+	RecordingList list;
+
+	ConstantAllocation first;
+	first.buffer = list.buffers[0];
+	first.offset = 0;
+	first.size = 256;
+
+	ConstantAllocation second = first;
+	second.offset = 256;
+
+	list.commandList.SetConstantBuffer(first, 1);
+	list.commandList.SetConstantBuffer(first, 1);
+	list.commandList.SetConstantBuffer(second, 1); // Same buffer, other range
+	list.commandList.SetConstantBuffer(second, 2); // Other slot
+	CHECK(list.Count(BackendCommandType::SetConstantBuffer) == 3);
+
+	const BackendCommand& last = list.backend.GetCommands().back();
+	CHECK(last.args[0] == 2);
+	CHECK(last.args[1] == second.GetFirstConstant());
+	CHECK(last.args[2] == 16);
+}
+
+TEST_CASE(TopologyAndViewportAreFiltered)
+{
+	RecordingList list;
+
+	list.commandList.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	list.commandList.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	list.commandList.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	list.commandList.SetViewport(1200.0f, 820.0f);
+	list.commandList.SetViewport(1200.0f, 820.0f);
+	list.commandList.SetViewport(800.0f, 820.0f);
+
+	CHECK(list.Count(BackendCommandType::SetTopology) == 2);
+	CHECK(list.Count(BackendCommandType::SetViewport) == 2);
+	CHECK(list.commandList.GetStats().filtered == 2);
+}
+
+TEST_CASE(InvalidateStateForgetsTheShadow)
+{
+	RecordingList list;
+
+	list.commandList.BindVertexBuffer(list.buffers[0], 0, 16, 0);
+	list.commandList.SetIndexBuffer(list.buffers[1], DXGI_FORMAT_R16_UINT, 0);
+
+	// Something bound behind the list's back, e.g. a deferred context that was reset by FinishCommandList
+	list.commandList.InvalidateState();
+
+	list.commandList.BindVertexBuffer(list.buffers[0], 0, 16, 0);
+	list.commandList.SetIndexBuffer(list.buffers[1], DXGI_FORMAT_R16_UINT, 0);
+	CHECK(list.Count(BackendCommandType::SetVertexBuffer) == 2);
+	CHECK(list.Count(BackendCommandType::SetIndexBuffer) == 2);
+	CHECK(list.commandList.GetStats().filtered == 0);
+}
+
+TEST_CASE(DrawsAreNeverFiltered)
+{
+	RecordingList list;
+
+	list.commandList.DrawIndexed(36, 0, 0);
+	list.commandList.DrawIndexed(36, 0, 0);
+	list.commandList.DrawIndexedInstanced(36, 4, 0, 0, 0);
+
+	CHECK(list.Count(BackendCommandType::DrawIndexed) == 3);
+
+	const CommandListStats& stats = list.commandList.GetStats();
+	CHECK(stats.draws == 3);
+	CHECK(stats.instances == 6);
+	CHECK(stats.submitted == 3);
+
+	list.commandList.ResetStats();
+	CHECK(list.commandList.GetStats().draws == 0);
+}
+
+TEST_CASE(FilteredCallsAreCapturedAsRedundant)
+{
+	NullBackend backend;
+	CommandCapture capture(backend);
+
+	BackendBufferDesc desc;
+	desc.size = 256;
+	ID3D11Buffer* buffer = FromBackendHandle<ID3D11Buffer>(capture.CreateBuffer(desc, nullptr));
+
+	CommandList commandList;
+	commandList.Initialize(capture);
+	commandList.SetCapture(&capture);
+
+	commandList.BindVertexBuffer(buffer, 0, 16, 0);
+	commandList.BindVertexBuffer(buffer, 0, 16, 0);
+	commandList.BindVertexBuffer(buffer, 0, 16, 0);
+
+	TraceStats stats;
+	CHECK(capture.GetTrace().Analyze(stats));
+	CHECK(stats.opCounts[static_cast<uint32_t>(TraceOp::SetVertexBuffer)] == 1);
+	CHECK(stats.filteredBinds == 2);
+	CHECK(stats.redundantBinds == 0);
+}
@@ -0,0 +1,350 @@
+#include "TestFramework.h"
+#include "Graphics/CommandTrace.h"
+#include "Graphics/NullBackend.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace Graphics;
+
+namespace
+{
+	const uint32_t FrameCount = 8;
+	const uint32_t SwapFrame = 3; // The vertex buffer is replaced before this frame is drawn
+
+	// A small scene driven through a capture: targets, a pipeline, a vertex buffer replaced halfway, a dynamic constant
+	// buffer written every frame and a copy into a static one. Frame f draws 1 + f instances and uploads f.
+	struct Scene
+	{
+		NullBackend backend;
+		CommandCapture capture;
+		BackendHandle color = 0;
+		BackendHandle depth = 0;
+		BackendHandle pipeline = 0;
+		BackendHandle vertexBuffer = 0;
+		BackendHandle constants = 0;
+		BackendHandle copy = 0;
+
+		Scene() : capture(backend)
+		{
+			backend.SetRecording(true);
+
+			BackendTextureDesc texture;
+			texture.width = 64;
+			texture.height = 32;
+			color = capture.CreateTexture(texture);
+			texture.format = BackendFormat::D24UnormS8UInt;
+			depth = capture.CreateTexture(texture);
+
+			BackendPipelineDesc desc;
+			desc.elements.push_back({ "POSITION", 0, BackendFormat::RGBA32Float, 0, 0, false });
+			desc.vertexShaderEntry = "VS";
+			desc.pixelShaderEntry = "PS";
+			pipeline = capture.CreatePipeline(desc);
+
+			vertexBuffer = CreateVertexBuffer(1.0f);
+
+			BackendBufferDesc buffer;
+			buffer.kind = BackendBufferKind::Constant;
+			buffer.size = 16;
+			buffer.dynamic = true;
+			constants = capture.CreateBuffer(buffer, nullptr);
+			buffer.dynamic = false;
+			copy = capture.CreateBuffer(buffer, nullptr);
+		}
+
+		BackendHandle CreateVertexBuffer(float value)
+		{
+			const float vertices[12] = { value, value, value, value, value, value, value, value, value, value, value, value };
+			BackendBufferDesc desc;
+			desc.size = sizeof(vertices);
+			return capture.CreateBuffer(desc, vertices);
+		}
+
+		void Frame(uint32_t frame)
+		{
+			if (frame == SwapFrame)
+			{
+				capture.Destroy(vertexBuffer);
+				vertexBuffer = CreateVertexBuffer(2.0f);
+			}
+
+			uint32_t* memory = static_cast<uint32_t*>(capture.Map(constants, BackendMap::Discard));
+			for (uint32_t i = 0; i < 4; ++i)
+				memory[i] = frame;
+			capture.Unmap(constants, 0, 16);
+			capture.CopyBuffer(copy, 0, constants, 0, 16);
+			capture.UpdateBuffer(copy, 4, &frame, 4);
+
+			const float clear[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			capture.SetRenderTargets(color, depth);
+			capture.SetViewport(64.0f, 32.0f);
+			capture.SetTopology(BackendTopology::TriangleList);
+			capture.ClearColor(color, clear);
+			capture.ClearDepth(depth, 1.0f);
+			capture.SetPipeline(pipeline);
+			capture.SetVertexBuffer(0, vertexBuffer, 16, 0);
+			capture.SetConstantBuffer(0, constants, 0, 0);
+			capture.DrawIndexed(3, 1 + frame, 0, 0, 0);
+			capture.Present(color);
+		}
+	};
+
+	bool SameCommands(const std::vector<BackendCommand>& a, const std::vector<BackendCommand>& b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (a[i].type != b[i].type || a[i].handle != b[i].handle || a[i].secondHandle != b[i].secondHandle || memcmp(a[i].args, b[i].args, sizeof(a[i].args)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t Count(const NullBackend& backend, BackendCommandType type)
+	{
+		uint32_t count = 0;
+		for (const BackendCommand& command : backend.GetCommands())
+			count += (command.type == type) ? 1 : 0;
+		return count;
+	}
+
+	// A trace of hand-written records, for the cases a capture never produces
+	struct Records
+	{
+		CommandTrace trace;
+
+		void CreateBuffer(uint32_t id, uint32_t size, bool dynamic, const uint8_t* data, uint32_t dataSize)
+		{
+			TraceRecord record;
+			record.op = TraceOp::CreateBuffer;
+			record.id = id;
+			record.buffer.kind = BackendBufferKind::Constant;
+			record.buffer.size = size;
+			record.buffer.dynamic = dynamic;
+			record.data = data;
+			record.dataSize = dataSize;
+			trace.Write(record);
+		}
+
+		void Upload(TraceOp op, uint32_t id, uint32_t offset, const uint8_t* data, uint32_t size)
+		{
+			TraceRecord record;
+			record.op = op;
+			record.id = id;
+			record.args[0] = (op == TraceOp::WriteBuffer) ? static_cast<uint32_t>(BackendMap::Discard) : offset;
+			record.args[1] = (op == TraceOp::WriteBuffer) ? offset : 0;
+			record.data = data;
+			record.dataSize = size;
+			trace.Write(record);
+		}
+
+		void Copy(uint32_t destination, uint32_t destinationOffset, uint32_t source, uint32_t sourceOffset, uint32_t size)
+		{
+			TraceRecord record;
+			record.op = TraceOp::CopyBuffer;
+			record.id = destination;
+			record.secondId = source;
+			record.args[0] = destinationOffset;
+			record.args[1] = sourceOffset;
+			record.args[2] = size;
+			trace.Write(record);
+		}
+	};
+}
+
+TEST_CASE(SavedTraceReplaysTheCapturedCommands)
+{
+	Scene scene;
+	for (uint32_t frame = 0; frame < FrameCount; ++frame)
+		scene.Frame(frame);
+
+	const char* const path = "CommandTraceRoundTrip.bin";
+	std::remove(path);
+	CHECK(scene.capture.Save(path));
+
+	CommandTrace trace;
+	CHECK(trace.Load(path));
+	CHECK(trace.GetData() == scene.capture.GetTrace().GetData());
+	std::remove(path);
+
+	TraceStats stats;
+	CHECK(trace.Analyze(stats));
+	CHECK(stats.frames == FrameCount);
+	CHECK(stats.draws == FrameCount);
+	CHECK(stats.instances == FrameCount * (FrameCount + 1) / 2);
+	CHECK(stats.opCounts[static_cast<uint32_t>(TraceOp::CreateBuffer)] == 4);
+	CHECK(stats.peakResources == 6);
+
+	// NullBackend hands out the same handles for the same creation order, so the streams match call for call
+	NullBackend backend;
+	backend.SetRecording(true);
+	CommandReplayer replayer;
+	CHECK(replayer.Replay(trace, backend));
+	CHECK(SameCommands(backend.GetCommands(), scene.backend.GetCommands()));
+
+	const TraceReplayStats& replay = replayer.GetStats();
+	CHECK(replay.frames == FrameCount);
+	CHECK(replay.missingResources == 0);
+	CHECK(replay.malformedRecords == 0);
+	CHECK(replayer.GetLastPresented() == scene.color);
+	CHECK(backend.GetStats().bytesUploaded == scene.backend.GetStats().bytesUploaded);
+
+	replayer.Release();
+	CHECK(backend.GetStats().liveResources == 0);
+}
+
+TEST_CASE(ExtractedRangeStartsFromTheStateBeforeIt)
+{
+	Scene scene;
+	for (uint32_t frame = 0; frame < FrameCount; ++frame)
+		scene.Frame(frame);
+
+	const uint32_t firstFrame = 4;
+	CommandTrace range;
+	CHECK(scene.capture.GetTrace().Extract(firstFrame, 2, range));
+
+	// Live resources first, numbered again from 1, buffers with what the frames before left in them
+	TraceReader reader(range);
+	TraceRecord record;
+	uint32_t created = 0;
+	uint32_t presents = 0;
+	bool snapshotContents = true;
+	while (reader.Next(record))
+	{
+		if (record.op == TraceOp::CreateBuffer || record.op == TraceOp::CreateTexture || record.op == TraceOp::CreatePipeline)
+			created++;
+		if (record.op == TraceOp::Present)
+			presents++;
+
+		if (record.op == TraceOp::CreateBuffer && record.buffer.kind == BackendBufferKind::Constant)
+		{
+			uint32_t words[4] = {};
+			snapshotContents = snapshotContents && record.dataSize == sizeof(words);
+			if (record.dataSize == sizeof(words))
+				memcpy(words, record.data, sizeof(words));
+			snapshotContents = snapshotContents && words[0] == firstFrame - 1 && words[2] == firstFrame - 1;
+		}
+	}
+	CHECK(reader.IsValid());
+	CHECK(created == 6);
+	CHECK(presents == 2);
+	CHECK(snapshotContents);
+
+	NullBackend backend;
+	backend.SetRecording(true);
+	CommandReplayer replayer;
+	CHECK(replayer.Replay(range, backend));
+	CHECK(replayer.GetStats().frames == 2);
+	CHECK(replayer.GetStats().missingResources == 0);
+
+	std::vector<uint32_t> instances;
+	for (const BackendCommand& command : backend.GetCommands())
+	{
+		if (command.type == BackendCommandType::DrawIndexed)
+			instances.push_back(command.args[1]);
+	}
+	CHECK(instances.size() == 2);
+	CHECK(instances.size() == 2 && instances[0] == 1 + firstFrame && instances[1] == 2 + firstFrame);
+
+	// Replaying a range of the whole trace does the same
+	NullBackend direct;
+	direct.SetRecording(true);
+	CommandReplayer directReplayer;
+	CHECK(directReplayer.Replay(scene.capture.GetTrace(), direct, firstFrame, 2));
+	CHECK(SameCommands(direct.GetCommands(), backend.GetCommands()));
+
+	CHECK(!scene.capture.GetTrace().Extract(FrameCount, 1, range)); // Past the end
+}
+
+TEST_CASE(TruncatedTracesAreRejected)
+{
+	Scene scene;
+	for (uint32_t frame = 0; frame < 2; ++frame)
+		scene.Frame(frame);
+
+	const std::vector<uint8_t>& data = scene.capture.GetTrace().GetData();
+	CommandTrace truncated;
+	truncated.Append(data.data() + 8, data.data() + data.size() - 3); // After the header, the last Present cut short
+
+	TraceStats stats;
+	CHECK(!truncated.Analyze(stats));
+
+	NullBackend backend;
+	CommandReplayer replayer;
+	CHECK(!replayer.Replay(truncated, backend));
+	CHECK(replayer.GetStats().frames == 1);
+
+	// A file cut short inside the header
+	const char* const path = "CommandTraceTruncated.bin";
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data.data()), 6);
+	}
+
+	CommandTrace loaded = scene.capture.GetTrace();
+	CHECK(!loaded.Load(path));
+	CHECK(loaded.GetSize() == 8); // Cleared back to an empty trace
+	std::remove(path);
+}
+
+TEST_CASE(OutOfRangeRecordsAreRejectedOrSkipped)
+{
+	const uint8_t bytes[32] = {};
+
+	// Initial data must cover the whole buffer
+	{
+		Records records;
+		records.CreateBuffer(1, 16, false, bytes, 8);
+
+		NullBackend backend;
+		CommandReplayer replayer;
+		CHECK(!replayer.Replay(records.trace, backend));
+		CHECK(backend.GetStats().buffersCreated == 0);
+	}
+
+	// Created ids must come in sequence, a huge one is never used to size anything
+	{
+		Records records;
+		records.CreateBuffer(1, 16, false, nullptr, 0);
+		records.CreateBuffer(0xFFFFFFF0u, 16, false, nullptr, 0);
+
+		TraceStats stats;
+		CHECK(!records.trace.Analyze(stats));
+
+		NullBackend backend;
+		CommandReplayer replayer;
+		CHECK(!replayer.Replay(records.trace, backend));
+		CHECK(backend.GetStats().buffersCreated == 1);
+		CHECK(replayer.GetHandle(0xFFFFFFF0u) == 0);
+	}
+
+	// Uploads and copies past the end of their buffer are skipped and counted, the rest still replays
+	{
+		Records records;
+		records.CreateBuffer(1, 16, true, nullptr, 0);
+		records.CreateBuffer(2, 8, false, nullptr, 0);
+		records.Upload(TraceOp::WriteBuffer, 1, 12, bytes, 8);
+		records.Upload(TraceOp::WriteBuffer, 1, 0xFFFFFFF8u, bytes, 16); // Offset plus size wraps in 32 bits
+		records.Upload(TraceOp::UpdateBuffer, 2, 4, bytes, 8);
+		records.Copy(2, 0, 1, 0, 16);
+		records.Copy(1, 0, 2, 4, 8);
+		records.Upload(TraceOp::WriteBuffer, 1, 0, bytes, 16);
+		records.Upload(TraceOp::UpdateBuffer, 2, 0, bytes, 8);
+		records.Copy(1, 8, 2, 0, 8);
+
+		NullBackend backend;
+		backend.SetRecording(true);
+		CommandReplayer replayer;
+		CHECK(replayer.Replay(records.trace, backend));
+		CHECK(replayer.GetStats().malformedRecords == 5);
+		CHECK(Count(backend, BackendCommandType::Map) == 1);
+		CHECK(Count(backend, BackendCommandType::UpdateBuffer) == 1);
+		CHECK(Count(backend, BackendCommandType::CopyBuffer) == 1);
+		CHECK(backend.GetStats().bytesUploaded == 24);
+	}
+}
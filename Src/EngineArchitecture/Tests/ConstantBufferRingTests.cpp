@@ -0,0 +1,186 @@
+#include "TestFramework.h"
+#include "Graphics/ConstantBufferRing.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+#include <cstring>
+
+using namespace Graphics;
+
+namespace
+{
+	// Map modes the ring asked for, in order
+	std::vector<BackendMap> GetMapModes(const NullBackend& backend)
+	{
+		std::vector<BackendMap> modes;
+		for (const BackendCommand& command : backend.GetCommands())
+		{
+			if (command.type == BackendCommandType::Map)
+				modes.push_back(static_cast<BackendMap>(command.args[0]));
+		}
+		return modes;
+	}
+
+	bool Allocate(ConstantBufferRing& ring, uint32_t size, ConstantAllocation& allocation)
+	{
+		std::vector<uint8_t> data(size, static_cast<uint8_t>(size));
+		return ring.Allocate(nullptr, data.data(), size, allocation);
+	}
+}
+
+TEST_CASE(AllocationsAreAlignedTo256Bytes)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	ConstantBufferRing ring;
+	CHECK(ring.Initialize(device, 4096, 1));
+
+	const uint32_t sizes[] = { 1, 64, 255, 256, 257, 1000 };
+	uint32_t expectedOffset = 0;
+
+	for (uint32_t size : sizes)
+	{
+		ConstantAllocation allocation;
+		CHECK(Allocate(ring, size, allocation));
+		CHECK(allocation.IsValid());
+		CHECK(allocation.offset == expectedOffset);
+		CHECK(allocation.offset % ConstantBufferRing::Alignment == 0);
+		CHECK(allocation.size == ConstantBufferRing::AlignSize(size));
+		CHECK(allocation.GetFirstConstant() == allocation.offset / 16);
+		CHECK(allocation.GetNumConstants() % 16 == 0);
+
+		expectedOffset += allocation.size;
+	}
+
+	CHECK(ring.GetStats().allocations == 6);
+	CHECK(ring.GetStats().bytesAllocated == expectedOffset);
+}
+
+TEST_CASE(DataLandsAtTheAllocationOffset)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	ConstantBufferRing ring;
+	CHECK(ring.Initialize(device, 1024, 1));
+
+	const float first[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+	const float second[4] = { 5.0f, 6.0f, 7.0f, 8.0f };
+
+	ConstantAllocation a;
+	ConstantAllocation b;
+	CHECK(ring.Allocate(nullptr, first, sizeof(first), a));
+	CHECK(ring.Allocate(nullptr, second, sizeof(second), b));
+	CHECK(a.buffer == b.buffer);
+
+	const uint8_t* memory = static_cast<const uint8_t*>(backend.Map(ToBackendHandle(a.buffer), BackendMap::NoOverwrite));
+	CHECK(memory != nullptr);
+	CHECK(memcmp(memory + a.offset, first, sizeof(first)) == 0);
+	CHECK(memcmp(memory + b.offset, second, sizeof(second)) == 0);
+}
+
+TEST_CASE(OversizedAllocationFails)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	ConstantBufferRing ring;
+	CHECK(ring.Initialize(device, 512, 2));
+
+	ConstantAllocation allocation;
+	CHECK(!Allocate(ring, 513, allocation));
+	CHECK(!allocation.IsValid());
+	CHECK(ring.GetStats().allocations == 0);
+}
+
+TEST_CASE(FullPageWrapsOntoTheNextPage)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+	backend.SetRecording(true);
+
+	ConstantBufferRing ring;
+	CHECK(ring.Initialize(device, 1024, 2)); // Four 256-byte slots per page
+
+	ConstantAllocation allocations[5];
+	for (ConstantAllocation& allocation : allocations)
+		CHECK(Allocate(ring, 200, allocation));
+
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		CHECK(allocations[i].buffer == allocations[0].buffer);
+		CHECK(allocations[i].offset == i * 256);
+	}
+
+	CHECK(allocations[4].buffer != allocations[0].buffer);
+	CHECK(allocations[4].offset == 0);
+
+	// First write into each page discards, appends after it never do
+	std::vector<BackendMap> modes = GetMapModes(backend);
+	CHECK(modes.size() == 5);
+	CHECK(modes[0] == BackendMap::Discard);
+	CHECK(modes[1] == BackendMap::NoOverwrite);
+	CHECK(modes[3] == BackendMap::NoOverwrite);
+	CHECK(modes[4] == BackendMap::Discard);
+	CHECK(ring.GetStats().discards == 2);
+}
+
+TEST_CASE(WrapOntoPageOfTheCurrentFrameDiscards)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	ConstantBufferRing ring;
+	CHECK(ring.Initialize(device, 512, 2));
+
+	ring.BeginFrame(nullptr);
+
+	// Page 0, page 1, then back onto page 0 within the same frame: its data may still be read, it must be renamed
+	ConstantAllocation allocation;
+	for (uint32_t i = 0; i < 4; ++i)
+		CHECK(Allocate(ring, 256, allocation));
+	CHECK(ring.GetStats().discards == 2);
+
+	backend.SetRecording(true);
+	CHECK(Allocate(ring, 256, allocation));
+	CHECK(allocation.offset == 0);
+	CHECK(GetMapModes(backend).back() == BackendMap::Discard);
+	CHECK(ring.GetStats().discards == 3);
+}
+
+TEST_CASE(PagesOfRetiredFramesAreAppendedWithoutDiscard)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	ConstantBufferRing ring;
+	CHECK(ring.Initialize(device, 512, 2));
+
+	ConstantAllocation allocation;
+
+	ring.BeginFrame(nullptr);
+	for (uint32_t i = 0; i < 4; ++i)
+		CHECK(Allocate(ring, 256, allocation)); // Both pages written in frame 1
+	ring.EndFrame(nullptr); // A backend has finished the frame once it was presented
+
+	ring.BeginFrame(nullptr);
+	CHECK(ring.GetStats().discards == 0); // Reset per frame
+
+	backend.SetRecording(true);
+	for (uint32_t i = 0; i < 4; ++i)
+		CHECK(Allocate(ring, 256, allocation));
+
+	// Frame 1 retired: wrapping onto either page appends without renaming
+	for (BackendMap mode : GetMapModes(backend))
+		CHECK(mode == BackendMap::NoOverwrite);
+	CHECK(ring.GetStats().discards == 0);
+	CHECK(ring.GetStats().allocations == 4);
+	ring.EndFrame(nullptr);
+}
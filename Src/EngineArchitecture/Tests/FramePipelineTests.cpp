@@ -0,0 +1,224 @@
+#include "TestFramework.h"
+#include "Core/FramePipeline.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Core;
+
+namespace
+{
+	// What a frame carries from update to render: enough values that a half-written slot would show
+	struct Frame
+	{
+		uint64_t frameIndex = 0;
+		std::vector<uint64_t> transforms;
+	};
+
+	// Simulated stage cost. Sleeping rather than spinning, so the two stages overlap even on a single core.
+	void Spend(double milliseconds)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(milliseconds));
+	}
+
+	double Elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Fill(Frame& frame, uint64_t frameIndex)
+	{
+		frame.frameIndex = frameIndex;
+		frame.transforms.resize(256);
+		for (size_t i = 0; i < frame.transforms.size(); ++i)
+			frame.transforms[i] = frameIndex * 1000 + i;
+	}
+
+	bool IsIntact(const Frame& frame, uint64_t frameIndex)
+	{
+		if (frame.frameIndex != frameIndex || frame.transforms.size() != 256)
+			return false;
+
+		for (size_t i = 0; i < frame.transforms.size(); ++i)
+		{
+			if (frame.transforms[i] != frameIndex * 1000 + i)
+				return false;
+		}
+		return true;
+	}
+
+	// Wall time of frameCount frames with the given stage costs
+	double RunFrames(uint32_t framesInFlight, uint32_t frameCount, double updateMilliseconds, double renderMilliseconds, FramePipelineStats& stats)
+	{
+		FramePipeline<Frame> pipeline;
+		pipeline.Start(framesInFlight, [updateMilliseconds](Frame& frame, uint64_t frameIndex)
+		{
+			Spend(updateMilliseconds);
+			Fill(frame, frameIndex);
+		});
+
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < frameCount; ++i)
+			pipeline.RenderFrame([renderMilliseconds](const Frame&, uint64_t) { Spend(renderMilliseconds); });
+		double milliseconds = Elapsed(start);
+
+		pipeline.Stop();
+		stats = pipeline.GetStats();
+		return milliseconds;
+	}
+}
+
+TEST_CASE(StartRejectsBadArguments)
+{
+	FramePipeline<Frame> pipeline;
+	CHECK(!pipeline.Start(0, [](Frame&, uint64_t) {}));
+	CHECK(!pipeline.Start(2, nullptr));
+
+	CHECK(pipeline.Start(2, [](Frame&, uint64_t) {}));
+	CHECK(!pipeline.Start(2, [](Frame&, uint64_t) {})); // Already running
+	CHECK(pipeline.GetFramesInFlight() == 2);
+
+	pipeline.Stop();
+	CHECK(!pipeline.RenderFrame([](const Frame&, uint64_t) {}));
+
+	// Restartable once stopped
+	CHECK(pipeline.Start(3, [](Frame&, uint64_t) {}));
+	CHECK(pipeline.RenderFrame([](const Frame&, uint64_t) {}));
+	pipeline.Stop();
+}
+
+TEST_CASE(FramesRenderInOrderAndIntact)
+{
+	for (uint32_t framesInFlight = 1; framesInFlight <= 3; ++framesInFlight)
+	{
+		FramePipeline<Frame> pipeline;
+		CHECK(pipeline.Start(framesInFlight, Fill));
+
+		// Uneven costs on both sides so the two threads interleave differently from frame to frame
+		bool inOrder = true;
+		bool intact = true;
+		for (uint64_t expected = 0; expected < 200; ++expected)
+		{
+			pipeline.RenderFrame([&](const Frame& frame, uint64_t frameIndex)
+			{
+				inOrder = inOrder && frameIndex == expected;
+				intact = intact && IsIntact(frame, frameIndex);
+				if (expected % 7 == 0)
+					Spend(0.5);
+			});
+		}
+
+		CHECK(inOrder);
+		CHECK(intact);
+		pipeline.Stop();
+
+		FramePipelineStats stats = pipeline.GetStats();
+		CHECK(stats.framesRendered == 200);
+		CHECK(stats.framesUpdated >= 200);
+		CHECK(stats.framesUpdated <= 200 + framesInFlight); // Finished but never rendered, dropped by Stop()
+	}
+}
+
+TEST_CASE(UpdateRunsAtMostFramesInFlightAhead)
+{
+	for (uint32_t framesInFlight = 1; framesInFlight <= 3; ++framesInFlight)
+	{
+		std::atomic<uint64_t> updated { 0 };
+		std::atomic<bool> inUpdate { false };
+
+		FramePipeline<Frame> pipeline;
+		CHECK(pipeline.Start(framesInFlight, [&updated, &inUpdate](Frame& frame, uint64_t frameIndex)
+		{
+			inUpdate = true;
+			Fill(frame, frameIndex);
+			inUpdate = false;
+			updated++;
+		}));
+
+		// While frame N renders its slot is taken, so update can finish at most frames N + 1 .. N + framesInFlight - 1
+		bool bounded = true;
+		bool overlapped = false;
+		for (uint64_t frame = 0; frame < 100; ++frame)
+		{
+			pipeline.RenderFrame([&](const Frame&, uint64_t frameIndex)
+			{
+				Spend(0.2); // Give update every chance to run past the limit
+				bounded = bounded && updated.load() <= frameIndex + framesInFlight;
+				overlapped = overlapped || inUpdate.load();
+			});
+		}
+
+		CHECK(bounded);
+		if (framesInFlight == 1)
+			CHECK(!overlapped); // One slot: the stages run back to back, never at the same time
+		pipeline.Stop();
+	}
+}
+
+TEST_CASE(StagesOverlapWithSimulatedCosts)
+{
+	const uint32_t frameCount = 40;
+	const double stageMilliseconds = 4.0;
+	const double serial = frameCount * 2.0 * stageMilliseconds;
+
+	FramePipelineStats stats;
+	double backToBack = RunFrames(1, frameCount, stageMilliseconds, stageMilliseconds, stats);
+	CHECK(backToBack >= 0.95 * serial);
+
+	// Balanced stages: ideally one stage per frame plus the first update. Loose bound, sleeps overshoot on busy machines.
+	double doubleBuffered = RunFrames(2, frameCount, stageMilliseconds, stageMilliseconds, stats);
+	CHECK(doubleBuffered < 0.8 * serial);
+	CHECK(doubleBuffered < backToBack);
+
+	double tripleBuffered = RunFrames(3, frameCount, stageMilliseconds, stageMilliseconds, stats);
+	CHECK(tripleBuffered < 0.8 * serial);
+}
+
+TEST_CASE(StallsShowWhichStageBounds)
+{
+	const uint32_t frameCount = 30;
+
+	// Render bound: update finishes early and waits for a slot, render never waits for a frame
+	FramePipelineStats renderBound;
+	RunFrames(2, frameCount, 1.0, 6.0, renderBound);
+	CHECK(renderBound.updateStall.GetAverage() > renderBound.renderStall.GetAverage());
+	CHECK(renderBound.addedLatency.GetAverage() > 2.0); // Finished frames sit queued behind the one rendering
+
+	// Update bound: render waits for every frame, frames go out as soon as they are finished
+	FramePipelineStats updateBound;
+	RunFrames(2, frameCount, 6.0, 1.0, updateBound);
+	CHECK(updateBound.renderStall.GetAverage() > updateBound.updateStall.GetAverage());
+	CHECK(updateBound.addedLatency.GetAverage() < renderBound.addedLatency.GetAverage());
+
+	for (const FramePipelineStats* stats : { &renderBound, &updateBound })
+	{
+		CHECK(stats->framesRendered == frameCount);
+		CHECK(stats->render.samples == frameCount);
+		CHECK(stats->latency.samples == frameCount);
+		CHECK(stats->latency.GetAverage() >= stats->update.GetAverage() + stats->render.GetAverage() - 0.01);
+		CHECK(stats->update.maxMilliseconds >= stats->update.GetAverage());
+	}
+}
+
+TEST_CASE(StopWakesABlockedUpdate)
+{
+	// Nothing is ever rendered: update fills every slot and blocks on the next one, Stop() must still join it
+	for (uint32_t round = 0; round < 20; ++round)
+	{
+		std::atomic<uint64_t> updated { 0 };
+		FramePipeline<Frame> pipeline;
+		CHECK(pipeline.Start(1 + round % 3, [&updated](Frame& frame, uint64_t frameIndex)
+		{
+			Fill(frame, frameIndex);
+			updated++;
+		}));
+
+		while (updated.load() < 1 + round % 3)
+			std::this_thread::yield();
+
+		pipeline.Stop();
+		CHECK(updated.load() == 1 + round % 3);
+		CHECK(pipeline.GetStats().framesRendered == 0);
+	}
+}
@@ -0,0 +1,229 @@
+#include "TestFramework.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/RangeAllocator.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+
+using namespace Graphics;
+
+namespace
+{
+	struct Vertex
+	{
+		float position[4];
+		float color[4];
+	};
+
+	// A quad: 4 vertices, 6 indices
+	GeometryHandle AllocateQuad(GeometryArena& arena)
+	{
+		const Vertex vertices[4] = {};
+		const uint32_t indices[6] = { 0, 1, 2, 2, 1, 3 };
+		return arena.Allocate(nullptr, vertices, 4, indices, 6);
+	}
+}
+
+TEST_CASE(RangesAreFirstFit)
+{
+	RangeAllocator ranges;
+	ranges.Reset(100);
+
+	CHECK(ranges.Allocate(0) == RangeAllocator::InvalidOffset);
+	CHECK(ranges.Allocate(30) == 0);
+	CHECK(ranges.Allocate(30) == 30);
+	CHECK(ranges.Allocate(30) == 60);
+	CHECK(ranges.Allocate(20) == RangeAllocator::InvalidOffset);
+	CHECK(ranges.GetUsed() == 90);
+	CHECK(ranges.GetLargestFreeBlock() == 10);
+
+	ranges.Free(0, 30);
+	CHECK(ranges.Allocate(10) == 0); // First block that fits, not the best fit
+	CHECK(ranges.GetFreeBlockCount() == 2);
+}
+
+TEST_CASE(FreedRangesCoalesce)
+{
+	RangeAllocator ranges;
+	ranges.Reset(90);
+
+	uint32_t a = ranges.Allocate(30);
+	uint32_t b = ranges.Allocate(30);
+	uint32_t c = ranges.Allocate(30);
+	CHECK(ranges.GetFreeBlockCount() == 0);
+
+	ranges.Free(a, 30);
+	ranges.Free(c, 30);
+	CHECK(ranges.GetFreeBlockCount() == 2);
+
+	ranges.Free(b, 30); // Merges with both neighbours
+	CHECK(ranges.GetFreeBlockCount() == 1);
+	CHECK(ranges.GetLargestFreeBlock() == 90);
+	CHECK(ranges.GetUsed() == 0);
+}
+
+TEST_CASE(MeshesArePackedIntoOneBuffer)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	GeometryArena arena;
+	CHECK(arena.Initialize(device, sizeof(Vertex), 64, 128));
+
+	GeometryHandle first = AllocateQuad(arena);
+	GeometryHandle second = AllocateQuad(arena);
+	CHECK(first != InvalidGeometry && second != InvalidGeometry && first != second);
+
+	const GeometryRange& a = arena.GetRange(first);
+	const GeometryRange& b = arena.GetRange(second);
+	CHECK(a.baseVertex == 0 && a.firstIndex == 0 && a.indexCount == 6 && a.vertexCount == 4);
+	CHECK(b.baseVertex == 4 && b.firstIndex == 6);
+	CHECK(arena.GetIndexFormat() == DXGI_FORMAT_R16_UINT);
+
+	GeometryArenaStats stats = arena.GetStats();
+	CHECK(stats.meshes == 2);
+	CHECK(stats.verticesUsed == 8);
+	CHECK(stats.indicesUsed == 12);
+}
+
+TEST_CASE(FreedAndInvalidHandlesHaveEmptyRanges)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	GeometryArena arena;
+	CHECK(arena.Initialize(device, sizeof(Vertex), 64, 128));
+
+	CHECK(arena.GetRange(InvalidGeometry).indexCount == 0);
+	CHECK(arena.GetRange(0).indexCount == 0); // Nothing allocated yet
+
+	GeometryHandle handle = AllocateQuad(arena);
+	CHECK(arena.GetRange(handle).indexCount == 6);
+	CHECK(arena.GetRange(handle + 1).indexCount == 0);
+
+	arena.Free(handle);
+	CHECK(arena.GetRange(handle).indexCount == 0);
+	CHECK(arena.GetRange(handle).vertexCount == 0);
+
+	arena.Free(handle); // Ignored, like GetRange
+	CHECK(arena.GetStats().meshes == 0);
+	CHECK(arena.GetStats().verticesUsed == 0);
+
+	// The new mesh gets the space back
+	GeometryHandle reused = AllocateQuad(arena);
+	CHECK(reused != InvalidGeometry);
+	CHECK(arena.GetRange(reused).baseVertex == 0);
+}
+
+TEST_CASE(StaleHandlesNeverReachAReusedEntry)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	GeometryArena arena;
+	CHECK(arena.Initialize(device, sizeof(Vertex), 64, 128));
+
+	GeometryHandle stale = AllocateQuad(arena);
+	arena.Free(stale);
+
+	// Same entry, next generation: a different handle, and the old one does not resolve to the new mesh
+	GeometryHandle reused = AllocateQuad(arena);
+	CHECK(reused != stale);
+	CHECK(arena.GetRange(reused).indexCount == 6);
+	CHECK(arena.GetRange(stale).indexCount == 0);
+	CHECK(arena.GetRange(stale).vertexCount == 0);
+
+	// A double Free after reuse is ignored instead of releasing the new mesh's ranges
+	arena.Free(stale);
+	CHECK(arena.GetStats().meshes == 1);
+	CHECK(arena.GetStats().verticesUsed == 4);
+	CHECK(arena.GetStats().indicesUsed == 6);
+	CHECK(arena.GetRange(reused).indexCount == 6);
+
+	GeometryHandle other = AllocateQuad(arena);
+	CHECK(arena.GetRange(other).baseVertex == 4); // The reused mesh's vertices were not handed out again
+
+	arena.Free(reused);
+	CHECK(arena.GetStats().meshes == 1);
+	CHECK(arena.GetRange(other).indexCount == 6);
+}
+
+TEST_CASE(FullArenaRejectsMeshes)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	GeometryArena arena;
+	CHECK(arena.Initialize(device, sizeof(Vertex), 8, 128));
+
+	CHECK(AllocateQuad(arena) != InvalidGeometry);
+	CHECK(AllocateQuad(arena) != InvalidGeometry);
+	CHECK(AllocateQuad(arena) == InvalidGeometry);
+	CHECK(arena.GetStats().indicesUsed == 12); // The failed mesh left nothing behind
+
+	const Vertex vertices[4] = {};
+	const uint32_t wide[3] = { 0, 1, 70000 };
+	CHECK(arena.Allocate(nullptr, vertices, 4, wide, 3) == InvalidGeometry); // Does not fit the R16 index buffer
+}
+
+TEST_CASE(SplitArenaUploadsBothStreams)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	GeometryArena arena;
+	CHECK(arena.InitializeSplit(device, sizeof(Vertex), 16, 64, 128));
+	CHECK(arena.IsSplit());
+	CHECK(arena.GetVertexStride() == 16);
+	CHECK(arena.GetAttributeStride() == 16);
+	CHECK(arena.GetAttributeBuffer() != nullptr);
+
+	backend.SetRecording(true);
+	AllocateQuad(arena);
+	AllocateQuad(arena);
+
+	// Per mesh: positions, attributes and indices, each at the mesh's own offset
+	uint32_t positionWrites = 0;
+	uint32_t attributeWrites = 0;
+	for (const BackendCommand& command : backend.GetCommands())
+	{
+		if (command.type != BackendCommandType::UpdateBuffer)
+			continue;
+
+		if (command.handle == ToBackendHandle(arena.GetVertexBuffer()))
+			CHECK(command.args[0] == positionWrites++ * 64);
+		if (command.handle == ToBackendHandle(arena.GetAttributeBuffer()))
+			CHECK(command.args[0] == attributeWrites++ * 64);
+	}
+	CHECK(positionWrites == 2);
+	CHECK(attributeWrites == 2);
+}
+
+TEST_CASE(CompactionMovesLiveMeshesToTheFront)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	GeometryArena arena;
+	CHECK(arena.Initialize(device, sizeof(Vertex), 64, 128));
+
+	GeometryHandle a = AllocateQuad(arena);
+	GeometryHandle b = AllocateQuad(arena);
+	GeometryHandle c = AllocateQuad(arena);
+	arena.Free(a);
+	CHECK(arena.GetStats().freeVertexBlocks == 2);
+
+	CHECK(arena.Compact(nullptr));
+	CHECK(arena.GetRange(b).baseVertex == 0);
+	CHECK(arena.GetRange(c).baseVertex == 4);
+	CHECK(arena.GetRange(c).firstIndex == 6);
+	CHECK(arena.GetRange(a).indexCount == 0);
+	CHECK(arena.GetStats().freeVertexBlocks == 1);
+	CHECK(backend.GetStats().liveResources == 2); // Old buffers released
+}
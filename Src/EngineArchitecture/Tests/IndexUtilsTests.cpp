@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "Graphics/IndexUtils.h"
+#include "Graphics/Buffer.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+
+using namespace Graphics;
+
+// Counts cover the empty input, the scalar tail alone, whole 8-index vectors and vectors plus a tail
+TEST_CASE(IndicesBelow65536CanBeNarrowed)
+{
+	for (size_t count = 0; count <= 35; ++count)
+	{
+		std::vector<uint32_t> indices(count);
+		for (size_t i = 0; i < count; ++i)
+			indices[i] = static_cast<uint32_t>((i * 7919) & 0xFFFF);
+
+		CHECK(CanNarrowIndices(indices.data(), count));
+	}
+
+	const uint32_t boundary[9] = { 0xFFFF, 0xFFFF, 0, 0x8000, 0x7FFF, 0xFFFF, 1, 0xFFFE, 0xFFFF };
+	CHECK(CanNarrowIndices(boundary, 9));
+}
+
+TEST_CASE(OneWideIndexAnywhereBlocksNarrowing)
+{
+	const uint32_t wide[] = { 0x10000, 0x12345, 0x80000000u, 0xFFFFFFFFu };
+	uint32_t missed = 0;
+
+	for (size_t count = 1; count <= 35; ++count)
+	{
+		for (size_t position = 0; position < count; ++position)
+		{
+			for (uint32_t value : wide)
+			{
+				std::vector<uint32_t> indices(count, 0xFFFF);
+				indices[position] = value;
+
+				if (CanNarrowIndices(indices.data(), count))
+					missed++;
+			}
+		}
+	}
+
+	CHECK(missed == 0);
+}
+
+TEST_CASE(NarrowingKeepsEveryValue)
+{
+	for (size_t count = 0; count <= 35; ++count)
+	{
+		std::vector<uint32_t> source(count);
+		for (size_t i = 0; i < count; ++i)
+			source[i] = static_cast<uint32_t>((i * 40503u + 0x7FF0u) & 0xFFFF); // Crosses the 0x8000 bias of the packing
+
+		std::vector<uint16_t> destination(count + 1, 0xABCD);
+		NarrowIndices(source.data(), destination.data(), count);
+
+		for (size_t i = 0; i < count; ++i)
+			CHECK(destination[i] == source[i]);
+		CHECK(destination[count] == 0xABCD); // Nothing written past the end
+	}
+
+	const uint32_t extremes[8] = { 0, 1, 0x7FFF, 0x8000, 0x8001, 0xFFFE, 0xFFFF, 0x4000 };
+	uint16_t narrowed[8] = {};
+	NarrowIndices(extremes, narrowed, 8);
+	for (size_t i = 0; i < 8; ++i)
+		CHECK(narrowed[i] == extremes[i]);
+}
+
+TEST_CASE(IndexBufferPicksTheNarrowFormat)
+{
+	NullBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	std::vector<uint32_t> small(36);
+	for (uint32_t i = 0; i < small.size(); ++i)
+		small[i] = i * 1000;
+
+	Buffer narrow;
+	CHECK(narrow.Initialize(device, BufferType::IndexBuffer, small.data(), static_cast<uint32_t>(small.size() * 4), 4));
+	CHECK(narrow.GetFormat() == DXGI_FORMAT_R16_UINT);
+	CHECK(narrow.GetStride() == 2);
+	CHECK(narrow.GetSize() == small.size() * 2);
+
+	small[35] = 70000;
+
+	Buffer wide;
+	CHECK(wide.Initialize(device, BufferType::IndexBuffer, small.data(), static_cast<uint32_t>(small.size() * 4), 4));
+	CHECK(wide.GetFormat() == DXGI_FORMAT_R32_UINT);
+	CHECK(wide.GetStride() == 4);
+	CHECK(wide.GetSize() == small.size() * 4);
+}
@@ -0,0 +1,116 @@
+#include "Core/JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Core;
+
+// Scaling of the job system from one worker up to every hardware thread, on two loads:
+//   parallel for  1M elements of a few hundred cycles each, ParallelFor with the default split
+//   small jobs    100k empty Run() calls on one counter, measures queue and wake-up overhead per job
+//
+//   JobSystemBench [repeats]   best of repeats (default 5) per worker count, non-zero exit if a result is wrong
+
+namespace
+{
+	const uint32_t ElementCount = 1 << 20;
+	const uint32_t SmallJobCount = 100000;
+
+	double Elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Enough dependent math per element that the split, not memory bandwidth, decides the scaling
+	float Work(uint32_t index)
+	{
+		float value = static_cast<float>(index & 1023) * 0.001f;
+		for (uint32_t i = 0; i < 64; ++i)
+			value = std::sqrt(value * value + 1.0f) - 0.5f;
+		return value;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int repeats = (argc > 1) ? std::max(1, atoi(argv[1])) : 5;
+	const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<uint32_t> workerCounts;
+	for (uint32_t workers = 1; workers < hardwareThreads; workers *= 2)
+		workerCounts.push_back(workers);
+	workerCounts.push_back(hardwareThreads);
+
+	// Reference result on this thread, every run must reproduce it exactly
+	std::vector<float> expected(ElementCount);
+	for (uint32_t i = 0; i < ElementCount; ++i)
+		expected[i] = Work(i);
+
+	std::vector<float> output(ElementCount);
+	bool correct = true;
+	double singleWorkerMilliseconds = 0.0;
+
+	std::cout << "workers   for ms   speedup   efficiency   small jobs ms   ns/job   stolen   sleeps\n" << std::fixed;
+
+	for (uint32_t workers : workerCounts)
+	{
+		JobSystem jobs;
+		jobs.Initialize(workers);
+
+		double forMilliseconds = 1e30;
+		double smallMilliseconds = 1e30;
+		JobSystemStats stats;
+
+		for (int repeat = 0; repeat < repeats; ++repeat)
+		{
+			std::fill(output.begin(), output.end(), 0.0f);
+			jobs.ResetStats();
+
+			auto start = std::chrono::steady_clock::now();
+			jobs.ParallelFor(ElementCount, 256, [&output](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+					output[i] = Work(i);
+			});
+			forMilliseconds = std::min(forMilliseconds, Elapsed(start));
+			stats = jobs.GetStats();
+
+			correct = correct && std::equal(output.begin(), output.end(), expected.begin());
+
+			std::atomic<uint32_t> executed { 0 };
+			JobCounter counter;
+
+			start = std::chrono::steady_clock::now();
+			for (uint32_t i = 0; i < SmallJobCount; ++i)
+				jobs.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter, "Small");
+			jobs.Wait(counter);
+			smallMilliseconds = std::min(smallMilliseconds, Elapsed(start));
+
+			correct = correct && executed.load() == SmallJobCount;
+		}
+
+		jobs.Shutdown();
+
+		if (workers == 1)
+			singleWorkerMilliseconds = forMilliseconds;
+
+		double speedup = singleWorkerMilliseconds / forMilliseconds;
+		std::cout << std::setw(7) << workers << std::setprecision(2) << std::setw(9) << forMilliseconds << std::setw(10) << speedup
+			<< std::setprecision(0) << std::setw(12) << 100.0 * speedup / workers << "%" << std::setprecision(2) << std::setw(16) << smallMilliseconds
+			<< std::setprecision(1) << std::setw(9) << smallMilliseconds * 1e6 / SmallJobCount << std::setw(9) << stats.stolen << std::setw(9) << stats.sleeps << "\n";
+	}
+
+	if (!correct)
+	{
+		std::cout << "Wrong result.\n";
+		return 1;
+	}
+
+	return 0;
+}
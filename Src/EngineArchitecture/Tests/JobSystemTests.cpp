@@ -0,0 +1,240 @@
+#include "TestFramework.h"
+#include "Core/JobSystem.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Core;
+
+namespace
+{
+	// More workers than this machine may have cores, so preemption in the middle of a steal is exercised too
+	const uint32_t Workers = 8;
+
+	bool AllOnce(const std::vector<std::atomic<uint32_t>>& hits)
+	{
+		for (const std::atomic<uint32_t>& hit : hits)
+		{
+			if (hit.load() != 1)
+				return false;
+		}
+		return true;
+	}
+
+	// Each job queues two children until depth runs out: 2^(depth + 1) - 1 jobs, most of them queued by workers
+	void Spawn(JobSystem& jobs, JobCounter& counter, std::atomic<uint32_t>& executed, uint32_t depth)
+	{
+		executed++;
+		if (depth == 0)
+			return;
+
+		for (uint32_t i = 0; i < 2; ++i)
+			jobs.Run([&jobs, &counter, &executed, depth]() { Spawn(jobs, counter, executed, depth - 1); }, &counter);
+	}
+}
+
+TEST_CASE(EveryJobRunsExactlyOnce)
+{
+	JobSystem jobs;
+	CHECK(jobs.Initialize(Workers));
+
+	const uint32_t count = 100000;
+	std::vector<std::atomic<uint32_t>> hits(count);
+	for (std::atomic<uint32_t>& hit : hits)
+		hit = 0;
+
+	JobCounter counter;
+	for (uint32_t i = 0; i < count; ++i)
+		jobs.Run([&hits, i]() { hits[i]++; }, &counter);
+
+	jobs.Wait(counter);
+	CHECK(counter.IsDone());
+	CHECK(AllOnce(hits));
+
+	JobSystemStats stats = jobs.GetStats();
+	CHECK(stats.executed == count);
+	jobs.Shutdown();
+}
+
+TEST_CASE(JobsQueuedByJobsAreCounted)
+{
+	JobSystem jobs;
+	CHECK(jobs.Initialize(Workers));
+
+	for (uint32_t round = 0; round < 20; ++round)
+	{
+		std::atomic<uint32_t> executed { 0 };
+		JobCounter counter;
+
+		jobs.Run([&jobs, &counter, &executed]() { Spawn(jobs, counter, executed, 12); }, &counter);
+		jobs.Wait(counter);
+
+		// The counter only drops to zero after the last grandchild, never in between
+		CHECK(executed.load() == (1u << 13) - 1);
+	}
+
+	jobs.Shutdown();
+}
+
+TEST_CASE(ThreadsOutsideThePoolInjectAndWait)
+{
+	JobSystem jobs;
+	CHECK(jobs.Initialize(Workers));
+
+	const uint32_t threadCount = 6;
+	const uint32_t perThread = 20000;
+	std::vector<std::atomic<uint32_t>> hits(threadCount * perThread);
+	for (std::atomic<uint32_t>& hit : hits)
+		hit = 0;
+
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		threads.emplace_back([&jobs, &hits, t, perThread]()
+		{
+			// Several waits per thread, each on its own counter
+			for (uint32_t batch = 0; batch < 4; ++batch)
+			{
+				JobCounter counter;
+				uint32_t begin = t * perThread + batch * (perThread / 4);
+				for (uint32_t i = begin; i < begin + perThread / 4; ++i)
+					jobs.Run([&hits, i]() { hits[i]++; }, &counter);
+				jobs.Wait(counter);
+			}
+		});
+	}
+
+	// Worker 0 keeps helping meanwhile
+	JobCounter local;
+	std::atomic<uint32_t> localExecuted { 0 };
+	for (uint32_t i = 0; i < 10000; ++i)
+		jobs.Run([&localExecuted]() { localExecuted++; }, &local);
+	jobs.Wait(local);
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	CHECK(AllOnce(hits));
+	CHECK(localExecuted.load() == 10000);
+	CHECK(jobs.GetStats().injected == threadCount * perThread);
+	jobs.Shutdown();
+}
+
+TEST_CASE(FullDequeRunsJobsInline)
+{
+	JobSystem jobs;
+	CHECK(jobs.Initialize(2, 16));
+
+	std::atomic<uint32_t> executed { 0 };
+	JobCounter counter;
+	for (uint32_t i = 0; i < 5000; ++i)
+		jobs.Run([&executed]() { executed++; }, &counter);
+	jobs.Wait(counter);
+
+	CHECK(executed.load() == 5000);
+	CHECK(jobs.GetStats().ranInline > 0);
+	jobs.Shutdown();
+}
+
+TEST_CASE(ParallelForCoversEveryIndexOnce)
+{
+	JobSystem jobs;
+	CHECK(jobs.Initialize(Workers));
+
+	const uint32_t counts[] = { 0, 1, 7, 64, 1000, 100003 };
+	const uint32_t chunks[] = { 1, 16, 5000 };
+
+	for (uint32_t count : counts)
+	{
+		for (uint32_t chunk : chunks)
+		{
+			std::vector<std::atomic<uint32_t>> hits(count);
+			for (std::atomic<uint32_t>& hit : hits)
+				hit = 0;
+
+			jobs.ParallelFor(count, chunk, [&hits](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+					hits[i]++;
+			});
+
+			CHECK(AllOnce(hits));
+		}
+	}
+
+	// Nested inside jobs, the inner loops share the pool with the outer one
+	std::vector<std::atomic<uint32_t>> hits(64 * 1000);
+	for (std::atomic<uint32_t>& hit : hits)
+		hit = 0;
+
+	jobs.ParallelFor(64, 1, [&jobs, &hits](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t outer = begin; outer < end; ++outer)
+		{
+			jobs.ParallelFor(1000, 10, [&hits, outer](uint32_t innerBegin, uint32_t innerEnd)
+			{
+				for (uint32_t i = innerBegin; i < innerEnd; ++i)
+					hits[outer * 1000 + i]++;
+			});
+		}
+	});
+
+	CHECK(AllOnce(hits));
+	jobs.Shutdown();
+}
+
+TEST_CASE(ShutdownFinishesQueuedJobs)
+{
+	// Repeated start/stop with work still queued: no job lost, no worker left behind
+	for (uint32_t round = 0; round < 50; ++round)
+	{
+		std::atomic<uint32_t> executed { 0 };
+		{
+			JobSystem jobs;
+			CHECK(jobs.Initialize(1 + round % Workers));
+
+			for (uint32_t i = 0; i < 500; ++i)
+				jobs.Run([&executed]() { executed++; });
+
+			jobs.Shutdown();
+		}
+		CHECK(executed.load() == 500);
+	}
+}
+
+TEST_CASE(ProfilerHooksPairUp)
+{
+	struct Hooks
+	{
+		std::atomic<uint32_t> begins { 0 };
+		std::atomic<uint32_t> ends { 0 };
+		std::atomic<uint32_t> outside { 0 }; // Begins reported for worker -1
+	};
+
+	Hooks hooks;
+	JobProfiler profiler;
+	profiler.userData = &hooks;
+	profiler.onBegin = [](const char*, int32_t worker, void* userData)
+	{
+		Hooks& hooks = *static_cast<Hooks*>(userData);
+		hooks.begins++;
+		if (worker < 0)
+			hooks.outside++;
+	};
+	profiler.onEnd = [](const char*, int32_t, void* userData) { static_cast<Hooks*>(userData)->ends++; };
+
+	JobSystem jobs;
+	CHECK(jobs.Initialize(4));
+	jobs.SetProfiler(profiler);
+
+	JobCounter counter;
+	for (uint32_t i = 0; i < 10000; ++i)
+		jobs.Run([]() {}, &counter, "Empty");
+	jobs.Wait(counter);
+	jobs.Shutdown();
+
+	CHECK(hooks.begins.load() == 10000);
+	CHECK(hooks.ends.load() == 10000);
+	CHECK(hooks.outside.load() == 0); // Every job ran on a pool thread
+}
@@ -0,0 +1,192 @@
+#include "TestFramework.h"
+#include "Graphics/ParallelSubmit.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+#include "Core/JobSystem.h"
+
+using namespace Graphics;
+
+namespace
+{
+	// What a draw sees: its own arguments plus the state bound when it was issued
+	struct DrawState
+	{
+		uint32_t draw[5] = {};
+		BackendHandle vertexBuffer = 0;
+		BackendHandle indexBuffer = 0;
+		BackendHandle constantBuffer = 0;
+		uint32_t firstConstant = 0;
+		uint32_t viewportWidth = 0;
+
+		bool operator==(const DrawState& other) const
+		{
+			for (uint32_t i = 0; i < 5; ++i)
+			{
+				if (draw[i] != other.draw[i])
+					return false;
+			}
+
+			return vertexBuffer == other.vertexBuffer && indexBuffer == other.indexBuffer && constantBuffer == other.constantBuffer &&
+				firstConstant == other.firstConstant && viewportWidth == other.viewportWidth;
+		}
+	};
+
+	// Chunks re-bind their state after a boundary, so the streams differ in binds, never in what the draws see
+	std::vector<DrawState> GetDraws(const std::vector<BackendCommand>& commands)
+	{
+		std::vector<DrawState> draws;
+		DrawState state;
+
+		for (const BackendCommand& command : commands)
+		{
+			switch (command.type)
+			{
+			case BackendCommandType::SetVertexBuffer: state.vertexBuffer = command.handle; break;
+			case BackendCommandType::SetIndexBuffer: state.indexBuffer = command.handle; break;
+			case BackendCommandType::SetViewport: state.viewportWidth = command.args[0]; break;
+			case BackendCommandType::SetConstantBuffer:
+				state.constantBuffer = command.handle;
+				state.firstConstant = command.args[1];
+				break;
+			case BackendCommandType::DrawIndexed:
+				for (uint32_t i = 0; i < 5; ++i)
+					state.draw[i] = command.args[i];
+				draws.push_back(state);
+				break;
+			default:
+				break;
+			}
+		}
+
+		return draws;
+	}
+
+	struct Scene
+	{
+		NullBackend backend;
+		Device device;
+		CommandList immediate;
+		RenderQueue queue;
+		std::vector<ID3D11Buffer*> meshes;
+		ID3D11Buffer* constants = nullptr;
+
+		explicit Scene(uint32_t packetCount)
+		{
+			device.Initialize(backend);
+			immediate.Initialize(backend);
+
+			BackendBufferDesc desc;
+			desc.size = 64 * 1024;
+			for (uint32_t i = 0; i < 10; ++i)
+				meshes.push_back(FromBackendHandle<ID3D11Buffer>(backend.CreateBuffer(desc, nullptr)));
+			constants = FromBackendHandle<ID3D11Buffer>(backend.CreateBuffer(desc, nullptr));
+
+			for (uint32_t i = 0; i < packetCount; ++i)
+			{
+				uint32_t mesh = (i * 7) % meshes.size();
+
+				DrawPacket packet;
+				packet.sortKey = RenderQueue::MakeSortKey(RenderPassType::Opaque, 0, mesh, static_cast<float>(i % 97) / 97.0f);
+				packet.vertexBuffer = meshes[mesh];
+				packet.indexBuffer = meshes[mesh];
+				packet.vertexStride = 32;
+				packet.indexCount = 36 + mesh * 6;
+				packet.startIndex = mesh * 100;
+				packet.constants.buffer = constants;
+				packet.constants.offset = i * ConstantBufferRing::Alignment;
+				packet.constants.size = ConstantBufferRing::Alignment;
+				queue.Push(packet);
+			}
+
+			queue.Sort();
+			backend.SetRecording(true);
+		}
+
+		std::vector<DrawState> SubmitSingleThreaded()
+		{
+			backend.ClearCommands();
+			immediate.InvalidateState();
+			immediate.SetViewport(1200.0f, 820.0f);
+			queue.Submit(immediate);
+			return GetDraws(backend.GetCommands());
+		}
+
+		std::vector<DrawState> SubmitParallel(ParallelSubmitter& submitter)
+		{
+			backend.ClearCommands();
+			immediate.InvalidateState(); // The stream is checked on its own, nothing may be filtered against the last submit
+			submitter.Submit(device, immediate, queue, [](CommandList& commandList) { commandList.SetViewport(1200.0f, 820.0f); });
+			return GetDraws(backend.GetCommands());
+		}
+	};
+}
+
+TEST_CASE(ChunksReplayInSubmitOrder)
+{
+	Scene scene(1000);
+
+	ParallelSubmitter submitter;
+	CHECK(submitter.Initialize(scene.device, 4, 64));
+
+	std::vector<DrawState> expected = scene.SubmitSingleThreaded();
+	std::vector<DrawState> parallel = scene.SubmitParallel(submitter);
+
+	CHECK(expected.size() == 1000);
+	CHECK(parallel.size() == expected.size());
+	CHECK(parallel == expected);
+
+	const ParallelSubmitStats& stats = submitter.GetStats();
+	CHECK(stats.chunks == 4);
+	CHECK(stats.draws == 1000);
+	CHECK(stats.instances == 1000);
+}
+
+TEST_CASE(ChunksRecordedAsJobsReplayInSubmitOrder)
+{
+	Scene scene(3000);
+
+	Core::JobSystem jobSystem;
+	CHECK(jobSystem.Initialize(4));
+
+	ParallelSubmitter submitter;
+	CHECK(submitter.Initialize(scene.device, 8, 32));
+	submitter.SetJobSystem(&jobSystem);
+
+	std::vector<DrawState> expected = scene.SubmitSingleThreaded();
+
+	// Same result every frame, whichever worker records which chunk
+	for (uint32_t frame = 0; frame < 20; ++frame)
+		CHECK(scene.SubmitParallel(submitter) == expected);
+
+	CHECK(submitter.GetStats().chunks == 8);
+	jobSystem.Shutdown();
+}
+
+TEST_CASE(SmallQueuesGoStraightToTheImmediateList)
+{
+	Scene scene(50);
+
+	ParallelSubmitter submitter;
+	CHECK(submitter.Initialize(scene.device, 4, 64));
+
+	std::vector<DrawState> expected = scene.SubmitSingleThreaded();
+	CHECK(scene.SubmitParallel(submitter) == expected);
+	CHECK(submitter.GetStats().chunks == 0);
+}
+
+TEST_CASE(EveryChunkStartsWithItsSetup)
+{
+	Scene scene(1000);
+
+	ParallelSubmitter submitter;
+	CHECK(submitter.Initialize(scene.device, 4, 64));
+	scene.SubmitParallel(submitter);
+
+	// One viewport per chunk: the shadow of each list starts empty, like a deferred context
+	uint32_t viewports = 0;
+	for (const BackendCommand& command : scene.backend.GetCommands())
+		viewports += (command.type == BackendCommandType::SetViewport) ? 1 : 0;
+	CHECK(viewports == 4);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Storage types only, the engine code the tests build does no matrix math
+
+namespace DirectX
+{
+	struct XMFLOAT2
+	{
+		float x, y;
+
+		XMFLOAT2() = default;
+		XMFLOAT2(float x_, float y_) : x(x_), y(y_) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x, y, z;
+
+		XMFLOAT3() = default;
+		XMFLOAT3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x, y, z, w;
+
+		XMFLOAT4() = default;
+		XMFLOAT4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		float m[4][4];
+	};
+
+	struct XMMATRIX
+	{
+		float r[4][4];
+	};
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <d3d11.h>
+
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+	virtual void VSSetConstantBuffers1(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstants, const UINT* numConstants) = 0;
+};
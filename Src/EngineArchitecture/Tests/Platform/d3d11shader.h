@@ -0,0 +1,78 @@
+#pragma once
+
+#include <d3d11.h>
+
+struct D3D11_SHADER_DESC
+{
+	UINT Version;
+	LPCSTR Creator;
+	UINT Flags;
+	UINT ConstantBuffers;
+	UINT BoundResources;
+	UINT InputParameters;
+	UINT OutputParameters;
+};
+
+struct D3D11_SHADER_BUFFER_DESC
+{
+	LPCSTR Name;
+	D3D_CBUFFER_TYPE Type;
+	UINT Variables;
+	UINT Size;
+	UINT uFlags;
+};
+
+struct D3D11_SHADER_VARIABLE_DESC
+{
+	LPCSTR Name;
+	UINT StartOffset;
+	UINT Size;
+	UINT uFlags;
+	LPVOID DefaultValue;
+	UINT StartTexture;
+	UINT TextureSize;
+	UINT StartSampler;
+	UINT SamplerSize;
+};
+
+struct D3D11_SHADER_INPUT_BIND_DESC
+{
+	LPCSTR Name;
+	D3D_SHADER_INPUT_TYPE Type;
+	UINT BindPoint;
+	UINT BindCount;
+	UINT uFlags;
+};
+
+struct D3D11_SIGNATURE_PARAMETER_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	UINT Register;
+	D3D_NAME SystemValueType;
+	D3D_REGISTER_COMPONENT_TYPE ComponentType;
+	BYTE Mask;
+	BYTE ReadWriteMask;
+	UINT Stream;
+};
+
+struct ID3D11ShaderReflectionVariable
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_VARIABLE_DESC* desc) = 0;
+};
+
+struct ID3D11ShaderReflectionConstantBuffer
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_BUFFER_DESC* desc) = 0;
+	virtual ID3D11ShaderReflectionVariable* GetVariableByIndex(UINT index) = 0;
+};
+
+struct ID3D11ShaderReflection : IUnknown
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_DESC* desc) = 0;
+	virtual ID3D11ShaderReflectionConstantBuffer* GetConstantBufferByIndex(UINT index) = 0;
+	virtual HRESULT GetResourceBindingDescByName(LPCSTR name, D3D11_SHADER_INPUT_BIND_DESC* desc) = 0;
+	virtual HRESULT GetInputParameterDesc(UINT index, D3D11_SIGNATURE_PARAMETER_DESC* desc) = 0;
+};
+
+static const IID IID_ID3D11ShaderReflection = {};
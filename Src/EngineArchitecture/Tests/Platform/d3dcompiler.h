@@ -0,0 +1,18 @@
+#pragma once
+
+#include <d3d11shader.h>
+
+#define D3DCOMPILE_DEBUG 0x1
+#define D3DCOMPILE_SKIP_OPTIMIZATION 0x4
+#define D3DCOMPILE_ENABLE_STRICTNESS 0x800
+#define D3DCOMPILE_OPTIMIZATION_LEVEL3 0x8000
+
+#define D3D_COMPILER_VERSION 47
+#define D3DCOMPILER_DLL_A "d3dcompiler_47.dll"
+
+inline HRESULT D3DCompile(LPCVOID, SIZE_T, LPCSTR, const D3D_SHADER_MACRO*, ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**) { return E_NOTIMPL; }
+inline HRESULT D3DCompileFromFile(LPCWSTR, const D3D_SHADER_MACRO*, ID3DInclude*, LPCSTR, LPCSTR, UINT, UINT, ID3DBlob**, ID3DBlob**) { return E_NOTIMPL; }
+inline HRESULT D3DPreprocess(LPCVOID, SIZE_T, LPCSTR, const D3D_SHADER_MACRO*, ID3DInclude*, ID3DBlob**, ID3DBlob**) { return E_NOTIMPL; }
+inline HRESULT D3DCreateBlob(SIZE_T, ID3DBlob**) { return E_NOTIMPL; }
+inline HRESULT D3DGetInputSignatureBlob(LPCVOID, SIZE_T, ID3DBlob**) { return E_NOTIMPL; }
+inline HRESULT D3DReflect(LPCVOID, SIZE_T, REFIID, void**) { return E_NOTIMPL; }
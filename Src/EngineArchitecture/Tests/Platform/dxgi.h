@@ -0,0 +1,128 @@
+#pragma once
+
+#include <windows.h>
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_UINT = 12,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R16G16B16A16_SINT = 14,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R10G10B10A2_UINT = 25,
+	DXGI_FORMAT_R11G11B10_FLOAT = 26,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+	DXGI_FORMAT_R8G8B8A8_SINT = 32,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R16G16_UNORM = 35,
+	DXGI_FORMAT_R16G16_UINT = 36,
+	DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R16G16_SINT = 38,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+	DXGI_FORMAT_D24_UNORM_S8_UINT = 45,
+	DXGI_FORMAT_R16_FLOAT = 54,
+	DXGI_FORMAT_R16_UNORM = 56,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_B8G8R8A8_UNORM = 87
+};
+
+#define DXGI_USAGE_RENDER_TARGET_OUTPUT 0x20
+
+typedef UINT DXGI_USAGE;
+
+enum DXGI_SWAP_EFFECT
+{
+	DXGI_SWAP_EFFECT_DISCARD = 0
+};
+
+struct DXGI_RATIONAL
+{
+	UINT Numerator;
+	UINT Denominator;
+};
+
+struct DXGI_MODE_DESC
+{
+	UINT Width;
+	UINT Height;
+	DXGI_RATIONAL RefreshRate;
+	DXGI_FORMAT Format;
+	UINT ScanlineOrdering;
+	UINT Scaling;
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+struct DXGI_SWAP_CHAIN_DESC
+{
+	DXGI_MODE_DESC BufferDesc;
+	DXGI_SAMPLE_DESC SampleDesc;
+	DXGI_USAGE BufferUsage;
+	UINT BufferCount;
+	HWND OutputWindow;
+	BOOL Windowed;
+	DXGI_SWAP_EFFECT SwapEffect;
+	UINT Flags;
+};
+
+struct DXGI_ADAPTER_DESC
+{
+	wchar_t Description[128];
+	UINT VendorId;
+	UINT DeviceId;
+	UINT SubSysId;
+	UINT Revision;
+	SIZE_T DedicatedVideoMemory;
+	SIZE_T DedicatedSystemMemory;
+	SIZE_T SharedSystemMemory;
+};
+
+struct IDXGIObject : IUnknown
+{
+	virtual HRESULT GetParent(REFIID riid, void** parent) = 0;
+};
+
+struct IDXGIAdapter : IDXGIObject
+{
+	virtual HRESULT GetDesc(DXGI_ADAPTER_DESC* desc) = 0;
+};
+
+struct IDXGIDevice : IDXGIObject
+{
+	virtual HRESULT GetAdapter(IDXGIAdapter** adapter) = 0;
+};
+
+struct IDXGISwapChain : IDXGIObject
+{
+	virtual HRESULT Present(UINT syncInterval, UINT flags) = 0;
+	virtual HRESULT GetBuffer(UINT buffer, REFIID riid, void** surface) = 0;
+	virtual HRESULT ResizeBuffers(UINT bufferCount, UINT width, UINT height, DXGI_FORMAT format, UINT flags) = 0;
+};
+
+struct IDXGIFactory : IDXGIObject
+{
+	virtual HRESULT EnumAdapters(UINT adapter, IDXGIAdapter** result) = 0;
+	virtual HRESULT CreateSwapChain(IUnknown* device, DXGI_SWAP_CHAIN_DESC* desc, IDXGISwapChain** swapChain) = 0;
+};
+
+inline HRESULT CreateDXGIFactory(REFIID, void**) { return E_NOTIMPL; }
@@ -0,0 +1,68 @@
+#pragma once
+
+// Off Windows the tests compile the engine against these headers. They only declare the SDK names the engine
+// refers to: interfaces are never implemented and every function fails, the tests run everything on a RenderBackend.
+
+#include <cstddef>
+#include <cstdint>
+
+typedef int32_t HRESULT;
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef unsigned long ULONG;
+typedef uint32_t DWORD;
+typedef uint64_t UINT64;
+typedef uint8_t BYTE;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef void* LPVOID;
+typedef const void* LPCVOID;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+typedef void* HWND;
+typedef void* HMODULE;
+typedef void* HINSTANCE;
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+
+typedef GUID IID;
+typedef const IID& REFIID;
+
+static const IID IID_NULL = {};
+#define __uuidof(type) IID_NULL
+
+#define TRUE 1
+#define FALSE 0
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_PENDING ((HRESULT)0x8000000A)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+
+#define STDMETHODCALLTYPE
+#define WINAPI
+#define __stdcall
+
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+
+struct IUnknown
+{
+	virtual HRESULT QueryInterface(REFIID riid, void** object) = 0;
+	virtual ULONG AddRef() = 0;
+	virtual ULONG Release() = 0;
+
+protected:
+	~IUnknown() = default;
+};
@@ -0,0 +1,91 @@
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace Core;
+
+// Cost of one PROFILE_ZONE, disabled and while a session records, on 1, 2 and 4 threads at once. Each thread's ring holds
+// every zone it records, so the recording number is the steady cost without drops, the collector writing as it goes.
+//
+//   ProfilerBench [repeats]   best of repeats (default 5) per thread count, non-zero exit if an event was lost
+
+namespace
+{
+	const uint32_t ZonesPerThread = 100000;
+	const char* const TracePath = "ProfilerBench.json";
+
+	// Nanoseconds per zone on one thread
+	double Measure()
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < ZonesPerThread; ++i)
+		{
+			PROFILE_ZONE("Bench");
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ZonesPerThread;
+	}
+
+	// Slowest thread, every thread starts together
+	double MeasureThreads(uint32_t threadCount)
+	{
+		std::vector<double> results(threadCount);
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < threadCount; ++t)
+			threads.emplace_back([&results, t]() { results[t] = Measure(); });
+		for (std::thread& thread : threads)
+			thread.join();
+
+		return *std::max_element(results.begin(), results.end());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int repeats = (argc > 1) ? std::max(1, atoi(argv[1])) : 5;
+	const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	Profiler& profiler = Profiler::Get();
+	bool correct = true;
+
+	std::cout << "threads   disabled ns   recording ns   written   dropped   flushes\n" << std::fixed << std::setprecision(2);
+
+	for (uint32_t threadCount = 1; threadCount <= std::min(4u, hardwareThreads); threadCount *= 2)
+	{
+		double disabled = 1e30;
+		double recording = 1e30;
+		ProfilerStats stats;
+
+		for (int repeat = 0; repeat < repeats; ++repeat)
+		{
+			disabled = std::min(disabled, MeasureThreads(threadCount));
+
+			if (!profiler.Start(TracePath, ZonesPerThread))
+				return 1;
+
+			recording = std::min(recording, MeasureThreads(threadCount));
+			profiler.Stop();
+
+			stats = profiler.GetStats();
+			correct = correct && stats.written == static_cast<uint64_t>(ZonesPerThread) * threadCount;
+		}
+
+		std::cout << std::setw(7) << threadCount << std::setw(14) << disabled << std::setw(15) << recording
+			<< std::setw(10) << stats.written << std::setw(10) << stats.dropped << std::setw(10) << stats.flushes << "\n";
+	}
+
+	std::remove(TracePath);
+
+	if (!correct)
+	{
+		std::cout << "Zones were lost while recording.\n";
+		return 1;
+	}
+
+	return 0;
+}
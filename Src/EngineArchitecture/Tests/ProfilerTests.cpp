@@ -0,0 +1,167 @@
+#include "TestFramework.h"
+#include "Core/Profiler.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+using namespace Core;
+
+// The profiler is one instance per process, the cases below run one session each, in order
+namespace
+{
+	const char* const TracePath = "ProfilerTests.json";
+
+	std::string ReadTrace()
+	{
+		std::ifstream file(TracePath, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	uint32_t Occurrences(const std::string& text, const std::string& pattern)
+	{
+		uint32_t count = 0;
+		for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + pattern.size()))
+			count++;
+		return count;
+	}
+
+	// Brackets balance outside strings, strings are closed and hold no raw control characters
+	bool IsWellFormed(const std::string& json)
+	{
+		int depth = 0;
+		bool inString = false;
+		for (size_t i = 0; i < json.size(); ++i)
+		{
+			char c = json[i];
+			if (inString)
+			{
+				if (static_cast<unsigned char>(c) < 0x20)
+					return false;
+				if (c == '\\')
+					++i;
+				else if (c == '"')
+					inString = false;
+				continue;
+			}
+
+			if (c == '"')
+				inString = true;
+			else if (c == '{' || c == '[')
+				depth++;
+			else if ((c == '}' || c == ']') && --depth < 0)
+				return false;
+		}
+		return depth == 0 && !inString;
+	}
+
+	// Track of a named thread, from its metadata event
+	uint32_t ThreadId(const std::string& json, const char* name)
+	{
+		size_t at = json.find(std::string(",\"args\":{\"name\":\"") + name + "\"}}");
+		size_t tid = (at != std::string::npos) ? json.rfind("\"tid\":", at) : std::string::npos;
+		return (tid != std::string::npos) ? static_cast<uint32_t>(strtoul(json.c_str() + tid + 6, nullptr, 10)) : 0;
+	}
+
+	void RecordZones(const char* threadName, const char* zone, uint32_t count)
+	{
+		Profiler::SetThreadName(threadName);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			PROFILE_ZONE(zone);
+		}
+	}
+}
+
+TEST_CASE(ZonesAreWrittenAsCompleteEvents)
+{
+	Profiler& profiler = Profiler::Get();
+	CHECK(!Profiler::IsEnabled());
+	CHECK(profiler.Start(TracePath));
+	CHECK(!profiler.Start(TracePath)); // Already running
+
+	Profiler::SetThreadName("Main \"test\"");
+	{
+		PROFILE_ZONE("Outer");
+		RecordZones("Main \"test\"", "Quote \" and \\ backslash", 10);
+		PROFILE_ZONE("Tab\there");
+	}
+
+	profiler.Stop();
+	CHECK(!Profiler::IsEnabled());
+	CHECK(profiler.GetStats().written == 12);
+
+	std::string json = ReadTrace();
+	std::remove(TracePath);
+
+	CHECK(json.compare(0, 39, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0);
+	CHECK(IsWellFormed(json));
+	CHECK(Occurrences(json, "\"ph\":\"X\"") == 12);
+	CHECK(Occurrences(json, "{\"name\":\"Outer\",\"ph\":\"X\",\"ts\":") == 1);
+	CHECK(Occurrences(json, "{\"name\":\"Quote \\\" and \\\\ backslash\",\"ph\":\"X\"") == 10);
+	CHECK(Occurrences(json, "{\"name\":\"Tab here\",\"ph\":\"X\"") == 1); // Control characters become spaces
+
+	// Track names as metadata, escaped the same way
+	CHECK(Occurrences(json, "{\"name\":\"thread_name\",\"ph\":\"M\"") >= 1);
+	CHECK(ThreadId(json, "Main \\\"test\\\"") != 0);
+}
+
+TEST_CASE(FullRingsCountDrops)
+{
+	Profiler& profiler = Profiler::Get();
+	const uint64_t droppedBefore = profiler.GetStats().dropped;
+
+	// The collector sleeps through the burst, only Stop() drains. A new thread gets a new ring of the session's size.
+	CHECK(profiler.Start(TracePath, 16, 10000));
+	std::thread burst(RecordZones, "Burst", "Burst", 100);
+	burst.join();
+	profiler.Stop();
+
+	ProfilerStats stats = profiler.GetStats();
+	CHECK(stats.written == 16);
+	CHECK(stats.dropped - droppedBefore == 84);
+
+	std::string json = ReadTrace();
+	std::remove(TracePath);
+	CHECK(IsWellFormed(json));
+	CHECK(Occurrences(json, "{\"name\":\"Burst\",\"ph\":\"X\"") == 16);
+}
+
+TEST_CASE(ExitedThreadsHandTheirRingOn)
+{
+	Profiler& profiler = Profiler::Get();
+	const ProfilerStats before = profiler.GetStats();
+	CHECK(profiler.Start(TracePath, 64, 1));
+
+	std::thread first(RecordZones, "First", "FirstZone", 5);
+	first.join();
+
+	// Once the collector drained what the thread left, the ring is free. Two passes: the first may have started before the exit.
+	const uint64_t flushes = profiler.GetStats().flushes;
+	while (profiler.GetStats().flushes < flushes + 2)
+		std::this_thread::yield();
+	const uint32_t buffers = profiler.GetStats().buffers;
+
+	std::thread second(RecordZones, "Second", "SecondZone", 5);
+	second.join();
+	profiler.Stop();
+
+	ProfilerStats stats = profiler.GetStats();
+	CHECK(stats.buffers == buffers); // No new ring for the second thread
+	CHECK(stats.buffers <= before.buffers + 1);
+	CHECK(stats.threads == before.threads + 2); // Yet a track of its own
+	CHECK(stats.written == 10);
+
+	std::string json = ReadTrace();
+	std::remove(TracePath);
+	CHECK(IsWellFormed(json));
+	CHECK(Occurrences(json, "{\"name\":\"FirstZone\",\"ph\":\"X\"") == 5);
+	CHECK(Occurrences(json, "{\"name\":\"SecondZone\",\"ph\":\"X\"") == 5);
+
+	const uint32_t firstId = ThreadId(json, "First");
+	const uint32_t secondId = ThreadId(json, "Second");
+	CHECK(firstId != 0 && secondId != 0 && firstId != secondId);
+	CHECK(Occurrences(json, ",\"tid\":" + std::to_string(secondId) + "}") == 5);
+}
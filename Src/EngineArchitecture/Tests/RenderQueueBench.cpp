@@ -0,0 +1,123 @@
+#include "Graphics/RenderQueue.h"
+#include "Graphics/CommandList.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace Graphics;
+
+// Sort and Submit cost of the render queue at 10k, 100k and 1M packets, on the null backend so only the engine is measured.
+// Packets spread over 256 meshes and 1024 constant ranges in random push order, like a scene traversal would push them.
+//
+//   RenderQueueBench [repeats]   best of repeats (default 10) per size, non-zero exit if the queue comes out unsorted
+
+namespace
+{
+	struct Result
+	{
+		double sortMilliseconds = 1e30;
+		double submitMilliseconds = 1e30;
+		CommandListStats commands;
+	};
+
+	double Elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int repeats = (argc > 1) ? std::max(1, atoi(argv[1])) : 10;
+	const size_t sizes[] = { 10000, 100000, 1000000 };
+
+	NullBackend backend;
+	CommandList commandList;
+	commandList.Initialize(backend);
+
+	BackendBufferDesc desc;
+	desc.size = 64 * 1024;
+	desc.dynamic = true;
+
+	std::vector<ID3D11Buffer*> meshes(256);
+	for (ID3D11Buffer*& mesh : meshes)
+		mesh = FromBackendHandle<ID3D11Buffer>(backend.CreateBuffer(desc, nullptr));
+	ID3D11Buffer* constants = FromBackendHandle<ID3D11Buffer>(backend.CreateBuffer(desc, nullptr));
+
+	std::cout << "packets      sort ms   submit ms   ns/packet   draws   submitted   filtered\n";
+
+	bool sorted = true;
+
+	for (size_t count : sizes)
+	{
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+		std::vector<DrawPacket> packets(count);
+		for (DrawPacket& packet : packets)
+		{
+			uint32_t mesh = random() % meshes.size();
+
+			packet.sortKey = RenderQueue::MakeSortKey(RenderPassType::Opaque, mesh % 16, mesh, depth(random));
+			packet.vertexBuffer = meshes[mesh];
+			packet.indexBuffer = meshes[mesh];
+			packet.vertexStride = 32;
+			packet.indexCount = 36;
+			packet.constants.buffer = constants;
+			packet.constants.offset = (random() % 1024) * ConstantBufferRing::Alignment;
+			packet.constants.size = ConstantBufferRing::Alignment;
+		}
+
+		RenderQueue queue;
+		queue.Reserve(count);
+
+		Result result;
+		for (int repeat = 0; repeat < repeats; ++repeat)
+		{
+			queue.Clear();
+			for (const DrawPacket& packet : packets)
+				queue.Push(packet);
+
+			auto start = std::chrono::steady_clock::now();
+			queue.Sort();
+			result.sortMilliseconds = std::min(result.sortMilliseconds, Elapsed(start));
+
+			commandList.InvalidateState();
+			commandList.ResetStats();
+
+			start = std::chrono::steady_clock::now();
+			queue.Submit(commandList);
+			result.submitMilliseconds = std::min(result.submitMilliseconds, Elapsed(start));
+			result.commands = commandList.GetStats();
+		}
+
+		for (size_t i = 1; i < queue.GetCount(); ++i)
+			sorted = sorted && queue.GetPacket(i - 1).sortKey <= queue.GetPacket(i).sortKey;
+
+		const double perPacket = (result.sortMilliseconds + result.submitMilliseconds) * 1e6 / static_cast<double>(count);
+
+		std::cout.width(7);
+		std::cout << count << "  ";
+		std::cout.width(10);
+		std::cout << result.sortMilliseconds << "  ";
+		std::cout.width(10);
+		std::cout << result.submitMilliseconds << "  ";
+		std::cout.width(10);
+		std::cout << perPacket << "  ";
+		std::cout.width(6);
+		std::cout << result.commands.draws << "  ";
+		std::cout.width(10);
+		std::cout << result.commands.submitted << "  ";
+		std::cout.width(9);
+		std::cout << result.commands.filtered << "\n";
+	}
+
+	if (!sorted)
+		std::cerr << "[RenderQueueBench] Queue is not in key order after Sort().\n";
+
+	return sorted ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+#include "TestFramework.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/CommandList.h"
+#include "Graphics/Pipeline.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+#include <cstring>
+
+using namespace Graphics;
+
+namespace
+{
+	struct Instance
+	{
+		float world[16];
+	};
+
+	Instance MakeInstance(float value)
+	{
+		Instance instance = {};
+		instance.world[0] = value;
+		return instance;
+	}
+
+	struct Scene
+	{
+		NullBackend backend;
+		Device device;
+		CommandList commandList;
+		Pipeline pipeline; // Never initialized, only compared by address
+		Pipeline instancedPipeline;
+		ID3D11Buffer* meshes[2] = {};
+
+		Scene()
+		{
+			device.Initialize(backend);
+			commandList.Initialize(backend);
+
+			BackendBufferDesc desc;
+			desc.size = 4096;
+			for (ID3D11Buffer*& mesh : meshes)
+				mesh = FromBackendHandle<ID3D11Buffer>(backend.CreateBuffer(desc, nullptr));
+		}
+
+		DrawPacket MakePacket(uint32_t mesh, float depth = 0.5f) const
+		{
+			DrawPacket packet;
+			packet.sortKey = RenderQueue::MakeSortKey(RenderPassType::Opaque, 0, mesh, depth);
+			packet.pipeline = &pipeline;
+			packet.instancedPipeline = &instancedPipeline;
+			packet.vertexBuffer = meshes[mesh];
+			packet.indexBuffer = meshes[mesh];
+			packet.vertexStride = 32;
+			packet.indexCount = 36;
+			return packet;
+		}
+
+		std::vector<BackendCommand> GetDraws() const
+		{
+			std::vector<BackendCommand> draws;
+			for (const BackendCommand& command : backend.GetCommands())
+			{
+				if (command.type == BackendCommandType::DrawIndexed)
+					draws.push_back(command);
+			}
+			return draws;
+		}
+	};
+}
+
+TEST_CASE(OpaqueSortsByStateThenFrontToBack)
+{
+	uint64_t nearA = RenderQueue::MakeSortKey(RenderPassType::Opaque, 1, 5, 0.1f);
+	uint64_t farA = RenderQueue::MakeSortKey(RenderPassType::Opaque, 1, 5, 0.9f);
+	uint64_t nearB = RenderQueue::MakeSortKey(RenderPassType::Opaque, 2, 5, 0.1f);
+	uint64_t depth = RenderQueue::MakeSortKey(RenderPassType::Depth, 9, 9, 1.0f);
+
+	CHECK(nearA < farA);
+	CHECK(farA < nearB); // Pipeline outranks depth
+	CHECK(depth < nearA); // Pass outranks everything
+
+	// Blending needs back-to-front, depth outranks state
+	uint64_t nearT = RenderQueue::MakeSortKey(RenderPassType::Transparent, 1, 5, 0.1f);
+	uint64_t farT = RenderQueue::MakeSortKey(RenderPassType::Transparent, 2, 5, 0.9f);
+	CHECK(farT < nearT);
+
+	CHECK(RenderQueue::QuantizeDepth(-1.0f) == 0);
+	CHECK(RenderQueue::QuantizeDepth(2.0f) == (1u << RenderQueue::DepthBits) - 1);
+}
+
+TEST_CASE(SortIsStableForEqualKeys)
+{
+	Scene scene;
+	RenderQueue queue;
+
+	for (uint32_t i = 0; i < 100; ++i)
+	{
+		DrawPacket packet = scene.MakePacket(0);
+		packet.sortKey = RenderQueue::MakeSortKey(RenderPassType::Opaque, i % 3, 0, 0.5f);
+		packet.startIndex = i; // Push order
+		queue.Push(packet);
+	}
+
+	queue.Sort();
+
+	for (size_t i = 1; i < queue.GetCount(); ++i)
+	{
+		const DrawPacket& previous = queue.GetPacket(i - 1);
+		const DrawPacket& packet = queue.GetPacket(i);
+		CHECK(previous.sortKey <= packet.sortKey);
+		if (previous.sortKey == packet.sortKey)
+			CHECK(previous.startIndex < packet.startIndex);
+	}
+}
+
+TEST_CASE(IdenticalMeshesGroupIntoOneBatch)
+{
+	Scene scene;
+	RenderQueue queue;
+
+	// Interleaved in push order, adjacent once sorted by mesh
+	for (uint32_t i = 0; i < 10; ++i)
+	{
+		Instance instance = MakeInstance(static_cast<float>(i));
+		queue.Push(scene.MakePacket(i % 2, 0.01f * i), &instance);
+	}
+
+	queue.Sort();
+	CHECK(queue.GetBatchCount() == 2);
+	CHECK(queue.GetBatch(0).count == 5);
+	CHECK(queue.GetBatch(1).first == 5);
+	CHECK(queue.GetBatch(1).count == 5);
+}
+
+TEST_CASE(AnyDifferenceInDrawStateBreaksTheBatch)
+{
+	Scene scene;
+	RenderQueue queue;
+	Instance instance = MakeInstance(1.0f);
+
+	DrawPacket packet = scene.MakePacket(0);
+	queue.Push(packet, &instance);
+	queue.Push(packet, &instance);
+
+	DrawPacket otherRange = packet;
+	otherRange.startIndex = 36;
+	otherRange.sortKey++;
+	queue.Push(otherRange, &instance);
+
+	DrawPacket otherPipeline = packet;
+	Pipeline pipeline;
+	otherPipeline.instancedPipeline = &pipeline;
+	otherPipeline.sortKey += 2;
+	queue.Push(otherPipeline, &instance);
+
+	DrawPacket notInstanced = packet;
+	notInstanced.sortKey += 3;
+	queue.Push(notInstanced); // No instance data, never joins a batch
+	queue.Push(notInstanced);
+
+	queue.Sort();
+	CHECK(queue.GetBatchCount() == 5);
+	CHECK(queue.GetBatch(0).count == 2);
+	CHECK(queue.GetBatch(3).count == 1);
+	CHECK(queue.GetBatch(4).count == 1);
+}
+
+TEST_CASE(BatchesAreCappedAtMaxInstances)
+{
+	Scene scene;
+	RenderQueue queue;
+	queue.SetMaxInstancesPerBatch(4);
+
+	Instance instance = MakeInstance(1.0f);
+	for (uint32_t i = 0; i < 10; ++i)
+		queue.Push(scene.MakePacket(0), &instance);
+
+	queue.Sort();
+	CHECK(queue.GetBatchCount() == 3);
+	CHECK(queue.GetBatch(0).count == 4);
+	CHECK(queue.GetBatch(1).count == 4);
+	CHECK(queue.GetBatch(2).count == 2);
+}
+
+TEST_CASE(InstancesAreUploadedInDrawOrder)
+{
+	Scene scene;
+	TransientUploadHeap uploadHeap;
+	ConstantBufferRing constantRing;
+	CHECK(uploadHeap.Initialize(scene.device, 64 * 1024, 1024));
+	CHECK(constantRing.Initialize(scene.device, 4096, 2));
+	uploadHeap.BeginFrame();
+
+	RenderQueue queue;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		Instance instance = MakeInstance(static_cast<float>(i));
+		queue.Push(scene.MakePacket(0, 1.0f - 0.1f * i), &instance); // Pushed far to near
+	}
+
+	queue.Sort();
+	CHECK(queue.PrepareInstances(nullptr, uploadHeap, constantRing));
+
+	const DrawBatch& batch = queue.GetBatch(0);
+	CHECK(batch.instances.IsValid());
+	CHECK(batch.instances.GetCount() == 8);
+
+	// Sorted near to far, so the instance stream is the reverse of the push order
+	const uint8_t* memory = static_cast<const uint8_t*>(scene.backend.Map(ToBackendHandle(batch.instances.buffer), BackendMap::NoOverwrite));
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		Instance instance;
+		memcpy(&instance, memory + batch.instances.offset + i * sizeof(Instance), sizeof(Instance));
+		CHECK(instance.world[0] == static_cast<float>(7 - i));
+	}
+
+	scene.backend.SetRecording(true);
+	queue.Submit(scene.commandList);
+
+	std::vector<BackendCommand> draws = scene.GetDraws();
+	CHECK(draws.size() == 1);
+	CHECK(draws[0].args[1] == 8); // instanceCount
+	CHECK(draws[0].args[4] == batch.instances.GetFirstElement());
+	CHECK(constantRing.GetStats().allocations == 0);
+}
+
+TEST_CASE(BatchesThatDoNotFitAreDrawnWithRingConstants)
+{
+	Scene scene;
+	TransientUploadHeap uploadHeap;
+	ConstantBufferRing constantRing;
+	CHECK(uploadHeap.Initialize(scene.device, 256, 256)); // Room for the first batch only
+	CHECK(constantRing.Initialize(scene.device, 4096, 2));
+	uploadHeap.BeginFrame();
+	constantRing.BeginFrame(nullptr);
+
+	RenderQueue queue;
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		Instance instance = MakeInstance(static_cast<float>(i));
+		queue.Push(scene.MakePacket(i / 3), &instance); // Two batches of three
+	}
+
+	queue.Sort();
+	CHECK(!queue.PrepareInstances(nullptr, uploadHeap, constantRing));
+	CHECK(queue.GetBatch(0).instances.IsValid());
+	CHECK(!queue.GetBatch(1).instances.IsValid());
+	CHECK(constantRing.GetStats().allocations == 3);
+
+	scene.backend.SetRecording(true);
+	queue.Submit(scene.commandList);
+
+	// One instanced draw, then the three packets that did not fit one by one, none of them dropped
+	std::vector<BackendCommand> draws = scene.GetDraws();
+	CHECK(draws.size() == 4);
+	CHECK(draws[0].args[1] == 3);
+	for (size_t i = 1; i < draws.size(); ++i)
+		CHECK(draws[i].args[1] == 1);
+
+	// Each carries its own instance data as constants
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		const ConstantAllocation& constants = queue.GetPacket(3 + i).constants;
+		CHECK(constants.IsValid());
+
+		const uint8_t* memory = static_cast<const uint8_t*>(scene.backend.Map(ToBackendHandle(constants.buffer), BackendMap::NoOverwrite));
+		Instance instance;
+		memcpy(&instance, memory + constants.offset, sizeof(Instance));
+		CHECK(instance.world[0] == static_cast<float>(3 + i));
+	}
+}
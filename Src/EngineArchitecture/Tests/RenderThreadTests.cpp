@@ -0,0 +1,346 @@
+#include "TestFramework.h"
+#include "Core/RenderThread.h"
+#include "Graphics/NullBackend.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace Core;
+using namespace Graphics;
+
+namespace
+{
+	struct Scene;
+
+	// What the game thread hands over: per-frame data plus the resource work to do before drawing it
+	struct Packet
+	{
+		uint64_t frameIndex = 0;
+		std::vector<uint32_t> instances;
+		std::vector<std::function<void(Scene& scene)>> resourceCommands;
+	};
+
+	// The fake device: a NullBackend that counts every call made from any thread but the render thread
+	class ThreadCheckedBackend : public NullBackend
+	{
+	public:
+		const RenderThread<Packet>* renderThread = nullptr;
+		std::atomic<uint32_t> offThreadCalls { 0 };
+
+		BackendHandle CreateBuffer(const BackendBufferDesc& desc, const void* initialData) override
+		{
+			Check();
+			return NullBackend::CreateBuffer(desc, initialData);
+		}
+
+		void Destroy(BackendHandle handle) override
+		{
+			Check();
+			NullBackend::Destroy(handle);
+		}
+
+		void SetVertexBuffer(uint32_t slot, BackendHandle buffer, uint32_t stride, uint32_t offset) override
+		{
+			Check();
+			NullBackend::SetVertexBuffer(slot, buffer, stride, offset);
+		}
+
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override
+		{
+			Check();
+			NullBackend::DrawIndexed(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+		}
+
+		void Present(BackendHandle color) override
+		{
+			Check();
+			NullBackend::Present(color);
+		}
+
+	private:
+		void Check()
+		{
+			if (!renderThread || !renderThread->IsRenderThread())
+				offThreadCalls++;
+		}
+	};
+
+	// Render thread state, only the executor touches it while the thread runs
+	struct Scene
+	{
+		ThreadCheckedBackend backend;
+		BackendHandle vertexBuffer = 0;
+		BackendHandle indexBuffer = 0;
+		std::vector<BackendHandle> meshes; // Every vertex buffer created, in order
+		uint64_t nextFrame = 0;
+		bool inOrder = true;
+		bool intact = true;
+		bool drewWithoutMesh = false;
+
+		void CreateMesh()
+		{
+			BackendBufferDesc desc;
+			desc.size = 24 * 32;
+			vertexBuffer = backend.CreateBuffer(desc, nullptr);
+
+			desc.kind = BackendBufferKind::Index;
+			desc.size = 36 * 4;
+			indexBuffer = backend.CreateBuffer(desc, nullptr);
+			meshes.push_back(vertexBuffer);
+		}
+
+		void DestroyMesh()
+		{
+			backend.Destroy(vertexBuffer);
+			backend.Destroy(indexBuffer);
+			vertexBuffer = 0;
+			indexBuffer = 0;
+		}
+
+		void Execute(Packet& packet)
+		{
+			for (const auto& command : packet.resourceCommands)
+				command(*this);
+			packet.resourceCommands.clear();
+
+			inOrder = inOrder && packet.frameIndex == nextFrame++;
+			for (size_t i = 0; i < packet.instances.size(); ++i)
+				intact = intact && packet.instances[i] == packet.frameIndex * 100 + i;
+
+			if (!vertexBuffer)
+			{
+				drewWithoutMesh = true;
+				return;
+			}
+
+			backend.SetVertexBuffer(0, vertexBuffer, 32, 0);
+			backend.DrawIndexed(36, static_cast<uint32_t>(packet.instances.size()), 0, 0, 0);
+			backend.Present(0);
+		}
+	};
+
+	void Record(Packet& packet, uint64_t frameIndex)
+	{
+		packet.frameIndex = frameIndex;
+		packet.instances.resize(1 + frameIndex % 8);
+		for (size_t i = 0; i < packet.instances.size(); ++i)
+			packet.instances[i] = static_cast<uint32_t>(frameIndex * 100 + i);
+	}
+
+	void Spend(double milliseconds)
+	{
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(milliseconds));
+	}
+}
+
+TEST_CASE(StartRejectsBadArguments)
+{
+	RenderThread<Packet> renderThread;
+	CHECK(!renderThread.Start(nullptr));
+	CHECK(!renderThread.Start([](Packet&) {}, 0));
+
+	CHECK(renderThread.Start([](Packet&) {}, 3));
+	CHECK(!renderThread.Start([](Packet&) {})); // Already running
+	CHECK(renderThread.GetPacketCount() == 3);
+	CHECK(!renderThread.IsRenderThread());
+	renderThread.Stop();
+	renderThread.Stop(); // Twice is harmless
+
+	// Restartable once stopped
+	std::atomic<uint32_t> executed { 0 };
+	CHECK(renderThread.Start([&executed](Packet&) { executed++; }, 2));
+	renderThread.BeginFrame();
+	renderThread.Submit();
+	renderThread.Stop();
+	CHECK(executed.load() == 1);
+}
+
+TEST_CASE(PacketsExecuteInOrderOnTheRenderThread)
+{
+	for (uint32_t packetCount = 1; packetCount <= 3; ++packetCount)
+	{
+		Scene scene;
+		RenderThread<Packet> renderThread;
+		scene.backend.renderThread = &renderThread;
+		scene.CreateMesh(); // Before Start, counted as off-thread below
+		CHECK(scene.backend.offThreadCalls.load() == 2);
+		scene.backend.offThreadCalls = 0;
+
+		CHECK(renderThread.Start([&scene](Packet& packet) { scene.Execute(packet); }, packetCount));
+
+		for (uint64_t frame = 0; frame < 500; ++frame)
+		{
+			Packet& packet = renderThread.BeginFrame();
+			Record(packet, frame); // Overwrites what this packet carried packetCount frames ago
+			renderThread.Submit();
+		}
+
+		renderThread.Stop();
+
+		// Joined, the scene is the game thread's again
+		CHECK(scene.inOrder);
+		CHECK(scene.intact);
+		CHECK(scene.nextFrame == 500);
+		CHECK(scene.backend.GetStats().frames == 500);
+		CHECK(scene.backend.offThreadCalls.load() == 0);
+
+		RenderThreadStats stats = renderThread.GetStats();
+		CHECK(stats.framesSubmitted == 500);
+		CHECK(stats.framesExecuted == 500);
+		CHECK(stats.maxQueueDepth <= packetCount);
+	}
+}
+
+TEST_CASE(ResourceCommandsRunBeforeTheirFrame)
+{
+	Scene scene;
+	RenderThread<Packet> renderThread;
+	scene.backend.renderThread = &renderThread;
+	scene.backend.SetRecording(true);
+	CHECK(renderThread.Start([&scene](Packet& packet) { scene.Execute(packet); }, 2));
+
+	// Recorded on the game thread, they only ever touch the device from the render thread
+	std::vector<std::function<void(Scene& scene)>> resourceCommands;
+	resourceCommands.push_back([](Scene& scene) { scene.CreateMesh(); });
+
+	const uint64_t frameCount = 100;
+	const uint64_t recreateFrame = 50; // A resize or a streamed LOD: the mesh is replaced between two frames
+
+	for (uint64_t frame = 0; frame < frameCount; ++frame)
+	{
+		if (frame == recreateFrame)
+		{
+			resourceCommands.push_back([](Scene& scene) { scene.DestroyMesh(); });
+			resourceCommands.push_back([](Scene& scene) { scene.CreateMesh(); });
+		}
+
+		Packet& packet = renderThread.BeginFrame();
+		Record(packet, frame);
+		CHECK(packet.resourceCommands.empty()); // Cleared by the executor before the packet came back
+		packet.resourceCommands.swap(resourceCommands);
+		renderThread.Submit();
+	}
+
+	renderThread.Stop();
+
+	CHECK(!scene.drewWithoutMesh);
+	CHECK(scene.backend.offThreadCalls.load() == 0);
+	CHECK(scene.meshes.size() == 2);
+
+	const NullBackendStats& stats = scene.backend.GetStats();
+	CHECK(stats.buffersCreated == 4);
+	CHECK(stats.destroyed == 2);
+	CHECK(stats.liveResources == 2);
+	CHECK(stats.frames == frameCount);
+
+	if (scene.meshes.size() != 2)
+		return;
+
+	// Frames before the swap draw the first mesh, every frame from the swap on the second
+	bool firstMesh = true;
+	bool secondMesh = true;
+	uint64_t presented = 0;
+	for (const BackendCommand& command : scene.backend.GetCommands())
+	{
+		if (command.type == BackendCommandType::Present)
+			presented++;
+		else if (command.type == BackendCommandType::SetVertexBuffer && presented < recreateFrame)
+			firstMesh = firstMesh && command.handle == scene.meshes[0];
+		else if (command.type == BackendCommandType::SetVertexBuffer)
+			secondMesh = secondMesh && command.handle == scene.meshes[1];
+	}
+
+	CHECK(firstMesh);
+	CHECK(secondMesh);
+	CHECK(presented == frameCount);
+}
+
+TEST_CASE(GameThreadStaysAtMostPacketCountAhead)
+{
+	for (uint32_t packetCount = 1; packetCount <= 3; ++packetCount)
+	{
+		std::atomic<uint64_t> submitted { 0 };
+		bool bounded = true;
+
+		RenderThread<Packet> renderThread;
+		CHECK(renderThread.Start([&submitted, &bounded, packetCount](Packet& packet)
+		{
+			Spend(0.5); // Render bound, the game thread catches up and has to wait
+			bounded = bounded && submitted.load() <= packet.frameIndex + packetCount;
+		}, packetCount));
+
+		for (uint64_t frame = 0; frame < 40; ++frame)
+		{
+			Packet& packet = renderThread.BeginFrame();
+			packet.frameIndex = frame;
+			renderThread.Submit();
+			submitted++;
+		}
+
+		renderThread.Stop();
+		CHECK(bounded);
+
+		RenderThreadStats stats = renderThread.GetStats();
+		CHECK(stats.maxQueueDepth <= packetCount);
+		CHECK(stats.gameStall.GetAverage() > stats.renderIdle.GetAverage());
+		CHECK(stats.execute.samples == 40);
+	}
+}
+
+TEST_CASE(FlushWaitsForEverySubmittedPacket)
+{
+	std::atomic<uint64_t> executed { 0 };
+	RenderThread<Packet> renderThread;
+	CHECK(renderThread.Start([&executed](Packet& packet)
+	{
+		if (packet.frameIndex % 5 == 0)
+			Spend(0.2);
+		executed++;
+	}, 3));
+
+	bool flushed = true;
+	uint64_t frame = 0;
+	for (uint32_t round = 0; round < 100; ++round)
+	{
+		for (uint32_t i = 0; i < 1 + round % 4; ++i)
+		{
+			Packet& packet = renderThread.BeginFrame();
+			packet.frameIndex = frame++;
+			renderThread.Submit();
+		}
+
+		renderThread.Flush();
+		flushed = flushed && executed.load() == frame;
+	}
+
+	CHECK(flushed);
+	renderThread.Flush(); // Nothing pending, returns at once
+	renderThread.Stop();
+}
+
+TEST_CASE(StopExecutesEverySubmittedPacket)
+{
+	for (uint32_t round = 0; round < 30; ++round)
+	{
+		const uint32_t packetCount = 1 + round % 3;
+		std::atomic<uint32_t> executed { 0 };
+
+		RenderThread<Packet> renderThread;
+		CHECK(renderThread.Start([&executed](Packet&)
+		{
+			Spend(0.1);
+			executed++;
+		}, packetCount));
+
+		for (uint32_t i = 0; i < 2 * packetCount; ++i)
+		{
+			renderThread.BeginFrame();
+			renderThread.Submit();
+		}
+
+		renderThread.Stop();
+		CHECK(executed.load() == 2 * packetCount);
+	}
+}
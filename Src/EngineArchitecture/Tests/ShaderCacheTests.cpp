@@ -0,0 +1,287 @@
+#include "TestFramework.h"
+#include "Graphics/ShaderCache.h"
+#include "Graphics/ShaderCompiler.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace Graphics;
+
+namespace
+{
+	// Everything below lives in the working directory of the test, ctest runs it in the build tree
+	const char* const Directory = "ShaderCacheData";
+
+	void MakeDirectory(const std::string& path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	void WriteText(const std::string& path, const std::string& text)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file << text;
+	}
+
+	std::string ArchivePath(const char* name)
+	{
+		MakeDirectory(Directory);
+		std::string path = std::string(Directory) + "/" + name;
+		std::remove(path.c_str());
+		return path;
+	}
+
+	std::string ToString(ID3DBlob* blob)
+	{
+		return std::string(static_cast<const char*>(blob->GetBufferPointer()));
+	}
+
+	// Main.hlsl includes Common/Lighting.hlsl, which includes Brdf.hlsl next to itself, not next to Main.hlsl
+	void WriteShaders()
+	{
+		MakeDirectory(Directory);
+		MakeDirectory(std::string(Directory) + "/Common");
+
+		WriteText(std::string(Directory) + "/Main.hlsl", "#include \"Common/Lighting.hlsl\"\nfloat4 PS() : SV_Target { return Shade(); }\n");
+		WriteText(std::string(Directory) + "/Common/Lighting.hlsl", "#include \"Brdf.hlsl\"\nfloat4 Shade() { return Brdf(); }\n");
+		WriteText(std::string(Directory) + "/Common/Brdf.hlsl", "float4 Brdf() { return 1; } // common\n");
+		WriteText(std::string(Directory) + "/Brdf.hlsl", "float4 Brdf() { return 0; } // wrong directory\n");
+	}
+
+	const wchar_t* const MainPath = L"ShaderCacheData/Main.hlsl";
+}
+
+TEST_CASE(NestedIncludesResolveNextToTheIncludingFile)
+{
+	WriteShaders();
+
+	NullShaderCompiler compiler;
+	ShaderCache cache;
+	CHECK(cache.Initialize(ArchivePath("Nested.bin"), &compiler));
+
+	ID3DBlob* blob = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+	if (!blob)
+		return;
+
+	std::string bytecode = ToString(blob);
+	CHECK(bytecode.find("// common") != std::string::npos);
+	CHECK(bytecode.find("wrong directory") == std::string::npos);
+	CHECK(bytecode.find("Shade()") != std::string::npos);
+	blob->Release();
+}
+
+TEST_CASE(SecondCompileIsAnArchiveHit)
+{
+	WriteShaders();
+
+	NullShaderCompiler compiler;
+	ShaderCache cache;
+	CHECK(cache.Initialize(ArchivePath("Hit.bin"), &compiler));
+
+	ID3DBlob* first = nullptr;
+	ID3DBlob* second = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &first)));
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &second)));
+
+	CHECK(compiler.GetCompileCount() == 1);
+	CHECK(compiler.GetPreprocessCount() == 2); // Paid on every request
+	CHECK(cache.GetStats().misses == 1);
+	CHECK(cache.GetStats().hits == 1);
+
+	if (first && second)
+	{
+		CHECK(ToString(first) == ToString(second));
+		first->Release();
+		second->Release();
+	}
+
+	// Different macros are a different shader
+	ID3DBlob* variant = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", { { "SHADOWS", "1" } }, 0, &variant)));
+	CHECK(compiler.GetCompileCount() == 2);
+	if (variant)
+		variant->Release();
+}
+
+TEST_CASE(BytecodeSurvivesARestart)
+{
+	WriteShaders();
+	std::string path = ArchivePath("Restart.bin");
+
+	{
+		NullShaderCompiler compiler;
+		ShaderCache cache;
+		CHECK(cache.Initialize(path, &compiler));
+
+		ID3DBlob* blob = nullptr;
+		CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+		if (blob)
+			blob->Release();
+	} // Release() flushes
+
+	NullShaderCompiler compiler;
+	ShaderCache cache;
+	CHECK(cache.Initialize(path, &compiler));
+
+	ID3DBlob* blob = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+	CHECK(compiler.GetCompileCount() == 0);
+	CHECK(cache.GetStats().hits == 1);
+	if (blob)
+		blob->Release();
+}
+
+TEST_CASE(CompilerUpdateInvalidatesTheArchive)
+{
+	WriteShaders();
+	std::string path = ArchivePath("Version.bin");
+
+	{
+		NullShaderCompiler compiler("NullShaderCompiler 1");
+		ShaderCache cache;
+		CHECK(cache.Initialize(path, &compiler));
+
+		ID3DBlob* blob = nullptr;
+		CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+		if (blob)
+			blob->Release();
+	}
+
+	// Same sources, newer compiler: its output may differ, so nothing compiled by the old one is reused
+	NullShaderCompiler compiler("NullShaderCompiler 2");
+	ShaderCache cache;
+	CHECK(cache.Initialize(path, &compiler));
+
+	ID3DBlob* blob = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+	CHECK(compiler.GetCompileCount() == 1);
+	CHECK(cache.GetStats().misses == 1);
+	if (blob)
+		blob->Release();
+}
+
+TEST_CASE(EditingANestedIncludeRecompiles)
+{
+	WriteShaders();
+
+	NullShaderCompiler compiler;
+	ShaderCache cache;
+	CHECK(cache.Initialize(ArchivePath("Edit.bin"), &compiler));
+
+	ID3DBlob* blob = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+	if (blob)
+		blob->Release();
+
+	WriteText(std::string(Directory) + "/Common/Brdf.hlsl", "float4 Brdf() { return 2; } // common, edited\n");
+
+	blob = nullptr;
+	CHECK(SUCCEEDED(cache.Compile(MainPath, "PS", "ps_5_0", &blob)));
+	CHECK(compiler.GetCompileCount() == 2);
+	if (blob)
+	{
+		CHECK(ToString(blob).find("edited") != std::string::npos);
+		blob->Release();
+	}
+}
+
+TEST_CASE(CompileErrorsAreNotCached)
+{
+	WriteShaders();
+
+	NullShaderCompiler compiler;
+	ShaderCache cache;
+	CHECK(cache.Initialize(ArchivePath("Error.bin"), &compiler));
+
+	ID3DBlob* blob = nullptr;
+	CHECK(FAILED(cache.Compile(MainPath, "MissingEntry", "ps_5_0", &blob)));
+	CHECK(FAILED(cache.Compile(MainPath, "MissingEntry", "ps_5_0", &blob)));
+	CHECK(compiler.GetCompileCount() == 2);
+	CHECK(cache.GetStats().hits == 0);
+
+	CHECK(FAILED(cache.Compile(L"ShaderCacheData/Missing.hlsl", "PS", "ps_5_0", &blob)));
+	CHECK(compiler.GetPreprocessCount() == 2); // Never got that far
+}
+
+TEST_CASE(ArchiveSurvivesAnInterruptedFlush)
+{
+	std::string path = ArchivePath("Interrupted.bin");
+	const std::string first = "first blob";
+	const std::string second = "second blob";
+
+	ShaderArchive::Header oldHeader = {};
+	{
+		ShaderArchive archive;
+		CHECK(archive.Open(path));
+		archive.Store(1, first.data(), first.size());
+		CHECK(archive.Flush());
+
+		std::ifstream file(path, std::ios::binary);
+		file.read(reinterpret_cast<char*>(&oldHeader), sizeof(oldHeader));
+		uint64_t oldEnd = archive.GetDataEnd();
+
+		archive.Store(2, second.data(), second.size());
+		CHECK(archive.Flush());
+		CHECK(archive.GetDataEnd() > oldEnd);
+	}
+
+	// Put back the header of the first flush: what a crash before the second header write leaves behind
+	{
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&oldHeader), sizeof(oldHeader));
+	}
+
+	ShaderArchive archive;
+	CHECK(archive.Open(path));
+	CHECK(archive.GetEntryCount() == 1);
+
+	const void* data = nullptr;
+	size_t size = 0;
+	CHECK(archive.Find(1, &data, &size));
+	CHECK(size == first.size() && std::string(static_cast<const char*>(data), size) == first);
+	CHECK(!archive.Find(2, &data, &size));
+}
+
+TEST_CASE(ArchiveCompactsDeadSpace)
+{
+	std::string path = ArchivePath("Compact.bin");
+	std::string blob(64 * 1024, 'a');
+
+	ShaderArchive archive;
+	CHECK(archive.Open(path));
+
+	// Every flush replaces the same key, the old copies are dead
+	uint64_t peak = 0;
+	for (uint32_t i = 0; i < 16; ++i)
+	{
+		blob[0] = static_cast<char>('a' + i);
+		archive.Store(7, blob.data(), blob.size());
+		CHECK(archive.Flush());
+		peak = archive.GetDataEnd() > peak ? archive.GetDataEnd() : peak;
+	}
+
+	CHECK(peak < 16 * blob.size()); // Without compaction every copy would still be there
+	CHECK(archive.GetEntryCount() == 1);
+
+	std::ifstream temporary(path + ".tmp");
+	CHECK(!temporary);
+
+	ShaderArchive reopened;
+	CHECK(reopened.Open(path));
+
+	const void* data = nullptr;
+	size_t size = 0;
+	CHECK(reopened.Find(7, &data, &size));
+	CHECK(size == blob.size() && static_cast<const char*>(data)[0] == 'a' + 15);
+}
@@ -0,0 +1,171 @@
+#include "Core/JobSystem.h"
+#include "Graphics/SoftwareBackend.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace Graphics;
+
+// Triangle throughput of the software rasterizer at 1280x720, one frame of TriangleCount triangles per run:
+// quads of a given size laid out in rows across the target, layer after layer, each layer a little nearer so
+// every pixel passes the depth test. Small triangles measure setup and binning, large ones fill rate.
+//
+//   SoftwareBackendBench [repeats]   best of repeats (default 5) per triangle size, non-zero exit if a frame lost pixels
+
+namespace
+{
+	const uint32_t Width = 1280;
+	const uint32_t Height = 720;
+	const uint32_t TriangleCount = 1 << 19;
+
+	struct Vertex
+	{
+		float position[4];
+		float color[4];
+	};
+
+	double Elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Pixels a frame must write: each quad covers size x size pixel centers, nothing overlaps within a layer
+	uint64_t BuildQuads(uint32_t size, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const uint32_t columns = Width / size;
+		const uint32_t rows = Height / size;
+		const uint32_t perLayer = columns * rows;
+		const uint32_t quadCount = TriangleCount / 2;
+
+		vertices.resize(quadCount * 4);
+		indices.resize(quadCount * 6);
+
+		for (uint32_t quad = 0; quad < quadCount; ++quad)
+		{
+			uint32_t cell = quad % perLayer;
+			float left = static_cast<float>((cell % columns) * size) / Width * 2.0f - 1.0f;
+			float top = 1.0f - static_cast<float>((cell / columns) * size) / Height * 2.0f;
+			float right = left + 2.0f * size / Width;
+			float bottom = top - 2.0f * size / Height;
+			float z = 1.0f - static_cast<float>(quad / perLayer + 1) / (quadCount / perLayer + 2); // Nearer every layer
+			float shade = static_cast<float>(quad & 255) / 255.0f;
+
+			Vertex* v = &vertices[quad * 4];
+			v[0] = { { left, top, z, 1.0f }, { shade, 0.5f, 1.0f - shade, 1.0f } };
+			v[1] = { { right, top, z, 1.0f }, { shade, 0.5f, 1.0f - shade, 1.0f } };
+			v[2] = { { left, bottom, z, 1.0f }, { shade, 0.5f, 1.0f - shade, 1.0f } };
+			v[3] = { { right, bottom, z, 1.0f }, { shade, 0.5f, 1.0f - shade, 1.0f } };
+
+			const uint32_t quadIndices[6] = { 0, 1, 2, 2, 1, 3 };
+			for (uint32_t i = 0; i < 6; ++i)
+				indices[quad * 6 + i] = quad * 4 + quadIndices[i];
+		}
+
+		return static_cast<uint64_t>(quadCount) * size * size;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const int repeats = (argc > 1) ? std::max(1, atoi(argv[1])) : 5;
+
+	Core::JobSystem jobs;
+	jobs.Initialize();
+	SoftwareBackend backend(&jobs);
+
+	const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	float camera[32];
+	memcpy(camera, identity, sizeof(identity));
+	memcpy(camera + 16, identity, sizeof(identity));
+
+	BackendBufferDesc constants;
+	constants.kind = BackendBufferKind::Constant;
+	constants.size = sizeof(camera);
+	backend.SetConstantBuffer(0, backend.CreateBuffer(constants, camera), 0, 0);
+	constants.size = sizeof(identity);
+	backend.SetConstantBuffer(1, backend.CreateBuffer(constants, identity), 0, 0);
+
+	BackendTextureDesc texture;
+	texture.width = Width;
+	texture.height = Height;
+	BackendHandle color = backend.CreateTexture(texture);
+	texture.format = BackendFormat::D24UnormS8UInt;
+	BackendHandle depth = backend.CreateTexture(texture);
+
+	BackendPipelineDesc pipeline;
+	pipeline.elements.push_back({ "POSITION", 0, BackendFormat::RGBA32Float, 0, 0, false });
+	pipeline.elements.push_back({ "COLOR", 0, BackendFormat::RGBA32Float, 0, 16, false });
+	pipeline.vertexShaderEntry = "VS";
+	pipeline.pixelShaderEntry = "PS";
+	pipeline.cullMode = BackendCull::None;
+
+	backend.SetRenderTargets(color, depth);
+	backend.SetViewport(static_cast<float>(Width), static_cast<float>(Height));
+	backend.SetTopology(BackendTopology::TriangleList);
+	backend.SetPipeline(backend.CreatePipeline(pipeline));
+
+	bool correct = true;
+	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	std::cout << "Software rasterizer, " << Width << "x" << Height << ", " << TriangleCount << " triangles per frame, " << jobs.GetWorkerCount() << " workers\n";
+	std::cout << "quad px   frame ms   geometry ms   raster ms   Mtri/s   Mpix/s\n" << std::fixed;
+
+	for (uint32_t size : { 2u, 8u, 32u })
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		uint64_t expectedPixels = BuildQuads(size, vertices, indices);
+
+		BackendBufferDesc desc;
+		desc.size = static_cast<uint32_t>(vertices.size() * sizeof(Vertex));
+		BackendHandle vertexBuffer = backend.CreateBuffer(desc, vertices.data());
+		desc.kind = BackendBufferKind::Index;
+		desc.size = static_cast<uint32_t>(indices.size() * sizeof(uint32_t));
+		BackendHandle indexBuffer = backend.CreateBuffer(desc, indices.data());
+
+		backend.SetVertexBuffer(0, vertexBuffer, sizeof(Vertex), 0);
+		backend.SetIndexBuffer(indexBuffer, BackendFormat::R32UInt, 0);
+
+		double best = 1e30;
+		SoftwareBackendStats stats;
+		for (int repeat = 0; repeat < repeats; ++repeat)
+		{
+			backend.ClearColor(color, clearColor);
+			backend.ClearDepth(depth, 1.0f);
+			backend.ResetStats();
+
+			auto start = std::chrono::steady_clock::now();
+			backend.DrawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+			backend.Present(color); // Rasterizes every tile before it returns
+			double milliseconds = Elapsed(start);
+
+			if (milliseconds < best)
+			{
+				best = milliseconds;
+				stats = backend.GetStats();
+			}
+			correct = correct && backend.GetStats().pixelsWritten == expectedPixels;
+		}
+
+		backend.Destroy(vertexBuffer);
+		backend.Destroy(indexBuffer);
+
+		std::cout << std::setw(7) << size << std::setprecision(2) << std::setw(11) << best << std::setw(14) << stats.geometryMilliseconds
+			<< std::setw(12) << stats.rasterMilliseconds << std::setw(9) << TriangleCount / best / 1000.0
+			<< std::setw(9) << stats.pixelsWritten / best / 1000.0 << "\n";
+	}
+
+	jobs.Shutdown();
+
+	if (!correct)
+	{
+		std::cout << "Pixels written do not match the quads drawn.\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+#include "TestFramework.h"
+#include "Core/JobSystem.h"
+#include "Graphics/SoftwareBackend.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace Graphics;
+
+namespace
+{
+	struct Vertex
+	{
+		float position[4];
+		float color[4];
+	};
+
+	const uint32_t Red = 0xFF0000FF; // RGBA8, R in the low byte
+	const uint32_t Green = 0xFF00FF00;
+	const uint32_t Blue = 0xFFFF0000;
+
+	uint32_t ToDepth(float z)
+	{
+		return static_cast<uint32_t>(std::lrint(z * 16777215.0f));
+	}
+
+	// A color and a depth target of an odd size, so tiles at the right and bottom edge are partial.
+	// Identity camera and world: vertex positions are clip space, quads are given in pixels.
+	struct Target
+	{
+		Core::JobSystem jobs;
+		SoftwareBackend backend;
+		uint32_t width;
+		uint32_t height;
+		BackendHandle color = 0;
+		BackendHandle depth = 0;
+
+		Target(uint32_t width, uint32_t height, uint32_t workers = 4)
+			: backend(&jobs), width(width), height(height)
+		{
+			jobs.Initialize(workers); // Tiles are rasterized in parallel
+
+			const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+			float camera[32];
+			memcpy(camera, identity, sizeof(identity));
+			memcpy(camera + 16, identity, sizeof(identity));
+
+			BackendBufferDesc constants;
+			constants.kind = BackendBufferKind::Constant;
+			constants.size = sizeof(camera);
+			BackendHandle cameraBuffer = backend.CreateBuffer(constants, camera);
+			constants.size = sizeof(identity);
+			BackendHandle objectBuffer = backend.CreateBuffer(constants, identity);
+
+			BackendTextureDesc texture;
+			texture.width = width;
+			texture.height = height;
+			color = backend.CreateTexture(texture);
+			texture.format = BackendFormat::D24UnormS8UInt;
+			depth = backend.CreateTexture(texture);
+
+			backend.SetRenderTargets(color, depth);
+			backend.SetViewport(static_cast<float>(width), static_cast<float>(height));
+			backend.SetTopology(BackendTopology::TriangleList);
+			backend.SetConstantBuffer(0, cameraBuffer, 0, 0);
+			backend.SetConstantBuffer(1, objectBuffer, 0, 0);
+		}
+
+		~Target() { jobs.Shutdown(); }
+
+		BackendHandle CreatePipeline(bool depthTest, BackendCompare depthFunc)
+		{
+			BackendPipelineDesc desc;
+			desc.elements.push_back({ "POSITION", 0, BackendFormat::RGBA32Float, 0, 0, false });
+			desc.elements.push_back({ "COLOR", 0, BackendFormat::RGBA32Float, 0, 16, false });
+			desc.vertexShaderEntry = "VS";
+			desc.pixelShaderEntry = "PS";
+			desc.cullMode = BackendCull::None;
+			desc.depthEnabled = depthTest;
+			desc.depthFunc = depthFunc;
+			return backend.CreatePipeline(desc);
+		}
+
+		void Clear(const float rgba[4], float z)
+		{
+			backend.ClearColor(color, rgba);
+			backend.ClearDepth(depth, z);
+		}
+
+		// Two triangles sharing the diagonal from the top right to the bottom left corner
+		void DrawQuad(float left, float top, float right, float bottom, float z, const float rgba[4])
+		{
+			auto x = [this](float pixel) { return pixel / width * 2.0f - 1.0f; };
+			auto y = [this](float pixel) { return 1.0f - pixel / height * 2.0f; };
+
+			Vertex vertices[4] =
+			{
+				{ { x(left), y(top), z, 1.0f }, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+				{ { x(right), y(top), z, 1.0f }, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+				{ { x(left), y(bottom), z, 1.0f }, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+				{ { x(right), y(bottom), z, 1.0f }, { rgba[0], rgba[1], rgba[2], rgba[3] } },
+			};
+			const uint16_t indices[6] = { 0, 1, 2, 2, 1, 3 };
+
+			BackendBufferDesc desc;
+			desc.size = sizeof(vertices);
+			BackendHandle vertexBuffer = backend.CreateBuffer(desc, vertices);
+			desc.kind = BackendBufferKind::Index;
+			desc.size = sizeof(indices);
+			BackendHandle indexBuffer = backend.CreateBuffer(desc, indices);
+
+			backend.SetVertexBuffer(0, vertexBuffer, sizeof(Vertex), 0);
+			backend.SetIndexBuffer(indexBuffer, BackendFormat::R16UInt, 0);
+			backend.DrawIndexed(6, 1, 0, 0, 0);
+
+			// Draws keep what they read, the buffers can go right away
+			backend.Destroy(vertexBuffer);
+			backend.Destroy(indexBuffer);
+		}
+
+		uint32_t Count(BackendHandle texture, uint32_t value)
+		{
+			std::vector<uint32_t> pixels;
+			uint32_t readWidth = 0;
+			uint32_t readHeight = 0;
+			backend.ReadPixels(texture, pixels, readWidth, readHeight);
+
+			uint32_t count = 0;
+			for (uint32_t pixel : pixels)
+				count += (pixel == value) ? 1 : 0;
+			return count;
+		}
+	};
+
+	const float Black[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const float RedColor[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+	const float GreenColor[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+	const float BlueColor[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+}
+
+TEST_CASE(FullTargetQuadWritesEveryPixelOnce)
+{
+	Target target(200, 150);
+	target.backend.SetPipeline(target.CreatePipeline(false, BackendCompare::Always)); // No depth test: a second write would count
+
+	target.Clear(Black, 1.0f);
+	target.backend.ResetStats();
+	target.DrawQuad(0.0f, 0.0f, 200.0f, 150.0f, 0.5f, RedColor);
+
+	CHECK(target.Count(target.color, Red) == 200 * 150);
+
+	const SoftwareBackendStats& stats = target.backend.GetStats();
+	CHECK(stats.trianglesBinned == 2);
+	CHECK(stats.pixelsWritten == 200 * 150); // The shared diagonal belongs to exactly one triangle
+}
+
+TEST_CASE(TopLeftRuleOnFractionalEdges)
+{
+	Target target(200, 150);
+	target.backend.SetPipeline(target.CreatePipeline(false, BackendCompare::Always));
+
+	// Pixel centers at x + 0.5: columns 10..50 and rows 20..40 are inside
+	target.Clear(Black, 1.0f);
+	target.backend.ResetStats();
+	target.DrawQuad(10.3f, 20.2f, 50.7f, 40.9f, 0.5f, RedColor);
+	CHECK(target.Count(target.color, Red) == 41 * 21);
+	CHECK(target.backend.GetStats().pixelsWritten == 41 * 21);
+
+	// Edges exactly on pixel centers: the left and top edge own them, the right and bottom edge do not
+	target.Clear(Black, 1.0f);
+	target.backend.ResetStats();
+	target.DrawQuad(64.5f, 63.5f, 130.5f, 100.5f, 0.5f, RedColor);
+	CHECK(target.Count(target.color, Red) == 66 * 37);
+	CHECK(target.backend.GetStats().pixelsWritten == 66 * 37);
+
+	// Four quads tiling the whole target across tile borders, every pixel exactly once
+	target.Clear(Black, 1.0f);
+	target.backend.ResetStats();
+	target.DrawQuad(0.0f, 0.0f, 77.25f, 64.5f, 0.5f, RedColor);
+	target.DrawQuad(77.25f, 0.0f, 200.0f, 64.5f, 0.5f, RedColor);
+	target.DrawQuad(0.0f, 64.5f, 77.25f, 150.0f, 0.5f, RedColor);
+	target.DrawQuad(77.25f, 64.5f, 200.0f, 150.0f, 0.5f, RedColor);
+	CHECK(target.Count(target.color, Red) == 200 * 150);
+	CHECK(target.backend.GetStats().pixelsWritten == 200 * 150);
+}
+
+TEST_CASE(LessRejectsAFartherQuad)
+{
+	Target target(130, 70, 2);
+	target.backend.SetPipeline(target.CreatePipeline(true, BackendCompare::Less));
+
+	target.Clear(Black, 1.0f);
+	target.DrawQuad(0.0f, 0.0f, 130.0f, 70.0f, 0.25f, RedColor);
+	CHECK(target.Count(target.depth, ToDepth(0.25f)) == 130 * 70); // Read back, so the quad is rasterized before the reset
+
+	target.backend.ResetStats();
+	target.DrawQuad(0.0f, 0.0f, 130.0f, 70.0f, 0.75f, GreenColor); // Behind
+	target.DrawQuad(0.0f, 0.0f, 130.0f, 70.0f, 0.25f, GreenColor); // Equal, not less
+	CHECK(target.Count(target.color, Red) == 130 * 70);
+	CHECK(target.Count(target.color, Green) == 0);
+	CHECK(target.backend.GetStats().pixelsWritten == 0);
+
+	// A nearer quad over the left half passes and writes its depth
+	target.DrawQuad(0.0f, 0.0f, 65.0f, 70.0f, 0.125f, BlueColor);
+	CHECK(target.Count(target.color, Blue) == 65 * 70);
+	CHECK(target.Count(target.color, Red) == 65 * 70);
+	CHECK(target.Count(target.depth, ToDepth(0.125f)) == 65 * 70);
+	CHECK(target.Count(target.depth, ToDepth(0.25f)) == 65 * 70);
+}
+
+TEST_CASE(ReadPixelsReturnsD24AndRGBA8)
+{
+	Target target(100, 60, 2);
+	target.backend.SetPipeline(target.CreatePipeline(true, BackendCompare::LessEqual));
+
+	const float clearColor[4] = { 0.0f, 0.2f, 0.4f, 1.0f };
+	target.Clear(clearColor, 1.0f);
+	target.DrawQuad(20.0f, 10.0f, 60.0f, 30.0f, 0.5f, GreenColor); // Pending until the read back
+
+	std::vector<uint32_t> color;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	CHECK(target.backend.ReadPixels(target.color, color, width, height));
+	CHECK(width == 100 && height == 60);
+	CHECK(color.size() == 100 * 60);
+
+	const uint32_t cleared = (51u << 8) | (102u << 16) | (255u << 24);
+	if (color.size() == 100 * 60)
+	{
+		CHECK(color[0] == cleared); // Rows are top-down: the quad starts at row 10
+		CHECK(color[10 * 100 + 20] == Green);
+		CHECK(color[29 * 100 + 59] == Green);
+		CHECK(color[30 * 100 + 59] == cleared);
+		CHECK(color[29 * 100 + 60] == cleared);
+		CHECK(color[59 * 100 + 99] == cleared);
+	}
+
+	std::vector<uint32_t> depth;
+	CHECK(target.backend.ReadPixels(target.depth, depth, width, height));
+	CHECK(depth.size() == 100 * 60);
+	if (depth.size() == 100 * 60)
+	{
+		CHECK((depth[0] & 0x00FFFFFF) == 0x00FFFFFF);
+		CHECK((depth[10 * 100 + 20] & 0x00FFFFFF) == ToDepth(0.5f));
+		CHECK((depth[29 * 100 + 59] & 0x00FFFFFF) == ToDepth(0.5f));
+	}
+
+	CHECK(!target.backend.ReadPixels(0, depth, width, height));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+// Just enough to run the engine's CPU-side logic without a GPU: every TEST_CASE registers itself, CHECK records a
+// failure and keeps going, TestMain.cpp runs the cases of one executable and returns the number that failed.
+
+namespace Tests
+{
+	using TestFunction = void (*)();
+
+	struct TestCase
+	{
+		const char* name = nullptr;
+		TestFunction function = nullptr;
+	};
+
+	std::vector<TestCase>& GetTestCases();
+	void ReportFailure(const char* file, int line, const char* expression);
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, TestFunction function) { GetTestCases().push_back({ name, function }); }
+	};
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static Tests::TestRegistrar name##Registrar(#name, &name); \
+	static void name()
+
+#define CHECK(expression) ((expression) ? (void)0 : Tests::ReportFailure(__FILE__, __LINE__, #expression))
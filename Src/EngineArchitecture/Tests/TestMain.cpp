@@ -0,0 +1,46 @@
+#include "TestFramework.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace Tests
+{
+	namespace
+	{
+		uint32_t s_Failures = 0; // Failed checks in the running case
+	}
+
+	std::vector<TestCase>& GetTestCases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	void ReportFailure(const char* file, int line, const char* expression)
+	{
+		std::cerr << file << "(" << line << "): CHECK(" << expression << ") failed\n";
+		s_Failures++;
+	}
+}
+
+// Tests.exe [name]: runs every case, or only the ones whose name contains the argument
+int main(int argc, char* argv[])
+{
+	const char* filter = (argc > 1) ? argv[1] : nullptr;
+	int failed = 0;
+
+	for (const Tests::TestCase& test : Tests::GetTestCases())
+	{
+		if (filter && !strstr(test.name, filter))
+			continue;
+
+		Tests::s_Failures = 0;
+		test.function();
+
+		std::cout << (Tests::s_Failures ? "FAILED " : "passed ") << test.name << "\n";
+		if (Tests::s_Failures)
+			failed++;
+	}
+
+	return failed;
+}
@@ -0,0 +1,222 @@
+#include "TestFramework.h"
+#include "Graphics/UploadHeap.h"
+#include "Graphics/Device.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/BackendBridge.h"
+#include <cstring>
+
+using namespace Graphics;
+
+namespace
+{
+	// NullBackend keeps mapped memory across maps and never renames it, so a wrap that overwrites data
+	// the frame still draws from shows up in the contents. Also logs the range of every write.
+	class MappingBackend : public NullBackend
+	{
+	public:
+		struct Write
+		{
+			BackendHandle buffer;
+			uint32_t offset;
+			uint32_t size;
+		};
+
+		void Unmap(BackendHandle buffer, uint32_t writtenOffset, uint32_t writtenSize) override
+		{
+			m_Writes.push_back({ buffer, writtenOffset, writtenSize });
+			NullBackend::Unmap(buffer, writtenOffset, writtenSize);
+		}
+
+		const std::vector<Write>& GetWrites() const { return m_Writes; }
+
+		// Without recording the map, unlike Map()
+		const uint8_t* GetMemory(ID3D11Buffer* buffer)
+		{
+			bool recording = IsRecording();
+			SetRecording(false);
+			const void* memory = Map(ToBackendHandle(buffer), BackendMap::NoOverwrite);
+			SetRecording(recording);
+			return static_cast<const uint8_t*>(memory);
+		}
+
+	private:
+		std::vector<Write> m_Writes;
+	};
+
+	std::vector<BackendMap> GetMapModes(const NullBackend& backend)
+	{
+		std::vector<BackendMap> modes;
+		for (const BackendCommand& command : backend.GetCommands())
+		{
+			if (command.type == BackendCommandType::Map)
+				modes.push_back(static_cast<BackendMap>(command.args[0]));
+		}
+		return modes;
+	}
+
+	bool AllocateVertices(TransientUploadHeap& heap, uint32_t count, uint32_t stride, uint8_t value, TransientAllocation& allocation)
+	{
+		std::vector<uint8_t> data(count * stride, value);
+		return heap.AllocateVertices(nullptr, data.data(), count, stride, allocation);
+	}
+
+	bool Holds(MappingBackend& backend, const TransientAllocation& allocation, uint8_t value)
+	{
+		const uint8_t* memory = backend.GetMemory(allocation.buffer);
+		for (uint32_t i = 0; i < allocation.size; ++i)
+		{
+			if (memory[allocation.offset + i] != value)
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST_CASE(AppendsAreAlignedToTheStride)
+{
+	MappingBackend backend;
+	Device device;
+	device.Initialize(backend);
+	backend.SetRecording(true);
+
+	TransientUploadHeap heap;
+	CHECK(heap.Initialize(device, 1024, 256));
+	heap.BeginFrame();
+
+	TransientAllocation a;
+	TransientAllocation b;
+	CHECK(AllocateVertices(heap, 3, 12, 1, a));
+	CHECK(AllocateVertices(heap, 2, 16, 2, b));
+
+	CHECK(a.offset == 0);
+	CHECK(a.GetCount() == 3);
+	CHECK(b.offset == 48); // 36 rounded up to a whole 16-byte vertex
+	CHECK(b.GetFirstElement() == 3);
+	CHECK(Holds(backend, a, 1));
+	CHECK(Holds(backend, b, 2));
+
+	std::vector<BackendMap> modes = GetMapModes(backend);
+	CHECK(modes.size() == 2);
+	CHECK(modes[0] == BackendMap::Discard);
+	CHECK(modes[1] == BackendMap::NoOverwrite);
+
+	// Only the allocated range is reported as written
+	const std::vector<MappingBackend::Write>& writes = backend.GetWrites();
+	CHECK(writes.size() == 2);
+	CHECK(writes[1].offset == 48 && writes[1].size == 32);
+
+	CHECK(heap.GetStats().vertexBytes == 68);
+	CHECK(heap.GetStats().allocations == 2);
+	CHECK(heap.GetStats().discards == 1);
+}
+
+TEST_CASE(IndicesUseTheIndexHeap)
+{
+	MappingBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	TransientUploadHeap heap;
+	CHECK(heap.Initialize(device, 1024, 256));
+	heap.BeginFrame();
+
+	const uint16_t indices[] = { 0, 1, 2, 2, 1, 3 };
+	TransientAllocation allocation;
+	CHECK(heap.AllocateIndices(nullptr, indices, 6, DXGI_FORMAT_R16_UINT, allocation));
+	CHECK(allocation.buffer == heap.GetIndexBuffer());
+	CHECK(allocation.stride == 2);
+	CHECK(allocation.GetCount() == 6);
+	CHECK(memcmp(backend.GetMemory(allocation.buffer), indices, sizeof(indices)) == 0);
+	CHECK(heap.GetStats().indexBytes == sizeof(indices));
+}
+
+TEST_CASE(FullHeapWithinAFrameRefusesInsteadOfWrapping)
+{
+	MappingBackend backend;
+	Device device;
+	device.Initialize(backend);
+	backend.SetRecording(true);
+
+	TransientUploadHeap heap;
+	CHECK(heap.Initialize(device, 256, 256));
+	heap.BeginFrame();
+
+	// Like RenderQueue::PrepareInstances: every batch is uploaded before any of them is drawn
+	TransientAllocation first;
+	TransientAllocation second;
+	TransientAllocation third;
+	CHECK(AllocateVertices(heap, 6, 16, 1, first));
+	CHECK(AllocateVertices(heap, 6, 16, 2, second));
+	CHECK(!AllocateVertices(heap, 6, 16, 3, third));
+	CHECK(!third.IsValid());
+
+	// Wrapping would have written over the first batch before it was drawn
+	CHECK(Holds(backend, first, 1));
+	CHECK(Holds(backend, second, 2));
+	CHECK(heap.GetStats().overflows == 1);
+	CHECK(heap.GetStats().discards == 1);
+	CHECK(GetMapModes(backend).size() == 2);
+
+	// The next frame gets a heap that holds all three
+	heap.BeginFrame();
+	CHECK(heap.GetVertexHeapSize() >= 3 * 96);
+	CHECK(heap.GetVertexBuffer() != nullptr);
+	CHECK(heap.GetStats().overflows == 0);
+
+	CHECK(AllocateVertices(heap, 6, 16, 1, first));
+	CHECK(AllocateVertices(heap, 6, 16, 2, second));
+	CHECK(AllocateVertices(heap, 6, 16, 3, third));
+	CHECK(first.offset == 0);
+	CHECK(heap.GetStats().overflows == 0);
+	CHECK(heap.GetStats().discards == 1); // New buffer, first map renames it
+
+	CHECK(backend.GetStats().liveResources == 2); // Old vertex heap destroyed
+}
+
+TEST_CASE(FullHeapWrapsOntoOlderFrames)
+{
+	MappingBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	TransientUploadHeap heap;
+	CHECK(heap.Initialize(device, 256, 256));
+
+	TransientAllocation allocation;
+	heap.BeginFrame();
+	CHECK(AllocateVertices(heap, 12, 16, 1, allocation));
+
+	// Only last frame's data is in the heap, renaming it leaves the GPU its copy
+	heap.BeginFrame();
+	backend.SetRecording(true);
+	CHECK(AllocateVertices(heap, 6, 16, 2, allocation));
+	CHECK(allocation.offset == 0);
+	CHECK(GetMapModes(backend).back() == BackendMap::Discard);
+	CHECK(heap.GetStats().discards == 1);
+	CHECK(heap.GetStats().overflows == 0);
+	CHECK(heap.GetVertexHeapSize() == 256);
+
+	CHECK(AllocateVertices(heap, 6, 16, 3, allocation));
+	CHECK(allocation.offset == 96);
+	CHECK(GetMapModes(backend).back() == BackendMap::NoOverwrite);
+}
+
+TEST_CASE(AllocationLargerThanTheHeapGrowsIt)
+{
+	MappingBackend backend;
+	Device device;
+	device.Initialize(backend);
+
+	TransientUploadHeap heap;
+	CHECK(heap.Initialize(device, 256, 256));
+	heap.BeginFrame();
+
+	TransientAllocation allocation;
+	CHECK(!AllocateVertices(heap, 64, 16, 1, allocation));
+	CHECK(heap.GetStats().overflows == 1);
+
+	heap.BeginFrame();
+	CHECK(heap.GetVertexHeapSize() >= 1024);
+	CHECK(AllocateVertices(heap, 64, 16, 1, allocation));
+	CHECK(Holds(backend, allocation, 1));
+}
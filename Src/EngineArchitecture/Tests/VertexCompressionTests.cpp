@@ -0,0 +1,293 @@
+#include "TestFramework.h"
+#include "Graphics/VertexCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace Graphics;
+
+namespace
+{
+	// 37 elements: a full AVX2 and SSE2 block plus a scalar tail on every path
+	const size_t Count = 37;
+
+	XMFLOAT3 RandomDirection(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+		for (;;)
+		{
+			float x = component(random);
+			float y = component(random);
+			float z = component(random);
+			float length = std::sqrt(x * x + y * y + z * z);
+			if (length > 0.01f && length <= 1.0f)
+				return XMFLOAT3(x / length, y / length, z / length);
+		}
+	}
+
+	float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	// Worst case angle between a direction and its decoded octahedral encoding, in radians
+	float OctahedralError(const std::vector<XMFLOAT3>& directions)
+	{
+		std::vector<int16_t> encoded(directions.size() * 2);
+		EncodeOctahedral(directions.data(), sizeof(XMFLOAT3), directions.size(), encoded.data(), 2 * sizeof(int16_t));
+
+		// Through the cross product, acos of a float dot product cannot resolve angles this small
+		double worst = 0.0;
+		for (size_t i = 0; i < directions.size(); ++i)
+		{
+			XMFLOAT3 a = DecodeOctahedral(&encoded[i * 2]);
+			const XMFLOAT3& b = directions[i];
+			double x = static_cast<double>(a.y) * b.z - static_cast<double>(a.z) * b.y;
+			double y = static_cast<double>(a.z) * b.x - static_cast<double>(a.x) * b.z;
+			double z = static_cast<double>(a.x) * b.y - static_cast<double>(a.y) * b.x;
+			worst = std::max(worst, std::asin(std::min(std::sqrt(x * x + y * y + z * z), 1.0)));
+		}
+		return static_cast<float>(worst);
+	}
+}
+
+TEST_CASE(PositionsRoundTripWithinHalfAStep)
+{
+	std::mt19937 random(17);
+	std::uniform_real_distribution<float> x(-40.0f, 25.0f);
+	std::uniform_real_distribution<float> y(0.0f, 3.0f);
+	std::uniform_real_distribution<float> z(-0.5f, 0.5f);
+
+	std::vector<XMFLOAT3> positions(1000);
+	for (XMFLOAT3& position : positions)
+		position = XMFLOAT3(x(random), y(random), z(random));
+
+	PositionQuantization quantization = ComputePositionQuantization(positions.data(), sizeof(XMFLOAT3), positions.size());
+
+	std::vector<uint16_t> encoded(positions.size() * 4);
+	EncodePositions(positions.data(), sizeof(XMFLOAT3), positions.size(), quantization, encoded.data(), 4 * sizeof(uint16_t));
+
+	// Half a UNORM16 step of each axis extent, plus float rounding in the decode
+	const float* scale = &quantization.scale.x;
+	float worst[3] = {};
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		XMFLOAT3 decoded = DecodePosition(&encoded[i * 4], quantization);
+		worst[0] = std::max(worst[0], std::fabs(decoded.x - positions[i].x));
+		worst[1] = std::max(worst[1], std::fabs(decoded.y - positions[i].y));
+		worst[2] = std::max(worst[2], std::fabs(decoded.z - positions[i].z));
+	}
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+		CHECK(worst[axis] <= scale[axis] * (0.5f / 65535.0f) + scale[axis] * 1e-6f);
+}
+
+TEST_CASE(BoundsEncodeToTheEndsOfTheRange)
+{
+	XMFLOAT3 positions[] = { { -2.0f, 5.0f, 7.0f }, { 6.0f, 1.0f, 7.0f }, { 0.0f, 3.0f, 7.0f } };
+	PositionQuantization quantization = ComputePositionQuantization(positions, sizeof(XMFLOAT3), 3);
+
+	CHECK(quantization.offset.x == -2.0f && quantization.scale.x == 8.0f);
+	CHECK(quantization.offset.y == 1.0f && quantization.scale.y == 4.0f);
+	CHECK(quantization.offset.z == 7.0f && quantization.scale.z == 1.0f); // Flat axis
+
+	uint16_t encoded[3][4] = {};
+	EncodePositions(positions, sizeof(XMFLOAT3), 3, quantization, encoded, sizeof(encoded[0]));
+
+	CHECK(encoded[0][0] == 0 && encoded[1][0] == 65535);
+	CHECK(encoded[0][1] == 65535 && encoded[1][1] == 0);
+	CHECK(encoded[0][2] == 0 && encoded[1][2] == 0 && encoded[2][2] == 0);
+
+	// Ends and flat axes come back exactly
+	XMFLOAT3 low = DecodePosition(encoded[0], quantization);
+	XMFLOAT3 high = DecodePosition(encoded[1], quantization);
+	CHECK(low.x == -2.0f && low.y == 5.0f && low.z == 7.0f);
+	CHECK(high.x == 6.0f && high.y == 1.0f && high.z == 7.0f);
+}
+
+TEST_CASE(OctahedralErrorIsBounded)
+{
+	std::mt19937 random(3);
+	std::vector<XMFLOAT3> directions(10000);
+	for (XMFLOAT3& direction : directions)
+		direction = RandomDirection(random);
+
+	// Axes, diagonals and the folded seam of the lower hemisphere
+	const XMFLOAT3 special[] = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		{ 0.70710678f, 0, -0.70710678f }, { 0, -0.70710678f, -0.70710678f }, { 0.57735027f, -0.57735027f, -0.57735027f } };
+	directions.insert(directions.end(), std::begin(special), std::end(special));
+
+	// 16-bit octahedral stays well under a hundredth of a degree
+	CHECK(OctahedralError(directions) < 0.0001f);
+}
+
+TEST_CASE(OctahedralSnorm16MinimumDecodesToMinusOne)
+{
+	const int16_t encoded[2] = { -32768, 0 };
+	XMFLOAT3 decoded = DecodeOctahedral(encoded);
+	CHECK(std::fabs(decoded.x + 1.0f) < 1e-6f && std::fabs(decoded.y) < 1e-6f && std::fabs(decoded.z) < 1e-6f);
+}
+
+TEST_CASE(HalfConversionMatchesIEEE)
+{
+	// Exactly representable values round-trip
+	const float exact[] = { 0.0f, -0.0f, 1.0f, -2.0f, 0.5f, 0.333251953125f, 65504.0f, 6.103515625e-05f, 5.9604644775390625e-08f };
+	for (float value : exact)
+		CHECK(HalfToFloat(FloatToHalf(value)) == value);
+
+	CHECK(FloatToHalf(1.0f) == 0x3C00);
+	CHECK(FloatToHalf(-2.0f) == 0xC000);
+	CHECK(FloatToHalf(65520.0f) == 0x7C00); // Rounds up to infinity
+	CHECK(FloatToHalf(std::numeric_limits<float>::infinity()) == 0x7C00);
+	CHECK(std::isnan(HalfToFloat(FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+	// Ties go to even: 1 + 2^-11 sits halfway between 1 and the next half
+	CHECK(FloatToHalf(1.0f + 1.0f / 2048.0f) == 0x3C00);
+	CHECK(FloatToHalf(1.0f + 3.0f / 2048.0f) == 0x3C02);
+
+	// Normal range: relative error of at most half an ulp (2^-11)
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> value(-8.0f, 8.0f);
+	for (uint32_t i = 0; i < 10000; ++i)
+	{
+		float original = value(random);
+		if (std::fabs(original) < 6.103515625e-05f)
+			continue;
+
+		float decoded = HalfToFloat(FloatToHalf(original));
+		CHECK(std::fabs(decoded - original) <= std::fabs(original) / 2048.0f);
+	}
+}
+
+TEST_CASE(ColorsRoundToNearestAndClamp)
+{
+	XMFLOAT4 colors[] = { { 0.0f, 1.0f, 0.5f, 0.25f }, { -1.0f, 2.0f, 0.2f, 0.999f } };
+	uint8_t encoded[2][4] = {};
+	EncodeColors(colors, sizeof(XMFLOAT4), 2, encoded, 4);
+
+	CHECK(encoded[0][0] == 0 && encoded[0][1] == 255 && encoded[0][2] == 128 && encoded[0][3] == 64);
+	CHECK(encoded[1][0] == 0 && encoded[1][1] == 255 && encoded[1][2] == 51 && encoded[1][3] == 255);
+}
+
+TEST_CASE(VectorPathsMatchTheScalarTail)
+{
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+
+	std::vector<VertexPositionNormalTangentTex> vertices(Count);
+	std::vector<XMFLOAT4> colors(Count);
+	for (size_t i = 0; i < Count; ++i)
+	{
+		vertices[i].Position = XMFLOAT3(coordinate(random), coordinate(random), coordinate(random));
+		vertices[i].Normal = RandomDirection(random);
+		vertices[i].Tangent = RandomDirection(random);
+		vertices[i].TexCoord = XMFLOAT2(unit(random) * 4.0f, unit(random));
+		colors[i] = XMFLOAT4(unit(random), unit(random), unit(random), unit(random));
+	}
+
+	// Lower-hemisphere normals with signed zeros, in the vector blocks and the tail: the fold must treat -0.0 like +0.0
+	const XMFLOAT3 signedZeros[] = { { -0.0f, 0.6f, -0.8f }, { 0.6f, -0.0f, -0.8f }, { -0.0f, -0.0f, -1.0f }, { 0.0f, -0.0f, -1.0f } };
+	for (size_t i = 1; i < Count; i += 5)
+		vertices[i].Normal = signedZeros[(i / 5) % 4];
+
+	const size_t stride = sizeof(VertexPositionNormalTangentTex);
+	PositionQuantization quantization = ComputePositionQuantization(&vertices[0].Position, stride, Count);
+
+	// Whole array (vector blocks) against one element at a time (scalar only): the bits must be identical
+	struct Encoded
+	{
+		uint16_t position[4];
+		int16_t normal[2];
+		uint16_t texCoord[2];
+		uint8_t color[4];
+	};
+
+	std::vector<Encoded> batched(Count);
+	std::vector<Encoded> single(Count);
+	memset(batched.data(), 0, batched.size() * sizeof(Encoded));
+	memset(single.data(), 0, single.size() * sizeof(Encoded));
+
+	EncodePositions(&vertices[0].Position, stride, Count, quantization, batched[0].position, sizeof(Encoded));
+	EncodeOctahedral(&vertices[0].Normal, stride, Count, batched[0].normal, sizeof(Encoded));
+	EncodeHalf2(&vertices[0].TexCoord, stride, Count, batched[0].texCoord, sizeof(Encoded));
+	EncodeColors(colors.data(), sizeof(XMFLOAT4), Count, batched[0].color, sizeof(Encoded));
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		EncodePositions(&vertices[i].Position, stride, 1, quantization, single[i].position, sizeof(Encoded));
+		EncodeOctahedral(&vertices[i].Normal, stride, 1, single[i].normal, sizeof(Encoded));
+		EncodeHalf2(&vertices[i].TexCoord, stride, 1, single[i].texCoord, sizeof(Encoded));
+		EncodeColors(&colors[i], sizeof(XMFLOAT4), 1, single[i].color, sizeof(Encoded));
+	}
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		CHECK(memcmp(batched[i].position, single[i].position, 3 * sizeof(uint16_t)) == 0);
+		CHECK(memcmp(batched[i].normal, single[i].normal, sizeof(batched[i].normal)) == 0);
+		CHECK(memcmp(batched[i].color, single[i].color, sizeof(batched[i].color)) == 0);
+
+		// F16C and the scalar conversion both round to nearest even
+		CHECK(batched[i].texCoord[0] == FloatToHalf(vertices[i].TexCoord.x));
+		CHECK(batched[i].texCoord[1] == FloatToHalf(vertices[i].TexCoord.y));
+		CHECK(memcmp(batched[i].texCoord, single[i].texCoord, sizeof(batched[i].texCoord)) == 0);
+	}
+}
+
+TEST_CASE(CompressedMeshesDecodeBack)
+{
+	std::mt19937 random(23);
+	std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	std::vector<VertexPositionNormalTangentTex> vertices(Count);
+	for (VertexPositionNormalTangentTex& vertex : vertices)
+	{
+		vertex.Position = XMFLOAT3(coordinate(random), coordinate(random) * 10.0f, coordinate(random));
+		vertex.Normal = RandomDirection(random);
+		vertex.Tangent = RandomDirection(random);
+		vertex.TexCoord = XMFLOAT2(unit(random), unit(random));
+	}
+
+	std::vector<VertexPositionNormalTangentTexPacked> packed(Count);
+	PositionQuantization quantization = CompressVertices(vertices.data(), Count, packed.data());
+	CHECK(sizeof(VertexPositionNormalTangentTexPacked) == 20);
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		XMFLOAT3 position = DecodePosition(packed[i].Position, quantization);
+		CHECK(std::fabs(position.x - vertices[i].Position.x) <= quantization.scale.x / 65535.0f);
+		CHECK(std::fabs(position.y - vertices[i].Position.y) <= quantization.scale.y / 65535.0f);
+		CHECK(std::fabs(position.z - vertices[i].Position.z) <= quantization.scale.z / 65535.0f);
+
+		CHECK(Dot(DecodeOctahedral(packed[i].Normal), vertices[i].Normal) > 0.99999f);
+		CHECK(Dot(DecodeOctahedral(packed[i].Tangent), vertices[i].Tangent) > 0.99999f);
+
+		// Texcoords in [0, 1] keep 11 significant bits
+		CHECK(std::fabs(HalfToFloat(packed[i].TexCoord[0]) - vertices[i].TexCoord.x) <= 1.0f / 2048.0f);
+		CHECK(std::fabs(HalfToFloat(packed[i].TexCoord[1]) - vertices[i].TexCoord.y) <= 1.0f / 2048.0f);
+	}
+
+	// Colors: RGBA8 within half a step
+	std::vector<VertexPositionColor> colored(Count);
+	for (VertexPositionColor& vertex : colored)
+	{
+		vertex.Position = XMFLOAT4(coordinate(random), coordinate(random), coordinate(random), 1.0f);
+		vertex.Color = XMFLOAT4(unit(random), unit(random), unit(random), 1.0f);
+	}
+
+	std::vector<VertexPositionColorPacked> packedColors(Count);
+	CompressVertices(colored.data(), Count, packedColors.data());
+	CHECK(sizeof(VertexPositionColorPacked) == 12);
+
+	for (size_t i = 0; i < Count; ++i)
+	{
+		const float* color = &colored[i].Color.x;
+		for (uint32_t channel = 0; channel < 4; ++channel)
+			CHECK(std::fabs(packedColors[i].Color[channel] / 255.0f - color[channel]) <= 0.5f / 255.0f + 1e-6f);
+	}
+}
@@ -2,8 +2,12 @@
 //
 
 #include <windows.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <d3d11.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
@@ -12,9 +16,23 @@
 #include "Graphics/SwapChain.h"
 #include "Graphics/CommandList.h"
 #include "Graphics/Buffer.h"
+#include "Graphics/BufferPool.h"
 #include "Graphics/Texture.h"
 #include "Graphics/Pipeline.h"
+#include "Graphics/PipelineCache.h"
+#include "Graphics/ShaderCache.h"
+#include "Graphics/ConstantBufferLayout.h"
+#include "Graphics/ConstantBufferRing.h"
+#include "Graphics/UploadHeap.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/NullBackend.h"
+#include "Graphics/SoftwareBackend.h"
+#include "Graphics/CommandTrace.h"
 #include "Core/Windows.h"
+#include "Core/FramePipeline.h"
+#include "Core/RenderThread.h"
+#include "Core/Profiler.h"
 
 
 #pragma comment(lib, "d3d11.lib")
@@ -27,17 +45,28 @@ private:
 
 
 
-    // Define a struct for the camera matrices (must match HLSL cbuffer layout)
-    struct CameraBuffer
+    // Per-cube data (must match HLSL ObjectBuffer layout)
+    struct ObjectBuffer
     {
         DirectX::XMMATRIX word;
-        DirectX::XMMATRIX view;
-        DirectX::XMMATRIX projection;
-    } cameraData, cameraData2;
+    };
 
-    float m_CubeRotation = 0.0f; // Rotation angle for the cube (tools for game)
+    float m_CubeRotation = 0.0f; // Rotation angle for the cube (tools for game), owned by the update stage
 
 public:
+    // Everything the render stage reads from the update stage, one copy per frame in flight
+    struct FrameData
+    {
+        ObjectBuffer cubes[2];
+    };
+
+    // Handed from the window thread to the render thread, which owns the context and the command list
+    struct RenderPacket
+    {
+        FrameData frame;
+        std::vector<std::function<void(Render& render)>> resourceCommands; // Create/destroy, run before the frame is drawn
+    };
+
     Render()
     {
     }
@@ -50,11 +79,20 @@ public:
     Graphics::Device device;
     Graphics::SwapChain swapChain;
     Graphics::CommandList commandList;
-    Graphics::Pipeline pipeline;
-    Graphics::Buffer vertexBuffer;
-    Graphics::Buffer indexBuffer;
-    Graphics::Buffer constantBuffer;
-    Graphics::Buffer constantBuffer2;
+    Graphics::ShaderCache shaderCache; // Bytecode from previous runs, ShaderCache.bin next to the executable
+    Graphics::PipelineCache pipelineCache;
+    std::shared_ptr<Graphics::Pipeline> pipeline;
+    std::shared_ptr<Graphics::Pipeline> instancedPipeline; // Same shading, world matrix from the instance stream
+    std::shared_ptr<Graphics::Pipeline> depthPipeline; // Depth prepass, reads only the position stream
+    std::shared_ptr<Graphics::Pipeline> depthInstancedPipeline;
+    Graphics::GeometryArena geometry; // Cube positions and colors in separate streams
+    Graphics::GeometryHandle cubeMesh { Graphics::InvalidGeometry };
+    Graphics::BufferPool bufferPool; // Buffers created after startup, recycled once the GPU has finished with them
+    Graphics::Buffer cameraBuffer; // View/projection, only re-uploaded when they change
+    Graphics::ConstantBufferLayout cameraLayout; // MatrrixBuffer as reflected from the vertex shader
+    Graphics::ConstantBufferRing constantRing; // Per-cube constants, used when the instance data does not fit the upload heap
+    Graphics::TransientUploadHeap uploadHeap; // Per-frame instance data
+    Graphics::RenderQueue renderQueue; // Identical cubes collapse into one instanced draw
 
     void Initialize(HWND hwnd)
     {
@@ -64,49 +102,182 @@ public:
 		swapChain.Initialize(device, hwnd, m_Width, m_Height); // Initialize the swap chain with the device and window handle
         commandList.Initialize(device.GetContext()); // Initialize the command list with the device context
 
+        CreateResources();
+        PrintShaderTimings();
+
+        std::wcout << L"GPU: " << adapter.GetGpuName() << std::endl;
+        std::wcout << L"Dedicated Video Memory: " << adapter.GetDedicatedVideoMemory() / (1024 * 1024) << L" MB" << std::endl;
+        std::wcout << L"Dedicated System Memory: " << adapter.GetDedicatedSystemMemory() / (1024 * 1024) << L" MB" << std::endl;
+        std::wcout << L"Shared System Memory: " << adapter.GetSharedSystemMemory() / (1024 * 1024) << L" MB" << std::endl;
+    }
+
+    // No window and no GPU: every resource and command goes to the backend, shaders are still compiled for reflection
+    bool InitializeHeadless(Graphics::RenderBackend& backend)
+    {
+        device.Initialize(backend);
+        if (!swapChain.Initialize(device, nullptr, m_Width, m_Height))
+            return false;
+
+        commandList.Initialize(backend);
+        return CreateResources() && CreateScene();
+    }
+
 
-        Graphics::VertexInputElement layout {};
-        layout.Add(Graphics::VertexType::Position);
-        layout.Add(Graphics::VertexType::Color);
+    // Pipelines and per-frame heaps, shared by the windowed and the headless path
+    bool CreateResources()
+    {
+        // Offsets and formats come from VertexTraits<VertexPositionColor>, checked against the struct at compile time.
+        // Position in slot 0 and color in slot 2, so the depth prepass below fetches 16 of the 32 bytes per vertex.
+        Graphics::VertexInputElement layout = Graphics::VertexInputElement::CreateStreams<Graphics::VertexPositionColor>();
 
         Graphics::PipelineDesc pipelineDesc {};
 		pipelineDesc.fillMode = D3D11_FILL_SOLID; // Set fill mode to solid
 		pipelineDesc.cullMode = D3D11_CULL_NONE; // Disable backface culling
 		pipelineDesc.depthEnabled = true; // Enable depth testing
+		pipelineDesc.depthFunc = D3D11_COMPARISON_LESS_EQUAL; // Only the closest surfaces left by the prepass are shaded
 		pipelineDesc.vertexInputElement = layout; // Set the vertex input layout    
-        pipeline.Initialize(device, pipelineDesc);
+        shaderCache.Initialize("ShaderCache.bin");
+        pipelineCache.Initialize(device);
+        pipelineCache.SetShaderCache(&shaderCache);
+
+        Graphics::PipelineDesc instancedDesc = pipelineDesc;
+        layout.AddInstanceMatrix("WORLD"); // float4x4 per instance, slot 1
+        instancedDesc.vertexShaderEntry = "VSInstanced";
+        instancedDesc.vertexInputElement = layout;
+
+        Graphics::PipelineDesc depthDesc = pipelineDesc;
+        Graphics::VertexInputElement depthLayout = Graphics::VertexInputElement::CreateStreams<Graphics::VertexPositionColor>(Graphics::VertexStream::Position);
+        depthDesc.depthOnly = true;
+        depthDesc.depthFunc = D3D11_COMPARISON_LESS;
+        depthDesc.vertexShaderEntry = "VSDepth";
+        depthDesc.vertexInputElement = depthLayout;
+
+        Graphics::PipelineDesc depthInstancedDesc = depthDesc;
+        depthLayout.AddInstanceMatrix("WORLD");
+        depthInstancedDesc.vertexShaderEntry = "VSDepthInstanced";
+        depthInstancedDesc.vertexInputElement = depthLayout;
+
+        // Every shader compiles at once on all cores, the pixel shader and states are shared through the cache
+        auto pipelines = pipelineCache.CreatePipelines({ pipelineDesc, instancedDesc, depthDesc, depthInstancedDesc });
+        pipeline = pipelines[0];
+        instancedPipeline = pipelines[1];
+        depthPipeline = pipelines[2];
+        depthInstancedPipeline = pipelines[3];
+
+        shaderCache.Flush(); // Persist whatever had to be compiled
+
+        if (!pipeline || !instancedPipeline || !depthPipeline || !depthInstancedPipeline)
+            return false;
+
+        uploadHeap.Initialize(device);
+        constantRing.Initialize(device);
+        bufferPool.Initialize(device);
+        return true;
+    }
+
+
+    // Startup shader compiles, slowest first
+    void PrintShaderTimings() const
+    {
+        const Graphics::PipelineCacheStats& stats = pipelineCache.GetStats();
+        if (!stats.batches)
+            return;
+
+        std::cout << "Shaders: " << stats.shadersBatched << " compiled in " << stats.batchWallMilliseconds << " ms wall, "
+            << stats.batchCompileMilliseconds << " ms total\n";
+
+        for (const Graphics::ShaderCompileTiming& timing : pipelineCache.GetShaderTimings())
+        {
+            std::wcout << L"  " << timing.milliseconds << L" ms  " << timing.path << L" ";
+            std::cout << timing.entryPoint << " " << timing.profile << (timing.failed ? "  FAILED" : "") << "\n";
+        }
+    }
+
 
+    // Camera and meshes. Windowed, this runs on the render thread as the first packet's resource command.
+    bool CreateScene()
+    {
         CreateCamera();
-        CreateMesh();
+        return CreateMesh();
+    }
 
-        std::wcout << L"GPU: " << adapter.GetGpuName() << std::endl;
-        std::wcout << L"Dedicated Video Memory: " << adapter.GetDedicatedVideoMemory() / (1024 * 1024) << L" MB" << std::endl;
-        std::wcout << L"Dedicated System Memory: " << adapter.GetDedicatedSystemMemory() / (1024 * 1024) << L" MB" << std::endl;
-        std::wcout << L"Shared System Memory: " << adapter.GetSharedSystemMemory() / (1024 * 1024) << L" MB" << std::endl;
+
+    // Render thread, the only thread that touches the device context once the render thread is started
+    void Execute(RenderPacket& packet)
+    {
+        for (const auto& command : packet.resourceCommands)
+            command(*this);
+
+        packet.resourceCommands.clear(); // The packet comes back to the window thread two frames later
+
+        if (cubeMesh == Graphics::InvalidGeometry)
+            return; // Scene creation failed, nothing to draw
+        Loop(packet.frame);
     }
 
 
-    void Loop()
+    void Loop(const FrameData& frame)
     {
+        PROFILE_ZONE("Render::Loop");
+
         float color[4] = { 0.0f, 0.2f, 0.4f, 1.0f };
 
         Graphics::RenderPass& pass = swapChain.GetRenderPass();
 
+        commandList.ResetStats();
+
         commandList.ClearRenderPass(pass, color);
         commandList.SetRenderPass(pass);
         commandList.SetViewport(m_Width, m_Height);
         commandList.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        commandList.SetPipelineState(pipeline);
-
-
-        constantBuffer.Bind(device.GetContext(), 0);        // ConstantBuffer: slot 0, stage VS
-        commandList.DrawIndexed(36, 0, 0);
+        commandList.SetPipelineState(*pipeline);
+
+        cameraLayout.Commit(device.GetContext(), cameraBuffer); // Skipped while no camera variable changed
+        commandList.SetConstantBuffer(cameraBuffer, cameraLayout.GetBindSlot()); // register(b0) in the shader, stage VS
+
+        constantRing.BeginFrame(device.GetContext());
+        uploadHeap.BeginFrame();
+        bufferPool.BeginFrame(device.GetContext());
+        renderQueue.Clear();
+
+        // Both cubes share mesh and pipeline, the queue draws them with one DrawIndexedInstanced per pass
+        const Graphics::GeometryRange& range = geometry.GetRange(cubeMesh);
+
+        Graphics::DrawPacket packet {};
+        packet.sortKey = Graphics::RenderQueue::MakeSortKey(Graphics::RenderPassType::Opaque, 0, cubeMesh, 0.0f);
+        packet.pipeline = pipeline.get();
+        packet.instancedPipeline = instancedPipeline.get();
+        packet.vertexBuffer = geometry.GetVertexBuffer();
+        packet.vertexStride = geometry.GetVertexStride();
+        packet.attributeBuffer = geometry.GetAttributeBuffer();
+        packet.attributeStride = geometry.GetAttributeStride();
+        packet.indexBuffer = geometry.GetIndexBuffer();
+        packet.indexFormat = geometry.GetIndexFormat();
+        packet.indexCount = range.indexCount;
+        packet.startIndex = range.firstIndex;
+        packet.baseVertex = range.baseVertex;
+
+        // Depth pass sorts first and only binds the position stream
+        Graphics::DrawPacket depthPacket = packet;
+        depthPacket.sortKey = Graphics::RenderQueue::MakeSortKey(Graphics::RenderPassType::Depth, 1, cubeMesh, 0.0f);
+        depthPacket.pipeline = depthPipeline.get();
+        depthPacket.instancedPipeline = depthInstancedPipeline.get();
+
+        for (const ObjectBuffer& cube : frame.cubes)
+        {
+            renderQueue.Push(depthPacket, &cube);
+            renderQueue.Push(packet, &cube); // Instance data: the ObjectBuffer world matrix
+        }
 
-        constantBuffer2.Bind(device.GetContext(), 0);        // ConstantBuffer: slot 0, stage VS
-        commandList.DrawIndexed(36, 0, 0);
+        renderQueue.Sort();
+        renderQueue.PrepareInstances(device.GetContext(), uploadHeap, constantRing); // Falls back to one draw per cube with ring constants
+        renderQueue.Submit(commandList);
 
 
 		swapChain.Present(true); // Present the swap chain with vsync enabled
+
+        constantRing.EndFrame(device.GetContext());
+        bufferPool.EndFrame(device.GetContext());
     }
 
 
@@ -152,8 +323,10 @@ public:
         };
 
 
-        vertexBuffer.Initialize(device, Graphics::BufferType::VertexBuffer, vertices, sizeof(vertices), sizeof(Graphics::VertexPositionColor));
-        vertexBuffer.Bind(device.GetContext()); 
+        // Split on upload: 16-byte positions in one buffer, 16-byte colors in the other
+        constexpr uint32_t positionStride = Graphics::GetPositionStreamStride<Graphics::VertexPositionColor>();
+        if (!geometry.InitializeSplit(device, sizeof(Graphics::VertexPositionColor), positionStride, 1024, 4096))
+            return false;
 
 
 
@@ -186,8 +359,9 @@ public:
 
 
 
-        indexBuffer.Initialize(device, Graphics::BufferType::IndexBuffer, indices, sizeof(indices));
-        indexBuffer.Bind(device.GetContext()); 
+        cubeMesh = geometry.Allocate(device.GetContext(), vertices, 24, indices, 36);
+        if (cubeMesh == Graphics::InvalidGeometry)
+            return false;
 
 
         return true;
@@ -207,41 +381,33 @@ public:
         float farZ = 1000.0f;
         DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(fov, aspect, nearZ, farZ);
 
-        // Transpose matrices for HLSL (row-major in C++, column-major in HLSL)
-        cameraData.word = DirectX::XMMatrixIdentity();
-        cameraData.view = DirectX::XMMatrixTranspose(view);
-        cameraData.projection = DirectX::XMMatrixTranspose(projection);
-
-
-
-        constantBuffer.Initialize(device, Graphics::BufferType::ConstantBuffer, &cameraData, sizeof(CameraBuffer));
-
-
-
-        cameraData2 = cameraData;
-        constantBuffer2.Initialize(device, Graphics::BufferType::ConstantBuffer, &cameraData2, sizeof(CameraBuffer));
-        constantBuffer2.Bind(device.GetContext(), 0);        // ConstantBuffer: slot 0, stage VS
+        // Offsets, size and slot come from the compiled shader, no C++ struct to keep in sync
+        if (pipeline && pipeline->GetVertexReflection())
+            cameraLayout.Initialize(*pipeline->GetVertexReflection(), "MatrrixBuffer");
 
+        // Transpose matrices for HLSL (row-major in C++, column-major in HLSL)
+        cameraLayout.Set("View", DirectX::XMMatrixTranspose(view));
+        cameraLayout.Set("Projection", DirectX::XMMatrixTranspose(projection));
 
+        // Recreated whenever the camera is, the previous buffer goes back to the pool
+        cameraBuffer.Release();
+        cameraLayout.CreateBuffer(bufferPool, device, cameraBuffer);
     }
 
 
 
-    void UpdateCamera()
+    // Update stage, runs on the frame pipeline thread: no device or context calls in here
+    void Update(FrameData& frame)
     {
+        PROFILE_ZONE("Render::Update");
 
         m_CubeRotation += 0.01f;
 
-        // Update camera matrices
-        cameraData.word = XMMatrixTranspose(DirectX::XMMatrixRotationRollPitchYaw(m_CubeRotation, m_CubeRotation, m_CubeRotation) * DirectX::XMMatrixTranslation(-0.256f, 0.0f, 0.0f));
-        // Update GPU
-        constantBuffer.Update(device.GetContext(), &cameraData, sizeof(CameraBuffer));
+        // Update cube matrices (uploaded as instance data by Loop)
+        frame.cubes[0].word = XMMatrixTranspose(DirectX::XMMatrixRotationRollPitchYaw(m_CubeRotation, m_CubeRotation, m_CubeRotation) * DirectX::XMMatrixTranslation(-0.256f, 0.0f, 0.0f));
 
-
-        // Update camera matrices
-        cameraData.word = XMMatrixTranspose(DirectX::XMMatrixRotationRollPitchYaw(-m_CubeRotation, -m_CubeRotation, -m_CubeRotation) * DirectX::XMMatrixTranslation(0.256f, 0.0f, 0.0f));
-        // Update GPU
-        constantBuffer2.Update(device.GetContext(), &cameraData, sizeof(CameraBuffer));
+        // Update cube matrices
+        frame.cubes[1].word = XMMatrixTranspose(DirectX::XMMatrixRotationRollPitchYaw(-m_CubeRotation, -m_CubeRotation, -m_CubeRotation) * DirectX::XMMatrixTranslation(0.256f, 0.0f, 0.0f));
 
     }
 
@@ -299,19 +465,239 @@ public:
 };
 
 
-int main()
+struct HeadlessRun
+{
+    Core::FrameStageStats cpu;
+    uint64_t submitted = 0;
+    uint64_t filtered = 0;
+};
+
+// Update and Loop back to back on one thread, the backend executes every frame before the next one starts
+void RunFrames(Render& render, uint32_t frameCount, HeadlessRun& run)
+{
+    Render::FrameData frame {};
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        render.Update(frame);
+        render.Loop(frame);
+        run.cpu.Record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        const Graphics::CommandListStats& commands = render.commandList.GetStats(); // Reset by every Loop
+        run.submitted += commands.submitted;
+        run.filtered += commands.filtered;
+    }
+}
+
+
+// Headless benchmark against the null backend, so the numbers are the engine's own CPU cost per frame
+// (culling, sorting, filtering, uploads) without driver or GPU time
+int RunHeadless(uint32_t frameCount)
+{
+    Graphics::NullBackend backend; // Declared first, outlives every resource the render creates
+    Render render = {};
+
+    if (!render.InitializeHeadless(backend))
+    {
+        std::cerr << "[Headless] Failed to create the scene on the null backend.\n";
+        return 1;
+    }
+
+    const Graphics::NullBackendStats setup = backend.GetStats();
+    backend.ResetStats();
+
+    HeadlessRun run;
+    RunFrames(render, frameCount, run);
+
+    const Graphics::NullBackendStats stats = backend.GetStats();
+    const double frames = frameCount ? static_cast<double>(frameCount) : 1.0;
+
+    std::cout << "Headless, " << frameCount << " frames: CPU " << run.cpu.GetAverage() << " ms avg, " << run.cpu.maxMilliseconds << " ms max\n";
+    std::cout << "Per frame: " << stats.draws / frames << " draws, " << stats.instances / frames << " instances, " << stats.triangles / frames
+        << " triangles, " << stats.stateChanges / frames << " state changes (" << run.filtered / frames << " filtered), "
+        << stats.bytesUploaded / frames << " bytes uploaded\n";
+    std::cout << "Command list: " << run.submitted / frames << " calls submitted per frame\n";
+    std::cout << "Resources: " << setup.buffersCreated << " buffers, " << setup.texturesCreated << " textures, " << setup.pipelinesCreated
+        << " pipelines, " << stats.liveBytes / 1024 << " KB live, " << stats.peakBytes / 1024 << " KB peak\n";
+    return 0;
+}
+
+
+// Renders on the CPU rasterizer, for machines without a GPU, and writes the last frame as a BMP
+int RunSoftware(uint32_t frameCount, const char* imagePath)
+{
+    Graphics::SoftwareBackend backend; // One rasterizer worker per hardware thread
+    Render render = {};
+
+    if (!render.InitializeHeadless(backend))
+    {
+        std::cerr << "[Software] Failed to create the scene on the software backend.\n";
+        return 1;
+    }
+
+    HeadlessRun run;
+    RunFrames(render, frameCount, run);
+
+    const Graphics::SoftwareBackendStats& stats = backend.GetStats();
+    const double frames = frameCount ? static_cast<double>(frameCount) : 1.0;
+    const double seconds = run.cpu.GetAverage() * frames / 1000.0;
+
+    std::cout << "Software, " << frameCount << " frames: " << run.cpu.GetAverage() << " ms avg, " << run.cpu.maxMilliseconds << " ms max (geometry "
+        << stats.geometryMilliseconds / frames << " ms, raster " << stats.rasterMilliseconds / frames << " ms)\n";
+    std::cout << "Per frame: " << stats.draws / frames << " draws, " << stats.trianglesSubmitted / frames << " triangles, " << stats.trianglesBinned / frames
+        << " binned, " << stats.pixelsWritten / frames << " pixels, " << (seconds > 0.0 ? stats.trianglesSubmitted / seconds / 1000000.0 : 0.0) << " M triangles/s\n";
+
+    if (frameCount && !backend.SaveImage(backend.GetLastPresented(), imagePath))
+        return 1;
+
+    return 0;
+}
+
+
+// Runs the scene on the null backend through a capture and writes every call, the filtered ones included, to a trace
+int RunCapture(uint32_t frameCount, const char* tracePath)
+{
+    Graphics::NullBackend backend;
+    Graphics::CommandCapture capture(backend); // Both outlive the render, its resources are destroyed through them
+    Render render = {};
+
+    if (!render.InitializeHeadless(capture))
+    {
+        std::cerr << "[Capture] Failed to create the scene on the null backend.\n";
+        return 1;
+    }
+
+    render.commandList.SetCapture(&capture);
+
+    HeadlessRun run;
+    RunFrames(render, frameCount, run);
+
+    if (!capture.Save(tracePath))
+        return 1;
+
+    std::cout << "Captured " << frameCount << " frames, " << capture.GetTrace().GetSize() / 1024 << " KB written to " << tracePath << "\n";
+    return 0;
+}
+
+
+// Re-issues a captured trace, or a frame range of it, and reports what it contains and where the backend spent its time
+int RunReplay(const char* tracePath, const char* backendName, uint32_t firstFrame, uint32_t frameCount)
+{
+    Graphics::CommandTrace trace;
+    Graphics::TraceStats stats;
+    if (!trace.Load(tracePath) || !trace.Analyze(stats))
+        return 1;
+
+    const double frames = stats.frames ? static_cast<double>(stats.frames) : 1.0;
+    std::cout << "Trace: " << stats.frames << " frames, " << stats.records << " records, " << trace.GetSize() / 1024 << " KB, " << stats.peakResources << " resources at peak\n";
+    std::cout << "Per frame: " << stats.draws / frames << " draws, " << stats.instances / frames << " instances, " << stats.bytesUploaded / frames << " bytes uploaded, "
+        << stats.filteredBinds / frames << " binds filtered, " << stats.redundantBinds / frames << " redundant binds reached the backend\n";
+
+    std::unique_ptr<Graphics::RenderBackend> backend;
+    if (strcmp(backendName, "software") == 0)
+        backend.reset(new Graphics::SoftwareBackend());
+    else
+        backend.reset(new Graphics::NullBackend());
+
+    Graphics::CommandReplayer replayer;
+    if (!replayer.Replay(trace, *backend, firstFrame, frameCount))
+        return 1;
+
+    const Graphics::TraceReplayStats& replay = replayer.GetStats();
+    std::cout << "Replay on " << backend->GetName() << ": " << replay.frames << " frames in " << replay.totalMilliseconds << " ms, slowest frame "
+        << replay.frameMilliseconds << " ms, " << replay.missingResources << " missing resources, "
+        << replay.malformedRecords << " malformed records skipped\n";
+
+    for (uint32_t op = 0; op < static_cast<uint32_t>(Graphics::TraceOp::Count); ++op)
+    {
+        if (replay.counts[op])
+            std::cout << "  " << Graphics::GetTraceOpName(static_cast<Graphics::TraceOp>(op)) << ": " << replay.counts[op] << " calls, "
+                << replay.milliseconds[op] << " ms, " << replay.milliseconds[op] * 1000.0 / replay.counts[op] << " us each\n";
+    }
+
+    replayer.Release();
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
 {
+    // EngineArchitecture.exe --null 1000
+    // EngineArchitecture.exe --software 100 [Frame.bmp]
+    // EngineArchitecture.exe --capture 100 Frames.trace
+    // EngineArchitecture.exe --replay Frames.trace [null|software] [firstFrame frameCount]
+    // Any of them, or the windowed run, with --profile Profile.json: zones go to a Chrome trace, written until main returns
+    Core::Profiler::SetThreadName("Main");
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (strcmp(argv[i], "--profile") == 0 && !Core::Profiler::Get().Start(argv[i + 1]))
+            return 1;
+    }
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (strcmp(argv[i], "--null") == 0)
+            return RunHeadless(static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10)));
+
+        if (strcmp(argv[i], "--software") == 0)
+            return RunSoftware(static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10)), (i + 2 < argc) ? argv[i + 2] : "Frame.bmp");
+
+        if (strcmp(argv[i], "--capture") == 0)
+            return RunCapture(static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10)), (i + 2 < argc) ? argv[i + 2] : "Frames.trace");
+
+        if (strcmp(argv[i], "--replay") == 0)
+            return RunReplay(argv[i + 1], (i + 2 < argc) ? argv[i + 2] : "null",
+                (i + 3 < argc) ? static_cast<uint32_t>(strtoul(argv[i + 3], nullptr, 10)) : 0,
+                (i + 4 < argc) ? static_cast<uint32_t>(strtoul(argv[i + 4], nullptr, 10)) : ~0u);
+    }
+
     Render render = {};
 
 
     Core::Windows windows {};
 	windows.Initialize();
+    render.Initialize(windows.GetWindowHandle()); // Device, swap chain and pipelines, the scene comes with the first packet
+
+    // Frame N+1 is simulated while frame N is drawn, three frames in flight
+    Core::FramePipeline<Render::FrameData> framePipeline;
+    framePipeline.Start(3, [&render](Render::FrameData& frame, uint64_t frameIndex) { render.Update(frame); });
+
+    // Draws and presents on its own thread, the window thread only pumps messages and hands frames over.
+    // Two packets: the next frame is handed over while the previous one is still being drawn.
+    Core::RenderThread<Render::RenderPacket> renderThread;
+    renderThread.Start([&render](Render::RenderPacket& packet) { render.Execute(packet); }, 2);
+
+    // Resource work recorded on the window thread, executed on the render thread ahead of the next frame it draws
+    std::vector<std::function<void(Render& render)>> resourceCommands;
+    resourceCommands.push_back([](Render& render)
+    {
+        if (!render.CreateScene())
+            std::cerr << "[Render] Failed to create the scene.\n";
+    });
+
     windows.RenderLoop([&]() 
     {
-        render.Loop();
-        render.UpdateCamera(); 
+        framePipeline.RenderFrame([&renderThread, &resourceCommands](const Render::FrameData& frame, uint64_t frameIndex)
+        {
+            Render::RenderPacket& packet = renderThread.BeginFrame();
+            packet.frame = frame;
+            packet.resourceCommands.swap(resourceCommands); // Execute() emptied the returned packet's list, an empty one stays behind
+            renderThread.Submit();
+        });
     });
 
+    framePipeline.Stop();
+    renderThread.Stop(); // Draws what was already handed over
+
+    const Core::FramePipelineStats stats = framePipeline.GetStats();
+    std::cout << "Frames: " << stats.framesRendered << ", update " << stats.update.GetAverage() << " ms, render " << stats.render.GetAverage()
+        << " ms, latency " << stats.latency.GetAverage() << " ms (" << stats.addedLatency.GetAverage() << " ms queued)\n";
+
+    const Core::RenderThreadStats renderStats = renderThread.GetStats();
+    std::cout << "Render thread: execute " << renderStats.execute.GetAverage() << " ms, latency " << renderStats.latency.GetAverage()
+        << " ms, window thread stalled " << renderStats.gameStall.GetAverage() << " ms, render thread idle " << renderStats.renderIdle.GetAverage() << " ms\n";
+
 
     render.Cleanup();
     return 0;
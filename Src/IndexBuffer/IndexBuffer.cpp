@@ -101,7 +101,7 @@ public:
         renderDevice.deviceContext->RSSetViewports(1, &view);
 
         renderDevice.deviceContext->IASetVertexBuffers(0, 1, &vertexBuffer.buffer, &vertexBuffer.stride, &vertexBuffer.offset);
-        renderDevice.deviceContext->IASetIndexBuffer(indexBuffer.buffer, DXGI_FORMAT_R32_UINT, indexBuffer.offset);
+        renderDevice.deviceContext->IASetIndexBuffer(indexBuffer.buffer, DXGI_FORMAT_R16_UINT, indexBuffer.offset);
 
         renderDevice.deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         renderDevice.deviceContext->IASetInputLayout(pipeline.inputLayout);
@@ -134,7 +134,7 @@ public:
         };
 
         D3D11_BUFFER_DESC vertexBufferDesc = {};
-        vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        vertexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
         vertexBufferDesc.ByteWidth = sizeof(vertices);
         vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 
@@ -153,7 +153,7 @@ public:
 
 
 
-        uint32_t  indices[] =
+        uint16_t indices[] =
         {
             0, 1, 2,
             0, 2, 3
@@ -162,7 +162,7 @@ public:
         indexBuffer.count = 6;
 
         D3D11_BUFFER_DESC indexBufferDesc = {};
-        indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+        indexBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
         indexBufferDesc.ByteWidth = sizeof(indices);
         indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 